@@ -48,18 +48,30 @@ ElectrostaticsPostProcessor::~ElectrostaticsPostProcessor()
 {
 }
 
-femm::ParserResult ElectrostaticsPostProcessor::parseSolution(std::istream &input, std::ostream &err)
+femm::ParserResult ElectrostaticsPostProcessor::parseSolution(femm::Lexer &input, std::ostream &err)
 {
     using femmsolver::CSMeshNode;
     using femmsolver::CHSElement;
 
     int k;
+    bool ok = true;
     // read in meshnodes;
     parseValue(input, k, err);
     meshnodes.reserve(k);
-    for(int i=0;i<k;i++)
+    for(int i=0;i<k && ok;i++)
+    {
+        CSMeshNode n;
+        ok &= input.parseDouble(n.x);
+        ok &= input.parseDouble(n.y);
+        ok &= input.parseDouble(n.V);
+        ok &= input.parseInt(n.Q);
+        input.skipLine();
+        meshnodes.push_back(MAKE_UNIQUE<CSMeshNode>(n));
+    }
+    if (!ok)
     {
-        meshnodes.push_back(MAKE_UNIQUE<CSMeshNode>(CSMeshNode::fromStream(input,err)));
+        err << "Malformed mesh node " << meshnodes.size()-1 << "\n";
+        return femm::F_FILE_MALFORMED;
     }
 
     // read in elements;
@@ -68,7 +80,17 @@ femm::ParserResult ElectrostaticsPostProcessor::parseSolution(std::istream &inpu
     auto &labellist = problem->labellist;
     for(int i=0;i<k;i++)
     {
-        CHSElement elm = CHSElement::fromStream(input,err);
+        CHSElement elm;
+        ok &= input.parseInt(elm.p[0]);
+        ok &= input.parseInt(elm.p[1]);
+        ok &= input.parseInt(elm.p[2]);
+        ok &= input.parseInt(elm.lbl);
+        input.skipLine();
+        if (!ok || elm.lbl < 0 || elm.lbl >= (int)labellist.size())
+        {
+            err << "Malformed mesh element " << i << "\n";
+            return femm::F_FILE_MALFORMED;
+        }
         elm.blk = labellist[elm.lbl]->BlockType;
         meshelems.push_back(MAKE_UNIQUE<CHSElement>(elm));
     }
@@ -76,14 +98,72 @@ femm::ParserResult ElectrostaticsPostProcessor::parseSolution(std::istream &inpu
     // read in circuit data;
     auto &circproplist = problem->circproplist;
     parseValue(input, k, err);
-    for(int i=0;i<k;i++)
+    for(int i=0;i<k && i<(int)circproplist.size();i++)
     {
         auto circuit = reinterpret_cast<CSCircuit*>(circproplist[i].get());
         // partially overwrite circuit data:
-        input >> circuit->V;
-        input >> circuit->q;
+        input.parseDouble(circuit->V);
+        input.parseDouble(circuit->q);
+        input.skipLine();
+    }
+    return femm::F_FILE_OK;
+}
+
+
+femm::ParserResult ElectrostaticsPostProcessor::loadSolution(const femm::SolutionData &solution, std::ostream &err)
+{
+    using femmsolver::CSMeshNode;
+    using femmsolver::CHSElement;
+
+    // mesh nodes
+    meshnodes.reserve(solution.numNodes());
+    for(int i=0;i<solution.numNodes();i++)
+    {
+        CSMeshNode n;
+        n.x = solution.nodeX[i];
+        n.y = solution.nodeY[i];
+        n.V = solution.nodeValue[i].re;
+        n.Q = solution.nodeMarker[i];
+        meshnodes.push_back(MAKE_UNIQUE<CSMeshNode>(n));
+    }
+
+    // elements
+    meshelems.reserve(solution.numElements());
+    auto &labellist = problem->labellist;
+    for(int i=0;i<solution.numElements();i++)
+    {
+        CHSElement elm;
+        for(int j=0;j<3;j++)
+            elm.p[j] = solution.elements[3*i+j];
+        elm.lbl = solution.elementLabel[i];
+        if (elm.lbl < 0 || elm.lbl >= (int)labellist.size())
+        {
+            err << "Element " << i << " has invalid block label " << elm.lbl << "\n";
+            return femm::F_FILE_MALFORMED;
+        }
+        elm.blk = labellist[elm.lbl]->BlockType;
+        meshelems.push_back(MAKE_UNIQUE<CHSElement>(elm));
     }
 
+    // circuit data
+    auto &circproplist = problem->circproplist;
+    if (solution.conductorValue.size() > circproplist.size())
+    {
+        err << "Solution contains more conductors than the problem description\n";
+        return femm::F_FILE_MALFORMED;
+    }
+    if (solution.conductorFlux.size() != solution.conductorValue.size())
+    {
+        err << "Solution contains inconsistent conductor data\n";
+        return femm::F_FILE_MALFORMED;
+    }
+    for(int i=0;i<(int)solution.conductorValue.size();i++)
+    {
+        auto circuit = reinterpret_cast<CSCircuit*>(circproplist[i].get());
+        // partially overwrite circuit data:
+        circuit->V = solution.conductorValue[i];
+        circuit->q = solution.conductorFlux[i];
+    }
     return femm::F_FILE_OK;
 }
 
@@ -29,7 +29,8 @@ class ElectrostaticsPostProcessor
 public:
     ElectrostaticsPostProcessor();
     virtual ~ElectrostaticsPostProcessor();
-    femm::ParserResult parseSolution( std::istream &input, std::ostream &err = std::cerr ) override;
+    femm::ParserResult parseSolution( femm::Lexer &input, std::ostream &err = std::cerr ) override;
+    femm::ParserResult loadSolution( const femm::SolutionData &solution, std::ostream &err = std::cerr ) override;
     bool OpenDocument( std::string solutionFile ) override;
 
     /**
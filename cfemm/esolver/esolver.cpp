@@ -37,12 +37,14 @@
 #include "spars.h"
 //#include "fparse.h"
 #include "esolver.h"
+#include "TextWriter.h"
 
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <cstring>
 #include <malloc.h>
+#include <sstream>
 
 // template instantiation:
 #include "../libfemm/feasolver.cpp"
@@ -128,29 +130,32 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
 {
     int i,j,k,q,n0,n1,n;
     char infile[256];
-    FILE *fp;
-    char s[1024];
 
-    //read meshnodes;
-    std::sprintf(infile,"%s.node",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL){
-        return BADELEMENTFILE;
-    }
-    if (fgets(s,1024,fp)==NULL)
+    // use the mesh handed over by the mesher, or read it from the mesh files
+    femm::MeshData fileMesh;
+    const femm::MeshData *mesh = meshData.get();
+    if (!mesh)
     {
-        return BADELEMENTFILE;
+        std::stringstream err;
+        LoadMeshErr status = fileMesh.read(PathName, err);
+        if (!err.str().empty())
+            WarnMessage(err.str().c_str());
+        if (status != NOERROR)
+            return status;
+        mesh = &fileMesh;
     }
-    std::sscanf(s,"%i",&k);
+
+    //read meshnodes;
+    k = mesh->numNodes();
     NumNodes=k;
 
     meshnode = new CNode[k];
     CNode node;
     for (i=0; i<k; i++)
     {
-        fscanf(fp,"%i",&j);
-        fscanf(fp,"%lf",&node.x);
-        fscanf(fp,"%lf",&node.y);
-        fscanf(fp,"%i",&n);
+        node.x = mesh->nodeX[i];
+        node.y = mesh->nodeY[i];
+        n = mesh->nodeMarker[i];
 
         if (n > 1)
         {
@@ -180,36 +185,14 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
 
         meshnode[i] = node;
     }
-    fclose(fp);
 
     //read in periodic boundary conditions;
-    sprintf(infile,"%s.pbc",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL){
-        return BADPBCFILE;
-    }
-    fgets(s,1024,fp);
-    sscanf(s,"%i",&k);
-    NumPBCs=k;
-
-    if (k!=0)
-        pbclist.reserve(k);
-    CCommonPoint pbc;
-    for(i=0;i<k;i++){
-        fscanf(fp,"%i",&j);
-        fscanf(fp,"%i",&pbc.x);
-        fscanf(fp,"%i",&pbc.y);
-        fscanf(fp,"%i",&pbc.t);
-        pbclist.push_back(pbc);
-    }
-    fclose(fp);
+    NumPBCs = (int)mesh->pbcs.size();
+    pbclist = mesh->pbcs;
 
     // read in elements;
-    sprintf(infile,"%s.ele",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL){
-        return BADELEMENTFILE;
-    }
-    fgets(s,1024,fp);
-    sscanf(s,"%i",&k); NumEls=k;
+    k = mesh->numElements();
+    NumEls=k;
 
     meshele.reserve(k);
     femmsolver::CElement elm;
@@ -219,11 +202,10 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
         if (labellist[i].IsDefault) defaultLabel=i;
 
     for(i=0;i<k;i++){
-        fscanf(fp,"%i",&j);
-        fscanf(fp,"%i",&elm.p[0]);
-        fscanf(fp,"%i",&elm.p[1]);
-        fscanf(fp,"%i",&elm.p[2]);
-        fscanf(fp,"%i",&elm.lbl);
+        elm.p[0] = mesh->elements[3*i];
+        elm.p[1] = mesh->elements[3*i+1];
+        elm.p[2] = mesh->elements[3*i+2];
+        elm.lbl = mesh->elementLabel[i];
         elm.lbl--;
         if(elm.lbl<0) elm.lbl=defaultLabel;
         if(elm.lbl<0){
@@ -232,7 +214,6 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
             msg +="button to highlight the problem regions.";
             WarnMessage(msg.c_str());
 
-            fclose(fp);
             if (deleteFiles)
             {
                 sprintf(infile,"%s.ele",PathName.c_str());
@@ -253,13 +234,14 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
 
         meshele.push_back(elm);
     }
-    fclose(fp);
 
     // initialize edge bc's and element permeabilities;
     for(i=0;i<NumEls;i++)
         for(j=0;j<3;j++)
             meshele[i].e[j] = -1;
 
+    meshEdges = mesh->edges;
+
     // read in edges to which boundary conditions are applied;
 
     // first, do a little bookkeeping so that element
@@ -292,20 +274,11 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
             nmbr[k]++;
         }
 
-    sprintf(infile,"%s.edge",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL)
-    {
-        return BADEDGEFILE;
-    }
-    fscanf(fp,"%i",&k);	// read in number of lines
-
-    fscanf(fp,"%i",&j);	// read in boundarymarker flag;
-    for(i=0;i<k;i++)
+    for(i=0;i<mesh->numEdges();i++)
     {
-        fscanf(fp,"%i",&j);
-        fscanf(fp,"%i",&n0);
-        fscanf(fp,"%i",&n1);
-        fscanf(fp,"%i",&n);
+        n0 = mesh->edges[2*i];
+        n1 = mesh->edges[2*i+1];
+        n = mesh->edgeMarker[i];
 
         // BC number;
         if (n<0)
@@ -350,7 +323,6 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
         }
 
     }
-    fclose(fp);
 
     // free up the connectivity information
     free(nmbr);
@@ -678,6 +650,7 @@ bool ESolver::runSolver(bool verbose)
     CBigLinProb L;
 
     L.Precision = Precision;
+    L.bFloatPC = FloatPreconditioner;
     if (!L.Create(NumNodes+NumCircProps,BandWidth))
     {
         WarnMessage("couldn't allocate enough space for matrices\n");
@@ -693,13 +666,31 @@ bool ESolver::runSolver(bool verbose)
     if (verbose)
         PrintMessage("Problem solved\n");
 
-    if (!WriteResults(L))
+    if ((keepSolution || binarySolutionFile || !solutionArchive.empty()) && !StoreResults(L))
     {
-        WarnMessage("couldn't write results to disk\n");
+        WarnMessage("couldn't store results\n");
         return false;
     }
-    if (verbose)
-        PrintMessage("results written to disk\n");
+    if (writeSolutionFile)
+    {
+        bool written = binarySolutionFile
+                ? WriteBinarySolution(PathName + ".res")
+                : WriteResults(L);
+        if (!written)
+        {
+            WarnMessage("couldn't write results to disk\n");
+            return false;
+        }
+        if (verbose)
+            PrintMessage("results written to disk\n");
+    }
+    if (!solutionArchive.empty() && !AppendToSolutionArchive())
+    {
+        WarnMessage("couldn't append results to the solution archive\n");
+        return false;
+    }
+    if (!keepSolution)
+        solution.reset();
 
     return true;
 }
@@ -722,9 +713,9 @@ int ESolver::WriteResults(CBigLinProb &L)
 	// write solution to disk;
 
 	char c[1024];
-	FILE *fp,*fz;
+	FILE *fz;
 	int i;
-    double cf;
+	double cf;
 	// first, echo input .fee file to the .res file;
 	sprintf(c,"%s.fee",PathName.c_str());
 
@@ -735,47 +726,90 @@ int ESolver::WriteResults(CBigLinProb &L)
         return false;
 	}
 
+    femm::TextWriter out;
     sprintf(c,"%s.res",PathName.c_str());
-    fp=fopen(c,"wt");
-	if(fp==NULL)
+	if(!out.open(c))
     {
+		fclose(fz);
 		printf("Couldn't write to %s.res",PathName.c_str());
         return false;
 	}
 
-	while(fgets(c,1024,fz)!=NULL)
-    {
-        fputs(c,fp);
-    }
+	out.copy(fz);
 	fclose(fz);
 
 	// then print out node, line, and element information
-	fprintf(fp,"[Solution]\n");
+	out.write("[Solution]\n");
     // get conversion factor for conversion from internal working units of
     // mm to the specified length units
 	cf = units[LengthUnits];
-	fprintf(fp,"%i\n",NumNodes);
+	out.writeInt(NumNodes);
+	out.write('\n');
 	for(i=0;i<NumNodes;i++)
     {
-		fprintf(fp,"%.17g	%.17g	%.17g	%i\n",meshnode[i].x/cf,meshnode[i].y/cf,L.V[i],L.Q[i]);
+		out.writeDouble(meshnode[i].x/cf);
+		out.write('\t');
+		out.writeDouble(meshnode[i].y/cf);
+		out.write('\t');
+		out.writeDouble(L.V[i]);
+		out.write('\t');
+		out.writeInt(L.Q[i]);
+		out.write('\n');
     }
 
-	fprintf(fp,"%i\n",NumEls);
+	out.writeInt(NumEls);
+	out.write('\n');
 
 	for(i=0;i<NumEls;i++)
     {
-		fprintf(fp,"%i	%i	%i	%i\n",
-			meshele[i].p[0],meshele[i].p[1],meshele[i].p[2],meshele[i].lbl);
+		out.writeInt(meshele[i].p[0]);
+		out.write('\t');
+		out.writeInt(meshele[i].p[1]);
+		out.write('\t');
+		out.writeInt(meshele[i].p[2]);
+		out.write('\t');
+		out.writeInt(meshele[i].lbl);
+		out.write('\n');
     }
 
 	// print out circuit info
-	fprintf(fp,"%i\n",NumCircProps);
+	out.writeInt(NumCircProps);
+	out.write('\n');
 	for(i=0;i<NumCircProps;i++)
     {
-		fprintf(fp,"%.17g	%.17g\n",L.V[NumNodes+i],circproplist[i].q);
+		out.writeDouble(L.V[NumNodes+i]);
+		out.write('\t');
+		out.writeDouble(circproplist[i].q);
+		out.write('\n');
+    }
+
+	if(!out.close())
+    {
+		printf("Couldn't write to %s.res",PathName.c_str());
+        return false;
+	}
+    return true;
+}
+
+bool ESolver::StoreResults(CBigLinProb &L)
+{
+    if (!StoreSolutionMesh(meshnode, units[LengthUnits], PathName + ".fee", femm::FileType::ElectrostaticsFile))
+        return false;
+
+    solution->nodeValue.resize(NumNodes);
+    for(int i=0; i<NumNodes; i++)
+    {
+        solution->nodeValue[i] = L.V[i];
+        solution->nodeMarker[i] = L.Q[i];
     }
 
-	fclose(fp);
+    solution->conductorValue.resize(NumCircProps);
+    solution->conductorFlux.resize(NumCircProps);
+    for(int i=0; i<NumCircProps; i++)
+    {
+        solution->conductorValue[i] = L.V[NumNodes+i];
+        solution->conductorFlux[i] = circproplist[i].q;
+    }
     return true;
 }
 
@@ -859,7 +893,19 @@ void ESolver::SortNodes (std::vector<int> newnum)
     }
 }
 
-bool ESolver::handleToken(const string &, istream &, ostream &)
+// NodeCoordinates: copies the mesh node positions for the space filling curve orderings
+void ESolver::NodeCoordinates (std::vector<double> &x, std::vector<double> &y) const
+{
+    x.resize(NumNodes);
+    y.resize(NumNodes);
+    for(int i = 0; i < NumNodes; i++)
+    {
+        x[i] = meshnode[i].x;
+        y[i] = meshnode[i].y;
+    }
+}
+
+bool ESolver::handleToken(const string &, femm::Lexer &, ostream &)
 {
     return false;
 }
@@ -73,6 +73,13 @@ public:
     bool LoadProblemFile();
     double ChargeOnConductor(int conductor, CBigLinProb &L);
     int WriteResults(CBigLinProb &L);
+    /**
+     * @brief Store the solution in #solution.
+     * The stored data is the same that WriteResults() writes to the solution file.
+     * @param L
+     * @return \c true on success, \c false otherwise.
+     */
+    bool StoreResults(CBigLinProb &L);
     int AnalyzeProblem(CBigLinProb &L);
     int (*WarnMessage)(const char*, ...);
 
@@ -82,10 +89,11 @@ private:
     void MsgBox(const char* message);
     void CleanUp() override;
 
-    // override parent class virtual method
+    // override parent class virtual methods
     void SortNodes (std::vector<int> newnum) override;
+    void NodeCoordinates (std::vector<double> &x, std::vector<double> &y) const override;
 
-    virtual bool handleToken(const std::string &, std::istream &, std::ostream &) override;
+    virtual bool handleToken(const std::string &, femm::Lexer &, std::ostream &) override;
 
 };
 
@@ -0,0 +1,392 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "BatchRunner.h"
+
+#include "lua.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+#ifdef _WIN32
+#include <direct.h> // _chdir, _getcwd, _mkdir
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace femmcli;
+
+namespace {
+
+/// name of the file that a job process uses to hand the values of the collected globals to femmcli
+const char resultFileName[] = "femmcli-batch.result";
+
+/// Split a line at blanks; double quotes group blanks into a token.
+std::vector<std::string> tokenize(const std::string &line)
+{
+    std::vector<std::string> tokens;
+    std::string token;
+    bool inToken = false;
+    bool quoted = false;
+    for (char c : line)
+    {
+        if (c == '"')
+        {
+            quoted = !quoted;
+            inToken = true;
+        } else if ((c == ' ' || c == '\t' || c == '\r') && !quoted)
+        {
+            if (inToken)
+                tokens.push_back(token);
+            token.clear();
+            inToken = false;
+        } else {
+            token += c;
+            inToken = true;
+        }
+    }
+    if (inToken)
+        tokens.push_back(token);
+    return tokens;
+}
+
+std::string currentDirectory()
+{
+    char buf[4096];
+#ifdef _WIN32
+    if (_getcwd(buf, sizeof(buf)) == nullptr)
+#else
+    if (getcwd(buf, sizeof(buf)) == nullptr)
+#endif
+        return ".";
+    return buf;
+}
+
+bool changeDirectory(const std::string &dir)
+{
+#ifdef _WIN32
+    return _chdir(dir.c_str()) == 0;
+#else
+    return chdir(dir.c_str()) == 0;
+#endif
+}
+
+/// Create a directory and its parent directories; existing directories are fine.
+void makeDirectories(const std::string &dir)
+{
+    for (std::size_t pos = dir.find_first_of("/\\", 1); ; pos = dir.find_first_of("/\\", pos+1))
+    {
+        const std::string parent = dir.substr(0, pos);
+#ifdef _WIN32
+        _mkdir(parent.c_str());
+#else
+        mkdir(parent.c_str(), 0777);
+#endif
+        if (pos == std::string::npos)
+            break;
+    }
+}
+
+bool isAbsolute(const std::string &path)
+{
+    return !path.empty() && (path[0] == '/' || path[0] == '\\' || (path.size() > 1 && path[1] == ':'));
+}
+
+std::string resolvePath(const std::string &baseDir, const std::string &path)
+{
+    if (isAbsolute(path))
+        return path;
+    return baseDir + "/" + path;
+}
+
+/// Drop "." components, ".." components with their parent, and duplicate and trailing separators.
+std::string normalizePath(const std::string &path)
+{
+    std::vector<std::string> parts;
+    std::size_t start = 0;
+    while (start <= path.size())
+    {
+        std::size_t end = path.find_first_of("/\\", start);
+        if (end == std::string::npos)
+            end = path.size();
+        const std::string part = path.substr(start, end-start);
+        if (part == ".." && !parts.empty() && !parts.back().empty() && parts.back() != "..")
+            parts.pop_back();
+        else if (part != "." && (!part.empty() || parts.empty()))
+            parts.push_back(part);
+        start = end+1;
+    }
+    std::string normalized;
+    for (std::size_t i=0; i<parts.size(); i++)
+        normalized += (i>0 ? "/" : "") + parts[i];
+    return normalized;
+}
+
+/// Replace characters that would break the summary table.
+std::string sanitize(std::string value)
+{
+    for (char &c : value)
+    {
+        if (c == '\t' || c == '\n' || c == '\r')
+            c = ' ';
+    }
+    return value;
+}
+
+} // anonymous namespace
+
+bool BatchRunner::readJobFile(const std::string &file, std::ostream &err)
+{
+    jobList.clear();
+    std::ifstream input(file);
+    if (!input)
+    {
+        err << "Could not open job file " << file << "\n";
+        return false;
+    }
+    const std::string jobFile = resolvePath(currentDirectory(), file);
+    const std::string baseDir = jobFile.substr(0, jobFile.find_last_of("/\\"));
+
+    // jobs in the same directory would overwrite each other's results and log
+    std::map<std::string,int> jobInDir;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(input, line))
+    {
+        lineNumber++;
+        const std::vector<std::string> tokens = tokenize(line);
+        if (tokens.empty() || tokens[0][0] == '#')
+            continue;
+
+        BatchJob job;
+        job.number = (int)jobList.size() + 1;
+        job.script = resolvePath(baseDir, tokens[0]);
+        for (std::size_t i=1; i<tokens.size(); i++)
+        {
+            const std::size_t pos = tokens[i].find('=');
+            if (pos == std::string::npos || pos == 0)
+            {
+                err << file << ":" << lineNumber << ": Expected name=value, but got \"" << tokens[i] << "\"\n";
+                return false;
+            }
+            const std::string name = tokens[i].substr(0, pos);
+            const std::string value = tokens[i].substr(pos+1);
+            if (name == "dir")
+                job.workDir = resolvePath(baseDir, value);
+            else
+                job.globals.push_back(std::make_pair(name, value));
+        }
+        if (job.workDir.empty())
+            job.workDir = jobFile + "." + std::to_string(job.number);
+        const auto inserted = jobInDir.insert(std::make_pair(normalizePath(job.workDir), job.number));
+        if (!inserted.second)
+        {
+            err << file << ":" << lineNumber << ": Directory " << job.workDir
+                << " is already used by job " << inserted.first->second << "\n";
+            return false;
+        }
+        jobList.push_back(job);
+    }
+    return true;
+}
+
+int BatchRunner::run(int numWorkers, const JobFunction &runJob)
+{
+    if (numWorkers < 1)
+        numWorkers = 1;
+    results.assign(jobList.size(), JobResult());
+    int failed = 0;
+    using clock = std::chrono::steady_clock;
+    std::vector<clock::time_point> startTime(jobList.size());
+
+#ifndef _WIN32
+    std::map<pid_t,int> running;
+    std::size_t next = 0;
+    while (next < jobList.size() || !running.empty())
+    {
+        while (next < jobList.size() && (int)running.size() < numWorkers)
+        {
+            // don't let the job process write buffered output a second time
+            std::cout.flush();
+            std::cerr.flush();
+            fflush(nullptr);
+            startTime[next] = clock::now();
+            pid_t pid = fork();
+            if (pid == 0)
+                _exit(runInWorkDir(jobList[next], runJob, true));
+            if (pid < 0)
+            {
+                results[next].status = "error";
+                std::cerr << "Could not start job " << jobList[next].number << "\n";
+                failed++;
+            } else {
+                running[pid] = (int)next;
+            }
+            next++;
+        }
+
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0 && errno == EINTR)
+            continue;
+        if (pid < 0)
+            break;
+        auto it = running.find(pid);
+        if (it == running.end())
+            continue;
+        const int i = it->second;
+        running.erase(it);
+
+        JobResult &result = results[i];
+        result.seconds = std::chrono::duration<double>(clock::now() - startTime[i]).count();
+        if (WIFEXITED(status))
+            readResultFile(jobList[i], WEXITSTATUS(status), result);
+        else
+            result.status = "crashed";
+        if (result.status != "ok")
+            failed++;
+        reportProgress(jobList[i], result);
+    }
+#else
+    // no fork(): run the jobs one after the other, and restore the working directory after each job
+    const std::string cwd = currentDirectory();
+    for (std::size_t i=0; i<jobList.size(); i++)
+    {
+        startTime[i] = clock::now();
+        int exitCode = runInWorkDir(jobList[i], runJob, false);
+        changeDirectory(cwd);
+        JobResult &result = results[i];
+        result.seconds = std::chrono::duration<double>(clock::now() - startTime[i]).count();
+        readResultFile(jobList[i], exitCode, result);
+        if (result.status != "ok")
+            failed++;
+        reportProgress(jobList[i], result);
+    }
+#endif
+    return failed;
+}
+
+bool BatchRunner::writeSummary(const std::string &file, std::ostream &err) const
+{
+    std::ofstream out(file);
+    if (!out)
+    {
+        err << "Could not write summary file " << file << "\n";
+        return false;
+    }
+    out << "job\tscript\tdir\tstatus\tseconds";
+    for (const std::string &name : collectedGlobals)
+        out << "\t" << name;
+    out << "\n";
+    for (std::size_t i=0; i<results.size(); i++)
+    {
+        const BatchJob &job = jobList[i];
+        const JobResult &result = results[i];
+        out << job.number << "\t" << job.script << "\t" << job.workDir
+            << "\t" << result.status
+            << "\t" << std::fixed << std::setprecision(3) << result.seconds;
+        for (std::size_t k=0; k<collectedGlobals.size(); k++)
+            out << "\t" << (k < result.values.size() ? result.values[k] : "");
+        out << "\n";
+    }
+    return (bool)out;
+}
+
+void BatchRunner::setGlobals(femm::LuaInstance &li, const BatchJob &job)
+{
+    lua_State *L = li.getLuaState();
+    for (const auto &global : job.globals)
+    {
+        const std::string &value = global.second;
+        char *end = nullptr;
+        double number = std::strtod(value.c_str(), &end);
+        if (!value.empty() && *end == '\0')
+            lua_pushnumber(L, number);
+        else
+            lua_pushstring(L, value.c_str());
+        lua_setglobal(L, global.first.c_str());
+    }
+}
+
+std::vector<std::string> BatchRunner::getGlobals(femm::LuaInstance &li, const std::vector<std::string> &names)
+{
+    lua_State *L = li.getLuaState();
+    std::vector<std::string> values;
+    for (const std::string &name : names)
+    {
+        lua_getglobal(L, name.c_str()); //+1
+        const char *value = nullptr;
+        if (lua_isnumber(L, -1) || lua_isstring(L, -1))
+            value = lua_tostring(L, -1);
+        values.push_back(sanitize(value ? value : ""));
+        lua_pop(L, 1); //-1
+    }
+    return values;
+}
+
+int BatchRunner::runInWorkDir(const BatchJob &job, const JobFunction &runJob, bool redirectOutput) const
+{
+    makeDirectories(job.workDir);
+    if (!changeDirectory(job.workDir))
+    {
+        std::cerr << "Job " << job.number << ": Could not change to working directory " << job.workDir << "\n";
+        return 2;
+    }
+#ifndef _WIN32
+    if (redirectOutput && std::freopen("femmcli.log", "w", stdout))
+        dup2(fileno(stdout), fileno(stderr));
+#else
+    (void)redirectOutput;
+#endif
+
+    std::vector<std::string> values;
+    int err = runJob(job, values);
+    {
+        // the job may have changed the current directory
+        std::ofstream out(job.workDir + "/" + resultFileName);
+        for (const std::string &value : values)
+            out << value << "\n";
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(nullptr);
+    return (err == 0) ? 0 : 1;
+}
+
+void BatchRunner::readResultFile(const BatchJob &job, int exitCode, JobResult &result) const
+{
+    result.status = (exitCode == 0) ? "ok" : "error";
+    const std::string file = job.workDir + "/" + resultFileName;
+    std::ifstream input(file);
+    std::string value;
+    while (input && std::getline(input, value))
+        result.values.push_back(value);
+    input.close();
+    std::remove(file.c_str());
+}
+
+void BatchRunner::reportProgress(const BatchJob &job, const JobResult &result) const
+{
+    if (quiet)
+        return;
+    std::ostringstream line;
+    line << "Job " << job.number << "/" << jobList.size() << ": " << result.status
+         << " (" << std::fixed << std::setprecision(2) << result.seconds << "s) "
+         << job.script << "\n";
+    std::cerr << line.str();
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
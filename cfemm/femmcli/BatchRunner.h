@@ -0,0 +1,144 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#ifndef FEMMCLI_BATCHRUNNER_H
+#define FEMMCLI_BATCHRUNNER_H
+
+#include "LuaInstance.h"
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace femmcli
+{
+
+/**
+ * @brief A job of a batch run, i.e. one line of the job file.
+ */
+struct BatchJob
+{
+    int number = 0;          ///< \brief position of the job in the job file, counting from 1
+    std::string script;      ///< \brief the lua script
+    std::string workDir;     ///< \brief working directory of the job
+    /// \brief lua globals that are set before the script is run, as (name, value) pairs
+    std::vector< std::pair<std::string,std::string> > globals;
+};
+
+/**
+ * @brief The BatchRunner class runs the jobs of a job file concurrently.
+ *
+ * Job file format
+ * ---------------
+ * One job per line; empty lines and lines starting with \c # are ignored:
+ *
+ *     <script.lua> [dir=<working directory>] [<name>=<value>]...
+ *
+ * Each \c name=value pair sets a lua global before the script is run.
+ * Values that are numbers are set as numbers, all other values as strings.
+ * Tokens are separated by blanks; use double quotes for values that contain blanks.
+ * Relative paths are relative to the directory of the job file.
+ * Without \c dir=, job \c n runs in the directory \c "<job file>.<n>".
+ * Missing working directories are created.
+ * Every job needs a working directory of its own, since the result file and the log
+ * are written there; a job file that uses a directory twice is rejected.
+ *
+ * Execution
+ * ---------
+ * The working directory and the mesher are process wide, so each job runs in a process of its own
+ * that is forked from femmcli, with its own FemmState and Lua interpreter.
+ * The output of a job goes to \c femmcli.log in its working directory.
+ * On platforms without \c fork(), the jobs run one after the other in the femmcli process.
+ *
+ * Summary file
+ * ------------
+ * A tab separated table with a header line, and one line per job:
+ * job number, script, working directory, status, run time in seconds,
+ * followed by the values of the collected lua globals after the script has run.
+ * The status is \c ok, \c error for lua errors, or \c crashed if the job process died.
+ */
+class BatchRunner
+{
+public:
+    /**
+     * @brief A function that runs a job in the current process, in the working directory of the job.
+     * It returns 0 on success, and stores the values of the collected globals in its second argument.
+     */
+    using JobFunction = std::function<int(const BatchJob &job, std::vector<std::string> &values)>;
+
+    /// \brief Names of the lua globals that are collected into the summary
+    std::vector<std::string> collectedGlobals;
+    /// \brief If set, do not report the progress
+    bool quiet = false;
+
+    /**
+     * @brief Read the jobs from a job file.
+     * @param file
+     * @param err output stream for error messages
+     * @return \c true on success, \c false otherwise.
+     */
+    bool readJobFile(const std::string &file, std::ostream &err = std::cerr);
+
+    /**
+     * @brief Run all jobs.
+     * @param numWorkers the number of jobs that run at the same time
+     * @param runJob the function that runs a job
+     * @return the number of jobs that failed
+     */
+    int run(int numWorkers, const JobFunction &runJob);
+
+    /**
+     * @brief Write the summary of the last run().
+     * @param file
+     * @param err output stream for error messages
+     * @return \c true on success, \c false otherwise.
+     */
+    bool writeSummary(const std::string &file, std::ostream &err = std::cerr) const;
+
+    const std::vector<BatchJob> &jobs() const { return jobList; }
+
+    /**
+     * @brief Set the globals of a job in a lua instance.
+     * @param li
+     * @param job
+     */
+    static void setGlobals(femm::LuaInstance &li, const BatchJob &job);
+    /**
+     * @brief Get the values of lua globals as strings.
+     * Numbers are formatted as lua does, and undefined globals are empty.
+     * @param li
+     * @param names
+     * @return the values
+     */
+    static std::vector<std::string> getGlobals(femm::LuaInstance &li, const std::vector<std::string> &names);
+
+private:
+    /// \brief The result of a job
+    struct JobResult
+    {
+        std::string status;
+        double seconds = 0;
+        std::vector<std::string> values;
+    };
+
+    /// Set up the working directory of a job, run it, and store the outcome in its result file.
+    int runInWorkDir(const BatchJob &job, const JobFunction &runJob, bool redirectOutput) const;
+    /// Read the result file of a job, and remove it.
+    void readResultFile(const BatchJob &job, int exitCode, JobResult &result) const;
+    void reportProgress(const BatchJob &job, const JobResult &result) const;
+
+    std::vector<BatchJob> jobList;
+    std::vector<JobResult> results;
+};
+
+} // namespace femmcli
+
+#endif
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -62,16 +62,38 @@ const std::shared_ptr<fmesher::FMesher> femmcli::FemmState::getMesher()
     return current.mesher;
 }
 
+const std::shared_ptr<fmesher::MeshCache> femmcli::FemmState::meshCache()
+{
+    if (!m_meshCache)
+        m_meshCache = std::make_shared<fmesher::MeshCache>();
+    return m_meshCache;
+}
+
 void femmcli::FemmState::closeSolution()
 {
     current.postProcessor.reset();
 }
 
+void femmcli::FemmState::setSolution(const std::string &pathName, std::shared_ptr<const femm::SolutionData> sol)
+{
+    current.solutionPathName = sol ? pathName : std::string();
+    current.solution = sol;
+}
+
+std::shared_ptr<const femm::SolutionData> femmcli::FemmState::solution(const std::string &pathName) const
+{
+    if (current.solution && current.solutionPathName == pathName)
+        return current.solution;
+    return nullptr;
+}
+
 void femmcli::FemmState::close()
 {
     current.document.reset();
     current.mesher.reset();
     current.postProcessor.reset();
+    current.solutionPathName.clear();
+    current.solution.reset();
 }
 
 void femmcli::FemmState::deactivateProblemSet()
@@ -24,8 +24,10 @@
 #include "fmesher.h"
 #include "fsolver.h"
 #include "PostProcessor.h"
+#include "SolutionData.h"
 
 #include <memory>
+#include <string>
 
 namespace femmcli
 {
@@ -64,8 +66,10 @@ namespace femmcli
  *    and store the result to disk.<br/>
  *    → additional mesh files (\c .edge, \c .ele, \c .node, \c .pbc) are generated
  * 4. LuaMagneticsCommands::luaAnalyze() runs the solver and stores the solution to disk.<br/>
- *    → the mesh files are removed, and a solution file \c .ans is generated
- * 5. LuaMagneticsCommands::luaLoadSolution() reads the solution file into memory.
+ *    → the mesh files are removed, and a solution file \c .ans is generated<br/>
+ *    The magnetics solver additionally hands its solution to the FemmState (see setSolution()).
+ * 5. LuaMagneticsCommands::luaLoadSolution() reads the solution file into memory,
+ *    or takes the solution handed over by the solver if there is one.
  *    The solution data is available for lua commands (mo_*).<br/>
  *    → the data is in memory in postProcessor
  *
@@ -110,12 +114,36 @@ public:
      */
     const std::shared_ptr<fmesher::FMesher> getMesher();
 
+    /**
+     * @brief The mesh cache of the session.
+     * The cache is shared by all problem sets, so that switching between documents
+     * or reopening a file does not discard cached triangulations.
+     * @return the mesh cache (never \c nullptr)
+     */
+    const std::shared_ptr<fmesher::MeshCache> meshCache();
     /**
      * @brief Invalidate the current solution data stored in postProcessor.
      * When a new solution is available, call this method before loading it.
      */
     void closeSolution();
 
+    /**
+     * @brief Remember a solution that was computed in memory.
+     * A subsequent call to solution() with the same \p pathName returns the stored data,
+     * which allows the post processor to skip reading the solution file.
+     * Only one solution is kept per problem set; storing a new solution replaces the old one.
+     * @param pathName the path of the problem file the solution belongs to
+     * @param sol the solution data, or \c nullptr to discard the stored solution
+     */
+    void setSolution(const std::string &pathName, std::shared_ptr<const femm::SolutionData> sol);
+
+    /**
+     * @brief Get the solution that was stored for the given problem file.
+     * @param pathName the path of the problem file
+     * @return the solution data, or \c nullptr if no solution is stored for \p pathName
+     */
+    std::shared_ptr<const femm::SolutionData> solution(const std::string &pathName) const;
+
     /**
      * @brief Close and discard the current problem set.
      * After this operation, the current problem set is empty and you
@@ -147,10 +175,13 @@ private:
         std::shared_ptr<femm::FemmProblem> document;
         std::shared_ptr<fmesher::FMesher> mesher;
         std::shared_ptr<femm::PProcIface> postProcessor;
+        std::string solutionPathName;
+        std::shared_ptr<const femm::SolutionData> solution;
     };
 
     ProblemSet current;
     std::vector<ProblemSet> inactiveProblems;
+    std::shared_ptr<fmesher::MeshCache> m_meshCache;
 
 
 };
@@ -18,12 +18,15 @@
 
 #include "LuaCommonCommands.h"
 
+#include "ErrorEstimate.h"
 #include "femmconstants.h"
 #include "femmenums.h"
 #include "FemmState.h"
+#include "fpproc.h"
 #include "locationTools.h"
 #include "LuaInstance.h"
 #include "MatlibReader.h"
+#include "nodeordering.h"
 #include "stringTools.h"
 
 #include <lua.h>
@@ -102,6 +105,95 @@ void femmcli::luaDebugWriteFEMFile(lua_State *L)
     doc->saveFEMFile(fileName);
 }
 
+void femmcli::luaConfigureMeshCache(lua_State *L, fmesher::FMesher &mesher)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+
+    // the cache is enabled by default:
+    bool ok=false;
+    const bool useCache = (luaInstance->getGlobal("XFEMM_MESH_CACHE", &ok) != 0) || !ok;
+    if (useCache)
+        mesher.meshCache = femmState->meshCache();
+    else
+        mesher.meshCache.reset();
+
+    // mesh morphing is disabled by default:
+    const double morphMinAngle = luaInstance->getGlobal("XFEMM_MESH_MORPH", &ok).re;
+    mesher.morphMinAngle = (ok && morphMinAngle > 0) ? morphMinAngle : 0;
+}
+
+int femmcli::luaAnalyzeAdaptive(lua_State *L, const std::string &command,
+                                const std::function<std::shared_ptr<fmesher::FMesher>()> &meshProblem,
+                                const AdaptiveSolveFunction &solve)
+{
+    if (!luaExpectParameterCount(L, 1, 3))
+        return 0;
+    const double targetError = lua_todouble(L,1);
+    int maxSteps = 5;
+    if (lua_gettop(L) > 1)
+        maxSteps = (int)lua_todouble(L,2);
+    double fraction = 0.5;
+    if (lua_gettop(L) > 2)
+        fraction = lua_todouble(L,3);
+    if (targetError <= 0 || maxSteps < 0 || fraction <= 0 || fraction > 1)
+    {
+        std::string msg = command + "(): The target error must be positive, the number of steps must not be negative,"
+                " and the fraction must be between 0 and 1\n";
+        lua_error(L, msg.c_str());
+        return 0;
+    }
+
+    std::shared_ptr<fmesher::FMesher> mesher = meshProblem();
+    if (!mesher)
+        return 0;
+
+    double relativeError = 0;
+    int step = 0;
+    for (;; step++)
+    {
+        if (!mesher->mesh)
+        {
+            lua_error(L, (command + "(): The mesh is not available in memory!\n").c_str());
+            return 0;
+        }
+        std::shared_ptr<const femm::SolutionData> solution;
+        std::vector<int> nodeNumbering;
+        std::vector<CComplex> coefficients;
+        if (!solve(mesher->mesh, solution, nodeNumbering, coefficients))
+        {
+            lua_error(L, "solver failed.");
+            return 0;
+        }
+        if (!solution || solution->numNodes() != mesher->mesh->numNodes()
+                || (!nodeNumbering.empty() && (int)nodeNumbering.size() != mesher->mesh->numNodes()))
+        {
+            lua_error(L, (command + "(): The solution does not match the mesh!\n").c_str());
+            return 0;
+        }
+
+        femm::ErrorEstimate estimate(*mesher->mesh, *solution, nodeNumbering, coefficients);
+        relativeError = estimate.relativeError();
+        if (mesher->Verbose)
+        {
+            std::cout << command << "(): step " << step << ", " << mesher->mesh->numElements()
+                      << " elements, estimated relative error " << relativeError << std::endl;
+        }
+        if (relativeError <= targetError || step == maxSteps)
+            break;
+        if (mesher->refineMesh(estimate.refinementAreas(fraction)) != 0)
+        {
+            lua_error(L, (command + "(): Mesh refinement failed!\n").c_str());
+            return 0;
+        }
+    }
+
+    lua_pushnumber(L, relativeError);
+    lua_pushnumber(L, mesher->mesh->numElements());
+    lua_pushnumber(L, step);
+    return 3;
+}
+
 /**
  * @brief Add a new arc segment.
  * Add a new arc segment from the nearest node to (x1,y1) to the
@@ -190,23 +282,7 @@ int femmcli::LuaCommonCommands::luaAddBlocklabel(lua_State *L)
     double x = lua_todouble(L,1);
     double y = lua_todouble(L,2);
 
-    double d;
-    if (doc->nodelist.size()<2)
-        d = 1.e-08;
-    else{
-        CComplex p0,p1,p2;
-        p0 = doc->nodelist[0]->CC();
-        p1 = p0;
-        for (int i=1; i<(int)doc->nodelist.size(); i++)
-        {
-            p2 = doc->nodelist[i]->CC();
-            if(p2.re<p0.re) p0.re = p2.re;
-            if(p2.re>p1.re) p1.re = p2.re;
-            if(p2.im<p0.im) p0.im = p2.im;
-            if(p2.im>p1.im) p1.im = p2.im;
-        }
-        d = abs(p1-p0)*CLOSE_ENOUGH;
-    }
+    double d = doc->defaultTolerance();
     doc->addBlockLabel(x,y,d);
 
     //BOOL flag=thisDoc->AddBlockLabel(x,y,d);
@@ -382,23 +458,7 @@ int femmcli::LuaCommonCommands::luaAddNode(lua_State *L)
     double x=lua_todouble(L,1);
     double y=lua_todouble(L,2);
 
-    double d;
-    if ((int)doc->nodelist.size()<2) {
-        d=1.e-08;
-    } else {
-        CComplex p0,p1,p2;
-        p0=doc->nodelist[0]->CC();
-        p1=p0;
-        for(int i=1; i< (int)doc->nodelist.size(); i++)
-        {
-            p2=doc->nodelist[i]->CC();
-            if(p2.re<p0.re) p0.re=p2.re;
-            if(p2.re>p1.re) p1.re=p2.re;
-            if(p2.im<p0.im) p0.im=p2.im;
-            if(p2.im>p1.im) p1.im=p2.im;
-        }
-        d=abs(p1-p0)*CLOSE_ENOUGH;
-    }
+    double d = doc->defaultTolerance();
     doc->addNode(x,y,d);
 
     //BOOL flag=doc->AddNode(x,y,d);
@@ -1688,6 +1748,15 @@ int femmcli::LuaCommonCommands::luaLoadSolution(lua_State *L)
         lua_error(L,"No output in focus!");
         return 0;
     }
+    // use the solution handed over by mi_analyze(), if available:
+    std::shared_ptr<const femm::SolutionData> solution = femmState->solution(doc->pathName);
+    std::shared_ptr<FPProc> fpproc = std::dynamic_pointer_cast<FPProc>(pproc);
+    if (solution && fpproc)
+    {
+        if (!fpproc->OpenDocument(*solution))
+            lua_error(L, "loadsolution(): error while loading solution data\n");
+        return 0;
+    }
     if (!pproc->OpenDocument(solutionFile))
     {
         std::string msg = "loadsolution(): error while loading solution file:\n";
@@ -2025,6 +2094,9 @@ int femmcli::LuaCommonCommands::luaCreateMesh(lua_State *L)
     }
 
     //BeginWaitCursor();
+    // LoadMesh() reads the mesh files
+    mesher->writeMeshFiles = true;
+    luaConfigureMeshCache(L, *mesher);
     if (mesher->HasPeriodicBC()){
         if (mesher->DoPeriodicBCTriangulation(pathName) != 0)
         {
@@ -2883,6 +2955,36 @@ int femmcli::LuaCommonCommands::luaSetEditMode(lua_State *L)
     return 0;
 }
 
+/**
+ * @brief Select whether the solver keeps its preconditioner in single precision.
+ * The Krylov iteration and its residuals stay in double precision,
+ * so the precision of the solution does not change.
+ * @param L
+ * @return 0
+ * \ingroup LuaCommon
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mi_setfloatpreconditioner(flag)}
+ * - \lua{ei_setfloatpreconditioner(flag)}
+ * - \lua{hi_setfloatpreconditioner(flag)}
+ *   flag is 1 to store the preconditioner in single precision, 0 to store it in double precision (default).
+ *   This sets the [FloatPreconditioner] property of the problem file.
+ *
+ * \note This function does not exist in FEMM42.
+ * \endinternal
+ */
+int femmcli::LuaCommonCommands::luaSetFloatPreconditioner(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<FemmProblem> doc = femmState->femmDocument();
+
+    luaExpectParameterCount(L, 1);
+    doc->FloatPreconditioner = (lua_tonumber(L,1) != 0);
+    return 0;
+}
+
 /**
  * @brief Set the currently active problem set.
  *
@@ -2988,6 +3090,83 @@ int femmcli::LuaCommonCommands::luaSetGroup(lua_State *L)
     return 0;
 }
 
+/**
+ * @brief Select how the solver sorts the mesh elements.
+ * @param L
+ * @return 0
+ * \ingroup LuaCommon
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mi_setelementordering(ordering)}
+ * - \lua{ei_setelementordering(ordering)}
+ * - \lua{hi_setelementordering(ordering)}
+ *   ordering is one of:
+ *   0 -- sum of the node numbers, the same order as FEMM (default)
+ *   1 -- position of the centroid along a Hilbert curve
+ *   2 -- position of the centroid along a Morton curve
+ *   This sets the [ElementOrdering] property of the problem file.
+ *
+ * \note This function does not exist in FEMM42.
+ * \endinternal
+ */
+int femmcli::LuaCommonCommands::luaSetElementOrdering(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<FemmProblem> doc = femmState->femmDocument();
+
+    luaExpectParameterCount(L, 1);
+    int ordering = (int)lua_todouble(L,1);
+    if (ordering < femm::ElementNodeSum || ordering > femm::ElementMortonCurve)
+    {
+        lua_error(L, "mi_setelementordering(): Invalid value of ordering!\n");
+        return 0;
+    }
+    doc->ElementOrdering = ordering;
+    return 0;
+}
+
+/**
+ * @brief Select how the solver numbers the mesh nodes.
+ * @param L
+ * @return 0
+ * \ingroup LuaCommon
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mi_setnodeordering(ordering)}
+ * - \lua{ei_setnodeordering(ordering)}
+ * - \lua{hi_setnodeordering(ordering)}
+ *   ordering is one of:
+ *   0 -- Cuthill-McKee, the same numbering as FEMM (default)
+ *   1 -- reverse Cuthill-McKee, starting at a pseudo-peripheral node
+ *   2 -- position along a Hilbert curve
+ *   3 -- position along a Morton curve
+ *   4 -- approximate minimum degree
+ *   5 -- nested dissection
+ *   This sets the [NodeOrdering] property of the problem file.
+ *
+ * \note This function does not exist in FEMM42.
+ * \endinternal
+ */
+int femmcli::LuaCommonCommands::luaSetNodeOrdering(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<FemmProblem> doc = femmState->femmDocument();
+
+    luaExpectParameterCount(L, 1);
+    int ordering = (int)lua_todouble(L,1);
+    if (ordering < femm::CuthillMcKee || ordering > femm::NestedDissection)
+    {
+        lua_error(L, "mi_setnodeordering(): Invalid value of ordering!\n");
+        return 0;
+    }
+    doc->NodeOrdering = ordering;
+    return 0;
+}
+
 /**
  * @brief Set the nodal property for selected nodes.
  * @param L
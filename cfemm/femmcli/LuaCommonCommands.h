@@ -18,10 +18,22 @@
 #ifndef LUACOMMONCOMMANDS_H
 #define LUACOMMONCOMMANDS_H
 
+#include "femmcomplex.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
 struct lua_State;
 
 namespace femm {
 class LuaInstance;
+class MeshData;
+class SolutionData;
+}
+namespace fmesher {
+class FMesher;
 }
 
 namespace femmcli
@@ -67,6 +79,46 @@ bool luaExpectParameterCount(lua_State *L, int expected);
  */
 void luaDebugWriteFEMFile(lua_State *L);
 
+/**
+ * @brief luaConfigureMeshCache attaches the session's mesh cache to a mesher.
+ * The cache is used unless the global variable "XFEMM_MESH_CACHE" is set to 0.
+ * If the global variable "XFEMM_MESH_MORPH" is set to a positive angle [deg], a cached mesh is morphed
+ * when only the positions of the nodes have changed, as long as its elements keep that minimum angle
+ * (see fmesher::FMesher::morphMinAngle).
+ *
+ * @param L
+ * @param mesher
+ */
+void luaConfigureMeshCache(lua_State *L, fmesher::FMesher &mesher);
+
+/**
+ * @brief Solves a problem on a mesh for luaAnalyzeAdaptive().
+ * It returns \c false if the solver failed, and otherwise stores the solution, the node numbering of the solver,
+ * and the material coefficients of each element of the solution (see femm::ErrorEstimate).
+ */
+using AdaptiveSolveFunction = std::function<bool(std::shared_ptr<const femm::MeshData> mesh,
+        std::shared_ptr<const femm::SolutionData> &solution, std::vector<int> &nodeNumbering,
+        std::vector<CComplex> &coefficients)>;
+
+/**
+ * @brief luaAnalyzeAdaptive implements the adaptive mesh refinement loop of mi_analyzeadaptive, ei_analyzeadaptive and hi_analyzeadaptive.
+ *
+ * The lua parameters are (targeterror[,maxsteps[,fraction]]).
+ * The problem is meshed and solved, and the relative error is estimated (see femm::ErrorEstimate).
+ * Until it is below targeterror, or maxsteps (default: 5) refinement steps have been made,
+ * the elements that make up fraction (default: 0.5) of the estimated error are refined, and the problem is solved again.
+ * The estimated relative error, the number of elements and the number of refinement steps are returned to lua.
+ *
+ * @param L
+ * @param command the name of the lua command, for error messages
+ * @param meshProblem meshes the problem; it returns \c nullptr after raising a lua error
+ * @param solve solves the problem on a mesh
+ * @return the number of lua results
+ */
+int luaAnalyzeAdaptive(lua_State *L, const std::string &command,
+                       const std::function<std::shared_ptr<fmesher::FMesher>()> &meshProblem,
+                       const AdaptiveSolveFunction &solve);
+
 /**
  * LuaCommonCommands provides lua commands which are shared between different modules.
  * These commands are registered by the individual module's registerCommands().
@@ -135,8 +187,11 @@ int luaSelectWithinCircle(lua_State *L);
 int luaSelectWithinRectangle(lua_State *L);
 int luaSetBlocklabelProperty(lua_State *L);
 int luaSetEditMode(lua_State *L);
+int luaSetElementOrdering(lua_State *L);
+int luaSetFloatPreconditioner(lua_State *L);
 int luaSetFocus(lua_State *L);
 int luaSetGroup(lua_State *L);
+int luaSetNodeOrdering(lua_State *L);
 int luaSetNodeProperty(lua_State *L);
 int luaSetSegmentProperty(lua_State *L);
 int luaSetSmoothing(lua_State *L);
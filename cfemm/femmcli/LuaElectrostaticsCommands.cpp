@@ -66,6 +66,8 @@ void femmcli::LuaElectrostaticsCommands::registerCommands(LuaInstance &li)
     li.addFunction("ei_addsegment", LuaCommonCommands::luaAddLine);
     li.addFunction("ei_analyse", luaAnalyze);
     li.addFunction("ei_analyze", luaAnalyze);
+    li.addFunction("ei_analyze_adaptive", luaAnalyzeAdaptive);
+    li.addFunction("ei_analyzeadaptive", luaAnalyzeAdaptive);
     li.addFunction("ei_attach_default", LuaCommonCommands::luaAttachDefault);
     li.addFunction("ei_attachdefault", LuaCommonCommands::luaAttachDefault);
     li.addFunction("ei_attach_outer_space", LuaCommonCommands::luaAttachOuterSpace);
@@ -173,12 +175,18 @@ void femmcli::LuaElectrostaticsCommands::registerCommands(LuaInstance &li)
     li.addFunction("ei_setblockprop", LuaCommonCommands::luaSetBlocklabelProperty);
     li.addFunction("ei_set_edit_mode", LuaCommonCommands::luaSetEditMode);
     li.addFunction("ei_seteditmode", LuaCommonCommands::luaSetEditMode);
+    li.addFunction("ei_set_float_preconditioner", LuaCommonCommands::luaSetFloatPreconditioner);
+    li.addFunction("ei_setfloatpreconditioner", LuaCommonCommands::luaSetFloatPreconditioner);
     li.addFunction("ei_set_focus", LuaCommonCommands::luaSetFocus);
     li.addFunction("ei_setfocus", LuaCommonCommands::luaSetFocus);
     li.addFunction("ei_set_grid", LuaInstance::luaNOP);
     li.addFunction("ei_setgrid", LuaInstance::luaNOP);
     li.addFunction("ei_set_group", LuaCommonCommands::luaSetGroup);
     li.addFunction("ei_setgroup", LuaCommonCommands::luaSetGroup);
+    li.addFunction("ei_set_element_ordering", LuaCommonCommands::luaSetElementOrdering);
+    li.addFunction("ei_setelementordering", LuaCommonCommands::luaSetElementOrdering);
+    li.addFunction("ei_set_node_ordering", LuaCommonCommands::luaSetNodeOrdering);
+    li.addFunction("ei_setnodeordering", LuaCommonCommands::luaSetNodeOrdering);
     li.addFunction("ei_set_node_prop", LuaCommonCommands::luaSetNodeProperty);
     li.addFunction("ei_setnodeprop", LuaCommonCommands::luaSetNodeProperty);
     li.addFunction("ei_set_segment_prop", LuaCommonCommands::luaSetSegmentProperty);
@@ -425,27 +433,19 @@ int femmcli::LuaElectrostaticsCommands::luaAddPointProperty(lua_State *L)
     return 0;
 }
 
+namespace {
+
 /**
- * @brief Mesh the problem description, save it, and run the solver.
- * If the global variable "XFEMM_VERBOSE" is set to 1, the mesher and solver is more verbose and prints statistics.
+ * @brief Check the problem description, save it, and mesh it.
+ * This is everything ei_analyze does before calling the solver.
  * @param L
- * @return 0
- * \ingroup LuaES
- *
- * \internal
- * ### Implements:
- * - \lua{ei_analyse(flag)}
- *   Parameter flag (0,1) determines visibility of fkern window and is ignored on xfemm.
- *
- * ### FEMM sources:
- * - \femm42{femm/beladrawLua.cpp,lua_analyze()}
- * - \femm42{femm/beladrawView.cpp,CbeladrawView::OnMenuAnalyze()}
- * \endinternal
+ * @param command the name of the lua command, for error messages
+ * @return the mesher, or \c nullptr after raising a lua error
  */
-int femmcli::LuaElectrostaticsCommands::luaAnalyze(lua_State *L)
+std::shared_ptr<fmesher::FMesher> meshProblem(lua_State *L, const std::string &command)
 {
     auto luaInstance = LuaInstance::instance(L);
-    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<femmcli::FemmState> femmState = std::dynamic_pointer_cast<femmcli::FemmState>(luaInstance->femmState());
     std::shared_ptr<femm::FemmProblem> doc = femmState->femmDocument();
 
     // check to see if all blocklabels are kosher...
@@ -453,7 +453,7 @@ int femmcli::LuaElectrostaticsCommands::luaAnalyze(lua_State *L)
         std::string msg = "No block information has been defined\n"
                           "Cannot analyze the problem";
         lua_error(L, msg.c_str());
-        return 0;
+        return nullptr;
     }
 
     bool hasMissingBlockProps = false;
@@ -484,7 +484,7 @@ int femmcli::LuaElectrostaticsCommands::luaAnalyze(lua_State *L)
                             "been defined for all block labels.\n"
                             "Cannot analyze the problem";
         lua_error(L,ermsg.c_str());
-        return 0;
+        return nullptr;
     }
 
 
@@ -500,7 +500,7 @@ int femmcli::LuaElectrostaticsCommands::luaAnalyze(lua_State *L)
                                     "r>=0 for axisymmetric problems.\n"
                                     "Cannot analyze the problem.";
                 lua_error(L,ermsg.c_str());
-                return 0;
+                return nullptr;
             }
         }
 
@@ -534,7 +534,7 @@ int femmcli::LuaElectrostaticsCommands::luaAnalyze(lua_State *L)
                                 "allowed in axisymmetric external regions.\n"
                                 "Cannot analyze the problem";
             lua_error(L,ermsg.c_str());
-            return 0;
+            return nullptr;
         }
 
         if (!hasExteriorProps)
@@ -545,7 +545,7 @@ int femmcli::LuaElectrostaticsCommands::luaAnalyze(lua_State *L)
                                 "have been adequately defined for the exterior region\n"
                                 "Cannot analyze the problem";
             lua_error(L,ermsg.c_str());
-            return 0;
+            return nullptr;
         }
     }
 
@@ -553,17 +553,17 @@ int femmcli::LuaElectrostaticsCommands::luaAnalyze(lua_State *L)
     if (pathName.empty())
     {
         lua_error(L,"A data file must be loaded,\nor the current data must saved.");
-        return 0;
+        return nullptr;
     }
     if (!doc->saveFEMFile(pathName))
     {
-        lua_error(L, "ei_analyze(): Could not save fem file!\n");
-        return 0;
+        lua_error(L, (command + "(): Could not save fem file!\n").c_str());
+        return nullptr;
     }
     if (!doc->consistencyCheckOK())
     {
-        lua_error(L,"ei_analyze(): consistency check failed before meshing!\n");
-        return 0;
+        lua_error(L,(command + "(): consistency check failed before meshing!\n").c_str());
+        return nullptr;
     }
 
     //BeginWaitCursor();
@@ -571,30 +571,68 @@ int femmcli::LuaElectrostaticsCommands::luaAnalyze(lua_State *L)
     // allow setting verbosity from lua:
     const bool verbose = (luaInstance->getGlobal("XFEMM_VERBOSE") != 0);
     mesherDoc->Verbose = verbose;
+    // hand the mesh to the solver in memory
+    mesherDoc->writeMeshFiles = false;
+    femmcli::luaConfigureMeshCache(L, *mesherDoc);
     if (mesherDoc->HasPeriodicBC()){
         if (mesherDoc->DoPeriodicBCTriangulation(pathName) != 0)
         {
             //EndWaitCursor();
             mesherDoc->problem->unselectAll();
-            lua_error(L, "ei_analyze(): Periodic BC triangulation failed!\n");
-            return 0;
+            lua_error(L, (command + "(): Periodic BC triangulation failed!\n").c_str());
+            return nullptr;
         }
     }
     else{
         if (mesherDoc->DoNonPeriodicBCTriangulation(pathName) != 0)
         {
             //EndWaitCursor();
-            lua_error(L, "ei_analyze(): Nonperiodic BC triangulation failed!\n");
-            return 0;
+            lua_error(L, (command + "(): Nonperiodic BC triangulation failed!\n").c_str());
+            return nullptr;
         }
     }
     //EndWaitCursor();
     if (!doc->consistencyCheckOK())
     {
-        lua_error(L,"ei_analyze(): consistency check failed after meshing!\n");
-        return 0;
+        lua_error(L,(command + "(): consistency check failed after meshing!\n").c_str());
+        return nullptr;
     }
 
+    return mesherDoc;
+}
+
+} // anonymous namespace
+
+/**
+ * @brief Mesh the problem description, save it, and run the solver.
+ * If the global variable "XFEMM_VERBOSE" is set to 1, the mesher and solver is more verbose and prints statistics.
+ * Unless the global variable "XFEMM_MESH_CACHE" is set to 0, a cached mesh is reused if the geometry has not changed.
+ * If the global variable "XFEMM_MESH_MORPH" is set to a minimum element angle [deg], a cached mesh is morphed if only nodes have moved.
+ * @param L
+ * @return 0
+ * \ingroup LuaES
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{ei_analyse(flag)}
+ *   Parameter flag (0,1) determines visibility of fkern window and is ignored on xfemm.
+ *
+ * ### FEMM sources:
+ * - \femm42{femm/beladrawLua.cpp,lua_analyze()}
+ * - \femm42{femm/beladrawView.cpp,CbeladrawView::OnMenuAnalyze()}
+ * \endinternal
+ */
+int femmcli::LuaElectrostaticsCommands::luaAnalyze(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<femm::FemmProblem> doc = femmState->femmDocument();
+
+    std::shared_ptr<fmesher::FMesher> mesherDoc = meshProblem(L, "ei_analyze");
+    if (!mesherDoc)
+        return 0;
+    const bool verbose = mesherDoc->Verbose;
+
     ESolver theSolver;
     // filename.fee -> filename
     std::size_t dotpos = doc->pathName.find_last_of(".");
@@ -606,6 +644,8 @@ int femmcli::LuaElectrostaticsCommands::luaAnalyze(lua_State *L)
         lua_error(L, "ei_analyze(): problem initializing solver!");
         return 0;
     }
+    theSolver.meshData = mesherDoc->mesh;
+    theSolver.binarySolutionFile = (luaInstance->getGlobal("XFEMM_BINARY_SOLUTION") != 0);
     assert( doc->ACSolver == theSolver.ACSolver);
     assert( doc->lineproplist.size() == theSolver.lineproplist.size());
     assert( doc->nodeproplist.size() == theSolver.nodeproplist.size());
@@ -621,6 +661,63 @@ int femmcli::LuaElectrostaticsCommands::luaAnalyze(lua_State *L)
     return 0;
 }
 
+/**
+ * @brief Mesh the problem, and refine the mesh where the estimated error of the solution is largest,
+ * until the estimated error is small enough.
+ * If the global variable "XFEMM_VERBOSE" is set to 1, the estimated error of each step is printed.
+ * @param L
+ * @return 3
+ * \ingroup LuaES
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{ei_analyzeadaptive(targeterror[,maxsteps[,fraction]])}
+ *   Solves the problem, estimates the relative error from the jump of the normal electric flux density across the element edges,
+ *   and refines the elements that make up fraction (default: 0.5) of the estimated error,
+ *   until the estimated relative error is below targeterror or maxsteps (default: 5) refinement steps have been made.
+ *   Returns the estimated relative error, the number of elements, and the number of refinement steps.
+ *   The solution file holds the solution on the refined mesh.
+ *
+ * \note This function does not exist in FEMM42.
+ * \endinternal
+ */
+int femmcli::LuaElectrostaticsCommands::luaAnalyzeAdaptive(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<femm::FemmProblem> doc = femmState->femmDocument();
+
+    return femmcli::luaAnalyzeAdaptive(L, "ei_analyzeadaptive",
+                                       [&]() { return meshProblem(L, "ei_analyzeadaptive"); },
+                                       [&](std::shared_ptr<const femm::MeshData> mesh,
+                                           std::shared_ptr<const femm::SolutionData> &solution, std::vector<int> &nodeNumbering,
+                                           std::vector<CComplex> &coefficients)
+    {
+        ESolver theSolver;
+        // filename.fee -> filename
+        std::size_t dotpos = doc->pathName.find_last_of(".");
+        theSolver.PathName = doc->pathName.substr(0,dotpos);
+        theSolver.WarnMessage = &PrintWarningMsg;
+        theSolver.PrintMessage = &PrintWarningMsg;
+        if (!theSolver.LoadProblemFile())
+            return false;
+        theSolver.meshData = mesh;
+        theSolver.keepSolution = true;
+        theSolver.binarySolutionFile = (luaInstance->getGlobal("XFEMM_BINARY_SOLUTION") != 0);
+        if (!theSolver.runSolver(luaInstance->getGlobal("XFEMM_VERBOSE") != 0))
+            return false;
+        solution = theSolver.solution;
+        nodeNumbering = theSolver.nodeNumbering;
+        coefficients.resize(2*theSolver.NumEls);
+        for (int i=0; i<theSolver.NumEls; i++)
+        {
+            coefficients[2*i] = theSolver.blockproplist[theSolver.meshele[i].blk].ex;
+            coefficients[2*i+1] = theSolver.blockproplist[theSolver.meshele[i].blk].ey;
+        }
+        return true;
+    });
+}
+
 /**
  * @brief Calculate a block integral for the selected blocks.
  * @param L
@@ -45,6 +45,7 @@ int luaAddConductorProperty(lua_State *L);
 int luaAddMaterialProperty(lua_State *L);
 int luaAddPointProperty(lua_State *L);
 int luaAnalyze(lua_State *L);
+int luaAnalyzeAdaptive(lua_State *L);
 int luaBlockIntegral(lua_State *L);
 int luaExitPost(lua_State *L);
 int luaGetPointValues(lua_State *L);
@@ -68,6 +68,8 @@ void femmcli::LuaHeatflowCommands::registerCommands(LuaInstance &li)
     li.addFunction("hi_addtkpoint", luaAddtkpoint);
     li.addFunction("hi_analyse", luaAnalyze);
     li.addFunction("hi_analyze", luaAnalyze);
+    li.addFunction("hi_analyze_adaptive", luaAnalyzeAdaptive);
+    li.addFunction("hi_analyzeadaptive", luaAnalyzeAdaptive);
     li.addFunction("hi_attach_default", LuaCommonCommands::luaAttachDefault);
     li.addFunction("hi_attachdefault", LuaCommonCommands::luaAttachDefault);
     li.addFunction("hi_attach_outer_space", LuaCommonCommands::luaAttachOuterSpace);
@@ -175,12 +177,18 @@ void femmcli::LuaHeatflowCommands::registerCommands(LuaInstance &li)
     li.addFunction("hi_setblockprop", LuaCommonCommands::luaSetBlocklabelProperty);
     li.addFunction("hi_set_edit_mode", LuaCommonCommands::luaSetEditMode);
     li.addFunction("hi_seteditmode", LuaCommonCommands::luaSetEditMode);
+    li.addFunction("hi_set_float_preconditioner", LuaCommonCommands::luaSetFloatPreconditioner);
+    li.addFunction("hi_setfloatpreconditioner", LuaCommonCommands::luaSetFloatPreconditioner);
     li.addFunction("hi_set_focus", LuaCommonCommands::luaSetFocus);
     li.addFunction("hi_setfocus", LuaCommonCommands::luaSetFocus);
     li.addFunction("hi_set_grid", LuaInstance::luaNOP);
     li.addFunction("hi_setgrid", LuaInstance::luaNOP);
     li.addFunction("hi_set_group", LuaCommonCommands::luaSetGroup);
     li.addFunction("hi_setgroup", LuaCommonCommands::luaSetGroup);
+    li.addFunction("hi_set_element_ordering", LuaCommonCommands::luaSetElementOrdering);
+    li.addFunction("hi_setelementordering", LuaCommonCommands::luaSetElementOrdering);
+    li.addFunction("hi_set_node_ordering", LuaCommonCommands::luaSetNodeOrdering);
+    li.addFunction("hi_setnodeordering", LuaCommonCommands::luaSetNodeOrdering);
     li.addFunction("hi_set_node_prop", LuaCommonCommands::luaSetNodeProperty);
     li.addFunction("hi_setnodeprop", LuaCommonCommands::luaSetNodeProperty);
     li.addFunction("hi_set_segment_prop", LuaCommonCommands::luaSetSegmentProperty);
@@ -191,6 +199,7 @@ void femmcli::LuaHeatflowCommands::registerCommands(LuaInstance &li)
     li.addFunction("hi_showmesh", LuaInstance::luaNOP);
     li.addFunction("hi_show_names", LuaInstance::luaNOP);
     li.addFunction("hi_shownames", LuaInstance::luaNOP);
+    li.addFunction("hi_transient", luaTransient);
     li.addFunction("hi_zoom_in", LuaInstance::luaNOP);
     li.addFunction("hi_zoomin", LuaInstance::luaNOP);
     li.addFunction("hi_zoom", LuaInstance::luaNOP);
@@ -430,27 +439,19 @@ int femmcli::LuaHeatflowCommands::luaAddPointProperty(lua_State *L)
     return 0;
 }
 
+namespace {
+
 /**
- * @brief Mesh the problem description, save it, and run the solver.
- * If the global variable "XFEMM_VERBOSE" is set to 1, the mesher and solver is more verbose and prints statistics.
+ * @brief Check the problem description, save it, and mesh it.
+ * This is everything hi_analyze does before calling the solver.
  * @param L
- * @return 0
- * \ingroup LuaHF
- *
- * \internal
- * ### Implements:
- * - \lua{hi_analyze(flag)}
- *   Parameter flag (0,1) determines visibility of hsolv window and is ignored on xfemm.
- *
- * ### FEMM sources:
- * - \femm42{femm/HDRAWLUA.cpp,lua_analyze()}
- * - \femm42{femm/hdrawView.cpp,ChdrawView::OnMenuAnalyze()}
- * \endinternal
+ * @param command the name of the lua command, for error messages
+ * @return the mesher, or \c nullptr after raising a lua error
  */
-int femmcli::LuaHeatflowCommands::luaAnalyze(lua_State *L)
+std::shared_ptr<fmesher::FMesher> meshProblem(lua_State *L, const std::string &command)
 {
     auto luaInstance = LuaInstance::instance(L);
-    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<femmcli::FemmState> femmState = std::dynamic_pointer_cast<femmcli::FemmState>(luaInstance->femmState());
     std::shared_ptr<femm::FemmProblem> doc = femmState->femmDocument();
 
     // check to see if all blocklabels are kosher...
@@ -458,7 +459,7 @@ int femmcli::LuaHeatflowCommands::luaAnalyze(lua_State *L)
         std::string msg = "No block information has been defined\n"
                           "Cannot analyze the problem";
         lua_error(L, msg.c_str());
-        return 0;
+        return nullptr;
     }
 
     bool hasMissingBlockProps = false;
@@ -489,7 +490,7 @@ int femmcli::LuaHeatflowCommands::luaAnalyze(lua_State *L)
                             "been defined for all block labels.\n"
                             "Cannot analyze the problem";
         lua_error(L,ermsg.c_str());
-        return 0;
+        return nullptr;
     }
 
 
@@ -505,7 +506,7 @@ int femmcli::LuaHeatflowCommands::luaAnalyze(lua_State *L)
                                     "r>=0 for axisymmetric problems.\n"
                                     "Cannot analyze the problem.";
                 lua_error(L,ermsg.c_str());
-                return 0;
+                return nullptr;
             }
         }
 
@@ -539,7 +540,7 @@ int femmcli::LuaHeatflowCommands::luaAnalyze(lua_State *L)
                                 "allowed in axisymmetric external regions.\n"
                                 "Cannot analyze the problem";
             lua_error(L,ermsg.c_str());
-            return 0;
+            return nullptr;
         }
 
         if (!hasExteriorProps)
@@ -550,7 +551,7 @@ int femmcli::LuaHeatflowCommands::luaAnalyze(lua_State *L)
                                 "have been adequately defined for the exterior region\n"
                                 "Cannot analyze the problem";
             lua_error(L,ermsg.c_str());
-            return 0;
+            return nullptr;
         }
     }
 
@@ -558,17 +559,17 @@ int femmcli::LuaHeatflowCommands::luaAnalyze(lua_State *L)
     if (pathName.empty())
     {
         lua_error(L,"A data file must be loaded,\nor the current data must saved.");
-        return 0;
+        return nullptr;
     }
     if (!doc->saveFEMFile(pathName))
     {
-        lua_error(L, "hi_analyze(): Could not save fem file!\n");
-        return 0;
+        lua_error(L, (command + "(): Could not save fem file!\n").c_str());
+        return nullptr;
     }
     if (!doc->consistencyCheckOK())
     {
-        lua_error(L,"hi_analyze(): consistency check failed before meshing!\n");
-        return 0;
+        lua_error(L, (command + "(): consistency check failed before meshing!\n").c_str());
+        return nullptr;
     }
 
     //BeginWaitCursor();
@@ -576,30 +577,68 @@ int femmcli::LuaHeatflowCommands::luaAnalyze(lua_State *L)
     // allow setting verbosity from lua:
     const bool verbose = (luaInstance->getGlobal("XFEMM_VERBOSE") != 0);
     mesherDoc->Verbose = verbose;
+    // hand the mesh to the solver in memory
+    mesherDoc->writeMeshFiles = false;
+    femmcli::luaConfigureMeshCache(L, *mesherDoc);
     if (mesherDoc->HasPeriodicBC()){
         if (mesherDoc->DoPeriodicBCTriangulation(pathName) != 0)
         {
             //EndWaitCursor();
             mesherDoc->problem->unselectAll();
-            lua_error(L, "hi_analyze(): Periodic BC triangulation failed!\n");
-            return 0;
+            lua_error(L, (command + "(): Periodic BC triangulation failed!\n").c_str());
+            return nullptr;
         }
     }
     else{
         if (mesherDoc->DoNonPeriodicBCTriangulation(pathName) != 0)
         {
             //EndWaitCursor();
-            lua_error(L, "hi_analyze(): Nonperiodic BC triangulation failed!\n");
-            return 0;
+            lua_error(L, (command + "(): Nonperiodic BC triangulation failed!\n").c_str());
+            return nullptr;
         }
     }
     //EndWaitCursor();
     if (!doc->consistencyCheckOK())
     {
-        lua_error(L,"hi_analyze(): consistency check failed after meshing!\n");
-        return 0;
+        lua_error(L, (command + "(): consistency check failed after meshing!\n").c_str());
+        return nullptr;
     }
 
+    return mesherDoc;
+}
+
+} // anonymous namespace
+
+/**
+ * @brief Mesh the problem description, save it, and run the solver.
+ * If the global variable "XFEMM_VERBOSE" is set to 1, the mesher and solver is more verbose and prints statistics.
+ * Unless the global variable "XFEMM_MESH_CACHE" is set to 0, a cached mesh is reused if the geometry has not changed.
+ * If the global variable "XFEMM_MESH_MORPH" is set to a minimum element angle [deg], a cached mesh is morphed if only nodes have moved.
+ * @param L
+ * @return 0
+ * \ingroup LuaHF
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{hi_analyze(flag)}
+ *   Parameter flag (0,1) determines visibility of hsolv window and is ignored on xfemm.
+ *
+ * ### FEMM sources:
+ * - \femm42{femm/HDRAWLUA.cpp,lua_analyze()}
+ * - \femm42{femm/hdrawView.cpp,ChdrawView::OnMenuAnalyze()}
+ * \endinternal
+ */
+int femmcli::LuaHeatflowCommands::luaAnalyze(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<femm::FemmProblem> doc = femmState->femmDocument();
+
+    std::shared_ptr<fmesher::FMesher> mesherDoc = meshProblem(L, "hi_analyze");
+    if (!mesherDoc)
+        return 0;
+    const bool verbose = mesherDoc->Verbose;
+
     HSolver theSolver;
     // filename.feh -> filename
     std::size_t dotpos = doc->pathName.find_last_of(".");
@@ -613,6 +652,8 @@ int femmcli::LuaHeatflowCommands::luaAnalyze(lua_State *L)
         lua_error(L, "hi_analyze(): problem initializing solver!");
         return 0;
     }
+    theSolver.meshData = mesherDoc->mesh;
+    theSolver.binarySolutionFile = (luaInstance->getGlobal("XFEMM_BINARY_SOLUTION") != 0);
     assert( doc->ACSolver == theSolver.ACSolver);
     assert( doc->lineproplist.size() == theSolver.lineproplist.size());
     assert( doc->nodeproplist.size() == theSolver.nodeproplist.size());
@@ -628,6 +669,225 @@ int femmcli::LuaHeatflowCommands::luaAnalyze(lua_State *L)
     return 0;
 }
 
+/**
+ * @brief Mesh the problem, and refine the mesh where the estimated error of the solution is largest,
+ * until the estimated error is small enough.
+ * If the global variable "XFEMM_VERBOSE" is set to 1, the estimated error of each step is printed.
+ * @param L
+ * @return 3
+ * \ingroup LuaHF
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{hi_analyzeadaptive(targeterror[,maxsteps[,fraction]])}
+ *   Solves the problem, estimates the relative error from the jump of the normal heat flux density across the element edges,
+ *   and refines the elements that make up fraction (default: 0.5) of the estimated error,
+ *   until the estimated relative error is below targeterror or maxsteps (default: 5) refinement steps have been made.
+ *   Returns the estimated relative error, the number of elements, and the number of refinement steps.
+ *   The solution file holds the solution on the refined mesh.
+ *
+ * \note This function does not exist in FEMM42.
+ * \endinternal
+ */
+int femmcli::LuaHeatflowCommands::luaAnalyzeAdaptive(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<femm::FemmProblem> doc = femmState->femmDocument();
+
+    if (!doc->previousSolutionFile.empty())
+    {
+        lua_error(L, "hi_analyzeadaptive(): Problems that start from a previous solution can not be refined\n");
+        return 0;
+    }
+
+    return femmcli::luaAnalyzeAdaptive(L, "hi_analyzeadaptive",
+                                       [&]() { return meshProblem(L, "hi_analyzeadaptive"); },
+                                       [&](std::shared_ptr<const femm::MeshData> mesh,
+                                           std::shared_ptr<const femm::SolutionData> &solution, std::vector<int> &nodeNumbering,
+                                           std::vector<CComplex> &coefficients)
+    {
+        HSolver theSolver;
+        // filename.feh -> filename
+        std::size_t dotpos = doc->pathName.find_last_of(".");
+        theSolver.PathName = doc->pathName.substr(0,dotpos);
+        theSolver.WarnMessage = &PrintWarningMsg;
+        theSolver.PrintMessage = &PrintWarningMsg;
+        theSolver.dT = doc->dT;
+        if (!theSolver.LoadProblemFile())
+            return false;
+        theSolver.meshData = mesh;
+        theSolver.keepSolution = true;
+        theSolver.binarySolutionFile = (luaInstance->getGlobal("XFEMM_BINARY_SOLUTION") != 0);
+        if (!theSolver.runSolver(luaInstance->getGlobal("XFEMM_VERBOSE") != 0))
+            return false;
+        solution = theSolver.solution;
+        nodeNumbering = theSolver.nodeNumbering;
+        // conductivity of each element at its mean temperature, as in the solver
+        coefficients.resize(2*theSolver.NumEls);
+        for (int i=0; i<theSolver.NumEls; i++)
+        {
+            const auto &el = theSolver.meshele[i];
+            CComplex k = 0;
+            for (int j=0; j<3; j++)
+                k += theSolver.blockproplist[el.blk].GetK(solution->nodeValue[el.p[j]].re)/3.;
+            coefficients[2*i] = k.re;
+            coefficients[2*i+1] = k.im;
+        }
+        return true;
+    });
+}
+
+/**
+ * @brief Solve a series of time steps of a transient problem.
+ * The problem is meshed only once, and the previous solution is handed from one step to the next in memory,
+ * instead of running hi_analyze() for every step with the last solution as previous solution.
+ * For linear problems, the matrix is assembled only once as long as the time step does not change.
+ * If the global variable "XFEMM_VERBOSE" is set to 1, the mesher and solver is more verbose and prints statistics.
+ * @param L
+ * @return 3
+ * \ingroup LuaHF
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{hi_transient(steps[,outputevery[,archive[,maxchange]]])}
+ *   Starts from the previous solution and uses the time step dT set by hi_probdef().
+ *   Every outputevery-th step and the last step are output steps (default: every step).
+ *   Returns three tables: the time of each output step, and the temperature
+ *   and the heat flux of each conductor at each output step.
+ *   If archive is given, the solution of each output step is appended to that solution archive.
+ *   If maxchange is given, the time step is halved whenever a temperature changes by more than maxchange
+ *   within one step, and it is doubled when all changes stay below a quarter of maxchange.
+ *   Afterwards, hi_loadsolution() loads the solution of the last step.
+ *
+ * \note This function does not exist in FEMM42.
+ * \endinternal
+ */
+int femmcli::LuaHeatflowCommands::luaTransient(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<femm::FemmProblem> doc = femmState->femmDocument();
+
+    if (!luaExpectParameterCount(L, 1, 4))
+        return 0;
+    const int steps = (int)lua_todouble(L,1);
+    int outputEvery = 1;
+    if (lua_gettop(L) > 1)
+        outputEvery = (int)lua_todouble(L,2);
+    std::string archive;
+    if (lua_gettop(L) > 2)
+        archive = lua_tostring(L,3);
+    double maxChange = 0;
+    if (lua_gettop(L) > 3)
+        maxChange = lua_todouble(L,4);
+
+    if (steps < 1 || outputEvery < 1)
+    {
+        lua_error(L, "hi_transient(): The number of steps and the output interval must be positive\n");
+        return 0;
+    }
+    if (maxChange < 0)
+    {
+        lua_error(L, "hi_transient(): The maximum temperature change must not be negative\n");
+        return 0;
+    }
+    if (doc->dT == 0 || doc->previousSolutionFile.empty())
+    {
+        lua_error(L, "hi_transient(): The problem needs a time step and a previous solution, see hi_probdef()\n");
+        return 0;
+    }
+
+    std::shared_ptr<fmesher::FMesher> mesherDoc = meshProblem(L, "hi_transient");
+    if (!mesherDoc)
+        return 0;
+    const bool verbose = mesherDoc->Verbose;
+
+    HSolver theSolver;
+    // filename.feh -> filename
+    std::size_t dotpos = doc->pathName.find_last_of(".");
+    theSolver.PathName = doc->pathName.substr(0,dotpos);
+    theSolver.WarnMessage = &PrintWarningMsg;
+    theSolver.PrintMessage = &PrintWarningMsg;
+    theSolver.dT = doc->dT;
+    theSolver.previousSolutionFile = doc->previousSolutionFile;
+    bool ok = theSolver.LoadProblemFile();
+    if (ok)
+    {
+        theSolver.meshData = mesherDoc->mesh;
+        theSolver.binarySolutionFile = (luaInstance->getGlobal("XFEMM_BINARY_SOLUTION") != 0);
+        theSolver.reuseAssembly = true;
+        theSolver.maxStepChange = maxChange;
+        ok = theSolver.prepareMesh(verbose);
+    }
+    if (!ok)
+    {
+        lua_error(L, "hi_transient(): problem initializing solver!");
+        return 0;
+    }
+    if (!theSolver.Tprev)
+    {
+        std::string msg = "hi_transient(): Could not load the previous solution " + doc->previousSolutionFile + "\n";
+        lua_error(L, msg.c_str());
+        return 0;
+    }
+
+    const int numConductors = doc->circproplist.size();
+    std::vector<double> times;
+    std::vector<std::vector<double>> temperature(numConductors);
+    std::vector<std::vector<double>> heatFlux(numConductors);
+    double time = 0;
+    for (int step=1; step<=steps; step++)
+    {
+        const bool output = (step % outputEvery == 0) || (step == steps);
+        theSolver.keepSolution = output;
+        theSolver.solutionArchive = output ? archive : std::string();
+        // only the last step is written to the solution file
+        theSolver.writeSolutionFile = (step == steps);
+        const double stepLength = theSolver.solveTimeStep(verbose);
+        if (stepLength == 0)
+        {
+            lua_error(L, "solver failed.");
+            return 0;
+        }
+        time += stepLength;
+        if (!output)
+            continue;
+
+        times.push_back(time);
+        for (int i=0; i<numConductors; i++)
+        {
+            temperature[i].push_back(theSolver.solution->conductorValue[i]);
+            heatFlux[i].push_back(theSolver.solution->conductorFlux[i]);
+        }
+    }
+
+    lua_newtable(L);
+    for (int k=0; k<(int)times.size(); k++)
+    {
+        lua_pushnumber(L, k+1);
+        lua_pushnumber(L, times[k]);
+        lua_settable(L, -3);
+    }
+    for (const auto *values: { &temperature, &heatFlux })
+    {
+        lua_newtable(L);
+        for (int i=0; i<numConductors; i++)
+        {
+            lua_pushstring(L, doc->circproplist[i]->CircName.c_str());
+            lua_newtable(L);
+            for (int k=0; k<(int)(*values)[i].size(); k++)
+            {
+                lua_pushnumber(L, k+1);
+                lua_pushnumber(L, (*values)[i][k]);
+                lua_settable(L, -3);
+            }
+            lua_settable(L, -3);
+        }
+    }
+    return 3;
+}
+
 /**
  * @brief Change problem definition.
  * Only the parameters that are set are changed.
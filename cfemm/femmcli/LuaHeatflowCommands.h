@@ -46,6 +46,7 @@ int luaAddMaterialProperty(lua_State *L);
 int luaAddPointProperty(lua_State *L);
 int luaAddtkpoint(lua_State *L);
 int luaAnalyze(lua_State *L);
+int luaAnalyzeAdaptive(lua_State *L);
 int luaBlockIntegral(lua_State *L);
 int luaCleartkpoints(lua_State *L);
 int luaGetPointValues(lua_State *L);
@@ -56,6 +57,7 @@ int luaModifyMaterialProperty(lua_State *L);
 int luaModifyPointProperty(lua_State *L);
 int luaNewDocument(lua_State *L);
 int luaProblemDefinition(lua_State *L);
+int luaTransient(lua_State *L);
 }
 
 } /* namespace FemmLua*/
@@ -30,6 +30,7 @@
 
 #include <lua.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <fstream>
@@ -70,6 +71,15 @@ void femmcli::LuaMagneticsCommands::registerCommands(LuaInstance &li)
     li.addFunction("mi_addpointprop", luaAddPointProperty);
     li.addFunction("mi_analyse", luaAnalyze);
     li.addFunction("mi_analyze", luaAnalyze);
+    li.addFunction("mi_analyze_adaptive", luaAnalyzeAdaptive);
+    li.addFunction("mi_analyzeadaptive", luaAnalyzeAdaptive);
+    li.addFunction("mi_archivesolution", luaArchiveSolution);
+    li.addFunction("mi_loadarchivestep", luaLoadArchiveStep);
+    li.addFunction("mi_numarchivesteps", luaNumArchiveSteps);
+    li.addFunction("mi_sweep_frequency", luaSweepFrequency);
+    li.addFunction("mi_sweepfrequency", luaSweepFrequency);
+    li.addFunction("mi_sweep_rotor", luaSweepRotor);
+    li.addFunction("mi_sweeprotor", luaSweepRotor);
     li.addFunction("mi_attach_default", LuaCommonCommands::luaAttachDefault);
     li.addFunction("mi_attachdefault", LuaCommonCommands::luaAttachDefault);
     li.addFunction("mi_attach_outer_space", LuaCommonCommands::luaAttachOuterSpace);
@@ -239,6 +249,8 @@ void femmcli::LuaMagneticsCommands::registerCommands(LuaInstance &li)
     li.addFunction("mi_setblockprop", luaSetBlocklabelProperty);
     li.addFunction("mi_set_edit_mode", LuaCommonCommands::luaSetEditMode);
     li.addFunction("mi_seteditmode", LuaCommonCommands::luaSetEditMode);
+    li.addFunction("mi_set_float_preconditioner", LuaCommonCommands::luaSetFloatPreconditioner);
+    li.addFunction("mi_setfloatpreconditioner", LuaCommonCommands::luaSetFloatPreconditioner);
     li.addFunction("mo_set_edit_mode", LuaInstance::luaNOP);
     li.addFunction("mo_seteditmode", LuaInstance::luaNOP);
     li.addFunction("mi_set_grid", LuaInstance::luaNOP);
@@ -247,6 +259,10 @@ void femmcli::LuaMagneticsCommands::registerCommands(LuaInstance &li)
     li.addFunction("mo_setgrid", LuaInstance::luaNOP);
     li.addFunction("mi_set_group", LuaCommonCommands::luaSetGroup);
     li.addFunction("mi_setgroup", LuaCommonCommands::luaSetGroup);
+    li.addFunction("mi_set_element_ordering", LuaCommonCommands::luaSetElementOrdering);
+    li.addFunction("mi_setelementordering", LuaCommonCommands::luaSetElementOrdering);
+    li.addFunction("mi_set_node_ordering", LuaCommonCommands::luaSetNodeOrdering);
+    li.addFunction("mi_setnodeordering", LuaCommonCommands::luaSetNodeOrdering);
     li.addFunction("mi_set_node_prop", luaSetNodeProperty);
     li.addFunction("mi_setnodeprop", luaSetNodeProperty);
     li.addFunction("mi_set_segment_prop", luaSetSegmentProperty);
@@ -639,39 +655,27 @@ int femmcli::LuaMagneticsCommands::luaAddPointProperty(lua_State *L)
     return 0;
 }
 
+namespace {
+
 /**
- * @brief Mesh the problem description, save it, and run the solver.
- * If the global variable "XFEMM_VERBOSE" is set to 1, the mesher and solver is more verbose and prints statistics.
+ * @brief Check the problem description, save it, and mesh it.
+ * This is everything mi_analyze does before calling the solver.
  * @param L
- * @return 0
- * \ingroup LuaMM
- *
- * \internal
- * ### Implements:
- * - \lua{mi_analyze(flag)}
- *   Parameter flag (0,1) determines visibility of fkern window and is ignored on xfemm.
- *
- * ### FEMM source:
- * - \femm42{femm/femmeLua.cpp,lua_analyze()}
- *
- * #### Additional source:
- * - \femm42{femm/femmeLua.cpp,lua_analyze()}: extracts thisDoc (=mesherDoc) and the accompanying FemmeViewDoc, calls CFemmeView::lnu_analyze(flag)
- * - \femm42{femm/FemmeView.cpp,CFemmeView::OnMenuAnalyze()}: does the things we do here directly...
- * \endinternal
+ * @param command the name of the lua command, for error messages
+ * @return the mesher, or \c nullptr after raising a lua error
  */
-int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
+std::shared_ptr<fmesher::FMesher> meshProblem(lua_State *L, const std::string &command)
 {
     auto luaInstance = LuaInstance::instance(L);
-    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<femmcli::FemmState> femmState = std::dynamic_pointer_cast<femmcli::FemmState>(luaInstance->femmState());
     std::shared_ptr<femm::FemmProblem> doc = femmState->femmDocument();
 
-    luaExpectParameterCount(L, 0,1);
     // check to see if all blocklabels are kosher...
     if (doc->labellist.size()==0){
         std::string msg = "No block information has been defined\n"
                           "Cannot analyze the problem";
         lua_error(L, msg.c_str());
-        return 0;
+        return nullptr;
     }
 
     bool hasMissingBlockProps = false;
@@ -702,7 +706,7 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
                             "been defined for all block labels.\n"
                             "Cannot analyze the problem";
         lua_error(L,ermsg.c_str());
-        return 0;
+        return nullptr;
     }
 
 
@@ -718,7 +722,7 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
                                     "r>=0 for axisymmetric problems.\n"
                                     "Cannot analyze the problem.";
                 lua_error(L,ermsg.c_str());
-                return 0;
+                return nullptr;
             }
         }
 
@@ -753,7 +757,7 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
                                 "allowed in axisymmetric external regions.\n"
                                 "Cannot analyze the problem";
             lua_error(L,ermsg.c_str());
-            return 0;
+            return nullptr;
         }
 
         if (!hasExteriorProps)
@@ -764,7 +768,7 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
                                 "have been adequately defined for the exterior region\n"
                                 "Cannot analyze the problem";
             lua_error(L,ermsg.c_str());
-            return 0;
+            return nullptr;
         }
     }
 
@@ -772,17 +776,17 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
     if (pathName.empty())
     {
         lua_error(L,"A data file must be loaded,\nor the current data must saved.");
-        return 0;
+        return nullptr;
     }
     if (!doc->saveFEMFile(pathName))
     {
-        lua_error(L, "mi_analyze(): Could not save fem file!\n");
-        return 0;
+        lua_error(L, (command + "(): Could not save fem file!\n").c_str());
+        return nullptr;
     }
     if (!doc->consistencyCheckOK())
     {
-        lua_error(L,"mi_analyze(): consistency check failed before meshing!\n");
-        return 0;
+        lua_error(L, (command + "(): consistency check failed before meshing!\n").c_str());
+        return nullptr;
     }
 
     //BeginWaitCursor();
@@ -790,30 +794,72 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
     // allow setting verbosity from lua:
     const bool verbose = (luaInstance->getGlobal("XFEMM_VERBOSE") != 0);
     mesherDoc->Verbose = verbose;
+    // hand the mesh to the solver in memory
+    mesherDoc->writeMeshFiles = false;
+    femmcli::luaConfigureMeshCache(L, *mesherDoc);
     if (mesherDoc->HasPeriodicBC()){
         if (mesherDoc->DoPeriodicBCTriangulation(pathName) != 0)
         {
             //EndWaitCursor();
             mesherDoc->problem->unselectAll();
-            lua_error(L, "mi_analyze(): Periodic BC triangulation failed!\n");
-            return 0;
+            lua_error(L, (command + "(): Periodic BC triangulation failed!\n").c_str());
+            return nullptr;
         }
     }
     else{
         if (mesherDoc->DoNonPeriodicBCTriangulation(pathName) != 0)
         {
             //EndWaitCursor();
-            lua_error(L, "mi_analyze(): Nonperiodic BC triangulation failed!\n");
-            return 0;
+            lua_error(L, (command + "(): Nonperiodic BC triangulation failed!\n").c_str());
+            return nullptr;
         }
     }
     //EndWaitCursor();
     if (!doc->consistencyCheckOK())
     {
-        lua_error(L,"mi_analyze(): consistency check failed after meshing!\n");
-        return 0;
+        lua_error(L, (command + "(): consistency check failed after meshing!\n").c_str());
+        return nullptr;
     }
 
+    return mesherDoc;
+}
+
+} // anonymous namespace
+
+/**
+ * @brief Mesh the problem description, save it, and run the solver.
+ * If the global variable "XFEMM_VERBOSE" is set to 1, the mesher and solver is more verbose and prints statistics.
+ * Unless the global variable "XFEMM_MESH_CACHE" is set to 0, a cached mesh is reused if the geometry has not changed.
+ * If the global variable "XFEMM_MESH_MORPH" is set to a minimum element angle [deg], a cached mesh is morphed if only nodes have moved.
+ * @param L
+ * @return 0
+ * \ingroup LuaMM
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mi_analyze(flag)}
+ *   Parameter flag (0,1) determines visibility of fkern window and is ignored on xfemm.
+ *
+ * ### FEMM source:
+ * - \femm42{femm/femmeLua.cpp,lua_analyze()}
+ *
+ * #### Additional source:
+ * - \femm42{femm/femmeLua.cpp,lua_analyze()}: extracts thisDoc (=mesherDoc) and the accompanying FemmeViewDoc, calls CFemmeView::lnu_analyze(flag)
+ * - \femm42{femm/FemmeView.cpp,CFemmeView::OnMenuAnalyze()}: does the things we do here directly...
+ * \endinternal
+ */
+int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<femm::FemmProblem> doc = femmState->femmDocument();
+
+    luaExpectParameterCount(L, 0,1);
+    std::shared_ptr<fmesher::FMesher> mesherDoc = meshProblem(L, "mi_analyze");
+    if (!mesherDoc)
+        return 0;
+    const bool verbose = mesherDoc->Verbose;
+
     FSolver theFSolver;
     // filename.fem -> filename
     std::size_t dotpos = doc->pathName.find_last_of(".");
@@ -827,6 +873,12 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
         lua_error(L, "mi_analyze(): problem initializing solver!");
         return 0;
     }
+    theFSolver.meshData = mesherDoc->mesh;
+    // hand the solution to the post processor in memory
+    theFSolver.keepSolution = true;
+    theFSolver.writeSolutionFile = (luaInstance->getGlobal("XFEMM_SKIP_SOLUTION_FILE") == 0);
+    theFSolver.binarySolutionFile = (luaInstance->getGlobal("XFEMM_BINARY_SOLUTION") != 0);
+    femmState->setSolution(doc->pathName, nullptr);
     assert( doc->ACSolver == theFSolver.ACSolver);
     assert( doc->Frequency == theFSolver.Frequency);
     assert( doc->lineproplist.size() == theFSolver.lineproplist.size());
@@ -839,10 +891,526 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
     if (!theFSolver.runSolver(verbose))
     {
         lua_error(L, "solver failed.");
+        return 0;
     }
+    femmState->setSolution(doc->pathName, theFSolver.solution);
     return 0;
 }
 
+/**
+ * @brief Mesh the problem, and refine the mesh where the estimated error of the solution is largest,
+ * until the estimated error is small enough.
+ * Refining only where it matters keeps the number of nodes (and the solution time) lower than
+ * refining whole regions by setting their mesh size.
+ * If the global variable "XFEMM_VERBOSE" is set to 1, the estimated error of each step is printed.
+ * @param L
+ * @return 3
+ * \ingroup LuaMM
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mi_analyzeadaptive(targeterror[,maxsteps[,fraction]])}
+ *   Solves the problem, estimates the relative error from the jump of the tangential field intensity (nu*dA/dn) across the element edges,
+ *   and refines the elements that make up fraction (default: 0.5) of the estimated error,
+ *   until the estimated relative error is below targeterror or maxsteps (default: 5) refinement steps have been made.
+ *   Returns the estimated relative error, the number of elements, and the number of refinement steps.
+ *   Afterwards, mi_loadsolution() loads the solution on the refined mesh.
+ *
+ * \note This function does not exist in FEMM42.
+ * \endinternal
+ */
+int femmcli::LuaMagneticsCommands::luaAnalyzeAdaptive(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<femm::FemmProblem> doc = femmState->femmDocument();
+
+    if (!doc->previousSolutionFile.empty())
+    {
+        lua_error(L, "mi_analyzeadaptive(): Problems that start from a previous solution can not be refined\n");
+        return 0;
+    }
+
+    return femmcli::luaAnalyzeAdaptive(L, "mi_analyzeadaptive",
+                                       [&]() { return meshProblem(L, "mi_analyzeadaptive"); },
+                                       [&](std::shared_ptr<const femm::MeshData> mesh,
+                                           std::shared_ptr<const femm::SolutionData> &solution, std::vector<int> &nodeNumbering,
+                                           std::vector<CComplex> &coefficients)
+    {
+        FSolver theFSolver;
+        // filename.fem -> filename
+        std::size_t dotpos = doc->pathName.find_last_of(".");
+        theFSolver.PathName = doc->pathName.substr(0,dotpos);
+        theFSolver.WarnMessage = &PrintWarningMsg;
+        theFSolver.PrintMessage = &PrintWarningMsg;
+        if (!theFSolver.LoadProblemFile())
+            return false;
+        theFSolver.meshData = mesh;
+        theFSolver.keepSolution = true;
+        theFSolver.writeSolutionFile = (luaInstance->getGlobal("XFEMM_SKIP_SOLUTION_FILE") == 0);
+        theFSolver.binarySolutionFile = (luaInstance->getGlobal("XFEMM_BINARY_SOLUTION") != 0);
+        femmState->setSolution(doc->pathName, nullptr);
+        if (!theFSolver.runSolver(luaInstance->getGlobal("XFEMM_VERBOSE") != 0))
+            return false;
+        femmState->setSolution(doc->pathName, theFSolver.solution);
+        solution = theFSolver.solution;
+        nodeNumbering = theFSolver.nodeNumbering;
+        // reluctivity of each element, as used in the last iteration of the solver
+        coefficients.resize(2*theFSolver.NumEls);
+        for (int i=0; i<theFSolver.NumEls; i++)
+        {
+            coefficients[2*i] = 1./theFSolver.meshele[i].mu2;
+            coefficients[2*i+1] = 1./theFSolver.meshele[i].mu1;
+        }
+        return true;
+    });
+}
+
+/**
+ * @brief Append the solution of the last analysis to a solution archive.
+ * All solutions in an archive share the mesh, which is stored only once.
+ * If the archive file does not exist, it is created.
+ * @param L
+ * @return 1
+ * \ingroup LuaMM
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mi_archivesolution(filename)}
+ *   Returns the number of the new step (counting from 1).
+ *
+ * \note This function does not exist in FEMM42.
+ * \endinternal
+ */
+int femmcli::LuaMagneticsCommands::luaArchiveSolution(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<femm::FemmProblem> doc = femmState->femmDocument();
+
+    if (!luaExpectParameterCount(L, 1))
+        return 0;
+    std::string archive = lua_tostring(L,1);
+
+    std::shared_ptr<const femm::SolutionData> solution = femmState->solution(doc->pathName);
+    if (!solution)
+    {
+        lua_error(L, "mi_archivesolution(): no solution available, call mi_analyze() first.\n");
+        return 0;
+    }
+    std::stringstream err;
+    if (!solution->appendToArchive(archive, err))
+    {
+        std::string msg = "mi_archivesolution(): " + err.str();
+        lua_error(L, msg.c_str());
+        return 0;
+    }
+    lua_pushnumber(L, femm::SolutionData::archiveStepCount(archive));
+    return 1;
+}
+
+/**
+ * @brief Load one step of a solution archive and run the postprocessor on it.
+ * @param L
+ * @return 0
+ * \ingroup LuaMM
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mi_loadarchivestep(filename,step)}
+ *   Steps are counted from 1, as returned by mi_archivesolution().
+ *
+ * \note This function does not exist in FEMM42.
+ * \endinternal
+ */
+int femmcli::LuaMagneticsCommands::luaLoadArchiveStep(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+
+    if (!luaExpectParameterCount(L, 2))
+        return 0;
+    std::string archive = lua_tostring(L,1);
+    int step = (int)lua_todouble(L,2);
+
+    femmState->closeSolution();
+    std::shared_ptr<FPProc> fpproc = std::dynamic_pointer_cast<FPProc>(femmState->getPostProcessor());
+    if (!fpproc)
+    {
+        lua_error(L,"No output in focus!");
+        return 0;
+    }
+    if (!fpproc->OpenArchiveStep(archive, step-1))
+    {
+        std::string msg = "mi_loadarchivestep(): error while loading step " + std::to_string(step) + " of " + archive + "\n";
+        lua_error(L, msg.c_str());
+    }
+    return 0;
+}
+
+/**
+ * @brief Get the number of steps in a solution archive.
+ * @param L
+ * @return 1
+ * \ingroup LuaMM
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mi_numarchivesteps(filename)}
+ *   Returns 0 if the file does not exist or is not a solution archive.
+ *
+ * \note This function does not exist in FEMM42.
+ * \endinternal
+ */
+int femmcli::LuaMagneticsCommands::luaNumArchiveSteps(lua_State *L)
+{
+    if (!luaExpectParameterCount(L, 1))
+        return 0;
+    std::string archive = lua_tostring(L,1);
+
+    std::stringstream err;
+    int steps = femm::SolutionData::archiveStepCount(archive, err);
+    lua_pushnumber(L, std::max(steps, 0));
+    return 1;
+}
+
+/**
+ * @brief Solve a harmonic problem for a series of frequencies.
+ * The problem is meshed only once, and each solve starts from the solution of the previous frequency.
+ * Linear problems are assembled only once: for every further frequency,
+ * the solver only combines the stored stiffness and conductivity matrices.
+ * If the global variable "XFEMM_VERBOSE" is set to 1, the mesher and solver is more verbose and prints statistics.
+ * @param L
+ * @return 3
+ * \ingroup LuaMM
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mi_sweepfrequency(frequencies[,archive])}
+ *   frequencies is a table of frequencies in Hz, solved in the given order.
+ *   Returns three tables with the current, the voltage drop and the flux linkage,
+ *   as returned by mo_getcircuitproperties(). Each of them holds a table with the
+ *   value of each frequency for each circuit name.
+ *   If archive is given, the solution of each frequency is appended to that solution archive.
+ *   Afterwards, mi_loadsolution() loads the solution of the last frequency.
+ *
+ * \note This function does not exist in FEMM42.
+ * \endinternal
+ */
+int femmcli::LuaMagneticsCommands::luaSweepFrequency(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<femm::FemmProblem> doc = femmState->femmDocument();
+
+    if (!luaExpectParameterCount(L, 1, 2))
+        return 0;
+    if (!lua_istable(L,1))
+    {
+        lua_error(L, "mi_sweepfrequency(): Expected a table of frequencies\n");
+        return 0;
+    }
+    std::vector<double> frequencies;
+    for (int k=1; k<=lua_getn(L,1); k++)
+    {
+        lua_rawgeti(L, 1, k);
+        frequencies.push_back(lua_todouble(L,-1));
+        lua_pop(L, 1);
+    }
+    std::string archive;
+    if (lua_gettop(L) > 1)
+        archive = lua_tostring(L,2);
+
+    if (frequencies.empty())
+    {
+        lua_error(L, "mi_sweepfrequency(): The table of frequencies is empty\n");
+        return 0;
+    }
+    for (double f: frequencies)
+    {
+        if (f <= 0)
+        {
+            lua_error(L, "mi_sweepfrequency(): Frequencies must be positive\n");
+            return 0;
+        }
+    }
+    if (!doc->previousSolutionFile.empty())
+    {
+        lua_error(L, "mi_sweepfrequency(): Incremental permeability problems can not be swept\n");
+        return 0;
+    }
+    for (const auto &block: doc->blockproplist)
+    {
+        // the apparent B-H curve of conducting laminations depends on the frequency,
+        // and is only computed when the solver loads the problem
+        const CMMaterialProp *prop = dynamic_cast<CMMaterialProp*>(block.get());
+        if (prop && prop->BHpoints > 0 && prop->Lam_d != 0 && prop->Cduct != 0)
+        {
+            std::string msg = "mi_sweepfrequency(): Nonlinear laminated material " + prop->BlockName + " has a conductivity\n";
+            lua_error(L, msg.c_str());
+            return 0;
+        }
+    }
+
+    // the solution echoes the problem file, which has to state the frequency of each step
+    const double problemFrequency = doc->Frequency;
+    doc->Frequency = frequencies[0];
+    std::shared_ptr<fmesher::FMesher> mesherDoc = meshProblem(L, "mi_sweepfrequency");
+    if (!mesherDoc)
+    {
+        doc->Frequency = problemFrequency;
+        return 0;
+    }
+    const bool verbose = mesherDoc->Verbose;
+
+    FSolver theFSolver;
+    // filename.fem -> filename
+    std::size_t dotpos = doc->pathName.find_last_of(".");
+    theFSolver.PathName = doc->pathName.substr(0,dotpos);
+    theFSolver.WarnMessage = &PrintWarningMsg;
+    theFSolver.PrintMessage = &PrintWarningMsg;
+    bool ok = theFSolver.LoadProblemFile();
+    if (ok)
+    {
+        theFSolver.meshData = mesherDoc->mesh;
+        theFSolver.keepSolution = true;
+        // a .ans file could only hold one of the steps
+        theFSolver.writeSolutionFile = false;
+        theFSolver.warmStart = true;
+        theFSolver.reuseAssembly = true;
+        femmState->setSolution(doc->pathName, nullptr);
+        ok = theFSolver.prepareMesh(verbose);
+    }
+    if (!ok)
+    {
+        doc->Frequency = problemFrequency;
+        lua_error(L, "mi_sweepfrequency(): problem initializing solver!");
+        return 0;
+    }
+
+    std::vector<std::vector<CComplex>> amps;
+    std::vector<std::vector<CComplex>> volts;
+    std::vector<std::vector<CComplex>> fluxLinkage;
+    FPProc fpproc;
+    std::string errorMsg;
+    for (int step=0; step<(int)frequencies.size() && errorMsg.empty(); step++)
+    {
+        doc->Frequency = frequencies[step];
+        theFSolver.Frequency = frequencies[step];
+        if (step > 0 && !doc->saveFEMFile(doc->pathName))
+        {
+            errorMsg = "mi_sweepfrequency(): Could not save fem file!\n";
+            break;
+        }
+        if (!theFSolver.solveMesh(verbose))
+        {
+            errorMsg = "solver failed.";
+            break;
+        }
+        if (!fpproc.OpenDocument(*theFSolver.solution))
+        {
+            errorMsg = "mi_sweepfrequency(): Could not load the solution!\n";
+            break;
+        }
+
+        const int numCircuits = fpproc.circproplist.size();
+        amps.resize(numCircuits);
+        volts.resize(numCircuits);
+        fluxLinkage.resize(numCircuits);
+        for (int i=0; i<numCircuits; i++)
+        {
+            amps[i].push_back(fpproc.circproplist[i].Amps);
+            volts[i].push_back(fpproc.GetVoltageDrop(i));
+            fluxLinkage[i].push_back(fpproc.GetFluxLinkage(i));
+        }
+
+        std::stringstream err;
+        if (!archive.empty() && !theFSolver.solution->appendToArchive(archive, err))
+            errorMsg = "mi_sweepfrequency(): " + err.str();
+    }
+
+    // the document keeps its own frequency
+    doc->Frequency = problemFrequency;
+    if (!doc->saveFEMFile(doc->pathName) && errorMsg.empty())
+        errorMsg = "mi_sweepfrequency(): Could not save fem file!\n";
+    if (!errorMsg.empty())
+    {
+        lua_error(L, errorMsg.c_str());
+        return 0;
+    }
+    femmState->setSolution(doc->pathName, theFSolver.solution);
+
+    for (const auto *values: { &amps, &volts, &fluxLinkage })
+    {
+        lua_newtable(L);
+        for (int i=0; i<(int)values->size(); i++)
+        {
+            lua_pushstring(L, fpproc.circproplist[i].CircName.c_str());
+            lua_newtable(L);
+            for (int k=0; k<(int)(*values)[i].size(); k++)
+            {
+                lua_pushnumber(L, k+1);
+                lua_pushnumber(L, (*values)[i][k]);
+                lua_settable(L, -3);
+            }
+            lua_settable(L, -3);
+        }
+    }
+    return 3;
+}
+
+/**
+ * @brief Solve the problem for a series of rotor positions.
+ * The problem is meshed only once. For each step, the inner ring (rotor) of an air gap element
+ * is turned, which only changes how the ring nodes are connected to the air gap element.
+ * The solver starts from the solution of the previous step.
+ * If the global variable "XFEMM_VERBOSE" is set to 1, the mesher and solver is more verbose and prints statistics.
+ * @param L
+ * @return 2
+ * \ingroup LuaMM
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mi_sweeprotor(agename,startangle,stepangle,steps[,archive])}
+ *   Turns the inner ring of air gap element agename to startangle, startangle+stepangle, ...
+ *   (steps positions; the outer angle of the boundary property is kept).
+ *   Returns a table with the torque of each step, as returned by mo_gapintegral(agename,0),
+ *   and a table that holds a table with the flux linkage of each step for each circuit name.
+ *   If archive is given, the solution of each step is appended to that solution archive.
+ *   Afterwards, mi_loadsolution() loads the solution of the last step.
+ *
+ * \note This function does not exist in FEMM42.
+ * \endinternal
+ */
+int femmcli::LuaMagneticsCommands::luaSweepRotor(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<femm::FemmProblem> doc = femmState->femmDocument();
+
+    if (!luaExpectParameterCount(L, 4, 5))
+        return 0;
+    std::string ageName = lua_tostring(L,1);
+    double startAngle = lua_todouble(L,2);
+    double stepAngle = lua_todouble(L,3);
+    int steps = (int)lua_todouble(L,4);
+    std::string archive;
+    if (lua_gettop(L) > 4)
+        archive = lua_tostring(L,5);
+
+    const CBoundaryProp *ageProp = nullptr;
+    for (const auto &prop: doc->lineproplist)
+    {
+        if (prop->BdryName == ageName && (prop->BdryFormat == 6 || prop->BdryFormat == 7))
+            ageProp = prop.get();
+    }
+    if (!ageProp)
+    {
+        std::string msg = "mi_sweeprotor(): No air gap element boundary named " + ageName + "\n";
+        lua_error(L, msg.c_str());
+        return 0;
+    }
+    if (steps < 1)
+    {
+        lua_error(L, "mi_sweeprotor(): The number of steps must be positive\n");
+        return 0;
+    }
+    if (doc->problemType != PLANAR || doc->Frequency != 0)
+    {
+        lua_error(L, "mi_sweeprotor(): Rotor sweeps need a planar magnetostatic problem\n");
+        return 0;
+    }
+
+    std::shared_ptr<fmesher::FMesher> mesherDoc = meshProblem(L, "mi_sweeprotor");
+    if (!mesherDoc)
+        return 0;
+    const bool verbose = mesherDoc->Verbose;
+
+    FSolver theFSolver;
+    // filename.fem -> filename
+    std::size_t dotpos = doc->pathName.find_last_of(".");
+    theFSolver.PathName = doc->pathName.substr(0,dotpos);
+    theFSolver.WarnMessage = &PrintWarningMsg;
+    theFSolver.PrintMessage = &PrintWarningMsg;
+    theFSolver.previousSolutionFile = doc->previousSolutionFile;
+    if (!theFSolver.LoadProblemFile())
+    {
+        lua_error(L, "mi_sweeprotor(): problem initializing solver!");
+        return 0;
+    }
+    theFSolver.meshData = mesherDoc->mesh;
+    theFSolver.keepSolution = true;
+    // a .ans file could only hold one of the steps
+    theFSolver.writeSolutionFile = false;
+    theFSolver.warmStart = true;
+    femmState->setSolution(doc->pathName, nullptr);
+    if (!theFSolver.prepareMesh(verbose))
+    {
+        lua_error(L, "mi_sweeprotor(): problem loading the mesh!");
+        return 0;
+    }
+
+    std::vector<double> torque;
+    std::vector<std::vector<double>> fluxLinkage;
+    FPProc fpproc;
+    for (int step=0; step<steps; step++)
+    {
+        if (!theFSolver.setAirGapAngles(ageName, startAngle + step*stepAngle, ageProp->OuterAngle))
+        {
+            lua_error(L, "mi_sweeprotor(): Could not turn the air gap element!\n");
+            return 0;
+        }
+        if (!theFSolver.solveMesh(verbose))
+        {
+            lua_error(L, "solver failed.");
+            return 0;
+        }
+        if (!fpproc.OpenDocument(*theFSolver.solution))
+        {
+            lua_error(L, "mi_sweeprotor(): Could not load the solution!\n");
+            return 0;
+        }
+
+        double tq = 0;
+        fpproc.gapDCTorqueIntegral(ageName, tq);
+        torque.push_back(tq);
+        fluxLinkage.resize(fpproc.circproplist.size());
+        for (int i=0; i<(int)fpproc.circproplist.size(); i++)
+            fluxLinkage[i].push_back(Re(fpproc.GetFluxLinkage(i)));
+
+        std::stringstream err;
+        if (!archive.empty() && !theFSolver.solution->appendToArchive(archive, err))
+        {
+            std::string msg = "mi_sweeprotor(): " + err.str();
+            lua_error(L, msg.c_str());
+            return 0;
+        }
+    }
+    femmState->setSolution(doc->pathName, theFSolver.solution);
+
+    lua_newtable(L);
+    for (int k=0; k<steps; k++)
+    {
+        lua_pushnumber(L, k+1);
+        lua_pushnumber(L, torque[k]);
+        lua_settable(L, -3);
+    }
+    lua_newtable(L);
+    for (int i=0; i<(int)fluxLinkage.size(); i++)
+    {
+        lua_pushstring(L, fpproc.circproplist[i].CircName.c_str());
+        lua_newtable(L);
+        for (int k=0; k<steps; k++)
+        {
+            lua_pushnumber(L, k+1);
+            lua_pushnumber(L, fluxLinkage[i][k]);
+            lua_settable(L, -3);
+        }
+        lua_settable(L, -3);
+    }
+    return 2;
+}
+
 /**
  * @brief Bend the end of the contour line.
  * Replaces the straight line formed by the last two
@@ -2051,8 +2619,11 @@ int femmcli::LuaMagneticsCommands::luaSetPrevious(lua_State *L)
  * \ingroup LuaMM
  * \internal
  * ### Implements:
- * - \lua{mi_probdef(frequency,(units),(type),(precision),(depth),(minangle),(acsolver))}
+ * - \lua{mi_probdef(frequency,(units),(type),(precision),(depth),(minangle),(acsolver),(restart))}
  *   A negative depth is interpreted as positive depth.
+ *   In addition to FEMM's acsolver values 0 (successive approximation) and 1 (Newton),
+ *   xfemm accepts 2 (successive approximation using GMRES).
+ *   The restart length of the GMRES solver can be given as additional parameter.
  *
  * ### FEMM source:
  * - \femm42{femm/femmeLua.cpp,lua_prob_def()}
@@ -2065,7 +2636,7 @@ int femmcli::LuaMagneticsCommands::luaProblemDefinition(lua_State * L)
     std::shared_ptr<femm::FemmProblem> magDoc = femmState->femmDocument();
 
     // argument count
-    luaExpectParameterCount(L, 1,7);
+    luaExpectParameterCount(L, 1,8);
     int n=lua_gettop(L);
 
     // Frequency
@@ -2124,10 +2695,20 @@ int femmcli::LuaMagneticsCommands::luaProblemDefinition(lua_State * L)
     if (n==6) return 0;
 
     int acSolver = (int)lua_tonumber(L,7).re;
-    if ((acSolver==0) || (acSolver==1))
+    if ((acSolver>=0) && (acSolver<=2))
     {
         magDoc->ACSolver=acSolver;
     }
+    if (n==7) return 0;
+
+    int restart = (int)lua_tonumber(L,8).re;
+    if (restart < 1)
+    {
+        std::string msg = "Invalid GMRES restart length " + std::to_string(restart);
+        lua_error(L,msg.c_str());
+        return 0;
+    }
+    magDoc->GMRESRestart = restart;
     return 0;
 }
 
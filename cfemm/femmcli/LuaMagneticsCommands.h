@@ -48,6 +48,8 @@ int luaAddContourPoint(lua_State *L);
 int luaAddMatProperty(lua_State *L);
 int luaAddPointProperty(lua_State *L);
 int luaAnalyze(lua_State *L);
+int luaAnalyzeAdaptive(lua_State *L);
+int luaArchiveSolution(lua_State *L);
 int luaBendContourLine(lua_State *L);
 int luaBlockIntegral(lua_State *L);
 int luaGapIntegral(lua_State *L);
@@ -61,11 +63,13 @@ int luaGetPointValues(lua_State *L);
 int luaBGradient(lua_State *L);
 int luaGroupSelectBlock(lua_State *L);
 int luaLineIntegral(lua_State *L);
+int luaLoadArchiveStep(lua_State *L);
 int luaModifyBoundaryProperty(lua_State *L);
 int luaModifyCircuitProperty(lua_State *L);
 int luaModifyMaterialProperty(lua_State *L);
 int luaModifyPointProperty(lua_State *L);
 int luaNewDocument(lua_State *L);
+int luaNumArchiveSteps(lua_State *L);
 int luaProblemDefinition(lua_State *L);
 int luaSelectOutputBlocklabel(lua_State *L);
 int luaAddContourPointFromNode(lua_State *L);
@@ -75,6 +79,8 @@ int luaSetNodeProperty(lua_State *L);
 int luaSetPrevious(lua_State *L);
 int luaSetSmoothing(lua_State *L);
 int luaSetSegmentProperty(lua_State *L);
+int luaSweepFrequency(lua_State *L);
+int luaSweepRotor(lua_State *L);
 int luaGetGapB(lua_State *L);
 int luaGetGapA(lua_State *L);
 int luaGetGapHarmonics(lua_State *L);
@@ -0,0 +1,248 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "LuaServer.h"
+
+#include "lua.h"
+
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace femmcli;
+
+namespace {
+
+/// maximum length of a request header; longer lines are cut off, and thus rejected as invalid
+constexpr std::size_t MaxHeaderLength = 64;
+
+/// Read a line without its line ending; returns \c false at the end of the input.
+bool readLine(std::FILE *in, std::string &line)
+{
+    line.clear();
+    int c;
+    while ((c = std::fgetc(in)) != EOF && c != '\n')
+    {
+        if (line.size() <= MaxHeaderLength)
+            line += (char)c;
+    }
+    if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+    return c != EOF || !line.empty();
+}
+
+void writeResponse(std::FILE *out, bool ok, const std::string &payload)
+{
+    std::fprintf(out, "%s %lu\n", ok ? "ok" : "error", (unsigned long)payload.size());
+    std::fwrite(payload.data(), 1, payload.size(), out);
+    std::fflush(out);
+}
+
+} // anonymous namespace
+
+LuaServer::LuaServer(femm::LuaInstance &li)
+    : li(li)
+{
+}
+
+int LuaServer::serveStdio()
+{
+    // Keep the original stdout for the responses, and send everything else that is written to stdout to stderr.
+    std::cout.flush();
+    std::fflush(stdout);
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    std::FILE *out = _fdopen(_dup(_fileno(stdout)), "wb");
+    _dup2(_fileno(stderr), _fileno(stdout));
+#else
+    std::FILE *out = fdopen(dup(fileno(stdout)), "wb");
+    dup2(fileno(stderr), fileno(stdout));
+#endif
+    if (!out)
+    {
+        std::cerr << "Could not open the response stream\n";
+        return 1;
+    }
+    StreamEnd end = serveStream(stdin, out);
+    std::fclose(out);
+    return (end == StreamEnd::ProtocolError) ? 1 : 0;
+}
+
+int LuaServer::serveSocket(const std::string &path)
+{
+#ifdef _WIN32
+    std::cerr << "UNIX domain sockets are not supported on this platform, use stdin instead.\n";
+    (void)path;
+    return 1;
+#else
+    sockaddr_un address {};
+    if (path.empty() || path.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "Invalid socket path: " << path << "\n";
+        return 1;
+    }
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, path.size());
+
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path.c_str());
+    if (listenFd < 0
+            || bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+            || listen(listenFd, 4) != 0)
+    {
+        std::cerr << "Could not listen on socket " << path << "\n";
+        if (listenFd >= 0)
+            close(listenFd);
+        return 1;
+    }
+    // a client that goes away must not kill the server
+    std::signal(SIGPIPE, SIG_IGN);
+    if (!quiet)
+        std::cerr << "Listening on " << path << "\n";
+
+    StreamEnd end = StreamEnd::EndOfInput;
+    while (end != StreamEnd::Quit)
+    {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0 && errno == EINTR)
+            continue;
+        if (fd < 0)
+            break;
+        std::FILE *in = fdopen(fd, "rb");
+        std::FILE *out = fdopen(dup(fd), "wb");
+        if (in && out)
+            end = serveStream(in, out);
+        if (in)
+            std::fclose(in);
+        else
+            close(fd);
+        if (out)
+            std::fclose(out);
+    }
+    close(listenFd);
+    unlink(path.c_str());
+    return 0;
+#endif
+}
+
+bool LuaServer::handleRequest(const std::string &chunk, std::string &payload)
+{
+    lua_State *L = li.getLuaState();
+    const int stackTop = lua_gettop(L);
+
+    // capture error messages instead of printing them
+    lua_getglobal(L, LUA_ERRORMESSAGE); //+1
+    lua_pushuserdata(L, this); //+1
+    lua_pushcclosure(L, luaCaptureError, 1); //-1,+1
+    lua_setglobal(L, LUA_ERRORMESSAGE); //-1
+    errorMessage.clear();
+
+    const int err = li.doBuffer(chunk, "request", femm::LuaInstance::LuaStackMode::Unsafe);
+
+    payload.clear();
+    if (err == 0)
+    {
+        for (int i=stackTop+2; i<=lua_gettop(L); i++)
+        {
+            const char *value = nullptr;
+            if (lua_isnumber(L, i) || lua_isstring(L, i))
+                value = lua_tostring(L, i);
+            else
+                value = lua_typename(L, lua_type(L, i));
+            payload += value;
+            payload += '\n';
+        }
+    } else {
+        payload = errorMessage;
+        if (payload.empty())
+            payload = (err == LUA_ERRSYNTAX) ? "syntax error" : "error running chunk";
+    }
+
+    // restore the previous error handler
+    lua_pushvalue(L, stackTop+1); //+1
+    lua_setglobal(L, LUA_ERRORMESSAGE); //-1
+    lua_settop(L, stackTop);
+    return err == 0;
+}
+
+LuaServer::StreamEnd LuaServer::serveStream(std::FILE *in, std::FILE *out)
+{
+    std::string header;
+    while (readLine(in, header))
+    {
+        if (header == "quit")
+        {
+            writeResponse(out, true, std::string());
+            return StreamEnd::Quit;
+        }
+        char *end = nullptr;
+        errno = 0;
+        const unsigned long length = std::strtoul(header.c_str(), &end, 10);
+        if (header.empty() || header.size() > MaxHeaderLength || *end != '\0'
+                || !std::isdigit((unsigned char)header[0]))
+        {
+            writeResponse(out, false, "invalid request header: " + header.substr(0, MaxHeaderLength));
+            return StreamEnd::ProtocolError;
+        }
+        // the chunk is not read, so the stream can not be continued
+        if (errno == ERANGE || length > maxRequestSize)
+        {
+            writeResponse(out, false, "request too large: " + header + " bytes (limit: "
+                          + std::to_string(maxRequestSize) + " bytes)");
+            return StreamEnd::ProtocolError;
+        }
+        std::string chunk(length, '\0');
+        if (length > 0 && std::fread(&chunk[0], 1, length, in) != length)
+        {
+            writeResponse(out, false, "incomplete request");
+            return StreamEnd::ProtocolError;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        std::string payload;
+        const bool ok = handleRequest(chunk, payload);
+        std::cout.flush();
+        std::fflush(stdout);
+        writeResponse(out, ok, payload);
+        requestCount++;
+        if (!quiet)
+        {
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::ostringstream line;
+            line << "Request " << requestCount << ": " << (ok ? "ok" : "error")
+                 << " (" << std::fixed << std::setprecision(2) << ms << "ms)\n";
+            std::cerr << line.str();
+        }
+    }
+    return StreamEnd::EndOfInput;
+}
+
+int LuaServer::luaCaptureError(lua_State *L)
+{
+    // the upvalue follows the arguments
+    LuaServer *me = static_cast<LuaServer*>(lua_touserdata(L, -1));
+    const char *message = lua_isstring(L, 1) ? lua_tostring(L, 1) : nullptr;
+    if (me && message)
+        me->errorMessage = message;
+    return 0;
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -0,0 +1,97 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#ifndef FEMMCLI_LUASERVER_H
+#define FEMMCLI_LUASERVER_H
+
+#include "LuaInstance.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+namespace femmcli
+{
+
+/**
+ * @brief The LuaServer class runs lua chunks that it receives from a client in one long-running lua instance.
+ *
+ * The lua instance, its FemmState, cached meshes and loaded solutions stay alive between requests,
+ * so that a client only pays for the initialization once.
+ * Requests are handled one after the other.
+ *
+ * Protocol
+ * --------
+ * A request is a header line with the length of the lua chunk in bytes, followed by the chunk:
+ *
+ *     <length>\n<lua chunk>
+ *
+ * The header line \c quit stops the server.
+ * A request that is longer than maxRequestSize is answered with \c error, and the connection is closed.
+ * Each request is answered with a header line with the status (\c ok or \c error) and the length of the payload,
+ * followed by the payload:
+ *
+ *     ok <length>\n<payload>
+ *     error <length>\n<payload>
+ *
+ * The payload of a successful request contains the values that the chunk returns, each of them followed by a newline.
+ * Numbers and strings are formatted as \c tostring() does, other values by their type name.
+ * The payload of a failed request is the error message.
+ *
+ * Output of the lua chunk and of the solvers, e.g. by \c print(), does not go to the client.
+ * When the client talks to the server over stdin and stdout, that output goes to stderr instead.
+ */
+class LuaServer
+{
+public:
+    explicit LuaServer(femm::LuaInstance &li);
+
+    /// \brief If set, do not log the requests to stderr
+    bool quiet = false;
+    /// \brief Maximum length of a lua chunk in bytes; longer requests are rejected before reading them
+    std::size_t maxRequestSize = 64*1024*1024;
+
+    /**
+     * @brief Read requests from stdin and write the responses to stdout, until the input ends.
+     * @return 0 on success, 1 on protocol errors.
+     */
+    int serveStdio();
+
+    /**
+     * @brief Listen on a UNIX domain socket, and serve the connections one after the other until a client sends \c quit.
+     * @param path the path of the socket; an existing file is replaced.
+     * @return 0 on success, 1 if the socket can not be created.
+     */
+    int serveSocket(const std::string &path);
+
+    /**
+     * @brief Run a lua chunk, and format its response.
+     * @param chunk the lua chunk
+     * @param payload the payload of the response
+     * @return \c true if the chunk ran without errors, \c false otherwise.
+     */
+    bool handleRequest(const std::string &chunk, std::string &payload);
+
+private:
+    enum class StreamEnd { EndOfInput, Quit, ProtocolError };
+
+    /// Serve the requests of a client, until its input ends or it sends \c quit.
+    StreamEnd serveStream(std::FILE *in, std::FILE *out);
+    /// Lua error handler that stores the error message in the server, which is its upvalue.
+    static int luaCaptureError(lua_State *L);
+
+    femm::LuaInstance &li;
+    int requestCount = 0;
+    /// error message of the current request
+    std::string errorMessage;
+};
+
+} // namespace femmcli
+
+#endif
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -9,6 +9,7 @@
  * along with the source code.
  */
 
+#include "BatchRunner.h"
 #include "CliTools.h"
 #include "FemmState.h"
 #include "femmversion.h"
@@ -19,12 +20,17 @@
 #include "LuaElectrostaticsCommands.h"
 #include "LuaHeatflowCommands.h"
 #include "LuaMagneticsCommands.h"
+#include "LuaServer.h"
 #include "stringTools.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
+#include <functional>
 #include <memory>
 #include <iostream>
 #include <string>
+#include <thread>
 
 #define DEBUG_FEMMCLI
 #ifdef DEBUG_FEMMCLI
@@ -43,18 +49,14 @@ using namespace femmcli;
 bool quiet = false;
 
 /**
- * \brief Execute a Lua File
- * \param inputFile the lua file
+ * \brief Register the femm commands in a lua instance, and run the initialization code
+ * \param li the lua instance
  * \param luaInit a lua file containing initialization code
  * \param luaTrace enable function tracing for lua
  * \param luaBaseDir base directory for lua
- * \return the result of lua_dostring()
  */
-int execLuaFile( const std::string &inputFile, const std::string &luaInit, bool luaTrace, const std::string &luaBaseDir, bool luaPedanticMode, bool luaDebugGeometry)
+void initLuaInstance( LuaInstance &li, const std::string &luaInit, bool luaTrace, const std::string &luaBaseDir, bool luaPedanticMode, bool luaDebugGeometry)
 {
-    // initialize interpreter
-    shared_ptr<FemmState> state = make_shared<FemmState>();
-    LuaInstance li(static_pointer_cast<FemmStateBase>(state));
     LuaBaseCommands::registerCommands(li);
     LuaMagneticsCommands::registerCommands(li);
     LuaElectrostaticsCommands::registerCommands(li);
@@ -83,8 +85,33 @@ int execLuaFile( const std::string &inputFile, const std::string &luaInit, bool
             }
         }
     }
+}
 
+/**
+ * \brief Execute a Lua File
+ * \param inputFile the lua file
+ * \param luaInit a lua file containing initialization code
+ * \param luaTrace enable function tracing for lua
+ * \param luaBaseDir base directory for lua
+ * \param meshCacheDir directory for on-disk mesh cache entries, or empty to keep them only in memory
+ * \param beforeScript if set, called after the initialization and before the lua file is executed
+ * \param afterScript if set, called after the lua file has been executed
+ * \return the result of lua_dostring()
+ */
+int execLuaFile( const std::string &inputFile, const std::string &luaInit, bool luaTrace, const std::string &luaBaseDir, bool luaPedanticMode, bool luaDebugGeometry, const std::string &meshCacheDir,
+                 const std::function<void(LuaInstance&)> &beforeScript = nullptr, const std::function<void(LuaInstance&)> &afterScript = nullptr)
+{
+    // initialize interpreter
+    shared_ptr<FemmState> state = make_shared<FemmState>();
+    state->meshCache()->setDirectory(meshCacheDir);
+    LuaInstance li(static_pointer_cast<FemmStateBase>(state));
+    initLuaInstance(li, luaInit, luaTrace, luaBaseDir, luaPedanticMode, luaDebugGeometry);
+
+    if (beforeScript)
+        beforeScript(li);
     int err = li.doFile(inputFile);
+    if (afterScript)
+        afterScript(li);
     switch(err)
     {
         case 0:
@@ -115,6 +142,25 @@ int execLuaFile( const std::string &inputFile, const std::string &luaInit, bool
     return err;
 }
 
+/**
+ * \brief Serve lua chunks from stdin or a UNIX domain socket in one long-running lua instance
+ * \param socketPath path of the socket, or empty to use stdin and stdout
+ * \return 0 on success
+ */
+int runServer( const std::string &socketPath, const std::string &luaInit, bool luaTrace, const std::string &luaBaseDir, bool luaPedanticMode, bool luaDebugGeometry, const std::string &meshCacheDir)
+{
+    shared_ptr<FemmState> state = make_shared<FemmState>();
+    state->meshCache()->setDirectory(meshCacheDir);
+    LuaInstance li(static_pointer_cast<FemmStateBase>(state));
+    initLuaInstance(li, luaInit, luaTrace, luaBaseDir, luaPedanticMode, luaDebugGeometry);
+
+    LuaServer server(li);
+    server.quiet = quiet;
+    if (socketPath.empty())
+        return server.serveStdio();
+    return server.serveSocket(socketPath);
+}
+
 int main(int argc, char ** argv)
 {
     std::string exe { argv[0] };
@@ -126,6 +172,13 @@ int main(int argc, char ** argv)
     bool luaTrace = false;
     bool luaPedanticMode = false;
     bool luaDebugGeometry = false;
+    std::string meshCacheDir;
+    std::string batchFile;
+    std::string batchSummary;
+    std::string batchGlobals;
+    int batchJobs = std::max(1, (int)std::thread::hardware_concurrency());
+    bool serverMode = false;
+    std::string serverSocket;
 
     for(int i=1; i<argc; i++)
     {
@@ -178,6 +231,54 @@ int main(int argc, char ** argv)
                 std::cerr << "Using custom base directory " << baseDir << std::endl;
             continue;
         }
+        if (arg == "--mesh-cache-dir")
+        {
+            if (value.empty())
+            {
+                i++;
+                if (i<argc)
+                    meshCacheDir = argv[i];
+            } else {
+                meshCacheDir = value;
+            }
+            continue;
+        }
+        if (arg == "--batch" || arg == "--batch-summary" || arg == "--batch-globals" || arg == "--jobs")
+        {
+            if (value.empty())
+            {
+                i++;
+                if (i<argc)
+                    value = argv[i];
+            }
+            if (arg == "--batch")
+                batchFile = value;
+            else if (arg == "--batch-summary")
+                batchSummary = value;
+            else if (arg == "--batch-globals")
+                batchGlobals = value;
+            else
+                batchJobs = std::atoi(value.c_str());
+            continue;
+        }
+        if (arg == "--server")
+        {
+            serverMode = true;
+            continue;
+        }
+        if (arg == "--server-socket")
+        {
+            if (value.empty())
+            {
+                i++;
+                if (i<argc)
+                    serverSocket = argv[i];
+            } else {
+                serverSocket = value;
+            }
+            serverMode = true;
+            continue;
+        }
         if (arg == "--version" )
         {
             std::cout << "femmcli version " << FEMM_VERSION_STRING << "\n"
@@ -211,10 +312,19 @@ int main(int argc, char ** argv)
         }
         std::cout << "Command-line interpreter for FEMM-specific lua files.\n";
         std::cout << "\n";
-        std::cout << "Usage: " << exe << " [-q|--quiet] [--lua-trace-functions] [--lua-pedantic-mode] [--lua-init=<init.lua>] [--lua-base-dir=<dir>] --lua-script=<file.lua>\n";
+        std::cout << "Usage: " << exe << " [-q|--quiet] [--lua-trace-functions] [--lua-pedantic-mode] [--lua-init=<init.lua>] [--lua-base-dir=<dir>] [--mesh-cache-dir=<dir>] --lua-script=<file.lua>\n";
+        std::cout << "       " << exe << " [options] --batch=<jobs.txt> [--jobs=<n>] [--batch-summary=<file>] [--batch-globals=<name>,...]\n";
+        std::cout << "       " << exe << " [options] --server|--server-socket=<path>\n";
         std::cout << "       " << exe << " [-h|--help] [--version]\n";
         std::cout << "\n";
         std::cout << "Command line arguments:\n";
+        std::cout << " --batch=<jobs.txt>       Run the jobs of a job file concurrently. Each line of the job file is\n";
+        std::cout << "                          \"<file.lua> [dir=<working directory>] [<name>=<value>]...\",\n";
+        std::cout << "                          where each name=value pair sets a lua global before the script runs.\n";
+        std::cout << " --batch-globals=<names>  Comma separated list of lua globals to collect into the batch summary.\n";
+        std::cout << " --batch-summary=<file>   Write the batch summary to <file>. [default: <jobs.txt>.summary]\n";
+        std::cout << " --jobs=<n>               Number of batch jobs that run at the same time.\n";
+        std::cout << "                          [default: " << batchJobs << "]\n";
         std::cout << " --lua-base-dir=<dir>     Set base directory for matlib.dat.\n";
         std::cout << "                          [default: " << baseDir << "]\n";
         std::cout << " --lua-debug-geometry     Debug lua functions that change the geometry of the model\n";
@@ -223,6 +333,12 @@ int main(int argc, char ** argv)
         std::cout << " --lua-pedantic-mode      Additional checks for lua scripts.\n";
         std::cout << " --lua-script=<file.lua>  Execute the lua file.\n";
         std::cout << " --lua-trace-functions    Show what lua functions are being executed.\n";
+        std::cout << " --mesh-cache-dir=<dir>   Keep meshes of analyzed problems in <dir> for use in later runs.\n";
+        std::cout << " --server                 Keep running, and execute the lua chunks of requests read from stdin.\n";
+        std::cout << "                          Each request is \"<length>\\n<lua chunk>\", and is answered on stdout\n";
+        std::cout << "                          with \"ok <length>\\n<returned values>\" or \"error <length>\\n<message>\".\n";
+        std::cout << "                          Other output goes to stderr. The request \"quit\" stops the server.\n";
+        std::cout << " --server-socket=<path>   Like --server, but serve the requests of clients of a UNIX domain socket.\n";
         std::cout << "\n";
         std::cout << "Additional options:\n";
         std::cout << " -h, --help               Show this help message and exit.\n";
@@ -241,12 +357,41 @@ int main(int argc, char ** argv)
         std::cout << "\n";
         return exitval;
     }
+    if (!batchFile.empty())
+    {
+        BatchRunner runner;
+        runner.quiet = quiet;
+        if (!runner.readJobFile(batchFile))
+            return 1;
+        std::string names = batchGlobals;
+        while (!names.empty())
+        {
+            std::size_t pos = names.find(',');
+            if (pos > 0)
+                runner.collectedGlobals.push_back(names.substr(0, pos));
+            names.erase(0, (pos == std::string::npos) ? pos : pos+1);
+        }
+        int failed = runner.run(batchJobs, [&](const BatchJob &job, std::vector<std::string> &values) {
+            return execLuaFile(job.script, luaInit, luaTrace, baseDir, luaPedanticMode, luaDebugGeometry, meshCacheDir,
+                               [&](LuaInstance &li) { BatchRunner::setGlobals(li, job); },
+                               [&](LuaInstance &li) { values = BatchRunner::getGlobals(li, runner.collectedGlobals); });
+        });
+        if (batchSummary.empty())
+            batchSummary = batchFile + ".summary";
+        if (!runner.writeSummary(batchSummary))
+            return 1;
+        if (!quiet)
+            std::cerr << runner.jobs().size()-failed << " of " << runner.jobs().size() << " jobs succeeded\n";
+        return (failed == 0) ? 0 : 1;
+    }
+    if (serverMode)
+        return runServer(serverSocket, luaInit, luaTrace, baseDir, luaPedanticMode, luaDebugGeometry, meshCacheDir);
     if (inputFile.empty())
     {
         std::cerr << "No file name given! Try \"femmcli --help\"...\n";
         return 1;
     }
 
-    return execLuaFile(inputFile, luaInit, luaTrace, baseDir, luaPedanticMode, luaDebugGeometry);
+    return execLuaFile(inputFile, luaInit, luaTrace, baseDir, luaPedanticMode, luaDebugGeometry, meshCacheDir);
 }
 // vi:expandtab:tabstop=4 shiftwidth=4:
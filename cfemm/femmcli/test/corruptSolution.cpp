@@ -0,0 +1,259 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+// corruptSolution.cpp
+// Checks that corrupted binary solution files are rejected instead of crashing the post processors.
+// A magnetics and a heat flow problem are solved, their solutions are written as binary files,
+// and single values of the files are overwritten with numbers that are out of range,
+// or arrays are written with a length that does not match the problem.
+// It also checks that long lines of the problem description are read completely.
+//
+// Usage: corruptSolution <magnetics problem> <heat flow problem>
+
+#include "FemmReader.h"
+#include "SolutionData.h"
+#include "fmesher.h"
+#include "fpproc.h"
+#include "fsolver.h"
+#include "hpproc.h"
+#include "hsolver.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace femm;
+
+namespace {
+
+// section ids of the binary solution file format (see SolutionData.cpp)
+constexpr uint32_t ElementsSection = 7;
+constexpr uint32_t ElementLabelSection = 8;
+constexpr uint32_t LabelCircuitValueSection = 11;
+
+int failed = 0;
+
+void check(const std::string &name, bool ok)
+{
+    std::cout << (ok ? "[  ok  ] " : "[FAILED] ") << name << std::endl;
+    if (!ok)
+        failed++;
+}
+
+std::shared_ptr<const MeshData> meshProblem(const std::string &file, FileType type)
+{
+    fmesher::FMesher mesher;
+    mesher.problem->filetype = type;
+    ParserResult status;
+    if (type == FileType::MagneticsFile)
+    {
+        MagneticsReader reader(mesher.problem, std::cerr);
+        status = reader.parse(file);
+    } else {
+        HeatFlowReader reader(mesher.problem, std::cerr);
+        status = reader.parse(file);
+    }
+    if (status != F_FILE_OK)
+        return nullptr;
+
+    mesher.writeMeshFiles = false;
+    int err = mesher.HasPeriodicBC()
+            ? mesher.DoPeriodicBCTriangulation(file)
+            : mesher.DoNonPeriodicBCTriangulation(file);
+    if (err != 0)
+        return nullptr;
+    return mesher.mesh;
+}
+
+/// Solve a problem and keep the solution in memory.
+template <class SolverT>
+std::shared_ptr<SolutionData> solve(const std::string &file, FileType type)
+{
+    SolverT solver;
+    // filename.fem -> filename
+    solver.PathName = file.substr(0, file.find_last_of("."));
+    if (!solver.LoadProblemFile())
+        return nullptr;
+    solver.meshData = meshProblem(file, type);
+    if (!solver.meshData)
+        return nullptr;
+    solver.keepSolution = true;
+    solver.writeSolutionFile = false;
+    if (!solver.runSolver(false))
+        return nullptr;
+    return solver.solution;
+}
+
+std::string readFile(const std::string &file)
+{
+    std::ifstream input(file, std::ios::in | std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+}
+
+void writeFile(const std::string &file, const std::string &contents)
+{
+    std::ofstream output(file, std::ios::out | std::ios::binary | std::ios::trunc);
+    output.write(contents.data(), contents.size());
+}
+
+/**
+ * @brief Find a section in the contents of a binary solution file.
+ * @return the position of the section table entry, or 0 if there is no such section
+ */
+size_t findSection(const std::string &contents, uint32_t id)
+{
+    // header: 8 bytes magic, version, byte order, file type, number of sections
+    uint32_t numSections;
+    std::memcpy(&numSections, contents.data() + 20, sizeof(numSections));
+    for (uint32_t i=0; i<numSections; i++)
+    {
+        // table entry: id, item size, offset, count
+        const size_t entry = 24 + 24*i;
+        uint32_t entryId;
+        std::memcpy(&entryId, contents.data() + entry, sizeof(entryId));
+        if (entryId == id)
+            return entry;
+    }
+    return 0;
+}
+
+/// Overwrite the first item of an int32 section.
+std::string corruptItem(std::string contents, uint32_t id, int32_t value)
+{
+    const size_t entry = findSection(contents, id);
+    uint64_t offset;
+    std::memcpy(&offset, contents.data() + entry + 8, sizeof(offset));
+    std::memcpy(&contents[offset], &value, sizeof(value));
+    return contents;
+}
+
+/// Change the number of items of a section.
+std::string corruptCount(std::string contents, uint32_t id, int64_t delta)
+{
+    const size_t entry = findSection(contents, id);
+    uint64_t count;
+    std::memcpy(&count, contents.data() + entry + 16, sizeof(count));
+    count += delta;
+    std::memcpy(&contents[entry + 16], &count, sizeof(count));
+    return contents;
+}
+
+/// Check that both the solution reader and the post processor reject a file.
+template <class PostProcT>
+void checkRejected(const std::string &name, const std::string &file, const std::string &contents, bool readable)
+{
+    writeFile(file, contents);
+    SolutionData data;
+    std::stringstream err;
+    bool read = data.readBinary(file, err);
+    if (!readable)
+        check(name + ": solution data rejected (" + err.str().substr(0, err.str().find('\n')) + ")", !read);
+    PostProcT pproc;
+    check(name + ": post processor rejects the file", !pproc.OpenDocument(file));
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <magnetics problem> <heat flow problem>" << std::endl;
+        return 2;
+    }
+
+    // magnetics
+    {
+        auto solution = solve<FSolver>(argv[1], FileType::MagneticsFile);
+        check("magnetics problem solved", solution != nullptr);
+        if (!solution)
+            return 1;
+        const std::string file = "corruptSolution.ans";
+        solution->writeBinary(file);
+        const std::string contents = readFile(file);
+        size_t numLabels = 0;
+        {
+            FPProc pproc;
+            check("magnetics: intact file is read", pproc.OpenDocument(file));
+            numLabels = pproc.blocklist.size();
+        }
+        // a comment that is longer than any line buffer:
+        {
+            SolutionData longComment = *solution;
+            std::string &text = longComment.problemDescription;
+            const size_t pos = text.find("[Comment]");
+            const std::string comment = "a long comment " + std::string(5000, 'x') + " that ends here";
+            text.replace(pos, text.find('\n', pos) - pos, "[Comment] = \"" + comment + "\"");
+            longComment.writeBinary(file);
+            FPProc pproc;
+            check("magnetics: file with a long line is read", pproc.OpenDocument(file));
+            check("magnetics: long line is not cut off", pproc.ProblemNote == comment);
+            check("magnetics: lines after the long line are read", numLabels > 0 && pproc.blocklist.size() == numLabels);
+        }
+        checkRejected<FPProc>("magnetics: node number too large", file,
+                              corruptItem(contents, ElementsSection, solution->numNodes()), false);
+        checkRejected<FPProc>("magnetics: negative node number", file,
+                              corruptItem(contents, ElementsSection, -1), false);
+        checkRejected<FPProc>("magnetics: negative block label", file,
+                              corruptItem(contents, ElementLabelSection, -1), false);
+        // the number of block labels is only known to the post processor:
+        checkRejected<FPProc>("magnetics: block label too large", file,
+                              corruptItem(contents, ElementLabelSection, 1000000), true);
+        checkRejected<FPProc>("magnetics: circuit data without value", file,
+                              corruptCount(contents, LabelCircuitValueSection, -1), false);
+        // a consistent file, but with circuit data for more block labels than the problem has:
+        {
+            SolutionData extra = *solution;
+            extra.labelCircuitCase.resize(extra.labelCircuitCase.size() + 1000, 1);
+            extra.labelCircuitValue.resize(extra.labelCircuitValue.size() + 1000, 0);
+            extra.writeBinary(file);
+            checkRejected<FPProc>("magnetics: circuit data for too many block labels", file, readFile(file), true);
+        }
+        remove(file.c_str());
+    }
+
+    // heat flow
+    {
+        auto solution = solve<HSolver>(argv[2], FileType::HeatFlowFile);
+        check("heat flow problem solved", solution != nullptr);
+        if (!solution)
+            return 1;
+        const std::string file = "corruptSolution.anh";
+        solution->writeBinary(file);
+        const std::string contents = readFile(file);
+        {
+            HPProc pproc;
+            check("heat flow: intact file is read", pproc.OpenDocument(file));
+        }
+        checkRejected<HPProc>("heat flow: node number too large", file,
+                              corruptItem(contents, ElementsSection, solution->numNodes()), false);
+        checkRejected<HPProc>("heat flow: block label too large", file,
+                              corruptItem(contents, ElementLabelSection, 1000000), true);
+        {
+            SolutionData extra = *solution;
+            extra.conductorValue.push_back(0);
+            extra.writeBinary(file);
+            checkRejected<HPProc>("heat flow: conductor flux missing", file, readFile(file), false);
+        }
+        remove(file.c_str());
+    }
+
+    if (failed)
+        return 1;
+    std::cout << "SUCCESS" << std::endl;
+    return 0;
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -0,0 +1,157 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+// entityPool.cpp
+// Checks the EntityPool that allocates nodes, segments, arc segments and block labels:
+// objects of a class are next to each other, freed objects are reused,
+// block labels are freed through their virtual destructor,
+// and objects can be freed by other threads, also after their allocating thread has finished.
+//
+// Usage: entityPool <threads>
+
+#include "CArcSegment.h"
+#include "CBlockLabel.h"
+#include "CNode.h"
+#include "CSegment.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace femm;
+
+namespace {
+
+int failed = 0;
+
+void check(const std::string &name, bool ok)
+{
+    std::cout << (ok ? "[  ok  ] " : "[FAILED] ") << name << std::endl;
+    if (!ok)
+        failed++;
+}
+
+int destroyedLabels = 0;
+
+/// a derived class without an operator new of its own
+class CountedBlockLabel : public CMBlockLabel
+{
+public:
+    ~CountedBlockLabel() { destroyedLabels++; }
+    std::string padding = std::string(100, 'x');
+};
+
+/// The entities created by one thread.
+struct Entities
+{
+    std::vector<std::unique_ptr<CNode>> nodes;
+    std::vector<std::unique_ptr<CSegment>> lines;
+    std::vector<std::unique_ptr<CArcSegment>> arcs;
+    std::vector<std::unique_ptr<CBlockLabel>> labels;
+};
+
+void create(Entities &e, int count)
+{
+    for (int i=0; i<count; i++)
+    {
+        e.nodes.push_back(std::unique_ptr<CNode>(new CNode(i, -i)));
+        e.lines.push_back(std::unique_ptr<CSegment>(new CSegment));
+        e.lines.back()->BoundaryMarkerName = "a boundary name that does not fit into the small string buffer";
+        e.arcs.push_back(std::unique_ptr<CArcSegment>(new CArcSegment));
+        e.labels.push_back(std::unique_ptr<CBlockLabel>(new CMBlockLabel));
+        e.labels.push_back(std::unique_ptr<CBlockLabel>(new CHBlockLabel));
+        e.labels.push_back(std::unique_ptr<CBlockLabel>(new CSBlockLabel));
+        e.labels.back()->BlockTypeName = "a material name that does not fit into the small string buffer";
+    }
+}
+
+bool intact(const Entities &e)
+{
+    for (std::size_t i=0; i<e.nodes.size(); i++)
+    {
+        if (e.nodes[i]->x != i || e.nodes[i]->y != -(double)i)
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <threads>" << std::endl;
+        return 2;
+    }
+    int numThreads = std::atoi(argv[1]);
+
+    {
+        std::vector<std::unique_ptr<CNode>> nodes;
+        for (int i=0; i<16; i++)
+            nodes.push_back(std::unique_ptr<CNode>(new CNode(i,i)));
+        bool contiguous = true;
+        std::ptrdiff_t stride = (char*)nodes[1].get() - (char*)nodes[0].get();
+        for (int i=1; i<16; i++)
+            contiguous = contiguous && ((char*)nodes[i].get() - (char*)nodes[i-1].get() == stride);
+        check("nodes are allocated one after the other", contiguous && stride > 0 && stride < 2*(std::ptrdiff_t)sizeof(CNode));
+
+        CNode *freed = nodes[5].get();
+        nodes[5].reset();
+        nodes[5].reset(new CNode(5,5));
+        check("a freed node is reused", nodes[5].get() == freed);
+    }
+
+    {
+        std::unique_ptr<CBlockLabel> label(new CountedBlockLabel);
+        label->BlockTypeName = "magnet";
+        label.reset();
+        check("a derived block label is freed through its destructor", destroyedLabels == 1);
+    }
+
+    // every thread creates entities and hands them to its neighbour, which frees them;
+    // the creating threads finish before the entities are freed
+    std::vector<Entities> entities(numThreads);
+    std::vector<std::thread> threads;
+    for (int t=0; t<numThreads; t++)
+        threads.emplace_back([&entities,t]() { create(entities[t], 2000); });
+    for (auto &thread : threads)
+        thread.join();
+    threads.clear();
+
+    std::mutex mutex;
+    bool allIntact = true;
+    for (int t=0; t<numThreads; t++)
+    {
+        threads.emplace_back([&,t]() {
+            Entities &e = entities[(t+1) % numThreads];
+            bool ok = intact(e);
+            e = Entities();
+            // allocate again while the other threads free
+            Entities mine;
+            create(mine, 1000);
+            ok = ok && intact(mine);
+            std::lock_guard<std::mutex> lock(mutex);
+            allIntact = allIntact && ok;
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    check("entities are freed by other threads", allIntact);
+
+    if (failed)
+        return 1;
+    std::cout << "SUCCESS" << std::endl;
+    return 0;
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
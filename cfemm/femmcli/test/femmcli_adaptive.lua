@@ -0,0 +1,145 @@
+-- femmcli_adaptive.lua
+-- This checks that mi_analyzeadaptive, ei_analyzeadaptive and hi_analyzeadaptive
+-- refine the mesh until the estimated error goes down,
+-- and that the solution on the refined mesh can be post processed.
+-- The torque on an iron bar in a uniform field gets closer to a reference value
+-- computed on a fine uniform mesh when the mesh is refined.
+-- Output:
+-- SUCCESS
+showconsole()
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the relative error is larger than <tolerance>, complain and return 1
+function checkRel(name, value, expected, tolerance)
+	local err = abs(value - expected)
+	if expected ~= 0 then
+		err = err / abs(expected)
+	end
+	if err > tolerance then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ")")
+	return fail
+end
+
+function check(name, value, expected)
+	return checkRel(name, value, expected, 0)
+end
+
+function checkLess(name, value, bound)
+	if value < bound then
+		result="[  ok  ] "
+		fail=0
+	else
+		result="[FAILED] "
+		fail=1
+	end
+	print(result .. name .. ": " .. value .. " (expected less than " .. bound .. ")")
+	return fail
+end
+
+-- compare the initial mesh (0 refinement steps) with <steps> refinement steps
+function compareRefinement(label, analyze, steps)
+	local failed = 0
+	local err0, elements0, steps0 = analyze(1e-6, 0)
+	failed = failed + check(label .. ": steps without refinement", steps0, 0)
+	local err, elements, stepsDone = analyze(1e-6, steps)
+	failed = failed + check(label .. ": refinement steps", stepsDone, steps)
+	failed = failed + checkLess(label .. ": estimated error", err, err0)
+	failed = failed + checkLess(label .. ": initial number of elements", elements0, elements)
+	-- a target that is already met stops without refinement
+	err, elements, stepsDone = analyze(err0*1.01, steps)
+	failed = failed + check(label .. ": steps for a met target", stepsDone, 0)
+	failed = failed + check(label .. ": elements for a met target", elements, elements0)
+	return failed
+end
+
+failed=0
+
+-- a problem with periodic boundaries and an air gap element
+open("femmcli_antiperiodicBC_AGE_TorqueBenchmark.fem")
+mi_saveas("femmcli_adaptive.fem")
+mi_modifyboundprop("AGE", 10, 30)
+failed = failed + compareRefinement("magnetics", mi_analyzeadaptive, 2)
+err, elements, steps = mi_analyzeadaptive(1e-6, 1)
+mi_loadsolution()
+failed = failed + check("magnetics: elements of the loaded solution", mo_numelements(), elements)
+-- the analytical torque is sin(30 degrees)
+failed = failed + checkRel("magnetics: torque", mo_gapintegral("AGE", 0), 0.5, 1e-3)
+mo_close()
+-- invalid parameters
+result = call(mi_analyzeadaptive, {-1}, "x", function(msg) end)
+failed = failed + check("magnetics: negative target is rejected", (result == nil) and 1 or 0, 1)
+result = call(mi_analyzeadaptive, {0.1, 2, 1.5}, "x", function(msg) end)
+failed = failed + check("magnetics: fraction above 1 is rejected", (result == nil) and 1 or 0, 1)
+
+-- an iron bar turned by 30 degrees in a uniform field:
+-- the field is singular at the corners of the bar, where the mesh is refined
+newdocument(0)
+mi_probdef(0,"centimeters","planar",1e-8,1,30,0)
+function polygon(points)
+	local n = getn(points)
+	for i=1,n do
+		mi_addnode(points[i][1], points[i][2])
+	end
+	for i=1,n do
+		local j = mod(i,n)+1
+		mi_addsegment(points[i][1], points[i][2], points[j][1], points[j][2])
+	end
+end
+polygon({{-5,-5}, {5,-5}, {5,5}, {-5,5}})
+c = cos(PI/6)
+s = sin(PI/6)
+polygon({{-2*c+0.5*s, -2*s-0.5*c}, {2*c+0.5*s, 2*s-0.5*c}, {2*c-0.5*s, 2*s+0.5*c}, {-2*c-0.5*s, -2*s+0.5*c}})
+mi_addboundprop("uniform",0,-0.01,0,0,0,0,0,0,0)
+mi_selectsegment(0,-5)
+mi_selectsegment(5,0)
+mi_selectsegment(0,5)
+mi_selectsegment(-5,0)
+mi_setsegmentprop("uniform",0,1,0,0)
+mi_clearselected()
+mi_addmaterial("Air",1,1,0,0,0)
+mi_addmaterial("Iron",100,100,0,0,0)
+mi_addblocklabel(-4,-4)
+mi_addblocklabel(0,0)
+function setMeshSize(size)
+	mi_selectlabel(-4,-4)
+	mi_setblockprop("Air",0,size,"<None>",0,0,0)
+	mi_clearselected()
+	mi_selectlabel(0,0)
+	mi_setblockprop("Iron",0,size,"<None>",0,0,0)
+	mi_clearselected()
+end
+function barTorque()
+	mi_loadsolution()
+	mo_selectblock(0,0)
+	local torque = mo_blockintegral(22)
+	mo_close()
+	return torque
+end
+mi_saveas("femmcli_adaptive.fem")
+setMeshSize(0.05)
+mi_analyze(1)
+referenceTorque = barTorque()
+setMeshSize(1)
+mi_analyzeadaptive(1e-6, 0)
+initialError = abs(barTorque() - referenceTorque)
+mi_analyzeadaptive(1e-6, 2)
+refinedError = abs(barTorque() - referenceTorque)
+failed = failed + checkLess("magnetics: torque error after refinement", refinedError, initialError/5)
+
+open("femmcli_epproc.fee")
+ei_saveas("femmcli_adaptive.fee")
+failed = failed + compareRefinement("electrostatics", ei_analyzeadaptive, 2)
+
+open("femmcli_hpproc.feh")
+hi_saveas("femmcli_adaptive.feh")
+failed = failed + compareRefinement("heatflow", hi_analyzeadaptive, 2)
+
+assert(failed==0)
+write("SUCCESS\n")
@@ -0,0 +1,95 @@
+-- femmcli_batch.lua
+-- This checks the summary of "femmcli --batch femmcli_batch.jobs":
+-- the jobs must report the same temperature as solving the problem here,
+-- strings with blanks are handed to the jobs, the working directory can be set,
+-- a job with a lua error is reported as failed, and the results of a job
+-- that changes its directory are kept.
+-- Output:
+-- SUCCESS
+showconsole()
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the values differ, complain and return 1
+function check(name, value, expected)
+	if value ~= expected then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ")")
+	return fail
+end
+
+-- split a line of the summary at tabs
+function split(line)
+	local fields = {}
+	local start = 1
+	local pos = strfind(line, "\t", start, 1)
+	while pos do
+		tinsert(fields, strsub(line, start, pos-1))
+		start = pos+1
+		pos = strfind(line, "\t", start, 1)
+	end
+	tinsert(fields, strsub(line, start))
+	return fields
+end
+
+-- solve the problem in this process
+function solve(Touter)
+	open("femmcli_batch.feh")
+	hi_saveas("femmcli_batch_reference.feh")
+	hi_modifyboundprop("Outer Boundary", 4, Touter)
+	hi_analyze()
+	hi_loadsolution()
+	local T = ho_getpointvalues(1.1, 1.1)
+	ho_close()
+	hi_close()
+	return T
+end
+
+assert(readfrom("femmcli_batch.jobs.summary"))
+header = split(read("*l"))
+jobs = {}
+line = read("*l")
+while line do
+	tinsert(jobs, split(line))
+	line = read("*l")
+end
+readfrom()
+
+failed=0
+failed = failed + check("columns", getn(header), 7)
+failed = failed + check("column 6", header[6], "T")
+failed = failed + check("column 7", header[7], "label")
+failed = failed + check("number of jobs", getn(jobs), 5)
+
+temperatures = { 300, 320, 340 }
+labels = { "first", "second job", "third" }
+for i = 1,3 do
+	failed = failed + check("job " .. i .. ": number", jobs[i][1], tostring(i))
+	failed = failed + check("job " .. i .. ": status", jobs[i][4], "ok")
+	failed = failed + check("job " .. i .. ": T", jobs[i][6], tostring(solve(temperatures[i])))
+	failed = failed + check("job " .. i .. ": label", jobs[i][7], labels[i])
+end
+
+-- without dir=, job n runs in "<job file>.<n>"
+dir = jobs[1][3]
+failed = failed + check("job 1: working directory", strsub(dir, -strlen("femmcli_batch.jobs.1")), "femmcli_batch.jobs.1")
+dir = jobs[3][3]
+failed = failed + check("job 3: working directory", strsub(dir, -strlen("femmcli_batch.custom")), "femmcli_batch.custom")
+-- the output of a job is kept in its working directory
+failed = failed + check("job 3: log file", readfrom("femmcli_batch.custom/femmcli.log") and 1 or 0, 1)
+readfrom()
+
+failed = failed + check("job 4: status", jobs[4][4], "error")
+failed = failed + check("job 4: T", jobs[4][6], "")
+
+failed = failed + check("job 5: status", jobs[5][4], "ok")
+failed = failed + check("job 5: T", jobs[5][6], tostring(solve(360)))
+failed = failed + check("job 5: label", jobs[5][7], "fifth")
+
+assert(failed==0)
+write("SUCCESS\n")
@@ -0,0 +1,18 @@
+-- femmcli_batchJob.lua
+-- A job of femmcli_batch.jobs: solve the heat flow problem with the ambient temperature Touter
+-- at the outer boundary, and store the temperature at a point in T.
+-- Each job runs in its own directory below the directory of femmcli_batch.feh.
+-- If leaveTo is set, the job changes to that directory at the end.
+if type(Touter) ~= "number" then
+	error("Touter must be a number")
+end
+
+open("../femmcli_batch.feh")
+hi_saveas("femmcli_batchJob.feh")
+hi_modifyboundprop("Outer Boundary", 4, Touter)
+hi_analyze()
+hi_loadsolution()
+T = ho_getpointvalues(1.1, 1.1)
+if leaveTo then
+	chdir(leaveTo)
+end
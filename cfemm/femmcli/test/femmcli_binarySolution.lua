@@ -0,0 +1,111 @@
+-- femmcli_binarySolution.lua
+-- This checks the binary solution file format (XFEMM_BINARY_SOLUTION):
+-- for each problem type, the post processor must give the same results
+-- for a binary solution file as for a text solution file.
+-- Output:
+-- SUCCESS
+showconsole()
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the values differ, complain and return 1
+function check(name, value, expected)
+	if value ~= expected then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ")")
+	return fail
+end
+
+failed=0
+
+-- magnetics: periodic boundaries and an air gap element
+open("femmcli_antiperiodicBC_AGE_TorqueBenchmark.fem")
+mi_saveas("femmcli_binarySolution.fem")
+mi_modifyboundprop("AGE", 10, 30)
+mi_saveas("femmcli_binarySolution.fem")
+
+-- (re-opening the problem makes sure the solution is read from the file)
+XFEMM_BINARY_SOLUTION=0
+mi_analyze(1)
+mi_close()
+open("femmcli_binarySolution.fem")
+mi_loadsolution()
+nodes = mo_numnodes()
+torque = mo_gapintegral("AGE", 0)
+A = mo_getpointvalues(0.01, 0.02)
+mo_close()
+mi_close()
+
+XFEMM_BINARY_SOLUTION=1
+open("femmcli_binarySolution.fem")
+mi_analyze(1)
+mi_close()
+open("femmcli_binarySolution.fem")
+mi_loadsolution()
+failed = failed + check("number of nodes", mo_numnodes(), nodes)
+failed = failed + check("torque", mo_gapintegral("AGE", 0), torque)
+failed = failed + check("A", mo_getpointvalues(0.01, 0.02), A)
+mo_close()
+mi_close()
+
+-- heat flow
+XFEMM_BINARY_SOLUTION=0
+open("femmcli_hpproc.feh")
+hi_saveas("femmcli_binarySolution.feh")
+hi_analyze()
+hi_close()
+open("femmcli_binarySolution.feh")
+hi_loadsolution()
+T,Fx,Fy = ho_getpointvalues(1.1,1.1)
+ho_close()
+hi_close()
+
+XFEMM_BINARY_SOLUTION=1
+open("femmcli_binarySolution.feh")
+hi_analyze()
+hi_close()
+open("femmcli_binarySolution.feh")
+hi_loadsolution()
+T2,Fx2,Fy2 = ho_getpointvalues(1.1,1.1)
+failed = failed + check("T", T2, T)
+failed = failed + check("Fx", Fx2, Fx)
+failed = failed + check("Fy", Fy2, Fy)
+ho_close()
+hi_close()
+
+-- electrostatics
+XFEMM_BINARY_SOLUTION=0
+open("femmcli_epproc.fee")
+ei_saveas("femmcli_binarySolution.fee")
+ei_analyze(0)
+ei_close()
+open("femmcli_binarySolution.fee")
+ei_loadsolution()
+V,Dx,Dy = eo_getpointvalues(0.250, 0)
+cV,cq = eo_getconductorproperties("m1t")
+eo_close()
+ei_close()
+
+XFEMM_BINARY_SOLUTION=1
+open("femmcli_binarySolution.fee")
+ei_analyze(0)
+ei_close()
+open("femmcli_binarySolution.fee")
+ei_loadsolution()
+V2,Dx2,Dy2 = eo_getpointvalues(0.250, 0)
+cV2,cq2 = eo_getconductorproperties("m1t")
+failed = failed + check("V", V2, V)
+failed = failed + check("Dx", Dx2, Dx)
+failed = failed + check("Dy", Dy2, Dy)
+failed = failed + check("conductor voltage", cV2, cV)
+failed = failed + check("conductor charge", cq2, cq)
+eo_close()
+ei_close()
+
+assert(failed==0)
+write("SUCCESS\n")
@@ -0,0 +1,164 @@
+-- femmcli_floatPreconditioner.lua
+-- This checks mi_setfloatpreconditioner, ei_setfloatpreconditioner and hi_setfloatpreconditioner:
+-- the option must be saved in the problem file, and for each problem type
+-- the solution must be the same as with the double precision preconditioner.
+-- Output:
+-- SUCCESS
+showconsole()
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the relative difference is larger than <tolerance>, complain and return 1
+function checkRel(name, value, expected, tolerance)
+	local err = abs(value - expected)
+	if expected ~= 0 then
+		err = err / abs(expected)
+	end
+	if not (err <= tolerance) then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ", relative error: " .. err .. ")")
+	return fail
+end
+
+-- check that <file> contains the [FloatPreconditioner] key exactly if <flag> is 1
+function checkFile(name, file, flag)
+	assert(readfrom(file))
+	local text = read("*a")
+	readfrom()
+	local found = 0
+	if strfind(text, "[FloatPreconditioner]", 1, 1) then
+		found = 1
+	end
+	return checkRel(name .. ": [FloatPreconditioner] in problem file", found, flag, 0)
+end
+
+failed=0
+tolerance=1e-6
+
+-- magnetostatics: periodic boundaries and an air gap element
+function solveMagnetostatics(flag)
+	open("femmcli_antiperiodicBC_AGE_TorqueBenchmark.fem")
+	mi_setfloatpreconditioner(flag)
+	mi_saveas("femmcli_floatPreconditioner.fem")
+	failed = failed + checkFile("magnetostatics", "femmcli_floatPreconditioner.fem", flag)
+	mi_analyze(1)
+	mi_loadsolution()
+	local torque = mo_gapintegral("AGE", 0)
+	local A = mo_getpointvalues(0.01, 0.02)
+	mo_close()
+	mi_close()
+	return torque, A
+end
+
+torque, A = solveMagnetostatics(0)
+torque2, A2 = solveMagnetostatics(1)
+failed = failed + checkRel("torque", torque2, torque, tolerance)
+failed = failed + checkRel("A", A2, A, tolerance)
+
+-- harmonic magnetics: a coil next to a conducting plate
+function rectangle(x1,y1,x2,y2)
+	mi_addnode(x1,y1)
+	mi_addnode(x2,y1)
+	mi_addnode(x2,y2)
+	mi_addnode(x1,y2)
+	mi_addsegment(x1,y1,x2,y1)
+	mi_addsegment(x2,y1,x2,y2)
+	mi_addsegment(x2,y2,x1,y2)
+	mi_addsegment(x1,y2,x1,y1)
+end
+
+function label(x,y,material,circuit,turns)
+	mi_addblocklabel(x,y)
+	mi_selectlabel(x,y)
+	mi_setblockprop(material,1,0,circuit,0,0,turns)
+	mi_clearselected()
+end
+
+newdocument(0)
+mi_probdef(1000,"millimeters","planar",1e-8,10,30,0)
+rectangle(0,0,100,100)
+rectangle(20,20,80,35)
+rectangle(40,50,60,70)
+mi_addboundprop("A0",0,0,0,0,0,0,0,0,0)
+mi_selectsegment(50,0)
+mi_selectsegment(50,100)
+mi_selectsegment(0,50)
+mi_selectsegment(100,50)
+mi_setsegmentprop("A0",0,1,0,0)
+mi_clearselected()
+mi_addmaterial("Air",1,1,0,0,0)
+mi_addmaterial("Aluminium",1,1,0,0,35)
+mi_addmaterial("Copper",1,1,0,0,58)
+mi_addcircprop("Coil",2,1)
+label(10,10,"Air","<None>",0)
+label(50,30,"Aluminium","<None>",0)
+label(50,60,"Copper","Coil",20)
+
+function solveHarmonic(flag)
+	mi_setfloatpreconditioner(flag)
+	mi_saveas("femmcli_floatPreconditioner.fem")
+	failed = failed + checkFile("harmonic magnetics", "femmcli_floatPreconditioner.fem", flag)
+	mi_analyze(1)
+	mi_loadsolution()
+	local A = mo_getpointvalues(50, 30)
+	local I, V, Phi = mo_getcircuitproperties("Coil")
+	mo_close()
+	return A, V
+end
+
+A, V = solveHarmonic(0)
+A2, V2 = solveHarmonic(1)
+failed = failed + checkRel("re(A)", re(A2), re(A), tolerance)
+failed = failed + checkRel("im(A)", im(A2), im(A), tolerance)
+failed = failed + checkRel("re(V)", re(V2), re(V), tolerance)
+failed = failed + checkRel("im(V)", im(V2), im(V), tolerance)
+
+-- heat flow
+function solveHeatflow(flag)
+	open("femmcli_hpproc.feh")
+	hi_setfloatpreconditioner(flag)
+	hi_saveas("femmcli_floatPreconditioner.feh")
+	failed = failed + checkFile("heat flow", "femmcli_floatPreconditioner.feh", flag)
+	hi_analyze()
+	hi_loadsolution()
+	local T,Fx,Fy = ho_getpointvalues(1.1,1.1)
+	ho_close()
+	hi_close()
+	return T,Fx,Fy
+end
+
+T,Fx,Fy = solveHeatflow(0)
+T2,Fx2,Fy2 = solveHeatflow(1)
+failed = failed + checkRel("T", T2, T, tolerance)
+failed = failed + checkRel("Fx", Fx2, Fx, tolerance)
+failed = failed + checkRel("Fy", Fy2, Fy, tolerance)
+
+-- electrostatics
+function solveElectrostatics(flag)
+	open("femmcli_epproc.fee")
+	ei_setfloatpreconditioner(flag)
+	ei_saveas("femmcli_floatPreconditioner.fee")
+	failed = failed + checkFile("electrostatics", "femmcli_floatPreconditioner.fee", flag)
+	ei_analyze(0)
+	ei_loadsolution()
+	local V,Dx,Dy = eo_getpointvalues(0.250, 0)
+	local cV,cq = eo_getconductorproperties("m1t")
+	eo_close()
+	ei_close()
+	return V,Dx,Dy,cq
+end
+
+V,Dx,Dy,cq = solveElectrostatics(0)
+V2,Dx2,Dy2,cq2 = solveElectrostatics(1)
+failed = failed + checkRel("V", V2, V, tolerance)
+failed = failed + checkRel("Dx", Dx2, Dx, tolerance)
+failed = failed + checkRel("Dy", Dy2, Dy, tolerance)
+failed = failed + checkRel("conductor charge", cq2, cq, tolerance)
+
+assert(failed==0)
+write("SUCCESS\n")
@@ -0,0 +1,178 @@
+-- femmcli_geometryIndex.lua
+-- This checks that the geometry queries that use the spatial index of the problem
+-- (adding nodes, splitting segments and arcs, finding intersections, selecting the closest item)
+-- give the same results as a search over all items,
+-- also after the geometry has grown, items were deleted and the geometry was moved.
+-- Output:
+-- SUCCESS
+showconsole()
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the values differ, complain and return 1
+function check(name, value, expected)
+	if value ~= expected then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ")")
+	return fail
+end
+
+-- pseudo random numbers in [0,1)
+seed = 4711
+function random()
+	seed = mod(seed*16807, 2147483647)
+	return seed/2147483647
+end
+
+-- the node closest to (x,y), searched in the lua copy of the node list
+function closestNode(x, y)
+	local best, bx, by = -1, 0, 0
+	for i=1,getn(nodes) do
+		local d = sqrt((nodes[i][1]-x)^2 + (nodes[i][2]-y)^2)
+		if best < 0 or d < best then
+			best, bx, by = d, nodes[i][1], nodes[i][2]
+		end
+	end
+	return bx, by
+end
+
+-- compare mi_selectnode with closestNode for a number of random points around (x0,y0)
+function checkClosestNodes(name, count, x0, y0, size)
+	local wrong = 0
+	for i=1,count do
+		local x = x0 + random()*size
+		local y = y0 + random()*size
+		local sx, sy = mi_selectnode(x, y)
+		local ex, ey = closestNode(x, y)
+		if sx ~= ex or sy ~= ey then
+			wrong = wrong + 1
+		end
+	end
+	mi_clearselected()
+	return check(name, wrong, 0)
+end
+
+newdocument(0)
+mi_probdef(0, "millimeters", "planar", 1e-8, 0, 30)
+
+failed=0
+
+-- a small geometry first, so that the index has to grow with the nodes that follow
+nodes = {}
+mi_addnode(0, 0)
+mi_addnode(60, 0)
+mi_addsegment(0, 0, 60, 0)
+tinsert(nodes, {0, 0})
+tinsert(nodes, {60, 0})
+
+-- irregular grid of nodes
+for i=0,59 do
+	for j=1,59 do
+		local x = i + random()*0.5
+		local y = j + random()*0.5
+		mi_addnode(x, y)
+		tinsert(nodes, {x, y})
+	end
+end
+failed = failed + checkClosestNodes("closest node", 500, -40, -40, 110)
+
+-- a node on the first segment splits it
+mi_addnode(20, 0)
+tinsert(nodes, {20, 0})
+local x0, y0, x1, y1 = mi_selectsegment(10, -1)
+failed = failed + check("left part of split segment", x0+x1, 20)
+x0, y0, x1, y1 = mi_selectsegment(50, -1)
+failed = failed + check("right part of split segment", x0+x1, 80)
+mi_clearselected()
+
+-- a node can not be added on top of another one
+mi_addnode(nodes[100][1], nodes[100][2] + 1e-9)
+mi_selectnode(nodes[100][1], nodes[100][2])
+mi_deleteselectednodes()
+x0, y0 = mi_selectnode(nodes[100][1], nodes[100][2])
+mi_clearselected()
+local dx, dy = nodes[100][1] - x0, nodes[100][2] - y0
+failed = failed + check("no duplicate node", (dx*dx + dy*dy > 1e-6) and 1 or 0, 1)
+nodes[100] = nodes[getn(nodes)]
+tremove(nodes)
+
+-- an arc through a node is split there
+mi_addnode(-10, -10)
+mi_addnode(-10, -30)
+mi_addnode(0, -20)
+mi_addarc(-10, -30, -10, -10, 180, 5)
+tinsert(nodes, {-10, -10})
+tinsert(nodes, {-10, -30})
+tinsert(nodes, {0, -20})
+x0, y0, x1, y1 = mi_selectarcsegment(-2, -15)
+failed = failed + check("upper part of split arc", y0+y1, -30)
+x0, y0, x1, y1 = mi_selectarcsegment(-2, -25)
+failed = failed + check("lower part of split arc", y0+y1, -50)
+mi_clearselected()
+
+-- crossing lines and arcs get a node at their intersection
+mi_addnode(70, -10)
+mi_addnode(80, -20)
+mi_addnode(70, -20)
+mi_addnode(80, -10)
+mi_addsegment(70, -10, 80, -20)
+mi_addsegment(70, -20, 80, -10)
+tinsert(nodes, {70, -10})
+tinsert(nodes, {80, -20})
+tinsert(nodes, {70, -20})
+tinsert(nodes, {80, -10})
+tinsert(nodes, {75, -15})
+x0, y0 = mi_selectnode(75.1, -15.1)
+failed = failed + check("line line intersection", x0 + y0, 60)
+mi_addnode(70, -30)
+mi_addnode(80, -30)
+mi_addnode(75, -40)
+mi_addnode(75, -30)
+mi_addarc(70, -30, 80, -30, 180, 5)
+mi_addsegment(75, -40, 75, -30)
+tinsert(nodes, {70, -30})
+tinsert(nodes, {80, -30})
+tinsert(nodes, {75, -40})
+tinsert(nodes, {75, -30})
+tinsert(nodes, {75, -35})
+x0, y0 = mi_selectnode(75.1, -35.1)
+failed = failed + check("line arc intersection", x0 + y0, 40)
+mi_clearselected()
+
+-- delete some nodes, and move the rest of the geometry
+for k=1,200 do
+	local i = 1 + floor(random()*getn(nodes))
+	mi_selectnode(nodes[i][1], nodes[i][2])
+	mi_deleteselectednodes()
+	nodes[i] = nodes[getn(nodes)]
+	tremove(nodes)
+end
+failed = failed + checkClosestNodes("closest node after deleting", 500, -40, -40, 110)
+
+for i=1,getn(nodes) do
+	mi_selectnode(nodes[i][1], nodes[i][2])
+	nodes[i][1] = nodes[i][1] + 100
+	nodes[i][2] = nodes[i][2] + 50
+end
+mi_movetranslate(100, 50, 0)
+mi_clearselected()
+failed = failed + checkClosestNodes("closest node after moving", 200, 60, 10, 110)
+
+-- block labels
+mi_addblocklabel(30.25, 30.25)
+mi_addblocklabel(30.25 + 1e-9, 30.25)
+mi_addblocklabel(-50, -50)
+x0, y0 = mi_selectlabel(31, 31)
+failed = failed + check("closest block label", x0 + y0, 60.5)
+mi_clearselected()
+
+if failed == 0 then
+	print("SUCCESS")
+else
+	error("FAILED")
+end
@@ -0,0 +1,106 @@
+-- femmcli_harmonicNewton.lua
+-- This checks that the Newton-Raphson AC solver (acsolver=1) and the
+-- GMRES-based successive approximation solver (acsolver=2) converge
+-- to the same solution as the successive approximation solver (acsolver=0)
+-- for a saturated harmonic problem.
+-- Output:
+-- SUCCESS
+showconsole()
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the relative difference is greater than the margin (in percent), complain and return 1
+function check(name, value, expected, margin)
+	diff=100*(value - expected) / expected
+	if abs(diff) > margin then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ", diff: " .. diff .. "%, margin: " .. margin .. "%)")
+	return fail
+end
+
+-- enable for additional output:
+-- XFEMM_VERBOSE = 1
+
+function rectangle(x1,y1,x2,y2)
+	mi_addnode(x1,y1)
+	mi_addnode(x2,y1)
+	mi_addnode(x2,y2)
+	mi_addnode(x1,y2)
+	mi_addsegment(x1,y1,x2,y1)
+	mi_addsegment(x2,y1,x2,y2)
+	mi_addsegment(x2,y2,x1,y2)
+	mi_addsegment(x1,y2,x1,y1)
+end
+
+function solve(acsolver)
+	mi_probdef(50,"millimeters","planar",1e-8,10,30,acsolver,20)
+	mi_saveas("femmcli_harmonicNewton_" .. acsolver .. ".fem")
+	mi_analyze()
+	mi_loadsolution()
+	local A,B1,B2 = mo_getpointvalues(50,50)
+	local I,V,Phi = mo_getcircuitproperties("Coil")
+	return A, sqrt(abs(B1)^2 + abs(B2)^2), Phi
+end
+
+newdocument(0)
+mi_probdef(50,"millimeters","planar",1e-8,10,30,0)
+
+-- air box, steel core and a coil above the core
+rectangle(0,0,100,100)
+rectangle(20,40,80,60)
+rectangle(20,62,80,75)
+
+mi_addboundprop("A0",0,0,0,0,0,0,0,0,0)
+mi_selectsegment(50,0)
+mi_selectsegment(50,100)
+mi_selectsegment(0,50)
+mi_selectsegment(100,50)
+mi_setsegmentprop("A0",0,1,0,0)
+mi_clearselected()
+
+mi_addmaterial("Air",1,1,0,0,0)
+mi_addmaterial("Steel",1,1,0,0,1)
+mi_addbhpoint("Steel",0,0)
+mi_addbhpoint("Steel",0.5,100)
+mi_addbhpoint("Steel",1.0,250)
+mi_addbhpoint("Steel",1.4,1000)
+mi_addbhpoint("Steel",1.7,6000)
+mi_addbhpoint("Steel",2.0,50000)
+mi_addbhpoint("Steel",2.3,300000)
+mi_addmaterial("Copper",1,1,0,0,0)
+mi_addcircprop("Coil",2000,1)
+
+mi_addblocklabel(10,10)
+mi_selectlabel(10,10)
+mi_setblockprop("Air",0,10,"<None>",0,0,0)
+mi_clearselected()
+
+mi_addblocklabel(50,50)
+mi_selectlabel(50,50)
+mi_setblockprop("Steel",0,5,"<None>",0,0,0)
+mi_clearselected()
+
+mi_addblocklabel(50,68)
+mi_selectlabel(50,68)
+mi_setblockprop("Copper",0,5,"Coil",0,0,10)
+mi_clearselected()
+
+A0,B0,Phi0 = solve(0)
+A1,B1,Phi1 = solve(1)
+A2,B2,Phi2 = solve(2)
+
+failed=0
+failed = failed + check("|A|", abs(A1), abs(A0), 0.5)
+failed = failed + check("|B|", B1, B0, 0.5)
+failed = failed + check("|Phi|", abs(Phi1), abs(Phi0), 0.5)
+failed = failed + check("|A| (GMRES)", abs(A2), abs(A0), 0.5)
+failed = failed + check("|B| (GMRES)", B2, B0, 0.5)
+failed = failed + check("|Phi| (GMRES)", abs(Phi2), abs(Phi0), 0.5)
+
+assert(failed==0)
+write("SUCCESS\n")
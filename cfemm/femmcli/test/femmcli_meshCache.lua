@@ -0,0 +1,104 @@
+-- femmcli_meshCache.lua
+-- This checks that mi_analyze reuses the mesh of unchanged geometry:
+-- solutions computed with a cached mesh must be identical to the ones computed
+-- after remeshing, changing a material or turning the rotor must not invalidate
+-- the cached mesh, and changing a mesh size must.
+-- The test is run with --mesh-cache-dir, so that evicted entries are read back from disk.
+-- The mesher lists the edges of the same geometry in the same order, and that order
+-- sets the node numbering, so the torques after remeshing must be identical, too.
+-- Output:
+-- SUCCESS
+showconsole()
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the values differ, complain and return 1
+function check(name, value, expected)
+	if value ~= expected then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ")")
+	return fail
+end
+
+-- analyze and return the number of nodes and the torque
+function solve()
+	mi_analyze(1)
+	mi_loadsolution()
+	local nodes = mo_numnodes()
+	local torque = mo_gapintegral("AGE", 0)
+	mo_close()
+	return nodes, torque
+end
+
+-- set the mesh size of the air region
+function setMeshSize(size)
+	mi_selectlabel(0.85, 0.4)
+	mi_setblockprop("Air", 0, size, "<None>", 0, 0, 1)
+	mi_clearselected()
+end
+
+-- a problem with periodic boundaries and an air gap element
+open("femmcli_antiperiodicBC_AGE_TorqueBenchmark.fem")
+mi_saveas("femmcli_meshCache.fem")
+
+failed=0
+
+-- reference values, always remeshing
+-- (there are more mesh sizes than entries kept in memory)
+sizes = { 0.1, 0.08, 0.06, 0.05, 0.04 }
+refNodes = {}
+refTorque = {}
+XFEMM_MESH_CACHE=0
+for i = 1,getn(sizes) do
+	setMeshSize(sizes[i])
+	refNodes[i], refTorque[i] = solve()
+end
+
+XFEMM_MESH_CACHE=1
+for run = 1,2 do
+	for i = 1,getn(sizes) do
+		setMeshSize(sizes[i])
+		nodes, torque = solve()
+		failed = failed + check("run " .. run .. ", mesh size " .. sizes[i] .. ": number of nodes", nodes, refNodes[i])
+		failed = failed + check("run " .. run .. ", mesh size " .. sizes[i] .. ": torque", torque, refTorque[i])
+	end
+end
+
+-- changing a material keeps the mesh
+mi_modifymaterial("magnet", 3, 2e6)
+cachedNodes, cachedTorque = solve()
+XFEMM_MESH_CACHE=0
+nodes, torque = solve()
+failed = failed + check("modified material: number of nodes", cachedNodes, nodes)
+failed = failed + check("modified material: torque", cachedTorque, torque)
+failed = failed + check("modified material: torque changed", (torque ~= refTorque[getn(sizes)]) and 1 or 0, 1)
+
+-- turning the rotor keeps the mesh
+XFEMM_MESH_CACHE=1
+mi_modifyboundprop("AGE", 10, 5)
+turnedNodes, turnedTorque = solve()
+XFEMM_MESH_CACHE=0
+nodes, torque = solve()
+failed = failed + check("turned rotor: number of nodes", turnedNodes, nodes)
+failed = failed + check("turned rotor: torque", turnedTorque, torque)
+failed = failed + check("turned rotor: torque changed", (torque ~= cachedTorque) and 1 or 0, 1)
+
+-- changing the geometry does not use the cache
+XFEMM_MESH_CACHE=1
+mi_seteditmode("nodes")
+mi_selectnode(0.5, 0.25)
+mi_movetranslate(0, 0.01)
+mi_clearselected()
+movedNodes, movedTorque = solve()
+XFEMM_MESH_CACHE=0
+nodes, torque = solve()
+failed = failed + check("moved node: number of nodes", movedNodes, nodes)
+failed = failed + check("moved node: torque", movedTorque, torque)
+
+assert(failed==0)
+write("SUCCESS\n")
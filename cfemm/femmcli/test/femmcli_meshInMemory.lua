@@ -0,0 +1,55 @@
+-- femmcli_meshInMemory.lua
+-- This checks that mi_analyze hands the mesh to the solver in memory:
+-- the solution must use the same mesh that mi_createmesh reads back from
+-- the mesh files, and no mesh files are written by mi_analyze.
+-- Output:
+-- SUCCESS
+showconsole()
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the values differ, complain and return 1
+function check(name, value, expected)
+	if value ~= expected then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ")")
+	return fail
+end
+
+function exists(filename)
+	local f = openfile(filename,"r")
+	if f == nil then
+		return 0
+	end
+	closefile(f)
+	return 1
+end
+
+-- a problem with periodic boundaries and an air gap element
+open("femmcli_antiperiodicBC_AGE_TorqueBenchmark.fem")
+mi_saveas("femmcli_meshInMemory.fem")
+
+failed=0
+
+-- mesh via the mesh files
+nodes = mi_createmesh()
+mi_purgemesh()
+remove("femmcli_meshInMemory.node")
+remove("femmcli_meshInMemory.ele")
+remove("femmcli_meshInMemory.edge")
+remove("femmcli_meshInMemory.pbc")
+
+mi_analyze(1)
+failed = failed + check("mesh files written", exists("femmcli_meshInMemory.node") + exists("femmcli_meshInMemory.ele") + exists("femmcli_meshInMemory.edge") + exists("femmcli_meshInMemory.pbc"), 0)
+
+mi_loadsolution()
+failed = failed + check("number of nodes", mo_numnodes(), nodes)
+mo_close()
+
+assert(failed==0)
+write("SUCCESS\n")
@@ -0,0 +1,174 @@
+-- femmcli_meshMorph.lua
+-- This checks that mi_analyze morphs a cached mesh when only nodes were moved
+-- and XFEMM_MESH_MORPH is set: the number of nodes stays the same, the torque matches
+-- the one computed after remeshing, and it does not depend on the sequence of morphs.
+-- If the elements get too distorted, if block labels are swapped between regions,
+-- or if morphing is disabled, the problem is meshed again.
+-- The mesher may then list the edges in another order, which changes the node numbering
+-- and thus the torque within the rounding errors.
+-- Output:
+-- SUCCESS
+showconsole()
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the relative error is larger than <tolerance>, complain and return 1
+function checkRel(name, value, expected, tolerance)
+	local err = abs(value - expected)
+	if expected ~= 0 then
+		err = err / abs(expected)
+	end
+	if err > tolerance then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ")")
+	return fail
+end
+
+function check(name, value, expected)
+	return checkRel(name, value, expected, 0)
+end
+
+-- analyze and return the number of nodes and the torque
+function solve()
+	mi_analyze(1)
+	mi_loadsolution()
+	local nodes = mo_numnodes()
+	local torque = mo_gapintegral("AGE", 0)
+	mo_close()
+	return nodes, torque
+end
+
+-- analyze without the mesh cache
+function solveRemeshed()
+	XFEMM_MESH_CACHE=0
+	local nodes, torque = solve()
+	XFEMM_MESH_CACHE=1
+	return nodes, torque
+end
+
+-- move the right side of the magnet
+magnetX = 0.5
+function widenMagnet(dx)
+	mi_seteditmode("nodes")
+	mi_selectnode(magnetX, 0.25)
+	mi_selectnode(magnetX, -0.25)
+	mi_movetranslate(dx, 0)
+	mi_clearselected()
+	magnetX = magnetX + dx
+end
+
+-- a problem with periodic boundaries and an air gap element
+open("femmcli_antiperiodicBC_AGE_TorqueBenchmark.fem")
+mi_saveas("femmcli_meshMorph.fem")
+mi_modifyboundprop("AGE", 10, 30)
+
+failed=0
+
+XFEMM_MESH_MORPH=10
+baseNodes, baseTorque = solve()
+
+-- one larger step
+widenMagnet(0.02)
+oneStepNodes, oneStepTorque = solve()
+remeshedNodes, remeshedTorque = solveRemeshed()
+failed = failed + check("one step: number of nodes", oneStepNodes, baseNodes)
+failed = failed + checkRel("one step: torque", oneStepTorque, remeshedTorque, 1e-4)
+failed = failed + check("one step: torque changed", (oneStepTorque ~= baseTorque) and 1 or 0, 1)
+
+-- the same change in two steps
+widenMagnet(-0.02)
+solve()
+widenMagnet(0.01)
+solve()
+widenMagnet(0.01)
+twoStepNodes, twoStepTorque = solve()
+failed = failed + check("two steps: number of nodes", twoStepNodes, baseNodes)
+failed = failed + checkRel("two steps: torque", twoStepTorque, oneStepTorque, 1e-9)
+
+-- a minimum angle that no morphed element keeps
+XFEMM_MESH_MORPH=89
+widenMagnet(0.01)
+nodes, torque = solve()
+remeshedNodes, remeshedTorque = solveRemeshed()
+failed = failed + check("distorted: number of nodes", nodes, remeshedNodes)
+failed = failed + checkRel("distorted: torque", torque, remeshedTorque, 1e-9)
+
+-- morphing is disabled by default
+XFEMM_MESH_MORPH=nil
+widenMagnet(0.01)
+nodes, torque = solve()
+remeshedNodes, remeshedTorque = solveRemeshed()
+failed = failed + check("disabled: number of nodes", nodes, remeshedNodes)
+failed = failed + checkRel("disabled: torque", torque, remeshedTorque, 1e-9)
+
+-- swapping the block labels of two regions changes the material of each region,
+-- although no node moved: the mesh must not keep the old regions
+function coilProperties()
+	mi_analyze(1)
+	mi_loadsolution()
+	local current, voltage, flux = mo_getcircuitproperties("Coil")
+	local nodes = mo_numnodes()
+	mo_close()
+	return nodes, flux
+end
+function rectangle(x1,y1,x2,y2)
+	mi_addnode(x1,y1)
+	mi_addnode(x2,y1)
+	mi_addnode(x2,y2)
+	mi_addnode(x1,y2)
+	mi_addsegment(x1,y1,x2,y1)
+	mi_addsegment(x2,y1,x2,y2)
+	mi_addsegment(x2,y2,x1,y2)
+	mi_addsegment(x1,y2,x1,y1)
+end
+function moveLabel(x1,y1,x2,y2)
+	mi_seteditmode("blocks")
+	mi_selectlabel(x1,y1)
+	mi_movetranslate(x2-x1,y2-y1)
+	mi_clearselected()
+end
+
+newdocument(0)
+mi_probdef(0,"millimeters","planar",1e-8,10,30,0)
+rectangle(0,0,40,40)
+rectangle(15,15,25,25)
+mi_addboundprop("A0",0,0,0,0,0,0,0,0,0)
+mi_selectsegment(20,0)
+mi_selectsegment(40,20)
+mi_selectsegment(20,40)
+mi_selectsegment(0,20)
+mi_setsegmentprop("A0",0,1,0,0)
+mi_clearselected()
+mi_addmaterial("Air",1,1,0,0,0)
+mi_addmaterial("Copper",1,1,0,0,58)
+mi_addcircprop("Coil",1,1)
+mi_addblocklabel(20,20)
+mi_selectlabel(20,20)
+mi_setblockprop("Copper",0,2,"Coil",0,0,100)
+mi_clearselected()
+mi_addblocklabel(5,5)
+mi_selectlabel(5,5)
+mi_setblockprop("Air",0,2,"<None>",0,0,0)
+mi_clearselected()
+mi_saveas("femmcli_meshMorph.fem")
+
+XFEMM_MESH_MORPH=10
+coilNodes, coilFlux = coilProperties()
+moveLabel(20,20,10,5)
+moveLabel(5,5,20,20)
+moveLabel(10,5,5,5)
+swappedNodes, swappedFlux = coilProperties()
+XFEMM_MESH_CACHE=0
+remeshedNodes, remeshedFlux = coilProperties()
+XFEMM_MESH_CACHE=1
+failed = failed + check("swapped labels: number of nodes", swappedNodes, remeshedNodes)
+failed = failed + checkRel("swapped labels: flux linkage", swappedFlux, remeshedFlux, 1e-9)
+failed = failed + check("swapped labels: flux linkage changed", (swappedFlux ~= coilFlux) and 1 or 0, 1)
+
+assert(failed==0)
+write("SUCCESS\n")
@@ -0,0 +1,286 @@
+-- femmcli_ordering.lua
+-- This checks mi_setnodeordering and mi_setelementordering:
+-- the default orderings must number the nodes and sort the elements like FEMM 4.2,
+-- reverse Cuthill-McKee must not increase the bandwidth,
+-- and the space filling curves must sort the nodes and the element centroids along the curve.
+-- All orderings must give the same solution.
+-- The fill of approximate minimum degree and nested dissection is checked by nodeOrdering.cpp.
+-- Output:
+-- SUCCESS
+showconsole()
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the relative difference is larger than <tolerance>, complain and return 1
+function checkRel(name, value, expected, tolerance)
+	local err = abs(value - expected)
+	if expected ~= 0 then
+		err = err / abs(expected)
+	end
+	if not (err <= tolerance) then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ", relative error: " .. err .. ")")
+	return fail
+end
+
+-- check that <value> is true, complain and return 1 otherwise
+function checkTrue(name, value)
+	if value then
+		print("[  ok  ] " .. name)
+		return 0
+	end
+	print("[FAILED] " .. name)
+	return 1
+end
+
+function rectangle(x1,y1,x2,y2)
+	mi_addnode(x1,y1)
+	mi_addnode(x2,y1)
+	mi_addnode(x2,y2)
+	mi_addnode(x1,y2)
+	mi_addsegment(x1,y1,x2,y1)
+	mi_addsegment(x2,y1,x2,y2)
+	mi_addsegment(x2,y2,x1,y2)
+	mi_addsegment(x1,y2,x1,y1)
+end
+
+-- keys of the space filling curves, see nodeordering.cpp
+curveBits = 16
+
+function hilbertKey(x,y)
+	local n = 2^curveBits
+	local d = 0
+	local s = n/2
+	while s >= 1 do
+		local rx = mod(floor(x/s),2)
+		local ry = mod(floor(y/s),2)
+		-- (3*rx) xor ry
+		if rx == 1 then
+			d = d + s*s*(3-ry)
+		else
+			d = d + s*s*ry
+		end
+		if ry == 0 then
+			if rx == 1 then
+				x = n-1-x
+				y = n-1-y
+			end
+			x, y = y, x
+		end
+		s = s/2
+	end
+	return d
+end
+
+function mortonKey(x,y)
+	local d = 0
+	local f = 1
+	for b = 0,curveBits-1 do
+		d = d + f*mod(x,2) + 2*f*mod(y,2)
+		x = floor(x/2)
+		y = floor(y/2)
+		f = f*4
+	end
+	return d
+end
+
+newdocument(0)
+mi_probdef(0,"meters","planar",1e-8,1,30,0)
+rectangle(0,0,1,1)
+rectangle(0.2,0.4,0.8,0.6)
+rectangle(0.2,0.62,0.8,0.75)
+mi_addboundprop("A0",0,0,0,0,0,0,0,0,0)
+mi_selectsegment(0.5,0)
+mi_selectsegment(0.5,1)
+mi_selectsegment(0,0.5)
+mi_selectsegment(1,0.5)
+mi_setsegmentprop("A0",0,1,0,0)
+mi_clearselected()
+mi_addmaterial("Air",1,1,0,0,0)
+mi_addmaterial("Iron",1000,1000,0,0,0)
+mi_addmaterial("Copper",1,1,0,0,0)
+mi_addcircprop("Coil",10,1)
+mi_addblocklabel(0.1,0.1)
+mi_selectlabel(0.1,0.1)
+mi_setblockprop("Air",0,0.03,"<None>",0,0,0)
+mi_clearselected()
+mi_addblocklabel(0.5,0.5)
+mi_selectlabel(0.5,0.5)
+mi_setblockprop("Iron",0,0.02,"<None>",0,0,0)
+mi_clearselected()
+mi_addblocklabel(0.5,0.68)
+mi_selectlabel(0.5,0.68)
+mi_setblockprop("Copper",0,0.02,"Coil",0,0,100)
+mi_clearselected()
+
+-- solve with node ordering <ordering> (nil: keep the default),
+-- return the number of nodes, the bandwidth and A in the iron
+function solve(ordering)
+	if ordering then
+		mi_setnodeordering(ordering)
+	end
+	mi_saveas("femmcli_ordering.fem")
+	mi_analyze()
+	mi_loadsolution()
+	local wide = 0
+	for e = 1,mo_numelements() do
+		local n1,n2,n3 = mo_getelement(e)
+		wide = max(wide, abs(n1-n2), abs(n2-n3), abs(n3-n1))
+	end
+	local A = mo_getpointvalues(0.5,0.5)
+	return mo_numnodes(), wide, A
+end
+
+-- return the coordinates of the nodes
+function nodePoints()
+	local x, y = {}, {}
+	for i = 1,mo_numnodes() do
+		x[i], y[i] = mo_getnode(i)
+	end
+	return x, y
+end
+
+-- return the centroids of the elements, computed like the solver does
+function elementCentroids()
+	local nx, ny = nodePoints()
+	local x, y = {}, {}
+	for e = 1,mo_numelements() do
+		local n1,n2,n3 = mo_getelement(e)
+		x[e] = (nx[n1]+nx[n2]+nx[n3])/3
+		y[e] = (ny[n1]+ny[n2]+ny[n3])/3
+	end
+	return x, y
+end
+
+-- return 1 if the points <x>, <y> are not sorted along <curve>
+function checkCurve(name, curve, x, y)
+	local n = getn(x)
+	local xmin, xmax, ymin, ymax = x[1], x[1], y[1], y[1]
+	for i = 2,n do
+		xmin = min(xmin,x[i])
+		xmax = max(xmax,x[i])
+		ymin = min(ymin,y[i])
+		ymax = max(ymax,y[i])
+	end
+	local scale = (2^curveBits-1)/max(xmax-xmin,ymax-ymin)
+	local sorted = 1
+	local last = -1
+	for i = 1,n do
+		local key = curve(floor((x[i]-xmin)*scale), floor((y[i]-ymin)*scale))
+		if key < last then
+			sorted = 0
+		end
+		last = key
+	end
+	return checkRel(name .. ": sorted along the curve", sorted, 1, 0)
+end
+
+failed=0
+
+-- FEMM 4.2 numbering
+nodes, wide, A = solve(nil)
+failed = failed + checkRel("default: nodes", nodes, 2209, 0)
+failed = failed + checkRel("default: bandwidth", wide, 95, 0)
+reference = {
+	{ 1, 0, 0 },
+	{ 277, 0.1510533993572786, 0.4793558524835524 },
+	{ 553, 0.31813802656706364, 0.47009000957901415 },
+	{ 829, 0.7494116666666666, 0 },
+	{ 1105, 0.3765906790947837, 0.6871737447599877 },
+	{ 1381, 0.47378727681714883, 0.6579151890536191 },
+	{ 1657, 0.01676489583333333, 1 },
+	{ 1933, 0.5636303062580531, 0.9385088165012906 },
+	{ 2209, 1, 1 },
+}
+for k = 1,getn(reference) do
+	local x,y = mo_getnode(reference[k][1])
+	failed = failed + checkRel("default: x of node " .. reference[k][1], x, reference[k][2], 1e-12)
+	failed = failed + checkRel("default: y of node " .. reference[k][1], y, reference[k][3], 1e-12)
+end
+failed = failed + checkRel("default: elements", mo_numelements(), 4236, 0)
+reference = {
+	{ 1, 1, 2, 3 },
+	{ 530, 313, 274, 273 },
+	{ 1059, 577, 522, 573 },
+	{ 1588, 876, 797, 796 },
+	{ 2117, 1145, 1064, 1065 },
+	{ 2646, 1389, 1301, 1390 },
+	{ 3175, 1601, 1662, 1663 },
+	{ 3704, 1953, 1904, 1905 },
+	{ 4233, 2204, 2205, 2207 },
+	{ 4236, 2207, 2208, 2209 },
+}
+for k = 1,getn(reference) do
+	local n1,n2,n3 = mo_getelement(reference[k][1])
+	failed = failed + checkRel("default: node 1 of element " .. reference[k][1], n1, reference[k][2], 0)
+	failed = failed + checkRel("default: node 2 of element " .. reference[k][1], n2, reference[k][3], 0)
+	failed = failed + checkRel("default: node 3 of element " .. reference[k][1], n3, reference[k][4], 0)
+end
+mo_close()
+
+nodes0, wide0, A0 = solve(0)
+failed = failed + checkRel("Cuthill-McKee: bandwidth", wide0, wide, 0)
+failed = failed + checkRel("Cuthill-McKee: A", A0, A, 1e-12)
+mo_close()
+
+nodes1, wide1, A1 = solve(1)
+failed = failed + checkRel("reverse Cuthill-McKee: nodes", nodes1, nodes, 0)
+failed = failed + checkTrue("reverse Cuthill-McKee: bandwidth " .. wide1 .. " <= " .. wide, wide1 <= wide)
+failed = failed + checkRel("reverse Cuthill-McKee: A", A1, A, 1e-6)
+mo_close()
+
+nodes2, wide2, A2 = solve(2)
+failed = failed + checkRel("Hilbert curve: nodes", nodes2, nodes, 0)
+failed = failed + checkRel("Hilbert curve: A", A2, A, 1e-6)
+failed = failed + checkCurve("Hilbert curve: nodes", hilbertKey, nodePoints())
+mo_close()
+
+nodes3, wide3, A3 = solve(3)
+failed = failed + checkRel("Morton curve: nodes", nodes3, nodes, 0)
+failed = failed + checkRel("Morton curve: A", A3, A, 1e-6)
+failed = failed + checkCurve("Morton curve: nodes", mortonKey, nodePoints())
+mo_close()
+
+nodes6, wide6, A6 = solve(4)
+failed = failed + checkRel("approximate minimum degree: nodes", nodes6, nodes, 0)
+failed = failed + checkRel("approximate minimum degree: A", A6, A, 1e-6)
+mo_close()
+
+nodes7, wide7, A7 = solve(5)
+failed = failed + checkRel("nested dissection: nodes", nodes7, nodes, 0)
+failed = failed + checkRel("nested dissection: A", A7, A, 1e-6)
+mo_close()
+
+-- element orderings with the default node numbering
+mi_setnodeordering(0)
+mi_setelementordering(1)
+nodes4, wide4, A4 = solve(nil)
+failed = failed + checkRel("Hilbert curve elements: bandwidth", wide4, wide, 0)
+failed = failed + checkRel("Hilbert curve elements: A", A4, A, 1e-12)
+failed = failed + checkCurve("Hilbert curve: elements", hilbertKey, elementCentroids())
+mo_close()
+
+mi_setelementordering(2)
+nodes5, wide5, A5 = solve(nil)
+failed = failed + checkRel("Morton curve elements: bandwidth", wide5, wide, 0)
+failed = failed + checkRel("Morton curve elements: A", A5, A, 1e-12)
+failed = failed + checkCurve("Morton curve: elements", mortonKey, elementCentroids())
+mo_close()
+
+-- invalid values
+result = call(mi_setnodeordering, {6}, "x", function(msg) end)
+failed = failed + checkRel("node ordering 6 is rejected", (result == nil) and 1 or 0, 1, 0)
+result = call(mi_setnodeordering, {-1}, "x", function(msg) end)
+failed = failed + checkRel("node ordering -1 is rejected", (result == nil) and 1 or 0, 1, 0)
+result = call(mi_setelementordering, {3}, "x", function(msg) end)
+failed = failed + checkRel("element ordering 3 is rejected", (result == nil) and 1 or 0, 1, 0)
+result = call(mi_setelementordering, {-1}, "x", function(msg) end)
+failed = failed + checkRel("element ordering -1 is rejected", (result == nil) and 1 or 0, 1, 0)
+
+assert(failed==0)
+write("SUCCESS\n")
@@ -0,0 +1,169 @@
+-- femmcli_parseBenchmark.lua
+-- This measures the parse throughput of the problem file reader and of the post processor:
+-- a large .fem file (a grid of square cells) is generated and read a few times,
+-- then a smaller grid is solved, and the resulting .ans file is loaded a few times.
+-- Output:
+-- timings and SUCCESS
+showconsole()
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the values differ, complain and return 1
+function check(name, value, expected)
+	if value ~= expected then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ")")
+	return fail
+end
+
+function filesize(filename)
+	local f = openfile(filename,"r")
+	local size = seek(f, "end")
+	closefile(f)
+	return size
+end
+
+-- print the throughput for reading <filename> <n> times in <seconds>
+function report(name, filename, n, seconds)
+	local mb = filesize(filename) / 1048576
+	if seconds <= 0 then
+		seconds = 1e-6
+	end
+	print(format("%s: %d x %.1f MB in %.3f s (%.1f MB/s)", name, n, mb, seconds, n * mb / seconds))
+end
+
+failed=0
+
+-- write a grid of N x N cells of 1mm x 1mm to <femfile>
+function writeGrid(femfile, N)
+	writeto(femfile)
+	write("[Format]      =  4.0\n")
+	write("[Frequency]   =  0\n")
+	write("[Precision]   =  1e-08\n")
+	write("[MinAngle]    =  30\n")
+	write("[Depth]       =  1\n")
+	write("[LengthUnits] =  millimeters\n")
+	write("[ProblemType] =  planar\n")
+	write("[Coordinates] =  cartesian\n")
+	write("[ACSolver]    =  0\n")
+	write("[Comment]     =  \"generated by femmcli_parseBenchmark.lua\"\n")
+	write("[PointProps]  =  0\n")
+	write("[BdryProps]   = 1\n")
+	write("  <BeginBdry>\n")
+	write("    <BdryName> = \"A=0\"\n")
+	write("    <BdryType> = 0\n")
+	write("    <A_0> = 0\n")
+	write("    <A_1> = 0\n")
+	write("    <A_2> = 0\n")
+	write("    <Phi> = 0\n")
+	write("    <c0> = 0\n")
+	write("    <c0i> = 0\n")
+	write("    <c1> = 0\n")
+	write("    <c1i> = 0\n")
+	write("    <Mu_ssd> = 0\n")
+	write("    <Sigma_ssd> = 0\n")
+	write("  <EndBdry>\n")
+	write("[BlockProps]  = 2\n")
+	for i = 1,2 do
+		write("  <BeginBlock>\n")
+		write("    <BlockName> = \"Material " .. i .. "\"\n")
+		write("    <Mu_x> = " .. i .. "\n")
+		write("    <Mu_y> = " .. i .. "\n")
+		write("    <H_c> = 0\n")
+		write("    <H_cAngle> = 0\n")
+		write("    <J_re> = " .. (i-1) .. "\n")
+		write("    <J_im> = 0\n")
+		write("    <Sigma> = 0\n")
+		write("    <d_lam> = 0\n")
+		write("    <Phi_h> = 0\n")
+		write("    <Phi_hx> = 0\n")
+		write("    <Phi_hy> = 0\n")
+		write("    <LamType> = 0\n")
+		write("    <LamFill> = 1\n")
+		write("    <NStrands> = 0\n")
+		write("    <WireD> = 0\n")
+		write("    <BHPoints> = 0\n")
+		write("  <EndBlock>\n")
+	end
+	write("[CircuitProps]  = 0\n")
+
+	-- point (i,j) has index i*(N+1)+j
+	write("[NumPoints] = " .. (N+1)*(N+1) .. "\n")
+	for i = 0,N do
+		for j = 0,N do
+			write(format("%.17g\t%.17g\t0\t0\n", i, j))
+		end
+	end
+	-- segments on the outer boundary get the A=0 boundary condition
+	write("[NumSegments] = " .. 2*N*(N+1) .. "\n")
+	for i = 0,N do
+		for j = 0,N-1 do
+			bdry = 0
+			if i == 0 or i == N then
+				bdry = 1
+			end
+			write(format("%d\t%d\t-1\t%d\t0\t0\n", i*(N+1)+j, i*(N+1)+j+1, bdry))
+			write(format("%d\t%d\t-1\t%d\t0\t0\n", j*(N+1)+i, (j+1)*(N+1)+i, bdry))
+		end
+	end
+	write("[NumArcSegments] = 0\n")
+	write("[NumHoles] = 0\n")
+	write("[NumBlockLabels] = " .. N*N .. "\n")
+	for i = 0,N-1 do
+		for j = 0,N-1 do
+			write(format("%.17g\t%.17g\t%d\t-1\t0\t0\t0\t1\t0\n", i+0.5, j+0.5, mod(i+j,2)+1))
+		end
+	end
+	writeto()
+end
+
+runs = 5
+
+-- problem file reader
+femfile = "femmcli_parseBenchmark_large.fem"
+writeGrid(femfile, 200)
+t0 = clock()
+for run = 1,runs do
+	open(femfile)
+	mi_close()
+end
+report("read .fem", femfile, runs, clock() - t0)
+
+-- solver (not timed: meshing and solving dominate)
+N = 20
+femfile = "femmcli_parseBenchmark.fem"
+writeGrid(femfile, N)
+open(femfile)
+XFEMM_BINARY_SOLUTION=0
+mi_analyze(1)
+mi_close()
+open(femfile)
+
+-- post processor
+t0 = clock()
+for run = 1,runs do
+	mi_loadsolution()
+	nodes = mo_numnodes()
+	elements = mo_numelements()
+	mo_close()
+end
+report("read .ans", "femmcli_parseBenchmark.ans", runs, clock() - t0)
+print("nodes: " .. nodes .. ", elements: " .. elements)
+
+mi_loadsolution()
+failed = failed + check("mesh is large", (elements > 10*N*N) and 1 or 0, 1)
+-- A vanishes on the boundary, and is symmetric with respect to the centre
+A1 = mo_getpointvalues(N/4 + 0.5, N/2 + 0.5)
+A2 = mo_getpointvalues(3*N/4 - 0.5, N/2 - 0.5)
+failed = failed + check("A symmetric", (abs(A1 - A2) < 1e-3 * abs(A1)) and 1 or 0, 1)
+failed = failed + check("A on boundary", mo_getpointvalues(0, N/2), 0)
+mo_close()
+mi_close()
+
+assert(failed==0)
+write("SUCCESS\n")
@@ -0,0 +1,46 @@
+# femmcli_server.cmake
+# Send a sequence of requests to "femmcli --server" over stdin,
+# and compare its responses on stdout with the expected ones.
+# This checks that the lua state and a loaded solution stay alive between requests,
+# that errors are reported without ending the server,
+# and that output of the lua chunks does not end up in the responses.
+#
+# Usage: cmake -DFEMMCLI=<femmcli> -DLUA_BASE_DIR=<dir> -P femmcli_server.cmake
+
+set(requests "")
+set(expected "")
+
+## request(<chunk> <status> <payload>)
+# Add a request, and its expected response.
+function(request chunk status payload)
+    string(LENGTH "${chunk}" length)
+    set(requests "${requests}${length}\n${chunk}" PARENT_SCOPE)
+    string(LENGTH "${payload}" length)
+    set(expected "${expected}${status} ${length}\n${payload}" PARENT_SCOPE)
+endfunction()
+
+request("return 1+1, \"two\", nil" ok "2\ntwo\nnil\n")
+request("answer = 42" ok "")
+request("return answer" ok "42\n")
+request("error(\"boom\")" error "boom")
+request("return answer" ok "42\n")
+request("print(\"noise\") write(\"more noise\\n\") return \"quiet\"" ok "quiet\n")
+request("open(\"femmcli_server.feh\") hi_saveas(\"femmcli_server_out.feh\") hi_analyze() hi_loadsolution() T = ho_getpointvalues(1.1, 1.1)" ok "")
+request("if ho_getpointvalues(1.1, 1.1) == T and T > 0 then return \"warm\" end" ok "warm\n")
+string(APPEND requests "quit\n")
+string(APPEND expected "ok 0\n")
+
+file(WRITE femmcli_server.requests "${requests}")
+execute_process(
+    COMMAND "${FEMMCLI}" --lua-base-dir "${LUA_BASE_DIR}" --server
+    INPUT_FILE femmcli_server.requests
+    OUTPUT_VARIABLE responses
+    RESULT_VARIABLE result
+    )
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "femmcli --server failed: ${result}")
+endif()
+if(NOT responses STREQUAL expected)
+    message(FATAL_ERROR "Unexpected responses:\n${responses}\nExpected:\n${expected}")
+endif()
+message("SUCCESS")
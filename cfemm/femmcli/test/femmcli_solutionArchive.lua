@@ -0,0 +1,73 @@
+-- femmcli_solutionArchive.lua
+-- This checks that the solutions of several rotor positions can be collected
+-- in a solution archive, and that every step of the archive gives the same
+-- results as the solution it was created from.
+-- Output:
+-- SUCCESS
+showconsole()
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the values differ, complain and return 1
+function check(name, value, expected)
+	if value ~= expected then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ")")
+	return fail
+end
+
+function filesize(filename)
+	local f = openfile(filename,"r")
+	local size = seek(f, "end")
+	closefile(f)
+	return size
+end
+
+-- a problem with periodic boundaries and an air gap element
+open("femmcli_antiperiodicBC_AGE_TorqueBenchmark.fem")
+mi_saveas("femmcli_solutionArchive.fem")
+
+archive = "femmcli_solutionArchive.xarc"
+remove(archive)
+
+failed=0
+failed = failed + check("steps in missing archive", mi_numarchivesteps(archive), 0)
+
+angles = { 0, 5, 10, 15 }
+refNodes = {}
+refTorque = {}
+refA = {}
+for i = 1,getn(angles) do
+	mi_modifyboundprop("AGE", 10, angles[i])
+	mi_analyze(1)
+	failed = failed + check("angle " .. angles[i] .. ": step", mi_archivesolution(archive), i)
+	mi_loadsolution()
+	refNodes[i] = mo_numnodes()
+	refTorque[i] = mo_gapintegral("AGE", 0)
+	refA[i] = mo_getpointvalues(0.6, 0.1)
+	mo_close()
+end
+failed = failed + check("number of steps", mi_numarchivesteps(archive), getn(angles))
+failed = failed + check("torque changes with the rotor angle", (refTorque[1] ~= refTorque[2]) and 1 or 0, 1)
+
+-- the mesh is stored only once
+ansSize = filesize("femmcli_solutionArchive.ans")
+failed = failed + check("archive smaller than separate solution files",
+	(filesize(archive) < getn(angles) * ansSize) and 1 or 0, 1)
+
+-- read the steps in reverse order
+for i = getn(angles),1,-1 do
+	mi_loadarchivestep(archive, i)
+	failed = failed + check("step " .. i .. ": number of nodes", mo_numnodes(), refNodes[i])
+	failed = failed + check("step " .. i .. ": torque", mo_gapintegral("AGE", 0), refTorque[i])
+	failed = failed + check("step " .. i .. ": A", mo_getpointvalues(0.6, 0.1), refA[i])
+	mo_close()
+end
+
+assert(failed==0)
+write("SUCCESS\n")
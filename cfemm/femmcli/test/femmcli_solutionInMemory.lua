@@ -0,0 +1,144 @@
+-- femmcli_solutionInMemory.lua
+-- This checks that mi_analyze hands the solution to the post processor in memory:
+-- with XFEMM_SKIP_SOLUTION_FILE set, no .ans file is written,
+-- and mi_loadsolution must give the same results as when reading the .ans file.
+-- Output:
+-- SUCCESS
+showconsole()
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the values differ, complain and return 1
+function check(name, value, expected)
+	if value ~= expected then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ")")
+	return fail
+end
+
+-- check variable <name>,
+-- compare <value> against <expected> value with a relative tolerance
+function checkClose(name, value, expected)
+	if abs(value - expected) > 1e-9 * (abs(expected) + 1e-30) then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ")")
+	return fail
+end
+
+function exists(filename)
+	local f = openfile(filename,"r")
+	if f == nil then
+		return 0
+	end
+	closefile(f)
+	return 1
+end
+
+failed=0
+
+-- magnetostatics with periodic boundaries and an air gap element
+open("femmcli_antiperiodicBC_AGE_TorqueBenchmark.fem")
+mi_saveas("femmcli_solutionInMemory.fem")
+mi_modifyboundprop("AGE", 10, 30)
+
+-- reference: solution file
+-- (re-opening the problem discards the solution kept in memory)
+XFEMM_SKIP_SOLUTION_FILE=0
+mi_analyze(1)
+failed = failed + check("solution file written", exists("femmcli_solutionInMemory.ans"), 1)
+mi_close()
+open("femmcli_solutionInMemory.fem")
+mi_loadsolution()
+nodes = mo_numnodes()
+torque = mo_gapintegral("AGE", 0)
+A = mo_getpointvalues(0.01, 0.02)
+mo_close()
+
+-- solution in memory
+remove("femmcli_solutionInMemory.ans")
+XFEMM_SKIP_SOLUTION_FILE=1
+mi_analyze(1)
+failed = failed + check("solution file written", exists("femmcli_solutionInMemory.ans"), 0)
+mi_loadsolution()
+failed = failed + check("number of nodes", mo_numnodes(), nodes)
+failed = failed + checkClose("torque", mo_gapintegral("AGE", 0), torque)
+failed = failed + checkClose("A", mo_getpointvalues(0.01, 0.02), A)
+mo_close()
+mi_close()
+
+-- time harmonic problem: a coil above a conducting plate
+function rectangle(x1,y1,x2,y2)
+	mi_addnode(x1,y1)
+	mi_addnode(x2,y1)
+	mi_addnode(x2,y2)
+	mi_addnode(x1,y2)
+	mi_addsegment(x1,y1,x2,y1)
+	mi_addsegment(x2,y1,x2,y2)
+	mi_addsegment(x2,y2,x1,y2)
+	mi_addsegment(x1,y2,x1,y1)
+end
+
+newdocument(0)
+mi_probdef(50,"millimeters","planar",1e-8,10,30)
+rectangle(0,0,100,100)
+rectangle(20,40,80,60)
+rectangle(20,62,80,75)
+mi_addboundprop("A0",0,0,0,0,0,0,0,0,0)
+mi_selectsegment(50,0)
+mi_selectsegment(50,100)
+mi_selectsegment(0,50)
+mi_selectsegment(100,50)
+mi_setsegmentprop("A0",0,1,0,0)
+mi_clearselected()
+mi_addmaterial("Air",1,1,0,0,0)
+mi_addmaterial("Aluminum",1,1,0,0,35)
+mi_addmaterial("Copper",1,1,0,0,0)
+mi_addcircprop("Coil",10,1)
+mi_addblocklabel(10,10)
+mi_selectlabel(10,10)
+mi_setblockprop("Air",1,0,"<None>",0,0,0)
+mi_clearselected()
+mi_addblocklabel(50,50)
+mi_selectlabel(50,50)
+mi_setblockprop("Aluminum",1,0,"<None>",0,0,0)
+mi_clearselected()
+mi_addblocklabel(50,68)
+mi_selectlabel(50,68)
+mi_setblockprop("Copper",1,0,"Coil",0,0,10)
+mi_clearselected()
+mi_saveas("femmcli_solutionInMemory_harmonic.fem")
+
+XFEMM_SKIP_SOLUTION_FILE=0
+mi_analyze(1)
+mi_close()
+open("femmcli_solutionInMemory_harmonic.fem")
+mi_loadsolution()
+A = mo_getpointvalues(50, 50)
+I,V,Phi = mo_getcircuitproperties("Coil")
+mo_close()
+
+remove("femmcli_solutionInMemory_harmonic.ans")
+XFEMM_SKIP_SOLUTION_FILE=1
+mi_analyze(1)
+failed = failed + check("harmonic solution file written", exists("femmcli_solutionInMemory_harmonic.ans"), 0)
+mi_loadsolution()
+A2 = mo_getpointvalues(50, 50)
+I2,V2,Phi2 = mo_getcircuitproperties("Coil")
+failed = failed + checkClose("Re(A)", re(A2), re(A))
+failed = failed + checkClose("Im(A)", im(A2), im(A))
+failed = failed + checkClose("Re(V)", re(V2), re(V))
+failed = failed + checkClose("Im(V)", im(V2), im(V))
+mo_close()
+
+assert(failed==0)
+write("SUCCESS\n")
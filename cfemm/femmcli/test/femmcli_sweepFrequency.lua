@@ -0,0 +1,159 @@
+-- femmcli_sweepFrequency.lua
+-- This checks that mi_sweepfrequency gives the same circuit properties
+-- as setting the frequency and calling mi_analyze for each frequency,
+-- for a linear planar problem, a linear axisymmetric problem, and a nonlinear one.
+-- The meshes are coarse to keep the test fast.
+-- Output:
+-- SUCCESS
+showconsole()
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the relative error is larger than <tolerance>, complain and return 1
+function checkRel(name, value, expected, tolerance)
+	local err = abs(value - expected)
+	if expected ~= 0 then
+		err = err / abs(expected)
+	end
+	if err > tolerance then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ")")
+	return fail
+end
+
+function check(name, value, expected)
+	return checkRel(name, value, expected, 0)
+end
+
+function rectangle(x1,y1,x2,y2)
+	mi_addnode(x1,y1)
+	mi_addnode(x2,y1)
+	mi_addnode(x2,y2)
+	mi_addnode(x1,y2)
+	mi_addsegment(x1,y1,x2,y1)
+	mi_addsegment(x2,y1,x2,y2)
+	mi_addsegment(x2,y2,x1,y2)
+	mi_addsegment(x1,y2,x1,y1)
+end
+
+function label(x,y,material,circuit,turns)
+	mi_addblocklabel(x,y)
+	mi_selectlabel(x,y)
+	mi_setblockprop(material,0,meshSize,circuit,0,0,turns)
+	mi_clearselected()
+end
+
+-- sweep the frequencies, and compare each one with a separate analysis
+function compareSweep(name, frequencies)
+	local failed = 0
+	local steps = getn(frequencies)
+	local archive = "femmcli_sweepFrequency.xarc"
+	remove(archive)
+	local amps, volts, flux = mi_sweepfrequency(frequencies, archive)
+	failed = failed + check(name .. ": archived steps", mi_numarchivesteps(archive), steps)
+	for c = 1,getn(circuits) do
+		local circuit = circuits[c]
+		failed = failed + check(name .. ", " .. circuit .. ": number of steps", getn(volts[circuit]), steps)
+	end
+	for i = 1,steps do
+		mi_probdef(frequencies[i])
+		mi_analyze(1)
+		mi_loadsolution()
+		for c = 1,getn(circuits) do
+			local circuit = circuits[c]
+			local I, V, Phi = mo_getcircuitproperties(circuit)
+			local prefix = name .. ", " .. frequencies[i] .. " Hz, " .. circuit
+			failed = failed + checkRel(prefix .. ": current", amps[circuit][i], I, 1e-6)
+			failed = failed + checkRel(prefix .. ": voltage", volts[circuit][i], V, 1e-6)
+			failed = failed + checkRel(prefix .. ": flux linkage", flux[circuit][i], Phi, 1e-6)
+		end
+		mo_close()
+	end
+	-- the frequency of the problem is not changed by the sweep
+	mi_probdef(60)
+	return failed
+end
+
+failed=0
+frequencies = { 10, 1000, 20000 }
+meshSize = 6
+
+-- a current driven coil next to a conducting plate
+newdocument(0)
+mi_probdef(60,"millimeters","planar",1e-8,10,30,0)
+rectangle(0,0,100,100)
+rectangle(20,20,80,35)
+rectangle(30,50,45,70)
+rectangle(55,50,70,70)
+mi_addboundprop("A0",0,0,0,0,0,0,0,0,0)
+mi_selectsegment(50,0)
+mi_selectsegment(50,100)
+mi_selectsegment(0,50)
+mi_selectsegment(100,50)
+mi_setsegmentprop("A0",0,1,0,0)
+mi_clearselected()
+mi_addmaterial("Air",1,1,0,0,0)
+mi_addmaterial("Aluminium",1,1,0,0,35)
+mi_addmaterial("Copper",1,1,0,0,58)
+mi_addcircprop("Coil",2,1)
+mi_addcircprop("Bar",1,1)
+label(10,10,"Air","<None>",0)
+label(50,30,"Aluminium","<None>",0)
+label(40,60,"Copper","Coil",20)
+label(60,60,"Copper","Bar",1)
+mi_saveas("femmcli_sweepFrequency.fem")
+circuits = { "Coil", "Bar" }
+failed = failed + compareSweep("planar", frequencies)
+
+-- the same in a saturating plate
+mi_addbhpoint("Aluminium",0,0)
+mi_addbhpoint("Aluminium",0.5,100)
+mi_addbhpoint("Aluminium",1.0,250)
+mi_addbhpoint("Aluminium",1.4,1000)
+mi_addbhpoint("Aluminium",1.7,6000)
+mi_addbhpoint("Aluminium",2.0,50000)
+failed = failed + compareSweep("nonlinear", { 50, 1000 })
+
+-- a coil and a solid ring in a conducting pot
+newdocument(0)
+mi_probdef(60,"millimeters","axi",1e-8,0,30,0)
+rectangle(0,0,100,100)
+rectangle(10,30,40,70)
+rectangle(15,40,30,50)
+rectangle(15,55,30,60)
+mi_addboundprop("A0",0,0,0,0,0,0,0,0,0)
+mi_selectsegment(50,0)
+mi_selectsegment(50,100)
+mi_selectsegment(100,50)
+mi_setsegmentprop("A0",0,1,0,0)
+mi_clearselected()
+mi_addmaterial("Air",1,1,0,0,0)
+mi_addmaterial("Iron",100,100,0,0,10)
+mi_addmaterial("Copper",1,1,0,0,58)
+mi_addcircprop("Coil",0.5,1)
+mi_addcircprop("Ring",10,0)
+label(60,10,"Air","<None>",0)
+label(12,50,"Iron","<None>",0)
+label(20,45,"Copper","Coil",50)
+label(20,57,"Copper","Ring",1)
+mi_saveas("femmcli_sweepFrequency.fem")
+circuits = { "Coil", "Ring" }
+failed = failed + compareSweep("axisymmetric", frequencies)
+
+-- the solution of the last frequency can be loaded
+mi_sweepfrequency({ 300 })
+mi_loadsolution()
+sweepA = mo_getpointvalues(20,52)
+mo_close()
+mi_probdef(300)
+mi_analyze(1)
+mi_loadsolution()
+failed = failed + checkRel("solution of the last frequency: A", sweepA, mo_getpointvalues(20,52), 1e-6)
+
+assert(failed==0)
+write("SUCCESS\n")
@@ -0,0 +1,88 @@
+-- femmcli_sweepRotor.lua
+-- This checks that mi_sweeprotor gives the same torque and flux linkage
+-- as turning the air gap element and calling mi_analyze for each rotor position,
+-- both for a linear problem, and for a nonlinear one.
+-- Output:
+-- SUCCESS
+showconsole()
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the relative error is larger than <tolerance>, complain and return 1
+function checkRel(name, value, expected, tolerance)
+	local err = abs(value - expected)
+	if expected ~= 0 then
+		err = err / abs(expected)
+	end
+	if err > tolerance then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ")")
+	return fail
+end
+
+function check(name, value, expected)
+	return checkRel(name, value, expected, 0)
+end
+
+-- sweep the rotor, and compare each step with a separate analysis
+function compareSweep(label, startAngle, stepAngle, steps)
+	local failed = 0
+	local archive = "femmcli_sweepRotor.xarc"
+	remove(archive)
+	local torque, flux = mi_sweeprotor("AGE", startAngle, stepAngle, steps, archive)
+	failed = failed + check(label .. ": number of steps", getn(torque), steps)
+	failed = failed + check(label .. ": archived steps", mi_numarchivesteps(archive), steps)
+	for i = 1,steps do
+		mi_modifyboundprop("AGE", 10, startAngle + (i-1)*stepAngle)
+		mi_analyze(1)
+		mi_loadsolution()
+		local t = mo_gapintegral("AGE", 0)
+		local amps, volts, fluxLinkage = mo_getcircuitproperties("coil")
+		mo_close()
+		failed = failed + checkRel(label .. ", step " .. i .. ": torque", torque[i], t, 1e-6)
+		failed = failed + checkRel(label .. ", step " .. i .. ": flux linkage", flux["coil"][i], fluxLinkage, 1e-3)
+	end
+	-- the angle of the problem is not changed by the sweep
+	mi_modifyboundprop("AGE", 10, 0)
+	return failed
+end
+
+-- a problem with periodic boundaries and an air gap element
+open("femmcli_antiperiodicBC_AGE_TorqueBenchmark.fem")
+mi_saveas("femmcli_sweepRotor.fem")
+
+-- measure the flux linkage of the outer magnet
+mi_addcircprop("coil", 0, 1)
+mi_selectlabel(3.07, 0.14)
+mi_setblockprop("Ext", 1, 0, "coil", 180, 0, 10)
+mi_clearselected()
+
+failed=0
+failed = failed + compareSweep("linear", 2, 4, 3)
+
+-- a saturating outer magnet
+mi_addbhpoint("Ext", 0, 0)
+mi_addbhpoint("Ext", 0.5, 350000)
+mi_addbhpoint("Ext", 1.0, 750000)
+mi_addbhpoint("Ext", 1.3, 1300000)
+mi_addbhpoint("Ext", 1.5, 2500000)
+mi_addbhpoint("Ext", 2.0, 6000000)
+failed = failed + compareSweep("nonlinear", 12, -4, 3)
+
+-- the solution of the last step can be loaded
+mi_sweeprotor("AGE", 0, 7, 2)
+mi_loadsolution()
+sweepTorque = mo_gapintegral("AGE", 0)
+mo_close()
+mi_modifyboundprop("AGE", 10, 7)
+mi_analyze(1)
+mi_loadsolution()
+failed = failed + checkRel("solution of the last step: torque", sweepTorque, mo_gapintegral("AGE", 0), 1e-6)
+
+assert(failed==0)
+write("SUCCESS\n")
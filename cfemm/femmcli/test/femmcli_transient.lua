@@ -0,0 +1,119 @@
+-- femmcli_transient.lua
+-- This checks that hi_transient gives the same conductor temperatures and
+-- the same final temperature field as a chain of hi_analyze calls, where each
+-- call uses the solution of the previous one as previous solution.
+-- This is checked for a nonlinear problem, a linear one, and with an adaptive time step.
+-- Output:
+-- SUCCESS
+showconsole()
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the relative error is larger than <tolerance>, complain and return 1
+function checkRel(name, value, expected, tolerance)
+	local err = abs(value - expected)
+	if expected ~= 0 then
+		err = err / abs(expected)
+	end
+	if err > tolerance then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ")")
+	return fail
+end
+
+function check(name, value, expected)
+	return checkRel(name, value, expected, 0)
+end
+
+initialSolution = "femmcli_transient_init.anh"
+dT = 0.05
+
+-- solve <steps> time steps with hi_transient,
+-- and compare each output step with a chain of separate analyses
+function compareTransient(label, steps, outputEvery, maxChange)
+	local failed = 0
+	local archive = "femmcli_transient.xarc"
+	remove(archive)
+	hi_probdef("meters", "planar", 1e-8, 20, 30, initialSolution, dT)
+	local times, temperature, heatFlux = hi_transient(steps, outputEvery, archive, maxChange)
+	local outputs = getn(times)
+	failed = failed + check(label .. ": archived steps", mi_numarchivesteps(archive), outputs)
+	hi_loadsolution()
+	local T = ho_getpointvalues(1.1, 1.1)
+	ho_close()
+
+	-- without output of every step, the time steps are fixed
+	local stepTimes = times
+	if outputEvery > 1 then
+		failed = failed + check(label .. ": number of output steps", outputs, ceil(steps/outputEvery))
+		stepTimes = {}
+		for i = 1,steps do
+			stepTimes[i] = i*dT
+		end
+	end
+
+	local previous = initialSolution
+	local t = 0
+	local k = 1
+	local refT
+	for i = 1,getn(stepTimes) do
+		hi_probdef("meters", "planar", 1e-8, 20, 30, previous, stepTimes[i] - t)
+		t = stepTimes[i]
+		hi_analyze()
+		hi_loadsolution()
+		refT = ho_getpointvalues(1.1, 1.1)
+		if k <= outputs and abs(times[k] - t) < 1e-9 then
+			local refTemperature, refHeatFlux = ho_getconductorproperties("heater")
+			failed = failed + checkRel(label .. ", t=" .. t .. ": heater temperature", temperature["heater"][k], refTemperature, 1e-6)
+			failed = failed + checkRel(label .. ", t=" .. t .. ": heater flux", heatFlux["heater"][k], refHeatFlux, 1e-6)
+			k = k + 1
+		end
+		ho_close()
+		previous = "femmcli_transient_step" .. i .. ".anh"
+		remove(previous)
+		rename("femmcli_transient.anh", previous)
+	end
+	failed = failed + check(label .. ": compared output steps", k-1, outputs)
+	failed = failed + checkRel(label .. ": final temperature", T, refT, 1e-6)
+	return failed, times
+end
+
+open("femmcli_hpproc.feh")
+hi_saveas("femmcli_transient.feh")
+
+-- heat the inner region through a segment
+hi_addconductorprop("heater", 0, 20, 0)
+hi_selectsegment(1.25, 0.5)
+hi_setsegmentprop("<None>", 0, 1, 0, 0, "heater")
+hi_clearselected()
+
+-- the steady state is the initial state
+hi_analyze()
+remove(initialSolution)
+rename("femmcli_transient.anh", initialSolution)
+hi_modifyconductorprop("heater", 3, 200)
+
+failed=0
+failed = failed + compareTransient("nonlinear", 5, 2, 0)
+
+-- replace the air, whose conductivity depends on the temperature
+hi_addmaterial("Linear air", 0.03, 0.03, 0, 3)
+hi_selectlabel(1.162, 1.224)
+hi_setblockprop("Linear air", 1, 0, 0)
+hi_clearselected()
+failed = failed + compareTransient("linear", 4, 1, 0)
+
+-- the first time step is too long for the change of the heater,
+-- but the time step grows again while the temperatures settle
+fails, times = compareTransient("adaptive", 6, 1, 0.5)
+failed = failed + fails
+failed = failed + check("adaptive: first time step shortened", (times[1] < dT) and 1 or 0, 1)
+failed = failed + check("adaptive: last time step longer", (times[6] - times[5] > times[1]) and 1 or 0, 1)
+
+assert(failed==0)
+write("SUCCESS\n")
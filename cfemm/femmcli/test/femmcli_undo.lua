@@ -0,0 +1,70 @@
+-- femmcli_undo.lua
+-- This checks that the mesher leaves the geometry as it was,
+-- both after meshing a problem with periodic boundaries and after meshing failed half way
+-- (the mesher changes the segments and arc segments in place and reverts them with undo).
+-- Output:
+-- SUCCESS
+showconsole()
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the values differ, complain and return 1
+function check(name, value, expected)
+	if value ~= expected then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ")")
+	return fail
+end
+
+function readfile(filename)
+	local f = openfile(filename,"r")
+	local content = read(f,"*a")
+	closefile(f)
+	return content
+end
+
+-- save the geometry and compare it to an earlier state
+function sameGeometry(expected)
+	mi_saveas("femmcli_undo.fem")
+	if readfile("femmcli_undo.fem") == expected then
+		return 1
+	end
+	return 0
+end
+
+-- a problem with periodic boundaries and an air gap element
+open("femmcli_antiperiodicBC_AGE_TorqueBenchmark.fem")
+mi_saveas("femmcli_undo.fem")
+geometry = readfile("femmcli_undo.fem")
+
+failed=0
+
+nodes = mi_createmesh()
+mi_purgemesh()
+failed = failed + check("geometry after meshing", sameGeometry(geometry), 1)
+
+-- air gap boundaries can not be put on segments: the mesher stops after it changed the geometry
+mi_selectsegment(0, 0.25)
+mi_setsegmentprop("AGE", 0, 1, 0, 0)
+mi_clearselected()
+mi_saveas("femmcli_undo.fem")
+broken = readfile("femmcli_undo.fem")
+result = call(mi_createmesh, {}, "x", function(msg) end)
+failed = failed + check("meshing fails", (result == nil) and 1 or 0, 1)
+failed = failed + check("geometry after failed meshing", sameGeometry(broken), 1)
+
+-- the geometry can still be edited and meshed
+mi_selectsegment(0, 0.25)
+mi_setsegmentprop("<None>", 0, 1, 0, 0)
+mi_clearselected()
+failed = failed + check("geometry after repair", sameGeometry(geometry), 1)
+failed = failed + check("number of nodes", mi_createmesh(), nodes)
+mi_purgemesh()
+
+assert(failed==0)
+write("SUCCESS\n")
@@ -0,0 +1,155 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+// luaServerSocket.cpp
+// Test for LuaServer::serveSocket: a server thread listens on a UNIX domain socket,
+// and several clients connect one after the other.
+// This checks that the lua state stays alive between connections, that requests that are
+// too large are rejected without reading them, that the server keeps accepting
+// connections after a protocol error, and that "quit" stops the server.
+//
+// Usage: luaServerSocket <socket path>
+
+#include "FemmState.h"
+#include "LuaInstance.h"
+#include "LuaServer.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+/// Connect to the server; the server thread may not be listening yet.
+int connectTo(const std::string &path)
+{
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, sizeof(address.sun_path)-1);
+    for (int attempt=0; attempt<500; attempt++)
+    {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0)
+            return fd;
+        close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return -1;
+}
+
+/// Send the requests, and read the responses until the server closes the connection.
+std::string talk(const std::string &path, const std::string &requests)
+{
+    int fd = connectTo(path);
+    if (fd < 0)
+        return "(could not connect)";
+    if (write(fd, requests.data(), requests.size()) != (ssize_t)requests.size())
+    {
+        close(fd);
+        return "(could not send)";
+    }
+    // end of input: the server answers the pending requests, then closes the connection
+    shutdown(fd, SHUT_WR);
+    std::string responses;
+    char buffer[256];
+    ssize_t count;
+    while ((count = read(fd, buffer, sizeof(buffer))) > 0)
+        responses.append(buffer, count);
+    close(fd);
+    return responses;
+}
+
+std::string request(const std::string &chunk)
+{
+    return std::to_string(chunk.size()) + "\n" + chunk;
+}
+
+std::string response(const std::string &status, const std::string &payload)
+{
+    return status + " " + std::to_string(payload.size()) + "\n" + payload;
+}
+
+int check(const std::string &name, const std::string &value, const std::string &expected)
+{
+    if (value != expected)
+    {
+        std::cout << "[FAILED] " << name << ":\n" << value << "\n(expected:)\n" << expected << "\n";
+        return 1;
+    }
+    std::cout << "[  ok  ] " << name << "\n";
+    return 0;
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <socket path>\n";
+        return 1;
+    }
+    const std::string path = argv[1];
+
+    auto state = std::make_shared<femmcli::FemmState>();
+    femm::LuaInstance li(std::static_pointer_cast<femm::FemmStateBase>(state));
+    femmcli::LuaServer server(li);
+    server.quiet = true;
+    server.maxRequestSize = 1024;
+    int serverResult = -1;
+    std::thread serverThread([&]() { serverResult = server.serveSocket(path); });
+
+    int failed = 0;
+    failed += check("first connection",
+                    talk(path, request("answer = 42") + request("return answer, \"two\"")),
+                    response("ok", "") + response("ok", "42\ntwo\n"));
+    failed += check("lua state is kept between connections",
+                    talk(path, request("return answer")),
+                    response("ok", "42\n"));
+    failed += check("request above the limit",
+                    talk(path, "2048\n" + std::string(2048, ' ') + request("return answer")),
+                    response("error", "request too large: 2048 bytes (limit: 1024 bytes)"));
+    failed += check("request of more bytes than memory",
+                    talk(path, "99999999999999999999999\nreturn answer"),
+                    response("error", "request too large: 99999999999999999999999 bytes (limit: 1024 bytes)"));
+    failed += check("negative length",
+                    talk(path, "-1\nreturn answer"),
+                    response("error", "invalid request header: -1"));
+    failed += check("request at the limit",
+                    talk(path, request("return answer" + std::string(1024-13, ' '))),
+                    response("ok", "42\n"));
+    failed += check("quit",
+                    talk(path, "quit\n"),
+                    response("ok", ""));
+
+    serverThread.join();
+    if (serverResult != 0)
+    {
+        std::cout << "[FAILED] serveSocket returned " << serverResult << "\n";
+        failed++;
+    }
+    struct stat info;
+    if (stat(path.c_str(), &info) == 0)
+    {
+        std::cout << "[FAILED] the socket file was not removed\n";
+        failed++;
+    }
+    if (failed)
+        return 1;
+    std::cout << "SUCCESS\n";
+    return 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+// nodeOrdering.cpp
+// Checks the node orderings of the solvers on the graph of two triangulated square grids,
+// whose nodes are shuffled first:
+// every ordering must be a permutation, reverse Cuthill-McKee must keep the bandwidth of the grid,
+// and approximate minimum degree and nested dissection must need a smaller factor than the
+// bandwidth reducing orderings.
+// The size of the factor is checked on graphs where it is known.
+//
+// Usage: nodeOrdering <grid size>
+
+#include "nodeordering.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace femm;
+
+namespace {
+
+int failed = 0;
+
+void check(const std::string &name, bool ok)
+{
+    std::cout << (ok ? "[  ok  ] " : "[FAILED] ") << name << std::endl;
+    if (!ok)
+        failed++;
+}
+
+std::vector<int> identity(int n)
+{
+    std::vector<int> newnum(n);
+    for (int i=0; i<n; i++)
+        newnum[i] = i;
+    return newnum;
+}
+
+bool isPermutation(std::vector<int> newnum)
+{
+    std::sort(newnum.begin(), newnum.end());
+    return newnum == identity((int)newnum.size());
+}
+
+/// The edges of a square grid of size x size nodes, with one diagonal per cell,
+/// numbered in the random order given by \p node.
+std::vector<int> gridEdges(int size, const std::vector<int> &node)
+{
+    std::vector<int> edges;
+    auto add = [&](int i, int j, int k, int l) {
+        edges.push_back(node[i*size+j]);
+        edges.push_back(node[k*size+l]);
+    };
+    for (int i=0; i<size; i++)
+        for (int j=0; j<size; j++)
+        {
+            if (j+1<size)
+                add(i,j, i,j+1);
+            if (i+1<size)
+                add(i,j, i+1,j);
+            if (i+1<size && j+1<size)
+                add(i,j, i+1,j+1);
+        }
+    return edges;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <grid size>" << std::endl;
+        return 2;
+    }
+    const int size = std::atoi(argv[1]);
+
+    // the size of the factor of graphs where it is known
+    {
+        // a path does not fill in
+        std::vector<int> edges;
+        for (int i=0; i+1<10; i++)
+        {
+            edges.push_back(i);
+            edges.push_back(i+1);
+        }
+        NodeGraph path(10, edges);
+        check("path: factor without fill", path.factorSize(identity(10)) == 9);
+
+        // a star fills in completely if the centre comes first, and not at all if it comes last
+        edges.clear();
+        for (int i=1; i<10; i++)
+        {
+            edges.push_back(0);
+            edges.push_back(i);
+        }
+        NodeGraph star(10, edges);
+        check("star, centre first: full factor", star.factorSize(identity(10)) == 45);
+        std::vector<int> centreLast = identity(10);
+        std::rotate(centreLast.begin(), centreLast.end()-1, centreLast.end());
+        check("star, centre last: factor without fill", star.factorSize(centreLast) == 9);
+        // the centre and the last leaf have the same degree at the end
+        check("star: approximate minimum degree numbers the centre last",
+              star.ordering(ApproximateMinimumDegree)[0] >= 8);
+    }
+
+    // a grid whose nodes are numbered at random, next to a second grid that is not connected to it
+    const int numNodes = 2*size*size;
+    std::vector<int> node = identity(numNodes);
+    unsigned int seed = 12345;
+    for (int i=numNodes-1; i>0; i--)
+    {
+        seed = seed*1103515245u + 12345u;
+        std::swap(node[i], node[(seed >> 8) % (unsigned int)(i+1)]);
+    }
+    std::vector<int> edges = gridEdges(size, node);
+    std::vector<int> second = gridEdges(size, std::vector<int>(node.begin()+size*size, node.end()));
+    edges.insert(edges.end(), second.begin(), second.end());
+    NodeGraph grid(numNodes, edges);
+
+    const std::pair<NodeOrdering, std::string> methods[] = {
+        { CuthillMcKee, "Cuthill-McKee" },
+        { ReverseCuthillMcKee, "reverse Cuthill-McKee" },
+        { ApproximateMinimumDegree, "approximate minimum degree" },
+        { NestedDissection, "nested dissection" }
+    };
+    int bandWidth[4];
+    long long factorSize[4];
+    for (int m=0; m<4; m++)
+    {
+        std::vector<int> newnum = grid.ordering(methods[m].first);
+        check(methods[m].second + ": permutation", isPermutation(newnum));
+        bandWidth[m] = grid.bandWidth(newnum);
+        factorSize[m] = grid.factorSize(newnum);
+        std::cout << "         " << methods[m].second << ": bandwidth " << bandWidth[m]
+                  << ", factor " << factorSize[m] << std::endl;
+    }
+    check("shuffled grid: large bandwidth", grid.bandWidth(identity(numNodes)) > numNodes/2);
+    check("reverse Cuthill-McKee: bandwidth of the grid", bandWidth[1] <= size+1);
+    check("reverse Cuthill-McKee: bandwidth not larger than Cuthill-McKee", bandWidth[1] <= bandWidth[0]);
+    check("approximate minimum degree: less fill than reverse Cuthill-McKee", factorSize[2] < factorSize[1]);
+    check("nested dissection: less fill than reverse Cuthill-McKee", factorSize[3] < factorSize[1]);
+
+    if (failed)
+        return 1;
+    std::cout << "SUCCESS" << std::endl;
+    return 0;
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -0,0 +1,335 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+// parallelSolve.cpp
+// Stress test for running several solvers and post processors concurrently in one process.
+// Every problem is meshed once (the mesher is not thread safe), then each problem is solved
+// and post processed serially, and again many times in parallel threads.
+// All parallel results must be bit-identical to the serial ones.
+//
+// Usage: parallelSolve <threads> <rounds> <job>...
+// where each job is a problem file; magnetics problems may be given as <file>@<frequency>
+// to solve them at a different frequency.
+
+#include "FemmReader.h"
+#include "SolutionData.h"
+#include "epproc.h"
+#include "esolver.h"
+#include "fmesher.h"
+#include "fpproc.h"
+#include "fsolver.h"
+#include "hpproc.h"
+#include "hsolver.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace femm;
+
+namespace {
+
+/// A problem file and its mesh
+struct Problem
+{
+    std::string file;
+    FileType type;
+    std::shared_ptr<const MeshData> mesh;
+};
+
+/// One solver run: a problem, and the frequency for magnetics problems
+struct Job
+{
+    const Problem *problem;
+    double frequency;
+};
+
+/// The results of one job, compared bit for bit
+struct Result
+{
+    bool ok = false;
+    std::shared_ptr<SolutionData> solution;
+    /// values of the post processor at sample points
+    std::vector<double> pointValues;
+};
+
+// grid of sample points for the post processors
+constexpr int SampleGrid = 8;
+
+bool meshProblem(Problem &problem)
+{
+    fmesher::FMesher mesher;
+    mesher.problem->filetype = problem.type;
+    ParserResult status = F_FILE_UNKNOWN_TYPE;
+    if (problem.type == FileType::MagneticsFile)
+    {
+        MagneticsReader reader(mesher.problem, std::cerr);
+        status = reader.parse(problem.file);
+    } else if (problem.type == FileType::HeatFlowFile)
+    {
+        HeatFlowReader reader(mesher.problem, std::cerr);
+        status = reader.parse(problem.file);
+    } else if (problem.type == FileType::ElectrostaticsFile)
+    {
+        ElectrostaticsReader reader(mesher.problem, std::cerr);
+        status = reader.parse(problem.file);
+    }
+    if (status != F_FILE_OK)
+        return false;
+
+    mesher.writeMeshFiles = false;
+    int err = mesher.HasPeriodicBC()
+            ? mesher.DoPeriodicBCTriangulation(problem.file)
+            : mesher.DoNonPeriodicBCTriangulation(problem.file);
+    problem.mesh = mesher.mesh;
+    return err == 0 && problem.mesh;
+}
+
+/// Load the problem file into the solver, and set it up to keep the solution in memory.
+template <class SolverT>
+bool loadProblem(SolverT &solver, const Problem &problem)
+{
+    // filename.fem -> filename
+    solver.PathName = problem.file.substr(0, problem.file.find_last_of("."));
+    if (!solver.LoadProblemFile())
+        return false;
+    solver.meshData = problem.mesh;
+    solver.keepSolution = true;
+    solver.writeSolutionFile = false;
+    return true;
+}
+
+/// Sample points on a grid over the bounding box of the mesh
+std::vector<CComplex> samplePoints(const SolutionData &solution)
+{
+    double xmin = solution.nodeX[0];
+    double xmax = xmin;
+    double ymin = solution.nodeY[0];
+    double ymax = ymin;
+    for (int i=1; i<solution.numNodes(); i++)
+    {
+        xmin = std::min(xmin, solution.nodeX[i]);
+        xmax = std::max(xmax, solution.nodeX[i]);
+        ymin = std::min(ymin, solution.nodeY[i]);
+        ymax = std::max(ymax, solution.nodeY[i]);
+    }
+    std::vector<CComplex> points;
+    for (int i=0; i<SampleGrid; i++)
+    {
+        for (int j=0; j<SampleGrid; j++)
+        {
+            points.push_back(CComplex(
+                                 xmin + (xmax-xmin)*(i+0.5)/SampleGrid,
+                                 ymin + (ymax-ymin)*(j+0.5)/SampleGrid));
+        }
+    }
+    return points;
+}
+
+/// Solve a job, and evaluate the solution at the sample points.
+/// \p index makes the names of temporary files unique.
+Result runJob(const Job &job, int index)
+{
+    Result result;
+    const Problem &problem = *job.problem;
+    if (problem.type == FileType::MagneticsFile)
+    {
+        FSolver solver;
+        if (!loadProblem(solver, problem))
+            return result;
+        solver.Frequency = job.frequency;
+        if (!solver.runSolver(false))
+            return result;
+        result.solution = solver.solution;
+
+        FPProc pproc;
+        if (!pproc.OpenDocument(*result.solution))
+            return result;
+        for (const CComplex &p : samplePoints(*result.solution))
+        {
+            CMPointVals u;
+            if (pproc.GetPointValues(p.re, p.im, u))
+            {
+                result.pointValues.push_back(u.A.re);
+                result.pointValues.push_back(u.A.im);
+                result.pointValues.push_back(u.B1.re);
+                result.pointValues.push_back(u.B2.re);
+            }
+        }
+        result.ok = true;
+        return result;
+    }
+
+    // the heat flow and electrostatics post processors only read files
+    const std::string solutionFile = "parallelSolve_job" + std::to_string(index) + ".ans";
+    if (problem.type == FileType::HeatFlowFile)
+    {
+        HSolver solver;
+        if (!loadProblem(solver, problem) || !solver.runSolver(false))
+            return result;
+        result.solution = solver.solution;
+        if (!result.solution->writeBinary(solutionFile))
+            return result;
+
+        HPProc pproc;
+        bool opened = pproc.OpenDocument(solutionFile);
+        remove(solutionFile.c_str());
+        if (!opened)
+            return result;
+        for (const CComplex &p : samplePoints(*result.solution))
+        {
+            CHPointVals u;
+            if (pproc.getPointValues(p.re, p.im, u))
+            {
+                result.pointValues.push_back(u.T);
+                result.pointValues.push_back(u.F.re);
+                result.pointValues.push_back(u.F.im);
+            }
+        }
+    } else {
+        ESolver solver;
+        if (!loadProblem(solver, problem) || !solver.runSolver(false))
+            return result;
+        result.solution = solver.solution;
+        if (!result.solution->writeBinary(solutionFile))
+            return result;
+
+        ElectrostaticsPostProcessor pproc;
+        bool opened = pproc.OpenDocument(solutionFile);
+        remove(solutionFile.c_str());
+        if (!opened)
+            return result;
+        for (const CComplex &p : samplePoints(*result.solution))
+        {
+            CSPointVals u;
+            if (pproc.getPointValues(p.re, p.im, u))
+            {
+                result.pointValues.push_back(u.V);
+                result.pointValues.push_back(u.E.re);
+                result.pointValues.push_back(u.E.im);
+            }
+        }
+    }
+    result.ok = true;
+    return result;
+}
+
+template <typename T>
+bool sameBits(const std::vector<T> &a, const std::vector<T> &b)
+{
+    return a.size() == b.size()
+            && (a.empty() || std::memcmp(a.data(), b.data(), a.size()*sizeof(T)) == 0);
+}
+
+bool sameResult(const Result &a, const Result &b)
+{
+    return a.ok && b.ok
+            && sameBits(a.solution->nodeValue, b.solution->nodeValue)
+            && sameBits(a.solution->labelCircuitValue, b.solution->labelCircuitValue)
+            && sameBits(a.solution->conductorValue, b.solution->conductorValue)
+            && sameBits(a.solution->conductorFlux, b.solution->conductorFlux)
+            && sameBits(a.pointValues, b.pointValues);
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " <threads> <rounds> <problem file>[@<frequency>]...\n";
+        return 1;
+    }
+    const int numThreads = std::atoi(argv[1]);
+    const int rounds = std::atoi(argv[2]);
+
+    // mesh every problem file once
+    std::list<Problem> problems;
+    std::vector<Job> jobs;
+    for (int i=3; i<argc; i++)
+    {
+        const std::string arg = argv[i];
+        const std::string file = arg.substr(0, arg.find('@'));
+        const double frequency = (file == arg) ? 0 : std::atof(arg.substr(file.size()+1).c_str());
+        auto problem = std::find_if(problems.begin(), problems.end(),
+                                    [&](const Problem &p) { return p.file == file; });
+        if (problem == problems.end())
+        {
+            problems.push_back(Problem { file, fmesher::FMesher::GetFileType(file), nullptr });
+            problem = std::prev(problems.end());
+            if (!meshProblem(*problem))
+            {
+                std::cerr << "Could not mesh " << file << "\n";
+                return 1;
+            }
+        }
+        jobs.push_back(Job { &*problem, frequency });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Result> reference;
+    for (int i=0; i<(int)jobs.size(); i++)
+    {
+        reference.push_back(runJob(jobs[i], i));
+        if (!reference.back().ok)
+        {
+            std::cerr << "Serial run failed for " << jobs[i].problem->file
+                      << " at " << jobs[i].frequency << " Hz\n";
+            return 1;
+        }
+    }
+    std::cout << "serial: " << jobs.size() << " jobs in " << secondsSince(start) << "s\n";
+
+    const int numRuns = rounds * (int)jobs.size();
+    std::vector<Result> results(numRuns);
+    std::atomic<int> nextRun {0};
+    start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t=0; t<numThreads; t++)
+    {
+        threads.emplace_back([&]() {
+            for (int i=nextRun++; i<numRuns; i=nextRun++)
+                results[i] = runJob(jobs[i % jobs.size()], i);
+        });
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+    std::cout << "parallel: " << numRuns << " jobs on " << numThreads
+              << " threads in " << secondsSince(start) << "s\n";
+
+    int failed = 0;
+    for (int i=0; i<numRuns; i++)
+    {
+        const Job &job = jobs[i % jobs.size()];
+        if (!sameResult(results[i], reference[i % jobs.size()]))
+        {
+            std::cout << "[FAILED] run " << i << ": " << job.problem->file
+                      << " at " << job.frequency << " Hz differs from the serial run\n";
+            failed++;
+        }
+    }
+    if (failed)
+        return 1;
+    std::cout << "SUCCESS\n";
+    return 0;
+}
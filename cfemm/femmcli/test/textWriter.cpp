@@ -0,0 +1,176 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+// textWriter.cpp
+// Checks that the doubles written by TextWriter read back to exactly the same value:
+// subnormals, powers of ten, signed zeros, values near the limits of the double range,
+// and random bit patterns are formatted, read back with strtod, and compared bit by bit.
+// Some of the values are also written to a file and read back from there.
+//
+// Usage: textWriter <number of random values>
+
+#include "TextWriter.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace femm;
+
+namespace {
+
+int failed = 0;
+
+void check(const std::string &name, bool ok)
+{
+    std::cout << (ok ? "[  ok  ] " : "[FAILED] ") << name << std::endl;
+    if (!ok)
+        failed++;
+}
+
+uint64_t bits(double d)
+{
+    uint64_t b;
+    std::memcpy(&b, &d, sizeof(b));
+    return b;
+}
+
+double fromBits(uint64_t b)
+{
+    double d;
+    std::memcpy(&d, &b, sizeof(d));
+    return d;
+}
+
+/// Format a value and read it back; print the first few values that do not read back.
+bool roundTrip(double d)
+{
+    static int reported = 0;
+    char out[32];
+    std::string text(out, TextWriter::formatDouble(d, out));
+    double back = std::strtod(text.c_str(), nullptr);
+    if (bits(back) == bits(d))
+        return true;
+    if (reported++ < 10)
+    {
+        std::printf("         %.17g (0x%016llx) is written as %s, which reads back as %.17g\n",
+                    d, (unsigned long long)bits(d), text.c_str(), back);
+    }
+    return false;
+}
+
+/// Check a list of values and report how many of them do not read back.
+void checkValues(const std::string &name, const std::vector<double> &values)
+{
+    int wrong = 0;
+    for (double d : values)
+        if (!roundTrip(d))
+            wrong++;
+    check(name + " (" + std::to_string(values.size()) + " values, " + std::to_string(wrong) + " wrong)", wrong == 0);
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <number of random values>" << std::endl;
+        return 2;
+    }
+    const long numRandom = std::atol(argv[1]);
+
+    std::vector<double> values;
+    // smallest and largest subnormals, and every power of two in between
+    for (uint64_t b = 1; b < (uint64_t(1) << 52); b *= 2)
+    {
+        values.push_back(fromBits(b));
+        values.push_back(fromBits(b+1));
+        values.push_back(fromBits(2*b-1));
+    }
+    values.push_back(fromBits((uint64_t(1) << 52) - 1));
+    values.push_back(DBL_MIN);
+    values.push_back(std::nextafter(DBL_MIN, 0.));
+    checkValues("subnormals", values);
+
+    values.clear();
+    for (int e = -323; e <= 308; e++)
+    {
+        double d = std::strtod(("1e" + std::to_string(e)).c_str(), nullptr);
+        values.push_back(d);
+        values.push_back(std::nextafter(d, 0.));
+        values.push_back(std::nextafter(d, HUGE_VAL));
+    }
+    checkValues("powers of ten and their neighbours", values);
+
+    values = { DBL_MAX, -DBL_MAX, std::nextafter(DBL_MAX, 0.), 1.7976931348623157e308, 1.7976931348623155e308,
+               DBL_EPSILON, 1+DBL_EPSILON, 1-DBL_EPSILON/2, 0.1, 0.2, 0.3, 1./3, 2./3, 5e-324, 9007199254740993. };
+    checkValues("limits and classic cases", values);
+
+    // signed zeros keep their sign
+    {
+        char out[32];
+        std::string zero(out, TextWriter::formatDouble(0., out));
+        std::string negativeZero(out, TextWriter::formatDouble(-0., out));
+        check("zero is written as " + zero, zero == "0" && roundTrip(0.));
+        check("negative zero is written as " + negativeZero, negativeZero == "-0" && roundTrip(-0.));
+    }
+
+    // random bit patterns, without infinities and NaNs
+    values.clear();
+    std::mt19937_64 random(20181018);
+    while ((long)values.size() < numRandom)
+    {
+        double d = fromBits(random());
+        if (std::isfinite(d))
+            values.push_back(d);
+    }
+    checkValues("random bit patterns", values);
+
+    // the same values, written to a file
+    {
+        const char *file = "textWriter.txt";
+        TextWriter writer;
+        bool ok = writer.open(file);
+        for (double d : values)
+        {
+            writer.writeDouble(d);
+            writer.write('\n');
+        }
+        ok = writer.close() && ok;
+        check("file written", ok);
+
+        int wrong = 0;
+        std::FILE *fp = std::fopen(file, "rt");
+        char line[64];
+        for (double d : values)
+        {
+            if (!fp || !std::fgets(line, sizeof(line), fp) || bits(std::strtod(line, nullptr)) != bits(d))
+                wrong++;
+        }
+        if (fp)
+            std::fclose(fp);
+        std::remove(file);
+        check("file read back (" + std::to_string(wrong) + " wrong)", wrong == 0);
+    }
+
+    if (failed)
+        return 1;
+    std::cout << "SUCCESS" << std::endl;
+    return 0;
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
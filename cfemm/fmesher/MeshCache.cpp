@@ -0,0 +1,522 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "MeshCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <process.h> // _getpid
+#else
+#include <unistd.h> // getpid
+#endif
+
+using namespace femm;
+using namespace fmesher;
+
+namespace {
+
+const char fileMagic[8] = {'X','F','E','M','M','M','S','H'};
+const uint32_t fileVersion = 2;
+const uint32_t byteOrderMark = 0x01020304;
+
+/// \brief Fixed size part of an air gap element as stored in the file
+struct AirGapRecord
+{
+    int32_t BdryFormat;
+    int32_t totalArcElements;
+    double totalArcLength;
+    double ri,ro;
+    double InnerAngle,OuterAngle;
+    double InnerShift,OuterShift;
+    double agc[2];
+};
+
+/// \brief Quad node as stored in the file (independent of the layout of CQuadPoint)
+struct QuadNodeRecord
+{
+    int32_t n[4];
+    double w[4];
+};
+
+/// \brief Periodic node pair as stored in the file (independent of the layout of CCommonPoint)
+struct CommonPointRecord
+{
+    int32_t x,y,t;
+};
+
+static_assert(sizeof(int) == sizeof(int32_t), "int arrays can not be stored as int32 arrays");
+
+template <typename T>
+void addValue(std::string &fp, const T &value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "only plain values can be added to a fingerprint");
+    fp.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void addString(std::string &fp, const std::string &value)
+{
+    addValue(fp, (uint64_t)value.size());
+    fp.append(value);
+}
+
+template <typename T>
+void writeValue(std::ostream &out, const T &value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void writeArray(std::ostream &out, const T *data, uint64_t count)
+{
+    writeValue(out, count);
+    if (count)
+        out.write(reinterpret_cast<const char*>(data), count*sizeof(T));
+}
+
+template <typename T>
+void writeVector(std::ostream &out, const std::vector<T> &v)
+{
+    writeArray(out, v.data(), v.size());
+}
+
+template <typename T>
+bool readValue(std::istream &in, T &value)
+{
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return (bool)in;
+}
+
+/**
+ * @brief Read an array of items that was written by writeArray().
+ * @param in
+ * @param v
+ * @param maxCount sanity limit for the item count, so that corrupt files don't trigger huge allocations
+ * @return \c true on success
+ */
+template <typename T>
+bool readVector(std::istream &in, std::vector<T> &v, uint64_t maxCount)
+{
+    uint64_t count;
+    if (!readValue(in, count) || count > maxCount)
+        return false;
+    v.resize(count);
+    if (count)
+        in.read(reinterpret_cast<char*>(v.data()), count*sizeof(T));
+    return (bool)in;
+}
+
+bool readString(std::istream &in, std::string &s, uint64_t maxCount)
+{
+    uint64_t count;
+    if (!readValue(in, count) || count > maxCount)
+        return false;
+    s.resize(count);
+    if (count)
+        in.read(&s[0], count);
+    return (bool)in;
+}
+
+/**
+ * @brief Build the fingerprint of the mesher input of a problem.
+ * @param problem
+ * @param withCoordinates if \c false, the coordinates of nodes and block labels and the angles of arc segments are left out
+ * @return a binary string
+ */
+std::string buildFingerprint(const FemmProblem &problem, bool withCoordinates)
+{
+    std::string fp;
+    // the version is bumped whenever the mesher changes in a way that affects its output
+    addString(fp, withCoordinates ? "xfemm mesh 3" : "xfemm topology 2");
+    addValue(fp, (int)problem.filetype);
+    addValue(fp, problem.MinAngle);
+    addValue(fp, problem.DoSmartMesh);
+    addValue(fp, problem.DoForceMaxMeshArea);
+
+    // node, segment and conductor markers are the indices of the properties with matching names;
+    // (anti)periodic boundaries and air gap elements additionally depend on the boundary format.
+    // The angles of air gap elements don't change the triangulation (see withAirGapAngles()).
+    addValue(fp, (uint64_t)problem.nodeproplist.size());
+    for (const auto &prop: problem.nodeproplist)
+        addString(fp, prop->PointName);
+    addValue(fp, (uint64_t)problem.lineproplist.size());
+    for (const auto &prop: problem.lineproplist)
+    {
+        addString(fp, prop->BdryName);
+        addValue(fp, prop->BdryFormat);
+    }
+    addValue(fp, (uint64_t)problem.circproplist.size());
+    for (const auto &prop: problem.circproplist)
+        addString(fp, prop->CircName);
+
+    addValue(fp, (uint64_t)problem.nodelist.size());
+    for (const auto &node: problem.nodelist)
+    {
+        if (withCoordinates)
+        {
+            addValue(fp, node->x);
+            addValue(fp, node->y);
+        }
+        addString(fp, node->BoundaryMarkerName);
+        addString(fp, node->InConductorName);
+    }
+    addValue(fp, (uint64_t)problem.linelist.size());
+    for (const auto &line: problem.linelist)
+    {
+        addValue(fp, line->n0);
+        addValue(fp, line->n1);
+        addValue(fp, line->MaxSideLength);
+        addString(fp, line->BoundaryMarkerName);
+        addString(fp, line->InConductorName);
+    }
+    addValue(fp, (uint64_t)problem.arclist.size());
+    for (const auto &arc: problem.arclist)
+    {
+        addValue(fp, arc->n0);
+        addValue(fp, arc->n1);
+        if (withCoordinates)
+            addValue(fp, arc->ArcLength);
+        addValue(fp, arc->MaxSideLength);
+        // the periodic triangulation counts selected air gap arcs
+        addValue(fp, arc->IsSelected);
+        addString(fp, arc->BoundaryMarkerName);
+        addString(fp, arc->InConductorName);
+    }
+    addValue(fp, (uint64_t)problem.labellist.size());
+    for (const auto &label: problem.labellist)
+    {
+        if (withCoordinates)
+        {
+            addValue(fp, label->x);
+            addValue(fp, label->y);
+        }
+        addValue(fp, label->MaxArea);
+        addValue(fp, label->isHole());
+    }
+    return fp;
+}
+
+} // anonymous namespace
+
+MeshCache::MeshCache(int maxEntries)
+    : maxEntries(maxEntries)
+    , entries()
+    , cacheDir()
+{
+}
+
+std::string MeshCache::fingerprint(const FemmProblem &problem)
+{
+    return buildFingerprint(problem, true);
+}
+
+std::string MeshCache::topologyFingerprint(const FemmProblem &problem)
+{
+    return buildFingerprint(problem, false);
+}
+
+uint64_t MeshCache::hash(const std::string &fingerprint)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for (unsigned char c: fingerprint)
+    {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+std::shared_ptr<const MeshData> MeshCache::withAirGapAngles(const std::shared_ptr<const MeshData> &mesh, const FemmProblem &problem)
+{
+    std::shared_ptr<MeshData> turned;
+    for (int i=0; i<(int)mesh->ages.size(); i++)
+    {
+        const femmsolver::CAirGapElement &age = mesh->ages[i];
+        for (const auto &prop: problem.lineproplist)
+        {
+            // the mesh stores the quoted name, followed by a newline
+            if (age.BdryName != "\"" + prop->BdryName + "\"\n")
+                continue;
+            if (prop->InnerAngle == age.InnerAngle && prop->OuterAngle == age.OuterAngle)
+                break;
+            if (!turned)
+                turned = std::make_shared<MeshData>(*mesh);
+            femmsolver::CAirGapElement &turnedAge = turned->ages[i];
+            turnedAge.InnerAngle = prop->InnerAngle;
+            turnedAge.OuterAngle = prop->OuterAngle;
+            std::vector<CComplex> nodePos;
+            nodePos.reserve(age.nodeNums.size());
+            for (int node: age.nodeNums)
+                nodePos.emplace_back(mesh->nodeX[node], mesh->nodeY[node]);
+            if (!turnedAge.mapRingNodes(nodePos))
+                return nullptr;
+            break;
+        }
+    }
+    if (turned)
+        return turned;
+    return mesh;
+}
+
+bool MeshCache::lookup(const std::string &fingerprint, Entry &entry)
+{
+    for (auto it = entries.begin(); it != entries.end(); ++it)
+    {
+        if (it->first == fingerprint)
+        {
+            // move to front
+            entries.splice(entries.begin(), entries, it);
+            entry = entries.front().second;
+            hits++;
+            return true;
+        }
+    }
+    if (!cacheDir.empty() && readEntry(fileName(fingerprint), fingerprint, entry))
+    {
+        insert(fingerprint, entry);
+        hits++;
+        return true;
+    }
+    misses++;
+    return false;
+}
+
+bool MeshCache::lookupTopology(const std::string &topology, Entry &entry) const
+{
+    for (const auto &item: entries)
+    {
+        if (item.second.geometry && item.second.topology == topology)
+        {
+            entry = item.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MeshCache::store(const std::string &fingerprint, const Entry &entry)
+{
+    insert(fingerprint, entry);
+    if (cacheDir.empty())
+        return true;
+    return writeEntry(fileName(fingerprint), fingerprint, entry);
+}
+
+void MeshCache::clear()
+{
+    entries.clear();
+}
+
+void MeshCache::setDirectory(const std::string &dir)
+{
+    cacheDir = dir;
+}
+
+std::string MeshCache::fileName(const std::string &fingerprint) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.xmesh", (unsigned long long)hash(fingerprint));
+    std::string file = cacheDir;
+    if (file.back() != '/' && file.back() != '\\')
+        file += '/';
+    return file + name;
+}
+
+void MeshCache::insert(const std::string &fingerprint, const Entry &entry)
+{
+    for (auto it = entries.begin(); it != entries.end(); ++it)
+    {
+        if (it->first == fingerprint)
+        {
+            entries.erase(it);
+            break;
+        }
+    }
+    entries.emplace_front(fingerprint, entry);
+    while ((int)entries.size() > maxEntries && !entries.empty())
+        entries.pop_back();
+}
+
+bool MeshCache::readEntry(const std::string &file, const std::string &fingerprint, Entry &entry) const
+{
+    std::ifstream in(file, std::ios::binary);
+    if (!in)
+        return false;
+
+    char magic[8];
+    uint32_t version, byteOrder;
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, fileMagic, sizeof(magic)) != 0)
+        return false;
+    if (!readValue(in, version) || version != fileVersion)
+        return false;
+    if (!readValue(in, byteOrder) || byteOrder != byteOrderMark)
+        return false;
+
+    // compare the fingerprint before reading the (much larger) mesh
+    std::string storedFingerprint;
+    if (!readString(in, storedFingerprint, fingerprint.size()) || storedFingerprint != fingerprint)
+        return false;
+
+    // no array can be larger than the file
+    in.seekg(0, std::ios::end);
+    const uint64_t maxCount = (uint64_t)in.tellg();
+    in.seekg(sizeof(magic) + 2*sizeof(uint32_t) + sizeof(uint64_t) + fingerprint.size());
+
+    auto mesh = std::make_shared<MeshData>();
+    std::vector<CommonPointRecord> pbcs;
+    uint64_t numAges;
+    if (!readVector(in, entry.arcSideLengths, maxCount)
+            || !readVector(in, mesh->nodeX, maxCount)
+            || !readVector(in, mesh->nodeY, maxCount)
+            || !readVector(in, mesh->nodeMarker, maxCount)
+            || !readVector(in, mesh->elements, maxCount)
+            || !readVector(in, mesh->elementLabel, maxCount)
+            || !readVector(in, mesh->edges, maxCount)
+            || !readVector(in, mesh->edgeMarker, maxCount)
+            || !readVector(in, pbcs, maxCount)
+            || !readValue(in, numAges) || numAges > maxCount)
+        return false;
+
+    mesh->pbcs.resize(pbcs.size());
+    for (size_t i=0; i<pbcs.size(); i++)
+    {
+        mesh->pbcs[i].x = pbcs[i].x;
+        mesh->pbcs[i].y = pbcs[i].y;
+        mesh->pbcs[i].t = pbcs[i].t;
+    }
+
+    mesh->ages.resize(numAges);
+    for (auto &age: mesh->ages)
+    {
+        AirGapRecord rec;
+        std::vector<QuadNodeRecord> quadNodes;
+        if (!readString(in, age.BdryName, maxCount)
+                || !readValue(in, rec)
+                || !readVector(in, quadNodes, maxCount)
+                || !readVector(in, age.nodeNums, maxCount))
+            return false;
+        age.BdryFormat = rec.BdryFormat;
+        age.totalArcElements = rec.totalArcElements;
+        age.totalArcLength = rec.totalArcLength;
+        age.ri = rec.ri;
+        age.ro = rec.ro;
+        age.InnerAngle = rec.InnerAngle;
+        age.OuterAngle = rec.OuterAngle;
+        age.InnerShift = rec.InnerShift;
+        age.OuterShift = rec.OuterShift;
+        age.agc = CComplex(rec.agc[0], rec.agc[1]);
+        age.quadNode.resize(quadNodes.size());
+        for (size_t i=0; i<quadNodes.size(); i++)
+        {
+            CQuadPoint &qp = age.quadNode[i];
+            qp.n0 = quadNodes[i].n[0]; qp.w0 = quadNodes[i].w[0];
+            qp.n1 = quadNodes[i].n[1]; qp.w1 = quadNodes[i].w[1];
+            qp.n2 = quadNodes[i].n[2]; qp.w2 = quadNodes[i].w[2];
+            qp.n3 = quadNodes[i].n[3]; qp.w3 = quadNodes[i].w[3];
+        }
+    }
+
+    // basic consistency checks
+    if (mesh->nodeY.size() != mesh->nodeX.size()
+            || mesh->nodeMarker.size() != mesh->nodeX.size()
+            || mesh->elements.size() != 3*mesh->elementLabel.size()
+            || mesh->edges.size() != 2*mesh->edgeMarker.size())
+        return false;
+    for (const auto &age: mesh->ages)
+    {
+        for (int node: age.nodeNums)
+            if (node < 0 || node >= mesh->numNodes())
+                return false;
+    }
+
+    entry.mesh = mesh;
+    return true;
+}
+
+bool MeshCache::writeEntry(const std::string &file, const std::string &fingerprint, const Entry &entry) const
+{
+    const MeshData &mesh = *entry.mesh;
+    // write to a temporary file first, so that concurrent readers never see a partial entry;
+    // the process id keeps concurrent femmcli processes (e.g. batch jobs) from writing to the same file
+#ifdef _WIN32
+    const std::string tmpFile = file + ".tmp" + std::to_string(_getpid());
+#else
+    const std::string tmpFile = file + ".tmp" + std::to_string(getpid());
+#endif
+    {
+        std::ofstream out(tmpFile, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+
+        out.write(fileMagic, sizeof(fileMagic));
+        writeValue(out, fileVersion);
+        writeValue(out, byteOrderMark);
+        writeArray(out, fingerprint.data(), fingerprint.size());
+
+        writeVector(out, entry.arcSideLengths);
+        writeVector(out, mesh.nodeX);
+        writeVector(out, mesh.nodeY);
+        writeVector(out, mesh.nodeMarker);
+        writeVector(out, mesh.elements);
+        writeVector(out, mesh.elementLabel);
+        writeVector(out, mesh.edges);
+        writeVector(out, mesh.edgeMarker);
+
+        std::vector<CommonPointRecord> pbcs;
+        pbcs.reserve(mesh.pbcs.size());
+        for (const CCommonPoint &pbc: mesh.pbcs)
+            pbcs.push_back(CommonPointRecord { pbc.x, pbc.y, pbc.t });
+        writeVector(out, pbcs);
+
+        writeValue(out, (uint64_t)mesh.ages.size());
+        for (const auto &age: mesh.ages)
+        {
+            writeArray(out, age.BdryName.data(), age.BdryName.size());
+            AirGapRecord rec;
+            rec.BdryFormat = age.BdryFormat;
+            rec.totalArcElements = age.totalArcElements;
+            rec.totalArcLength = age.totalArcLength;
+            rec.ri = age.ri;
+            rec.ro = age.ro;
+            rec.InnerAngle = age.InnerAngle;
+            rec.OuterAngle = age.OuterAngle;
+            rec.InnerShift = age.InnerShift;
+            rec.OuterShift = age.OuterShift;
+            rec.agc[0] = age.agc.re;
+            rec.agc[1] = age.agc.im;
+            writeValue(out, rec);
+
+            std::vector<QuadNodeRecord> quadNodes;
+            quadNodes.reserve(age.quadNode.size());
+            for (const CQuadPoint &qp: age.quadNode)
+            {
+                quadNodes.push_back(QuadNodeRecord {
+                                        { qp.n0, qp.n1, qp.n2, qp.n3 },
+                                        { qp.w0, qp.w1, qp.w2, qp.w3 } });
+            }
+            writeVector(out, quadNodes);
+            writeVector(out, age.nodeNums);
+        }
+        if (!out)
+            return false;
+    }
+    if (std::rename(tmpFile.c_str(), file.c_str()) != 0)
+    {
+        // on some platforms, rename does not replace existing files
+        std::remove(file.c_str());
+        if (std::rename(tmpFile.c_str(), file.c_str()) != 0)
+        {
+            std::remove(tmpFile.c_str());
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,152 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FMESHER_MESHCACHE_H
+#define FMESHER_MESHCACHE_H
+
+#include "FemmProblem.h"
+#include "MeshData.h"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fmesher
+{
+
+/**
+ * @brief The MeshCache class remembers triangulations, so that unchanged geometry is not meshed again.
+ *
+ * Entries are keyed by a fingerprint of everything in a FemmProblem that goes into the mesher:
+ * the geometry, the mesh sizes, the mesher settings, and the names of the properties
+ * that end up as markers in the mesh (see fingerprint()).
+ * Changing a material, a current, or the value of a boundary condition does not change the key.
+ * Neither do the angles of air gap elements: turning the rotor only changes how the ring nodes
+ * are connected to the air gap element, which is recomputed by withAirGapAngles().
+ *
+ * Entries in memory can additionally keep the geometry they were created for,
+ * so that a problem whose nodes were only moved can be meshed by morphing a cached mesh
+ * (see lookupTopology() and morphMesh()).
+ *
+ * The entries are kept in memory (at most maxEntries, least recently used entries are dropped).
+ * If a directory is set, entries are additionally stored on disk, so that they can be shared
+ * between runs. The file name of an entry is the hash of its fingerprint, and the file contains
+ * the full fingerprint to rule out hash collisions.
+ *
+ * Disk file format (version 2)
+ * ----------------------------
+ * All values are stored in native byte order; the header contains a byte order mark
+ * so that files from a machine with a different byte order are ignored.
+ *
+ *  * The header: 8 bytes magic ("XFEMMMSH"), then uint32 values for the format version and the byte order mark (0x01020304).
+ *  * The fingerprint and the mesh arrays, each as uint64 item count followed by the items.
+ */
+class MeshCache
+{
+public:
+    /**
+     * @brief A cached triangulation.
+     */
+    struct Entry
+    {
+        std::shared_ptr<const femm::MeshData> mesh;
+        /// \brief The CArcSegment::mySideLength of each arc segment after meshing
+        std::vector<double> arcSideLengths;
+        /**
+         * \brief The topologyFingerprint() of the problem, if the mesh can be morphed.
+         * Like #geometry, this is only kept in memory.
+         */
+        std::string topology;
+        /// \brief The geometry that the mesh was created for (see copyGeometry()), or \c nullptr.
+        std::shared_ptr<const femm::FemmProblem> geometry;
+    };
+
+    explicit MeshCache(int maxEntries = 4);
+
+    /**
+     * @brief Build the fingerprint of all mesher input of a problem.
+     * @param problem
+     * @return a binary string; the mesher creates the same mesh for two problems with equal fingerprints
+     */
+    static std::string fingerprint(const femm::FemmProblem &problem);
+    /**
+     * @brief Build the fingerprint of the mesher input of a problem without the node coordinates.
+     * Two problems with equal topology fingerprints only differ in the positions of their nodes and block labels
+     * and in the angles of their arc segments, so that the mesh of one can be morphed into a mesh of the other.
+     * @param problem
+     * @return a binary string
+     * @see morphMesh()
+     */
+    static std::string topologyFingerprint(const femm::FemmProblem &problem);
+    /**
+     * @brief Compute a 64 bit hash (FNV-1a) of a fingerprint.
+     * @param fingerprint
+     * @return the hash value
+     */
+    static uint64_t hash(const std::string &fingerprint);
+    /**
+     * @brief Adapt the air gap elements of a cached mesh to the angles of a problem.
+     * @param mesh a mesh of a problem with the same fingerprint
+     * @param problem
+     * @return \p mesh, if the angles already match; a copy with turned air gap elements, if not;
+     * \c nullptr if the ring nodes could not be mapped.
+     */
+    static std::shared_ptr<const femm::MeshData> withAirGapAngles(const std::shared_ptr<const femm::MeshData> &mesh, const femm::FemmProblem &problem);
+
+    /**
+     * @brief Look up the mesh for a fingerprint, first in memory and then on disk.
+     * @param fingerprint
+     * @param entry the cached entry, if one was found
+     * @return \c true, if an entry was found
+     */
+    bool lookup(const std::string &fingerprint, Entry &entry);
+    /**
+     * @brief Look up the most recently used entry in memory that can be morphed into a mesh for a topology fingerprint.
+     * @param topology
+     * @param entry the cached entry, if one was found
+     * @return \c true, if an entry was found
+     */
+    bool lookupTopology(const std::string &topology, Entry &entry) const;
+    /**
+     * @brief Store an entry in memory and (if a directory is set) on disk.
+     * @param fingerprint
+     * @param entry
+     * @return \c false, if the entry could not be written to disk
+     */
+    bool store(const std::string &fingerprint, const Entry &entry);
+    /**
+     * @brief Remove all entries from memory.
+     * Files in the cache directory are not touched.
+     */
+    void clear();
+
+    /**
+     * @brief Set the directory for on-disk entries.
+     * @param dir the directory, which must exist; if empty, entries are only kept in memory.
+     */
+    void setDirectory(const std::string &dir);
+    const std::string &directory() const { return cacheDir; }
+
+    int maxEntries; ///< maximum number of entries that are kept in memory
+    int hits = 0; ///< number of successful lookups
+    int misses = 0; ///< number of failed lookups
+private:
+    std::string fileName(const std::string &fingerprint) const;
+    bool readEntry(const std::string &file, const std::string &fingerprint, Entry &entry) const;
+    bool writeEntry(const std::string &file, const std::string &fingerprint, const Entry &entry) const;
+    void insert(const std::string &fingerprint, const Entry &entry);
+
+    /// \brief entries in the order of last use (most recent first)
+    std::list<std::pair<std::string, Entry>> entries;
+    std::string cacheDir;
+};
+
+} // namespace fmesher
+
+#endif
@@ -0,0 +1,534 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "MeshMorph.h"
+
+#include "CArcSegment.h"
+#include "CBlockLabel.h"
+#include "CNode.h"
+#include "CSegment.h"
+#include "femmconstants.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace femm;
+using namespace fmesher;
+
+namespace {
+
+/// \brief Where a mesh node lies on the geometry
+struct Anchor
+{
+    enum Kind { Free, OnNode, OnSegment, OnArc };
+    Kind kind = Free;
+    int item = -1;   ///< node, segment or arc segment index
+    int piece = 0;   ///< piece of the discretized arc segment
+    double t = 0;    ///< relative position on the segment or piece
+};
+
+/**
+ * @brief Compute the corner points of a discretized arc segment, the same way as discretizeInputArcSegments().
+ * @param geometry
+ * @param arc
+ * @param numParts
+ * @param points numParts+1 points from arc.n0 to arc.n1
+ */
+void arcPoints(const FemmProblem &geometry, const CArcSegment &arc, int numParts, std::vector<CComplex> &points)
+{
+    CComplex center;
+    double R=0;
+    geometry.getCircle(arc,center,R);
+    CComplex step = exp(I*arc.ArcLength*PI/(((double) numParts)*180.));
+    points.resize(numParts+1);
+    points[0] = geometry.nodelist[arc.n0]->CC();
+    for (int j=1; j<numParts; j++)
+        points[j] = (points[j-1]-center)*step+center;
+    points[numParts] = geometry.nodelist[arc.n1]->CC();
+}
+
+/**
+ * @brief The NodeGrid class is a uniform grid over the nodes of a mesh.
+ */
+class NodeGrid
+{
+public:
+    explicit NodeGrid(const MeshData &mesh)
+    {
+        const int numNodes = mesh.numNodes();
+        if (numNodes == 0)
+            return;
+        x0 = *std::min_element(mesh.nodeX.begin(), mesh.nodeX.end());
+        y0 = *std::min_element(mesh.nodeY.begin(), mesh.nodeY.end());
+        double w = *std::max_element(mesh.nodeX.begin(), mesh.nodeX.end()) - x0;
+        double h = *std::max_element(mesh.nodeY.begin(), mesh.nodeY.end()) - y0;
+        // about one node per cell
+        cellSize = std::max(w,h) / std::sqrt((double)numNodes);
+        if (!(cellSize > 0))
+            cellSize = 1;
+        nx = (int)(w/cellSize) + 1;
+        ny = (int)(h/cellSize) + 1;
+
+        std::vector<int> cell(numNodes);
+        cellStart.assign(nx*ny+1, 0);
+        for (int n=0; n<numNodes; n++)
+        {
+            cell[n] = cellIndex(mesh.nodeX[n], mesh.nodeY[n]);
+            cellStart[cell[n]+1]++;
+        }
+        for (int c=0; c<nx*ny; c++)
+            cellStart[c+1] += cellStart[c];
+        nodes.resize(numNodes);
+        std::vector<int> fill(cellStart.begin(), cellStart.end()-1);
+        for (int n=0; n<numNodes; n++)
+            nodes[fill[cell[n]]++] = n;
+    }
+
+    /**
+     * @brief Call a function for (at least) all nodes within one cell size of a line segment.
+     * Nodes may be visited more than once.
+     * @param a
+     * @param b
+     * @param f
+     */
+    template <typename Function>
+    void forNodesAlong(CComplex a, CComplex b, Function f) const
+    {
+        if (nodes.empty())
+            return;
+        // samples are at most one cell apart, and each sample visits its neighbouring cells
+        int steps = (int)(abs(b-a)/cellSize) + 1;
+        for (int k=0; k<=steps; k++)
+        {
+            CComplex q = a + (b-a)*((double)k/steps);
+            int ix = cellCoordinate(q.re, x0, nx);
+            int iy = cellCoordinate(q.im, y0, ny);
+            for (int cy=std::max(0,iy-1); cy<=std::min(ny-1,iy+1); cy++)
+            {
+                for (int cx=std::max(0,ix-1); cx<=std::min(nx-1,ix+1); cx++)
+                {
+                    const int c = cy*nx + cx;
+                    for (int i=cellStart[c]; i<cellStart[c+1]; i++)
+                        f(nodes[i]);
+                }
+            }
+        }
+    }
+
+private:
+    int cellCoordinate(double v, double origin, int count) const
+    {
+        double c = std::floor((v-origin)/cellSize);
+        return (int)std::max(0., std::min((double)(count-1), c));
+    }
+    int cellIndex(double x, double y) const
+    {
+        return cellCoordinate(y, y0, ny)*nx + cellCoordinate(x, x0, nx);
+    }
+
+    double x0 = 0, y0 = 0;
+    double cellSize = 1;
+    int nx = 0, ny = 0;
+    std::vector<int> cellStart; ///< start of the nodes of each cell in #nodes
+    std::vector<int> nodes;
+};
+
+/// Relative position of the projection of p onto the line from a to b, and its distance from the line segment.
+double project(CComplex p, CComplex a, CComplex b, double &distance)
+{
+    CComplex d = b-a;
+    double len2 = d.re*d.re + d.im*d.im;
+    double t = 0;
+    if (len2 > 0)
+        t = ((p.re-a.re)*d.re + (p.im-a.im)*d.im) / len2;
+    t = std::max(0., std::min(1., t));
+    distance = abs(p - (a + t*d));
+    return t;
+}
+
+/// Signed area (times 2) of a triangle, and its smallest angle [deg].
+double triangleShape(CComplex p0, CComplex p1, CComplex p2, double &minAngle)
+{
+    const CComplex p[3] = { p0, p1, p2 };
+    double smallest = 180;
+    for (int j=0; j<3; j++)
+    {
+        CComplex u = p[(j+1)%3]-p[j];
+        CComplex v = p[(j+2)%3]-p[j];
+        double angle = std::atan2(std::fabs(u.re*v.im - u.im*v.re), u.re*v.re + u.im*v.im) * 180/PI;
+        smallest = std::min(smallest, angle);
+    }
+    minAngle = smallest;
+    return (p1.re-p0.re)*(p2.im-p0.im) - (p2.re-p0.re)*(p1.im-p0.im);
+}
+
+/**
+ * @brief Solve the graph Laplacian of the free nodes with a Jacobi preconditioned conjugate gradient method.
+ * @param rowStart start of the (free) neighbours of each free node in \p cols
+ * @param cols
+ * @param diag number of neighbours of each free node
+ * @param rhs sum of the displacements of the fixed neighbours of each free node
+ * @param u the displacement of each free node
+ * @return \c false, if the method did not converge
+ */
+bool solveLaplacian(const std::vector<int> &rowStart, const std::vector<int> &cols, const std::vector<double> &diag,
+                    const std::vector<double> &rhs, std::vector<double> &u)
+{
+    const int n = (int)rhs.size();
+    u.assign(n, 0.);
+    double bnorm = 0;
+    for (double b: rhs)
+        bnorm += b*b;
+    if (bnorm == 0)
+        return true;
+    bnorm = std::sqrt(bnorm);
+
+    std::vector<double> r(rhs), z(n), p(n), q(n);
+    double rz = 0;
+    for (int i=0; i<n; i++)
+    {
+        z[i] = r[i]/diag[i];
+        p[i] = z[i];
+        rz += r[i]*z[i];
+    }
+    const int maxIter = n+100;
+    for (int iter=0; iter<maxIter; iter++)
+    {
+        double pq = 0;
+        for (int i=0; i<n; i++)
+        {
+            double sum = diag[i]*p[i];
+            for (int k=rowStart[i]; k<rowStart[i+1]; k++)
+                sum -= p[cols[k]];
+            q[i] = sum;
+            pq += p[i]*sum;
+        }
+        double alpha = rz/pq;
+        double rnorm = 0;
+        for (int i=0; i<n; i++)
+        {
+            u[i] += alpha*p[i];
+            r[i] -= alpha*q[i];
+            rnorm += r[i]*r[i];
+        }
+        if (std::sqrt(rnorm) <= 1e-12*bnorm)
+            return true;
+        double rzNew = 0;
+        for (int i=0; i<n; i++)
+        {
+            z[i] = r[i]/diag[i];
+            rzNew += r[i]*z[i];
+        }
+        double beta = rzNew/rz;
+        rz = rzNew;
+        for (int i=0; i<n; i++)
+            p[i] = z[i] + beta*p[i];
+    }
+    return false;
+}
+
+/**
+ * @brief Check that each block label of a problem lies in the region of the mesh that was created for it.
+ * The mesher numbers the regions of the labels that are not holes from 1 (see TriangulateHelper::initHolesAndRegions()).
+ * A label on an edge may lie in either element.
+ * @param mesh
+ * @param problem
+ * @return \c true, if each label lies in an element of its region, and each hole label outside of the mesh
+ */
+bool labelsMatchRegions(const MeshData &mesh, const FemmProblem &problem)
+{
+    int region = 0;
+    for (const auto &label: problem.labellist)
+    {
+        const int expected = label->isHole() ? -1 : ++region;
+        bool inside = false;
+        bool found = false;
+        for (int i=0; i<mesh.numElements() && !found; i++)
+        {
+            const int *e = &mesh.elements[3*i];
+            double x[3], y[3];
+            for (int j=0; j<3; j++)
+            {
+                x[j] = mesh.nodeX[e[j]];
+                y[j] = mesh.nodeY[e[j]];
+            }
+            if (label->x < std::min({x[0],x[1],x[2]}) || label->x > std::max({x[0],x[1],x[2]})
+                    || label->y < std::min({y[0],y[1],y[2]}) || label->y > std::max({y[0],y[1],y[2]}))
+                continue;
+            const double area = (x[1]-x[0])*(y[2]-y[0]) - (x[2]-x[0])*(y[1]-y[0]);
+            bool contains = true;
+            for (int j=0; j<3 && contains; j++)
+            {
+                const int k = (j+1)%3;
+                const double a = (x[k]-x[j])*(label->y-y[j]) - (label->x-x[j])*(y[k]-y[j]);
+                contains = (a*area >= -1e-10*area*area);
+            }
+            if (!contains)
+                continue;
+            inside = true;
+            found = (mesh.elementLabel[i] == expected);
+        }
+        if (label->isHole() ? inside : !found)
+            return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+std::shared_ptr<const FemmProblem> fmesher::copyGeometry(const FemmProblem &problem)
+{
+    auto geometry = std::make_shared<FemmProblem>(problem.filetype);
+    for (const auto &node: problem.nodelist)
+        geometry->nodelist.push_back(node->clone());
+    for (const auto &line: problem.linelist)
+        geometry->linelist.push_back(line->clone());
+    for (const auto &arc: problem.arclist)
+        geometry->arclist.push_back(std::unique_ptr<CArcSegment>(new CArcSegment(*arc)));
+    return geometry;
+}
+
+std::shared_ptr<MeshData> fmesher::morphMesh(const MeshData &mesh, const FemmProblem &oldGeometry, const std::vector<double> &arcSideLengths, const FemmProblem &problem, double minAngle)
+{
+    const FemmProblem &g = oldGeometry;
+    if (g.nodelist.size() != problem.nodelist.size()
+            || g.linelist.size() != problem.linelist.size()
+            || g.arclist.size() != problem.arclist.size()
+            || arcSideLengths.size() != g.arclist.size())
+        return nullptr;
+    for (int i=0; i<(int)g.linelist.size(); i++)
+    {
+        if (g.linelist[i]->n0 != problem.linelist[i]->n0 || g.linelist[i]->n1 != problem.linelist[i]->n1)
+            return nullptr;
+    }
+    for (int i=0; i<(int)g.arclist.size(); i++)
+    {
+        if (g.arclist[i]->n0 != problem.arclist[i]->n0 || g.arclist[i]->n1 != problem.arclist[i]->n1)
+            return nullptr;
+    }
+
+    double bx[2], by[2];
+    if (!g.getBoundingBox(bx,by))
+        return nullptr;
+    // mesh nodes on the geometry are computed from it, so they only deviate by rounding errors
+    const double eps = 1e-8 * std::max(bx[1]-bx[0], by[1]-by[0]);
+
+    // the discretized arcs, before and after the change
+    std::vector<int> arcParts(g.arclist.size());
+    std::vector<std::vector<CComplex>> oldArcPoints(g.arclist.size());
+    std::vector<std::vector<CComplex>> newArcPoints(g.arclist.size());
+    std::vector<bool> arcChanged(g.arclist.size());
+    for (int i=0; i<(int)g.arclist.size(); i++)
+    {
+        const CArcSegment &arc = *g.arclist[i];
+        arcParts[i] = (int) std::ceil(arc.ArcLength/arcSideLengths[i]);
+        if (arcParts[i] < 1)
+            return nullptr;
+        arcPoints(g, arc, arcParts[i], oldArcPoints[i]);
+        arcPoints(problem, *problem.arclist[i], arcParts[i], newArcPoints[i]);
+        arcChanged[i] = (arc.ArcLength != problem.arclist[i]->ArcLength)
+                || g.nodelist[arc.n0]->CC() != problem.nodelist[arc.n0]->CC()
+                || g.nodelist[arc.n1]->CC() != problem.nodelist[arc.n1]->CC();
+    }
+
+    // find the mesh nodes on the geometry
+    const int numNodes = mesh.numNodes();
+    std::vector<Anchor> anchors(numNodes);
+    NodeGrid grid(mesh);
+    auto anchorOnLine = [&](CComplex a, CComplex b, Anchor::Kind kind, int item, int piece) {
+        grid.forNodesAlong(a, b, [&](int n) {
+            if (anchors[n].kind != Anchor::Free)
+                return;
+            double d;
+            double t = project(CComplex(mesh.nodeX[n], mesh.nodeY[n]), a, b, d);
+            if (d <= eps)
+            {
+                anchors[n].kind = kind;
+                anchors[n].item = item;
+                anchors[n].piece = piece;
+                anchors[n].t = t;
+            }
+        });
+    };
+    for (int i=0; i<(int)g.nodelist.size(); i++)
+    {
+        const CComplex p = g.nodelist[i]->CC();
+        anchorOnLine(p, p, Anchor::OnNode, i, 0);
+    }
+    for (int i=0; i<(int)g.linelist.size(); i++)
+    {
+        const CSegment &line = *g.linelist[i];
+        anchorOnLine(g.nodelist[line.n0]->CC(), g.nodelist[line.n1]->CC(), Anchor::OnSegment, i, 0);
+    }
+    // nodes on the arc segments are on the straight pieces of their discretization
+    for (int i=0; i<(int)g.arclist.size(); i++)
+    {
+        for (int j=0; j<arcParts[i]; j++)
+            anchorOnLine(oldArcPoints[i][j], oldArcPoints[i][j+1], Anchor::OnArc, i, j);
+    }
+
+    // move them with the geometry
+    auto morphed = std::make_shared<MeshData>(mesh);
+    std::vector<bool> moved(numNodes, false);
+    for (int n=0; n<numNodes; n++)
+    {
+        const Anchor &anchor = anchors[n];
+        const CComplex p(mesh.nodeX[n], mesh.nodeY[n]);
+        CComplex newPos = p;
+        switch (anchor.kind)
+        {
+        case Anchor::Free:
+            break;
+        case Anchor::OnNode:
+            newPos = problem.nodelist[anchor.item]->CC();
+            break;
+        case Anchor::OnSegment:
+        {
+            const CSegment &line = *g.linelist[anchor.item];
+            CComplex a0 = problem.nodelist[line.n0]->CC();
+            CComplex a1 = problem.nodelist[line.n1]->CC();
+            if (a0 != g.nodelist[line.n0]->CC() || a1 != g.nodelist[line.n1]->CC())
+                newPos = a0 + anchor.t*(a1-a0);
+            break;
+        }
+        case Anchor::OnArc:
+            if (arcChanged[anchor.item])
+            {
+                const std::vector<CComplex> &points = newArcPoints[anchor.item];
+                newPos = points[anchor.piece] + anchor.t*(points[anchor.piece+1]-points[anchor.piece]);
+            }
+            break;
+        }
+        if (newPos != p)
+        {
+            moved[n] = true;
+            morphed->nodeX[n] = newPos.re;
+            morphed->nodeY[n] = newPos.im;
+        }
+    }
+
+    // node graph of the mesh
+    std::vector<int> neighbourStart(numNodes+1, 0);
+    for (int i=0; i<mesh.numEdges(); i++)
+    {
+        neighbourStart[mesh.edges[2*i]+1]++;
+        neighbourStart[mesh.edges[2*i+1]+1]++;
+    }
+    for (int n=0; n<numNodes; n++)
+        neighbourStart[n+1] += neighbourStart[n];
+    std::vector<int> neighbours(neighbourStart[numNodes]);
+    {
+        std::vector<int> fill(neighbourStart.begin(), neighbourStart.end()-1);
+        for (int i=0; i<mesh.numEdges(); i++)
+        {
+            int n0 = mesh.edges[2*i];
+            int n1 = mesh.edges[2*i+1];
+            neighbours[fill[n0]++] = n1;
+            neighbours[fill[n1]++] = n0;
+        }
+    }
+
+    // only the free nodes that are connected to a moved node are smoothed
+    std::vector<int> freeIndex(numNodes, -1);
+    std::vector<int> freeNodes;
+    for (int n=0; n<numNodes; n++)
+    {
+        if (!moved[n])
+            continue;
+        for (int j=neighbourStart[n]; j<neighbourStart[n+1]; j++)
+        {
+            const int start = neighbours[j];
+            if (anchors[start].kind != Anchor::Free || freeIndex[start] >= 0)
+                continue;
+            freeIndex[start] = (int)freeNodes.size();
+            freeNodes.push_back(start);
+            // breadth first search through the free nodes
+            for (size_t k=freeNodes.size()-1; k<freeNodes.size(); k++)
+            {
+                const int node = freeNodes[k];
+                for (int l=neighbourStart[node]; l<neighbourStart[node+1]; l++)
+                {
+                    const int m = neighbours[l];
+                    if (anchors[m].kind == Anchor::Free && freeIndex[m] < 0)
+                    {
+                        freeIndex[m] = (int)freeNodes.size();
+                        freeNodes.push_back(m);
+                    }
+                }
+            }
+        }
+    }
+
+    if (!freeNodes.empty())
+    {
+        const int numFree = (int)freeNodes.size();
+        std::vector<int> rowStart(numFree+1, 0);
+        std::vector<int> cols;
+        std::vector<double> diag(numFree), rhsX(numFree, 0.), rhsY(numFree, 0.);
+        for (int i=0; i<numFree; i++)
+        {
+            const int n = freeNodes[i];
+            diag[i] = (double)(neighbourStart[n+1]-neighbourStart[n]);
+            for (int k=neighbourStart[n]; k<neighbourStart[n+1]; k++)
+            {
+                const int m = neighbours[k];
+                if (freeIndex[m] >= 0)
+                    cols.push_back(freeIndex[m]);
+                else {
+                    rhsX[i] += morphed->nodeX[m] - mesh.nodeX[m];
+                    rhsY[i] += morphed->nodeY[m] - mesh.nodeY[m];
+                }
+            }
+            rowStart[i+1] = (int)cols.size();
+        }
+        std::vector<double> ux, uy;
+        if (!solveLaplacian(rowStart, cols, diag, rhsX, ux)
+                || !solveLaplacian(rowStart, cols, diag, rhsY, uy))
+            return nullptr;
+        for (int i=0; i<numFree; i++)
+        {
+            const int n = freeNodes[i];
+            morphed->nodeX[n] += ux[i];
+            morphed->nodeY[n] += uy[i];
+            moved[n] = true;
+        }
+    }
+
+    // the air gap elements are computed from their ring nodes
+    for (const auto &age: mesh.ages)
+    {
+        for (int node: age.nodeNums)
+            if (moved[node])
+                return nullptr;
+    }
+
+    // element quality
+    for (int i=0; i<mesh.numElements(); i++)
+    {
+        const int *e = &mesh.elements[3*i];
+        if (!moved[e[0]] && !moved[e[1]] && !moved[e[2]])
+            continue;
+        double oldAngle, newAngle;
+        double oldArea = triangleShape(CComplex(mesh.nodeX[e[0]], mesh.nodeY[e[0]]),
+                                       CComplex(mesh.nodeX[e[1]], mesh.nodeY[e[1]]),
+                                       CComplex(mesh.nodeX[e[2]], mesh.nodeY[e[2]]), oldAngle);
+        double newArea = triangleShape(CComplex(morphed->nodeX[e[0]], morphed->nodeY[e[0]]),
+                                       CComplex(morphed->nodeX[e[1]], morphed->nodeY[e[1]]),
+                                       CComplex(morphed->nodeX[e[2]], morphed->nodeY[e[2]]), newAngle);
+        if (oldArea*newArea <= 0)
+            return nullptr;
+        if (newAngle < minAngle && newAngle < oldAngle)
+            return nullptr;
+    }
+
+    // the block labels may have moved to other regions, even if no node moved
+    if (!labelsMatchRegions(*morphed, problem))
+        return nullptr;
+    return morphed;
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
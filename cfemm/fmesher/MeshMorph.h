@@ -0,0 +1,62 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FMESHER_MESHMORPH_H
+#define FMESHER_MESHMORPH_H
+
+#include "FemmProblem.h"
+#include "MeshData.h"
+
+#include <memory>
+#include <vector>
+
+namespace fmesher
+{
+
+/**
+ * @brief Copy the nodes, segments and arc segments of a problem.
+ * The copy is the reference geometry for morphMesh().
+ * @param problem
+ * @return a problem that only contains the geometry
+ */
+std::shared_ptr<const femm::FemmProblem> copyGeometry(const femm::FemmProblem &problem);
+
+/**
+ * @brief Move the nodes of a mesh to a changed geometry, keeping the elements and their connectivity.
+ *
+ * Mesh nodes on the nodes, segments and arc segments of the old geometry are moved to the
+ * corresponding position of the new geometry: a node on a segment keeps its relative position
+ * between the end points, and a node on an arc segment keeps its relative position on the same
+ * piece of the discretized arc.
+ * The displacement of all other nodes is the discrete harmonic extension of the boundary displacement,
+ * i.e. each of them moves by the average displacement of its neighbours (Laplacian smoothing).
+ * Because the weights of the smoothing only depend on the mesh topology, the result only depends
+ * on the geometry, not on the sequence of morphs that led to it.
+ * Parts of the mesh whose boundary does not move keep their node coordinates exactly.
+ *
+ * @param mesh the mesh of \p oldGeometry
+ * @param oldGeometry the geometry that \p mesh was created from (see copyGeometry())
+ * @param arcSideLengths the CArcSegment::mySideLength of each arc segment of \p oldGeometry after meshing
+ * @param problem the changed problem; its segments and arc segments must connect the same nodes as in \p oldGeometry
+ * @param minAngle an element whose smallest angle [deg] gets smaller than this and smaller than before rejects the morphed mesh
+ * The topology of the problem does not include the positions of its block labels,
+ * so each block label is looked up in the morphed mesh, and must lie in the region that was meshed for it.
+ *
+ * @return the morphed mesh, or \c nullptr if the mesh can not be morphed:
+ * if an element is inverted or too distorted, if the nodes of an air gap element would have to move,
+ * if a block label lies in another region than before, or if the geometries don't match.
+ */
+std::shared_ptr<femm::MeshData> morphMesh(
+        const femm::MeshData &mesh,
+        const femm::FemmProblem &oldGeometry,
+        const std::vector<double> &arcSideLengths,
+        const femm::FemmProblem &problem,
+        double minAngle);
+
+} // namespace fmesher
+
+#endif
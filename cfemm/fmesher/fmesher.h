@@ -40,6 +40,8 @@
 #include "CSegment.h"
 #include "femmenums.h"
 #include "FemmProblem.h"
+#include "MeshData.h"
+#include "MeshCache.h"
 
 #include <memory>
 #include <vector>
@@ -90,6 +92,26 @@ public:
     std::shared_ptr<femm::FemmProblem> problem;
     bool Verbose = true;
     bool writePolyFiles = false; ///< write .poly files when calling triangle
+    bool writeMeshFiles = true; ///< write .node, .ele, .edge and .pbc files after triangulation
+    /**
+     * \brief The triangulation created by the last call to DoNonPeriodicBCTriangulation() or DoPeriodicBCTriangulation().
+     * Pass this to a solver to avoid writing and reading the mesh files.
+     * It is \c nullptr if the triangulation could not be kept in memory; in that case the mesh files are always written.
+     */
+    std::shared_ptr<const femm::MeshData> mesh;
+    /**
+     * \brief Mesh cache shared between meshers, or \c nullptr to always call triangle.
+     * If the mesher input of the problem matches a cached entry, the triangulation is taken from the cache.
+     */
+    std::shared_ptr<MeshCache> meshCache;
+    /**
+     * \brief Smallest element angle [deg] that a morphed mesh must keep, or 0 to disable mesh morphing.
+     * If the mesher input of the problem only differs from a mesh in #meshCache by the positions of the nodes
+     * (e.g. in an optimization loop), the cached mesh is morphed to the new geometry instead of calling triangle.
+     * The problem is only meshed again if an element gets inverted, or if its smallest angle gets smaller
+     * than this value (and than before); see morphMesh().
+     */
+    double morphMinAngle = 0;
 
 	std::string BinDir;
 
@@ -135,6 +157,18 @@ public:
 	int DoNonPeriodicBCTriangulation(std::string PathName);
 	int DoPeriodicBCTriangulation(std::string PathName);
 	bool HasPeriodicBC();
+    /**
+     * @brief Refine the triangulation in #mesh, e.g. for adaptive mesh refinement.
+     * Triangle is called in refinement mode on the existing triangulation, so that existing nodes and elements
+     * are only split up, and the boundaries and regions of the mesh stay the same.
+     * The refined triangulation replaces #mesh; no mesh files are written.
+     * @param maxArea the maximum area of each element of #mesh, or a negative value for elements that need no refinement
+     * @return 0 on success
+     * \internal
+     * \note This method does not exist in FEMM42.
+     * \endinternal
+     */
+    int refineMesh(const std::vector<double> &maxArea);
 
     // pointer to function to call when issuing warning messages
     int (*WarnMessage)(const char*, ...);
@@ -145,6 +179,33 @@ public:
 private:
 
     virtual bool Initialize(femm::FileType t);
+    /**
+     * @brief Take the mesh from the cache instead of calling triangle.
+     * If no entry matches and #morphMinAngle is set, a cached mesh of the same topology is morphed to the geometry.
+     * On success, the state of the problem and the written files are the same as after triangulation.
+     * @param key the fingerprint of the problem
+     * @param PathName
+     * @param periodic \c true for DoPeriodicBCTriangulation()
+     * @return \c true, if a cached mesh was used
+     * \internal
+     * \note This method does not exist in FEMM42.
+     * \endinternal
+     */
+    bool useCachedMesh(const std::string &key, std::string PathName, bool periodic);
+    /**
+     * @brief Morph a cached mesh of the same topology to the geometry of the problem.
+     * @param entry the entry with the morphed mesh
+     * @return \c true, if a mesh could be morphed
+     * \internal
+     * \note This method does not exist in FEMM42.
+     * \endinternal
+     */
+    bool morphCachedMesh(MeshCache::Entry &entry);
+    /**
+     * @brief Store the current mesh in the cache.
+     * @param key the fingerprint of the problem before triangulation
+     */
+    void cacheMesh(const std::string &key);
 	void addFileStr (char * q);
 };
 
@@ -14888,14 +14888,16 @@ char **argv;
   /* To loop over the set of edges, loop over all triangles, and look at   */
   /*   the three edges of each triangle.  If there isn't another triangle  */
   /*   adjacent to the edge, operate on the edge.  If there is another     */
-  /*   adjacent triangle, operate on the edge only if the current triangle */
-  /*   has a smaller pointer than its neighbor.  This way, each edge is    */
-  /*   considered only once.                                               */
+  /*   adjacent triangle, operate on the edge only if the neighbor has not */
+  /*   been visited yet.  This way, each edge is considered only once.     */
+  /* Visited triangles are marked with the virus.  Unlike comparing the    */
+  /*   triangle pointers, this lists the edges in an order that does not   */
+  /*   depend on where the memory blocks of the triangle pool were put.    */
   while (triangleloop.tri != (triangle *) NULL) {
     for (triangleloop.orient = 0; triangleloop.orient < 3;
          triangleloop.orient++) {
       sym(triangleloop, trisym);
-      if ((triangleloop.tri < trisym.tri) || (trisym.tri == m->dummytri)) {
+      if ((trisym.tri == m->dummytri) || !infected(trisym)) {
         org(triangleloop, p1);
         dest(triangleloop, p2);
 #ifdef TRILIBRARY
@@ -14940,6 +14942,14 @@ char **argv;
         edgenumber++;
       }
     }
+    infect(triangleloop);
+    triangleloop.tri = triangletraverse(m);
+  }
+  /* Cure the triangles again. */
+  traversalinit(&m->triangles);
+  triangleloop.tri = triangletraverse(m);
+  while (triangleloop.tri != (triangle *) NULL) {
+    uninfect(triangleloop);
     triangleloop.tri = triangletraverse(m);
   }
 
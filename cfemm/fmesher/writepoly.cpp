@@ -28,6 +28,7 @@
 // implementation of various incarnations of calls
 // to triangle from the FMesher class
 #include "fmesher.h"
+#include "MeshMorph.h"
 #include "fparse.h"
 #include "IntPoint.h"
 #include "femmconstants.h"
@@ -41,12 +42,14 @@
 //}
 
 #include <iostream>
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdio>
 #include <fstream>
 #include <iomanip>
 #include <malloc.h>
+#include <map>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -65,8 +68,6 @@
 #define BoundingBoxFraction 100.0
 #endif
 
-#define toDegrees(x) ((Im(x)>=0) ? arg(x) : (arg(x) + 2.*PI))*(180./PI)
-
 using namespace std;
 using namespace femm;
 using namespace fmesher;
@@ -123,6 +124,16 @@ public:
      * @return \c true on success, \c false on (allocation) error
      */
     bool initHolesAndRegions(const FemmProblem &problem, bool forceMaxMeshArea, double defaultMeshSize);
+    /**
+     * @brief Use an existing triangulation as input for triangle, and switch triangle to refinement mode.
+     * The edges that carry a boundary marker, that lie on the mesh boundary, or that separate two regions
+     * are passed as segments, so that the refined mesh keeps all boundaries.
+     * Use this instead of the other initialization functions.
+     * @param mesh the triangulation
+     * @param maxArea the maximum area of each element of \p mesh, or a negative value for no constraint
+     * @return \c true on success, \c false on (allocation) error
+     */
+    bool initRefinement(const MeshData &mesh, const std::vector<double> &maxArea);
 
     /**
      * @brief triangulate
@@ -148,6 +159,13 @@ public:
      */
     bool writePolyFile(std::string filename, std::string comment) const;
     bool writeTriangulationFiles(std::string Pathname) const;
+    /**
+     * @brief Copy the triangulation into \p mesh, replacing its node, element and edge data.
+     * Periodic boundary conditions and air gap elements are not touched.
+     * @param mesh
+     * @return \c true on success, \c false if the triangle interface does not support this.
+     */
+    bool storeTriangulation(MeshData &mesh) const;
 
     // pointer to function to call when issuing warning messages
     int (*WarnMessage)(const char*, ...);
@@ -176,6 +194,7 @@ private:
     context *ctx;
 #endif
     double m_minAngle = 0.;
+    bool m_refine = false;
     bool m_suppressExteriorSteinerPoints = false;
     bool m_suppressUnusedVertices = false;
 };
@@ -222,6 +241,17 @@ void initialize(triangleio &io)
     io.numberofedges = 0;
 }
 
+/**
+ * @brief Record the arc segments whose mySideLength is about to be set by discretizeInputArcSegments().
+ * @param problem
+ */
+void recordArcSideLengthChanges(FemmProblem &problem)
+{
+    for (int i=0; i<(int)problem.arclist.size(); i++)
+        if (problem.arclist[i]->mySideLength != problem.arclist[i]->MaxSideLength)
+            problem.recordArcSegmentChange(i);
+}
+
 }
 
 double FMesher::averageLineLength() const
@@ -697,6 +727,116 @@ bool TriangulateHelper::writeTriangulationFiles(string PathName) const
     return true;
 }
 
+bool TriangulateHelper::storeTriangulation(MeshData &mesh) const
+{
+#ifdef XFEMM_BUILTIN_TRIANGLE
+    mesh.nodeX.resize(out.numberofpoints);
+    mesh.nodeY.resize(out.numberofpoints);
+    mesh.nodeMarker.assign(out.pointmarkerlist, out.pointmarkerlist + out.numberofpoints);
+    for(int i = 0; i < out.numberofpoints; i++)
+    {
+        mesh.nodeX[i] = out.pointlist[2*i];
+        mesh.nodeY[i] = out.pointlist[2*i+1];
+    }
+
+    mesh.edges.assign(out.edgelist, out.edgelist + 2*out.numberofedges);
+    mesh.edgeMarker.assign(out.edgemarkerlist, out.edgemarkerlist + out.numberofedges);
+
+    // only the corner nodes are used by the solvers, and only the first attribute (the region number)
+    mesh.elements.resize(3*out.numberoftriangles);
+    mesh.elementLabel.resize(out.numberoftriangles);
+    for(int i = 0; i < out.numberoftriangles; i++)
+    {
+        for (int j = 0; j < 3; j++)
+            mesh.elements[3*i+j] = out.trianglelist[i*out.numberofcorners+j];
+        if (out.numberoftriangleattributes > 0)
+            mesh.elementLabel[i] = (int)out.triangleattributelist[i*out.numberoftriangleattributes];
+        else
+            mesh.elementLabel[i] = 0;
+    }
+    return true;
+#else
+    // triangle_api has no accessor for the mesh arrays
+    (void)mesh;
+    return false;
+#endif
+}
+
+bool FMesher::useCachedMesh(const std::string &key, std::string PathName, bool periodic)
+{
+    MeshCache::Entry entry;
+    bool morphed = false;
+    if (!meshCache->lookup(key, entry))
+    {
+        if (morphMinAngle <= 0 || !morphCachedMesh(entry))
+            return false;
+        morphed = true;
+    }
+    // the fingerprint contains the number of arcs, so this is just a sanity check
+    if (entry.arcSideLengths.size() != problem->arclist.size())
+        return false;
+
+    // the cached mesh may have been created for other rotor angles
+    std::shared_ptr<const MeshData> cachedMesh = MeshCache::withAirGapAngles(entry.mesh, *problem);
+    if (!cachedMesh)
+        return false;
+    if (writeMeshFiles && !cachedMesh->write(PathName.substr(0, PathName.find_last_of('.'))))
+    {
+        WarnMessage("Couldn't write the mesh files\n");
+        return false;
+    }
+    mesh = cachedMesh;
+    for (int i=0; i<(int)problem->arclist.size(); i++)
+        problem->arclist[i]->mySideLength = entry.arcSideLengths[i];
+
+    if (periodic)
+    {
+        // leave the selection in the same state as DoPeriodicBCTriangulation does,
+        // and save the arc discretization into the .fem file
+        problem->updateUndo();
+        problem->unselectAll();
+        problem->undoLines();
+        problem->saveFEMFile(PathName);
+    }
+    // the morphed mesh can be used directly the next time
+    if (morphed)
+        cacheMesh(key);
+    return true;
+}
+
+bool FMesher::morphCachedMesh(MeshCache::Entry &entry)
+{
+    if (!meshCache->lookupTopology(MeshCache::topologyFingerprint(*problem), entry))
+        return false;
+    std::shared_ptr<MeshData> morphed = morphMesh(*entry.mesh, *entry.geometry, entry.arcSideLengths, *problem, morphMinAngle);
+    if (!morphed)
+    {
+        if (Verbose)
+            WarnMessage("The cached mesh can not be morphed to the changed geometry, meshing again.\n");
+        return false;
+    }
+    entry.mesh = morphed;
+    return true;
+}
+
+void FMesher::cacheMesh(const std::string &key)
+{
+    if (!mesh)
+        return;
+    MeshCache::Entry entry;
+    entry.mesh = mesh;
+    entry.arcSideLengths.reserve(problem->arclist.size());
+    for (const auto &arc: problem->arclist)
+        entry.arcSideLengths.push_back(arc->mySideLength);
+    if (morphMinAngle > 0)
+    {
+        entry.topology = MeshCache::topologyFingerprint(*problem);
+        entry.geometry = copyGeometry(*problem);
+    }
+    if (!meshCache->store(key, entry))
+        WarnMessage("Couldn't write mesh cache entry\n");
+}
+
 /**
  * @brief FMesher::DoNonPeriodicBCTriangulation
  * What we do in the normal case is DoNonPeriodicBCTriangulation
@@ -715,10 +855,8 @@ int FMesher::DoNonPeriodicBCTriangulation(string PathName)
     // if (!problem->previousSolutionFile.empty() && problem->Frequency>0)
     //     return true;
 
-    FILE *fp;
     double dL;
     //CStdString s;
-    string plyname;
     std::vector < std::unique_ptr<CNode> >       nodelst;
     std::vector < std::unique_ptr<CSegment> >    linelst;
 
@@ -726,6 +864,16 @@ int FMesher::DoNonPeriodicBCTriangulation(string PathName)
     WarnMessage("writepoly: beginning NON periodic boundary triangulation\n");
 #endif // DEBUG
 
+    mesh.reset();
+
+    std::string cacheKey;
+    if (meshCache)
+    {
+        cacheKey = MeshCache::fingerprint(*problem);
+        if (useCachedMesh(cacheKey, PathName, false))
+            return 0;
+    }
+
     nodelst.clear();
     linelst.clear();
     // calculate length used to kludge fine meshing near input node points
@@ -771,15 +919,6 @@ int FMesher::DoNonPeriodicBCTriangulation(string PathName)
 //        }
 //    fclose(fp);
 
-    // write out a trivial pbc file
-    plyname = pn.substr(0,pn.find_last_of('.')) + ".pbc";
-    if ((fp=fopen(plyname.c_str(),"wt"))==NULL){
-        WarnMessage("Couldn't write to specified .pbc file");
-        return -1;
-    }
-    fprintf(fp,"0\n0\n");
-    fclose(fp);
-
     // **********         call triangle       ***********
 
     {
@@ -803,10 +942,25 @@ int FMesher::DoNonPeriodicBCTriangulation(string PathName)
         if (tristatus != 0)
             return tristatus;
 
-        triHelper.writeTriangulationFiles(PathName);
+        std::shared_ptr<MeshData> newMesh = std::make_shared<MeshData>();
+        if (triHelper.storeTriangulation(*newMesh))
+            mesh = newMesh;
+
+        if (writeMeshFiles || !mesh)
+        {
+            // write out a trivial pbc file
+            if (!MeshData().writePbc(pn.substr(0,pn.find_last_of('.'))))
+            {
+                WarnMessage("Couldn't write to specified .pbc file");
+                return -1;
+            }
+            triHelper.writeTriangulationFiles(PathName);
+        }
     }
     problem->clearNotationTags();
 
+    if (meshCache)
+        cacheMesh(cacheKey);
     return 0;
 }
 
@@ -826,15 +980,13 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
     // // we can just bail out in that case.
     // if (!problem->previousSolutionFile.empty() && problem->Frequency>0)
     //     return true;
-    FILE *fp;
     int i, j, k, n;
     int l,n0,n1,n2;
     double z,R,dL;
     CComplex a0,a1,a2,c;
     CComplex b0,b1,b2;
-    char instring[1024];
     //string s;
-    string plyname;
+    MeshData trialMesh;
     std::vector < std::unique_ptr<CNode> >              nodelst;
     std::vector < std::unique_ptr<CSegment> >           linelst;
     //std::vector < std::unique_ptr<CCBlockLabel> >       blocklst;
@@ -851,7 +1003,19 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
     WarnMessage("writepoly: beginning periodic boundary triangulation\n");
 #endif // DEBUG
 
+    mesh.reset();
+
+    std::string cacheKey;
+    if (meshCache)
+    {
+        cacheKey = MeshCache::fingerprint(*problem);
+        if (useCachedMesh(cacheKey, PathName, true))
+            return 0;
+    }
+
     problem->updateUndo();
+    // the segments and arc segments are changed in place below (cnt, orientation, side lengths),
+    // each of them is recorded right before its first change
 
     // calculate length used to kludge fine meshing near input node points
     dL = averageLineLength() / LineFraction;
@@ -865,6 +1029,7 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
     discretizeInputSegments(*problem, nodelst, linelst, dL);
 
     // discretize input arc segments
+    recordArcSideLengthChanges(*problem);
     discretizeInputArcSegments(*problem, nodelst, linelst);
 
 
@@ -881,6 +1046,10 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
 
     // **********         call triangle       ***********
 
+    // This trial triangulation can not be skipped by splitting the periodic
+    // segment pairs up front: the number of pieces triangle cuts each outer
+    // boundary segment and arc into while enforcing the mesh quality becomes
+    // their MaxSideLength for the final triangulation below.
     {
         TriangulateHelper triHelper;
         triHelper.WarnMessage = WarnMessage;
@@ -903,14 +1072,28 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
         if (tristatus != 0)
             return tristatus;
 
-        triHelper.writeTriangulationFiles(PathName);
+        // the trial mesh is only needed to find out how triangle splits
+        // the segments, so it is kept in memory instead of writing it to disk
+        if (!triHelper.storeTriangulation(trialMesh))
+        {
+            // the triangle interface has no access to the mesh arrays, take the detour over the files
+            string baseName = PathName.substr(0, PathName.find_last_of('.'));
+            if (!triHelper.writeTriangulationFiles(PathName)
+                    || !MeshData().writePbc(baseName)
+                    || trialMesh.read(baseName) != NOERROR)
+            {
+                WarnMessage("Call to triangle was unsuccessful\n");
+                problem->undo();  problem->unselectAll();
+                return -1;
+            }
+        }
     }
 
 #ifdef DEBUG
     WarnMessage("writepoly: finished calling triangle\n");
 #endif // DEBUG
 
-    // So far, so good.  Now, read back in the .edge file
+    // So far, so good.  Now, go through the edges of the trial mesh
     // to make sure the points in the segments and arc
     // segments are ordered in a consistent way so that
     // the (anti)periodic boundary conditions can be applied.
@@ -919,15 +1102,8 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
     WarnMessage("writepoly: 876\n");
 #endif // DEBUG
 
-    // read meshlines;
-    plyname = pn.substr(0,pn.find_last_of('.')) + ".edge";
-    if((fp=fopen(plyname.c_str(),"rt"))==NULL){
-        WarnMessage("Call to triangle was unsuccessful\n");
-        problem->undo();  problem->unselectAll();
-        return -1;
-    }
-    fgets(instring,1024,fp);
-    sscanf(instring,"%i",&k);
+    // meshlines;
+    k = trialMesh.numEdges();
     problem->clearNotationTags();
     // use cnt again to keep a
     // tally of how many subsegments each
@@ -952,11 +1128,11 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
 
     for(i=0;i<k;i++)
     {
-        // get the next edge from the file
-        fgets(instring,1024,fp);
-        // get the edge number, start and end points (n0 and n1) and the
+        // get the start and end points (n0 and n1) of the next edge and the
         // segment/arc marker j
-        sscanf(instring,"%i    %i    %i    %i",&l,&n0,&n1,&j);
+        n0 = trialMesh.edges[2*i];
+        n1 = trialMesh.edges[2*i+1];
+        j = trialMesh.edgeMarker[i];
         // if j != 0, this edge is part of a segment/arc
         if(j!=0)
         {
@@ -980,6 +1156,7 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
                 // increment cnt for the segment which the edge we are
                 // examining is a part of to get a tally of how many edges
                 // are a part of the segment/boundary
+                problem->recordSegmentChange(j);
                 problem->linelist[j]->cnt++;
                 // check if the end n0 of the segment is the same node as the
                 // end n1 of the edge, or if the end n1 of the segment is the
@@ -999,6 +1176,7 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
                 // normal is on.
 
                 j=j-(int)problem->linelist.size();
+                problem->recordArcSegmentChange(j);
                 problem->arclist[j]->cnt++;
                 // Note(ZaJ): I assume that the second if statement should just be the else branch of the first if statement...
                 if((problem->arclist[j]->n0==n1) || (problem->arclist[j]->n1==n0))
@@ -1008,7 +1186,6 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
             }
         }
     }
-    fclose(fp);
 
 #ifdef DEBUG
     WarnMessage("writepoly: 974\n");
@@ -1023,23 +1200,26 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
     // elements each reference segment appears in.  If a
     // segment is on the boundary, it ought to appear in just
     // one element.  Otherwise, it appears in two.
-    plyname = pn.substr(0,pn.find_last_of('.')) + ".ele";
-    if((fp=fopen(plyname.c_str(),"rt"))==NULL){
-        WarnMessage("Call to triangle was unsuccessful");
-        problem->undo();  problem->unselectAll();
-        return -1;
-    }
-    fgets(instring,1024,fp);
-    sscanf(instring,"%i",&k);
+    k = trialMesh.numElements();
 
 #ifdef DEBUG
     WarnMessage("writepoly: 996\n");
 #endif // DEBUG
 
+    // look up the reference segments by their (sorted) end points
+    // instead of comparing every element side to every reference segment
+    std::multimap<std::pair<int,int>, int> referenceLines;
+    for(j=0;j<(int)ptlst.size();j++)
+    {
+        if (ptlst[j]->t != 0)
+            referenceLines.emplace(std::make_pair(ptlst[j]->x, ptlst[j]->y), j);
+    }
+
     for(i=0;i<k;i++)
     {
-        fgets(instring,1024,fp);
-        sscanf(instring,"%i    %i    %i    %i",&j,&n0,&n1,&n2);
+        n0 = trialMesh.elements[3*i];
+        n1 = trialMesh.elements[3*i+1];
+        n2 = trialMesh.elements[3*i+2];
 
         // Sort out the three nodes...
         if (n0>n1) { n=n0; n0=n1; n1=n; }
@@ -1048,14 +1228,13 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
 
         // now, check to see if any of the test segments
         // are sides of this node...
-        for(j=0;j<(int)ptlst.size();j++)
+        for (const auto &side : { std::make_pair(n0,n1), std::make_pair(n0,n2), std::make_pair(n1,n2) })
         {
-            if ((n0==ptlst[j]->x) && (n1==ptlst[j]->y)) ptlst[j]->t--;
-            if ((n0==ptlst[j]->x) && (n2==ptlst[j]->y)) ptlst[j]->t--;
-            if ((n1==ptlst[j]->x) && (n2==ptlst[j]->y)) ptlst[j]->t--;
+            auto range = referenceLines.equal_range(side);
+            for (auto it = range.first; it != range.second; ++it)
+                ptlst[it->second]->t--;
         }
     }
-    fclose(fp);
 
 #ifdef DEBUG
     WarnMessage("writepoly: 1021\n");
@@ -1070,6 +1249,7 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
             // length of the boundary divided by the number
             // of elements that were created in the first
             // attempt at meshing
+            problem->recordSegmentChange(i);
             problem->linelist[i]->MaxSideLength = problem->lengthOfLine(i) / ((double) problem->linelist[i]->cnt);
         }
     }
@@ -1090,6 +1270,7 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
             sprintf(kludge,"%.1e",newMaxSideLength);
             sscanf(kludge,"%lf",&newMaxSideLength);
 
+            problem->recordArcSegmentChange(i);
             problem->arclist[i]->MaxSideLength = newMaxSideLength;
         }
     }
@@ -1228,7 +1409,10 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
 			// apply new side length to all arcs in this AGE
 			for(j=0;j<(int)problem->arclist.size();j++)
 				if (problem->arclist[j]->BoundaryMarkerName==agelst[i]->BdryName)
+				{
+					problem->recordArcSegmentChange(j);
 					problem->arclist[j]->MaxSideLength=myMaxSideLength;
+				}
 		}
 	}
 
@@ -1367,6 +1551,8 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
             if(len2<=0) len2=len1;
             len=(std::min)(len1,len2);
 
+            problem->recordSegmentChange(pbclst[j]->seg[0]);
+            problem->recordSegmentChange(pbclst[j]->seg[1]);
             problem->linelist[pbclst[j]->seg[0]]->MaxSideLength=len;
             problem->linelist[pbclst[j]->seg[1]]->MaxSideLength=len;
         }
@@ -1391,6 +1577,8 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
 
             len=(std::min)(len1,len2);
 
+            problem->recordArcSegmentChange(pbclst[j]->seg[0]);
+            problem->recordArcSegmentChange(pbclst[j]->seg[1]);
             problem->arclist[pbclst[j]->seg[0]]->MaxSideLength=len;
             problem->arclist[pbclst[j]->seg[1]]->MaxSideLength=len;
         }
@@ -1421,6 +1609,8 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
 
             s0=pbclst[n]->seg[0];
             s1=pbclst[n]->seg[1];
+            problem->recordSegmentChange(s0);
+            problem->recordSegmentChange(s1);
             problem->linelist[s0]->IsSelected=true;
             problem->linelist[s1]->IsSelected=true;
 
@@ -1530,6 +1720,8 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
 
             s0 = pbclst[n]->seg[0];
             s1 = pbclst[n]->seg[1];
+            problem->recordArcSegmentChange(s0);
+            problem->recordArcSegmentChange(s1);
             problem->arclist[s0]->IsSelected = true;
             problem->arclist[s1]->IsSelected = true;
 
@@ -1657,6 +1849,7 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
 
 		for(i=0;i<(int)problem->arclist.size();i++)
 		if((problem->arclist[i]->IsSelected==false) && (problem->arclist[i]->BoundaryMarkerName==agelst[n]->BdryName)){
+			problem->recordArcSegmentChange(i);
 			problem->arclist[i]->IsSelected=true;
 			a2.Set(problem->nodelist[problem->arclist[i]->n0]->x,problem->nodelist[problem->arclist[i]->n0]->y);
 			k=(int) ceil(problem->arclist[i]->ArcLength/problem->arclist[i]->MaxSideLength);
@@ -1715,11 +1908,7 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
 				}
 			}
 		}
-        agelst[n]->nodeNums.clear ();
-		agelst[n]->nodeNums.shrink_to_fit ();
-		agelst[n]->nodeNums.reserve (myVector.size()+1);
-		agelst[n]->nodeNums[0]=(int) myVector.size();
-		for(k=0;k<(int)myVector.size();k++) agelst[n]->nodeNums[k+1]=myVector[k];
+		agelst[n]->nodeNums = myVector;
 	}
 
 
@@ -1730,6 +1919,7 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
     discretizeInputSegments(*problem, nodelst, linelst, dL, SegmentFilter::OnlyUnselected);
 
     // discretize input arc segments
+    recordArcSideLengthChanges(*problem);
     discretizeInputArcSegments(*problem, nodelst, linelst, SegmentFilter::OnlyUnselected);
 
     // create correct output filename;
@@ -1828,18 +2018,12 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
         return false;
     }
 */
-    // write out a pbc file containing a list of linked nodes
-    plyname = pn.substr(0,pn.find_last_of('.')) + ".pbc";
-    if ((fp=fopen(plyname.c_str(),"wt"))==NULL){
-        WarnMessage("Couldn't write to specified .pbc file");
-        problem->undo();  problem->unselectAll();
-        return -1;
-    }
-    fprintf(fp,"%i\n", (int) ptlst.size());
-
+    // collect the list of linked nodes for the pbc file
+    std::shared_ptr<MeshData> periodicMesh = std::make_shared<MeshData>();
+    periodicMesh->pbcs.reserve(ptlst.size());
     for(k=0;k<(int)ptlst.size();k++)
     {
-        fprintf(fp,"%i    %i    %i    %i\n",k,ptlst[k]->x,ptlst[k]->y,ptlst[k]->t);
+        periodicMesh->pbcs.push_back(*ptlst[k]);
     }
 
 #ifdef DEBUG
@@ -1849,121 +2033,33 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
         WarnMessage(buf);
     }
 #endif // DEBUG
-	fprintf(fp,"%i\n",(int) agelst.size());
+	periodicMesh->ages.reserve(agelst.size());
 	for(k=0;k<(int)agelst.size();k++)
 	{
-		double dtta;
-		std::vector<CQuadPoint> InnerRing;
-		std::vector<CQuadPoint> OuterRing;
-		InnerRing.clear();
-		InnerRing.shrink_to_fit();
-		OuterRing.clear();
-		OuterRing.shrink_to_fit();
-
-		n=agelst[k]->nodeNums[0]/2;
-		dtta = agelst[k]->totalArcLength/n;
-		n0=(int) round(360./dtta); // total elements in a 360deg annular ring;
-		n1=(int) round(360./agelst[k]->totalArcLength); // number of copied segments
-
-		// Should do some consistency checking here;
-		//   totalArcLength*n1 should equal 360
-		//   no*dtta should equal 360
-		//   if antiperiodic, n1 should be an even number
-		//   otherwise, throw error message, clean up, and return
-
-		InnerRing.reserve(n0);
-		OuterRing.reserve(n0);
-
-		// map each bdry point onto points on the ring;
-		int kk;
-		for(j=0,kk=0;j<n1;j++)  // do each slice
-		{
-			if ((agelst[k]->BdryFormat==1) && (j % 2 != 0)) dL=-1; // antiperiodic
-			else dL=1;
-
-			a1=exp(I*(j*agelst[k]->totalArcLength+agelst[k]->InnerAngle)*DEGREE);
-			a2=exp(I*(j*agelst[k]->totalArcLength+agelst[k]->OuterAngle)*DEGREE);
-			for(i=1;i<=n;i++)
-			{
-				a0=a1*(nodelst[agelst[k]->nodeNums[i]]->CC()-agelst[k]->agc); // position of the shifted mesh node
-				z=toDegrees(a0)/dtta;
-
-				InnerRing[kk].n0=agelst[k]->nodeNums[i];
-				InnerRing[kk].w0=z;
-				InnerRing[kk].w1=dL;
-
-				a0=a2*(nodelst[agelst[k]->nodeNums[i+n]]->CC()-agelst[k]->agc); // position of the shifted mesh node
-				z=toDegrees(a0)/dtta;
-
-				OuterRing[kk].n0=agelst[k]->nodeNums[i+n];
-				OuterRing[kk].w0=z;
-				OuterRing[kk].w1=dL;
-
-				kk++;
-			}
-		}
-
-		// InnerRing and OuterRing contain a list of boundary nodes, but the aren't yet properly sorted.
-		// Sort out the rings based on the angle of the points in the ring
-		for(int ii=0;ii<n0;ii++)
-		{
-			int bDone=1;
-			CQuadPoint qq;
-
-			for(int jj=0;jj<(n0-1);jj++)
-			{
-				if (InnerRing[jj].w0 > InnerRing[jj+1].w0)
-				{
-					qq=InnerRing[jj];
-					InnerRing[jj]=InnerRing[jj+1];
-					InnerRing[jj+1]=qq;
-					bDone=0;
-				}
-			}
-			if (bDone) break;
-		}
-
-		for(int ii=0;ii<n0;ii++)
-		{
-			int bDone=1;
-			CQuadPoint qq;
-
-			for(int jj=0;jj<(n0-1);jj++)
-			{
-				if (OuterRing[jj].w0 > OuterRing[jj+1].w0)
-				{
-					qq=OuterRing[jj];
-					OuterRing[jj]=OuterRing[jj+1];
-					OuterRing[jj+1]=qq;
-					bDone=0;
-				}
-			}
-			if (bDone) break;
-		}
-
-		// print out AGE definition
-		fprintf(fp,"\"%s\"\n",agelst[k]->BdryName.c_str ());
-		fprintf(fp,"%i %.17g %.17g %.17g %.17g %.17g %.17g %.17g %i %.17g %.17g\n",
-			agelst[k]->BdryFormat,agelst[k]->InnerAngle,agelst[k]->OuterAngle,
-			agelst[k]->ri,agelst[k]->ro,agelst[k]->totalArcLength,
-			Re(agelst[k]->agc),Im(agelst[k]->agc),n,
-			InnerRing[0].w0,OuterRing[0].w0);
-
-		for(i=0;i<=n;i++)
+		// AGE definition
+		CAirGapElement meshAge;
+		meshAge.BdryName = "\"" + agelst[k]->BdryName + "\"\n";
+		meshAge.BdryFormat = agelst[k]->BdryFormat;
+		meshAge.InnerAngle = agelst[k]->InnerAngle;
+		meshAge.OuterAngle = agelst[k]->OuterAngle;
+		meshAge.ri = agelst[k]->ri;
+		meshAge.ro = agelst[k]->ro;
+		meshAge.totalArcLength = agelst[k]->totalArcLength;
+		meshAge.agc = agelst[k]->agc;
+		meshAge.nodeNums = agelst[k]->nodeNums;
+
+		// map each bdry point onto points on the ring
+		std::vector<CComplex> nodePos;
+		nodePos.reserve(meshAge.nodeNums.size());
+		for (int node: meshAge.nodeNums)
+			nodePos.push_back(nodelst[node]->CC());
+		if (!meshAge.mapRingNodes(nodePos))
 		{
-			int p0,p1;
-
-			p1=i; if(p1==n0) p1=0;
-			p0=p1-1; if(p0<0) p0=n0+p0;
-
-			// ring points that bracket points in the annulus mesh
-			// and their sign, for the purposes of periodicity/antiperiodicity
-			fprintf(fp,"%i %g %i %g %i %g %i %g\n",
-				InnerRing[p0].n0, InnerRing[p0].w1,
-				InnerRing[p1].n0, InnerRing[p1].w1,
-				OuterRing[p0].n0, OuterRing[p0].w1,
-				OuterRing[p1].n0, OuterRing[p1].w1);
+			WarnMessage("The arcs of an air gap element must add up to a fraction of a full circle");
+			problem->undo();  problem->unselectAll();
+			return -1;
 		}
+		periodicMesh->ages.push_back(meshAge);
 
 /*
 		fprintf(fp,"%s\n",agelst[k]->BdryName);
@@ -1980,8 +2076,6 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
 	}
 
 
-    fclose(fp);
-
     // call triangle with -Y flag.
     {
         TriangulateHelper triHelper;
@@ -2006,7 +2100,20 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
         if (tristatus != 0)
             return tristatus;
 
-        triHelper.writeTriangulationFiles(PathName);
+        if (triHelper.storeTriangulation(*periodicMesh))
+            mesh = periodicMesh;
+
+        if (writeMeshFiles || !mesh)
+        {
+            // write out a pbc file containing a list of linked nodes and the air gap elements
+            if (!periodicMesh->writePbc(pn.substr(0,pn.find_last_of('.'))))
+            {
+                WarnMessage("Couldn't write to specified .pbc file");
+                problem->undo();  problem->unselectAll();
+                return -1;
+            }
+            triHelper.writeTriangulationFiles(PathName);
+        }
     }
 
     problem->unselectAll();
@@ -2022,6 +2129,57 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
     //SaveFEMFile(pn);
     problem->saveFEMFile(pn);
 
+    if (meshCache)
+        cacheMesh(cacheKey);
+    return 0;
+}
+
+int FMesher::refineMesh(const std::vector<double> &maxArea)
+{
+    if (!mesh || (int)maxArea.size() != mesh->numElements())
+    {
+        WarnMessage("refineMesh: no matching triangulation to refine\n");
+        return -1;
+    }
+
+    TriangulateHelper triHelper;
+    triHelper.WarnMessage = WarnMessage;
+    triHelper.TriMessage = this->TriMessage;
+    if (!triHelper.initRefinement(*mesh, maxArea))
+        return -1;
+    triHelper.setMinAngle(std::min(problem->MinAngle+MINANGLE_BUMP,MINANGLE_MAX));
+
+    // periodic boundary conditions and air gap elements refer to the nodes on the outer boundary,
+    // which must therefore stay as they are
+    const bool periodic = !mesh->pbcs.empty() || !mesh->ages.empty();
+    if (periodic)
+        triHelper.suppressExteriorSteinerPoints();
+
+    int tristatus = triHelper.triangulate(Verbose);
+    if (tristatus != 0)
+        return tristatus;
+
+    std::shared_ptr<MeshData> refinedMesh = std::make_shared<MeshData>();
+    if (!triHelper.storeTriangulation(*refinedMesh))
+    {
+        WarnMessage("refineMesh: the triangle interface does not support mesh refinement\n");
+        return -1;
+    }
+    // triangle keeps the numbers of the existing nodes, so that the node numbers of the
+    // periodic boundary conditions and air gap elements are still valid
+    for (int i=0; periodic && i<mesh->numNodes(); i++)
+    {
+        if (i >= refinedMesh->numNodes()
+                || refinedMesh->nodeX[i] != mesh->nodeX[i]
+                || refinedMesh->nodeY[i] != mesh->nodeY[i])
+        {
+            WarnMessage("refineMesh: triangle renumbered the mesh nodes\n");
+            return -1;
+        }
+    }
+    refinedMesh->pbcs = mesh->pbcs;
+    refinedMesh->ages = mesh->ages;
+    mesh = refinedMesh;
     return 0;
 }
 
@@ -2046,6 +2204,9 @@ TriangulateHelper::~TriangulateHelper()
     if (in.segmentlist) { free(in.segmentlist); }
     if (in.segmentmarkerlist) { free(in.segmentmarkerlist); }
     if (in.holelist) { free(in.holelist); }
+    if (in.trianglelist) { free(in.trianglelist); }
+    if (in.triangleattributelist) { free(in.triangleattributelist); }
+    if (in.trianglearealist) { free(in.trianglearealist); }
 
 #ifdef XFEMM_BUILTIN_TRIANGLE
     if (out.pointlist) { free(out.pointlist); }
@@ -2285,6 +2446,88 @@ bool TriangulateHelper::initHolesAndRegions(const FemmProblem &problem, bool for
     return true;
 }
 
+bool TriangulateHelper::initRefinement(const MeshData &mesh, const std::vector<double> &maxArea)
+{
+    // calling this method on an already initialized object would leak memory
+    if (in.numberofpoints!=0 || in.numberoftriangles!=0)
+    {
+        WarnMessage("initRefinement called on an initialized triangulation!\n");
+        return false;
+    }
+
+    in.numberofpoints = mesh.numNodes();
+    in.pointlist = (REAL *) malloc(in.numberofpoints * 2 * sizeof(REAL));
+    in.pointmarkerlist = (int *) malloc(in.numberofpoints * sizeof(int));
+    if (!in.pointlist || !in.pointmarkerlist) {
+        WarnMessage("Point list for triangulation is null!\n");
+        return false;
+    }
+    for(int i=0; i < in.numberofpoints; i++)
+    {
+        in.pointlist[2*i] = mesh.nodeX[i];
+        in.pointlist[2*i+1] = mesh.nodeY[i];
+        in.pointmarkerlist[i] = mesh.nodeMarker[i];
+    }
+
+    in.numberoftriangles = mesh.numElements();
+    in.numberofcorners = 3;
+    in.numberoftriangleattributes = 1;
+    in.trianglelist = (int *) malloc(3 * in.numberoftriangles * sizeof(int));
+    in.triangleattributelist = (REAL *) malloc(in.numberoftriangles * sizeof(REAL));
+    in.trianglearealist = (REAL *) malloc(in.numberoftriangles * sizeof(REAL));
+    if (!in.trianglelist || !in.triangleattributelist || !in.trianglearealist) {
+        WarnMessage("Triangle list for triangulation is null!\n");
+        return false;
+    }
+    std::copy(mesh.elements.begin(), mesh.elements.end(), in.trianglelist);
+    std::copy(mesh.elementLabel.begin(), mesh.elementLabel.end(), in.triangleattributelist);
+    std::copy(maxArea.begin(), maxArea.end(), in.trianglearealist);
+
+    // find the edges that are on the boundary or between regions
+    // (for each element side: the region of the first element, and whether the side is shared by two elements of the same region)
+    std::map<std::pair<int,int>, std::pair<int,bool>> sides;
+    for(int i=0; i < in.numberoftriangles; i++)
+    {
+        for (int j=0; j<3; j++)
+        {
+            int n0 = mesh.elements[3*i+j];
+            int n1 = mesh.elements[3*i+(j+1)%3];
+            auto side = std::make_pair(std::min(n0,n1), std::max(n0,n1));
+            auto it = sides.find(side);
+            if (it == sides.end())
+                sides.emplace(side, std::make_pair(mesh.elementLabel[i], false));
+            else
+                it->second.second = (it->second.first == mesh.elementLabel[i]);
+        }
+    }
+    std::vector<int> segments;
+    for(int i=0; i < mesh.numEdges(); i++)
+    {
+        int n0 = mesh.edges[2*i];
+        int n1 = mesh.edges[2*i+1];
+        auto it = sides.find(std::make_pair(std::min(n0,n1), std::max(n0,n1)));
+        if (mesh.edgeMarker[i] != 0 || it == sides.end() || !it->second.second)
+            segments.push_back(i);
+    }
+
+    in.numberofsegments = segments.size();
+    in.segmentlist = (int *) malloc(2 * in.numberofsegments * sizeof(int));
+    in.segmentmarkerlist = (int *) malloc(in.numberofsegments * sizeof(int));
+    if (!in.segmentlist || !in.segmentmarkerlist) {
+        WarnMessage("Segment list for triangulation is null!\n");
+        return false;
+    }
+    for(int i=0; i < in.numberofsegments; i++)
+    {
+        in.segmentlist[2*i] = mesh.edges[2*segments[i]];
+        in.segmentlist[2*i+1] = mesh.edges[2*segments[i]+1];
+        in.segmentmarkerlist[i] = mesh.edgeMarker[segments[i]];
+    }
+
+    m_refine = true;
+    return true;
+}
+
 int TriangulateHelper::triangulate(bool verbose)
 {
     std::string triArgs = triangulateParams(verbose);
@@ -2338,9 +2581,14 @@ string TriangulateHelper::triangulateParams(bool verbose) const
     //    have exactly the same coordinates, only the first appears in the
     //    output.
     // -Y Suppresses the creation of Steiner points on the exterior boundary.
+    // -r Refines a previously generated mesh (-a without a number takes the area constraints from the triangle area list).
     //
     // See http://www.cs.cmu.edu/~quake/triangle.switch.html for more info
-    std::string triArgs = "-pPq" + to_string(m_minAngle) + "eAaz" + (verbose?"":"Q") + "I";
+    std::string triArgs;
+    if (m_refine)
+        triArgs = "-rpPq" + to_string(m_minAngle) + "eaz" + (verbose?"":"Q") + "I";
+    else
+        triArgs = "-pPq" + to_string(m_minAngle) + "eAaz" + (verbose?"":"Q") + "I";
     if (m_suppressUnusedVertices)
         triArgs += "j";
     if (m_suppressExteriorSteinerPoints)
@@ -33,6 +33,7 @@
 #include <cstdio>
 #include <cmath>
 #include <regex>
+#include <sstream>
 #include "femmcomplex.h"
 #include "femmconstants.h"
 #include "fparse.h"
@@ -221,13 +222,59 @@ bool FPProc::NewDocument()
 
 bool FPProc::OpenDocument(string pathname)
 {
+    if (femm::SolutionData::isArchiveFile(pathname))
+        return OpenArchiveStep(pathname, 0);
+    if (femm::SolutionData::isBinaryFile(pathname))
+    {
+        femm::SolutionData solution;
+        std::stringstream err;
+        if (!solution.readBinary(pathname, err))
+        {
+            WarnMessage(err.str().c_str());
+            return false;
+        }
+        if (solution.fileType != femm::FileType::MagneticsFile)
+        {
+            WarnMessage("Solution file does not contain a magnetics solution\n");
+            return false;
+        }
+        return LoadDocument(pathname, &solution);
+    }
+    return LoadDocument(pathname, nullptr);
+}
+
+bool FPProc::OpenDocument(const femm::SolutionData &solution)
+{
+    return LoadDocument(string(), &solution);
+}
 
-    FILE *fp;
-    int i,j,k,t, sscnt;
-    char s[1024],q[1024];
+bool FPProc::OpenArchiveStep(const string &pathname, int step)
+{
+    femm::SolutionData solution;
+    std::stringstream err;
+    if (!solution.readArchiveStep(pathname, step, err))
+    {
+        WarnMessage(err.str().c_str());
+        return false;
+    }
+    if (solution.fileType != femm::FileType::MagneticsFile)
+    {
+        WarnMessage("Solution archive does not contain magnetics solutions\n");
+        return false;
+    }
+    return LoadDocument(pathname, &solution);
+}
+
+bool FPProc::LoadDocument(const string &pathname, const femm::SolutionData *solution)
+{
+
+    int i,j,k,t;
+    // the current line, and a buffer for the words scanned from it;
+    // both grow with the longest line, so that no line is cut off
+    std::vector<char> lineBuffer, wordBuffer;
+    char *s = nullptr, *q = nullptr;
     char *v;
     double b,bi,br;
-    double zr,zi;
     bool flag = false;
     CMPointProp    PProp;
     CMBoundaryProp BProp;
@@ -236,23 +283,41 @@ bool FPProc::OpenDocument(string pathname)
     CNode         node;
     CSegment      segm;
     CArcSegment   asegm;
-    femmpostproc::CPostProcMElement      elm;
     CMBlockLabel   blk;
-    femmsolver::CMMeshNode     mnode;
     //CPoint        mline;
 
     // clear out all the document data and set defaults to standard values
     NewDocument();
 
+    // the problem description is read either from the file,
+    // or from the solution data (which has the same format as the .ans file)
+    const std::string *text = solution ? &solution->problemDescription : nullptr;
+    femm::Lexer input(text ? text->data() : nullptr, text ? text->data()+text->size() : nullptr);
+
     // attempt to open the file for reading
-    if ((fp = fopen(pathname.c_str(),"rt")) == NULL)
+    if (!solution && !input.open(pathname))
     {
         WarnMessage("Couldn't read from specified .ans file\n");
         return false;
     }
 
+    // readLine behaves like fgets, but reads the whole line into s, however long it is
+    auto readLine = [&]() -> char* {
+        femm::Lexer::Token line;
+        if (!input.nextLine(line))
+            return nullptr;
+        lineBuffer.assign(line.begin, line.end);
+        lineBuffer.push_back('\n');
+        lineBuffer.push_back('\0');
+        if (wordBuffer.size() < lineBuffer.size())
+            wordBuffer.resize(lineBuffer.size());
+        s = lineBuffer.data();
+        q = wordBuffer.data();
+        return s;
+    };
+
     // parse the file
-    while ((flag==false) && (fgets(s,1024,fp) != NULL))
+    while ((flag==false) && (readLine() != NULL))
     {
         sscanf(s,"%s",q);
 
@@ -266,7 +331,6 @@ bool FPProc::OpenDocument(string pathname)
             if( ((int) vers)!=40 )
             {
                 WarnMessage("This file is from a different version of FEMM\nRe-analyze the problem using the current version.\n");
-                fclose(fp);
                 return false;
             }
             q[0] = '\0';
@@ -797,7 +861,7 @@ bool FPProc::OpenDocument(string pathname)
                 MProp.Bdata.reserve(MProp.BHpoints);
                 for(j=0; j<MProp.BHpoints; j++)
                 {
-                    fgets(s,1024,fp);
+                    readLine();
                     double b;
                     CComplex h;
                     sscanf(s,"%lf\t%lf",&b,&h.re);
@@ -927,8 +991,10 @@ bool FPProc::OpenDocument(string pathname)
             sscanf(v,"%i",&k);
             for(i=0; i<k; i++)
             {
-                fgets(s,1024,fp);
-                sscanf(s,"%lf\t%lf\t%i\n",&node.x,&node.y,&t);
+                input.parseDouble(node.x);
+                input.parseDouble(node.y);
+                input.parseInt(t);
+                input.skipLine();
                 node.BoundaryMarker=t-1;
                 nodelist.push_back(node);
             }
@@ -943,14 +1009,13 @@ bool FPProc::OpenDocument(string pathname)
             for(i=0; i<k; i++)
             {
                 int hidden = 0;
-                fgets(s,1024,fp);
-                sscanf(s,"%i\t%i\t%lf %i\t%i\t%i\n",
-                        &segm.n0,
-                        &segm.n1,
-                        &segm.MaxSideLength,
-                        &t,
-                        &hidden,
-                        &segm.InGroup);
+                input.parseInt(segm.n0);
+                input.parseInt(segm.n1);
+                input.parseDouble(segm.MaxSideLength);
+                input.parseInt(t);
+                input.parseInt(hidden);
+                input.parseInt(segm.InGroup);
+                input.skipLine();
                 segm.BoundaryMarker = t-1;
                 if (hidden == 0)
                 {
@@ -973,16 +1038,16 @@ bool FPProc::OpenDocument(string pathname)
             for(i=0; i<k; i++)
             {
                 int hidden = 0;
-                fgets(s,1024,fp);
-                sscanf(s,"%i\t%i\t%lf\t%lf %i\t%i\t%i\t%lf\n",
-                       &asegm.n0,
-                       &asegm.n1,
-                       &asegm.ArcLength,
-                       &asegm.MaxSideLength,
-                       &t,
-                       &hidden,
-                       &asegm.InGroup,
-                       &b);
+                b = 0;
+                input.parseInt(asegm.n0);
+                input.parseInt(asegm.n1);
+                input.parseDouble(asegm.ArcLength);
+                input.parseDouble(asegm.MaxSideLength);
+                input.parseInt(t);
+                input.parseInt(hidden);
+                input.parseInt(asegm.InGroup);
+                input.parseDouble(b);
+                input.skipLine();
                 asegm.BoundaryMarker=t-1;
                 if (b>0) asegm.MaxSideLength=b; // use as-meshed max side length for display purposes
                 if (hidden == 0)
@@ -1004,20 +1069,10 @@ bool FPProc::OpenDocument(string pathname)
         {
             v=StripKey(s);
             sscanf(v,"%i",&k);
-            if(k>0)
-            {
-                blk.BlockType=-1;
-                blk.MaxArea=0;
-                for(i=0; i<k; i++)
-                {
-                    fgets(s,1024,fp);
-                    sscanf(s,"%lf\t%lf\n",&blk.x,&blk.y);
-                    //    blocklist.push_back(blk);
-                    //  don't add holes to the list
-                    //  of block labels because it messes up the
-                    //  number of block labels.
-                }
-            }
+            //  don't add holes to the list
+            //  of block labels because it messes up the
+            //  number of block labels.
+            input.skipLines(k);
             q[0] = '\0';
         }
 
@@ -1028,8 +1083,6 @@ bool FPProc::OpenDocument(string pathname)
             sscanf(v,"%i",&k);
             for(i=0; i<k; i++)
             {
-                fgets(s,1024,fp);
-
                 //some defaults
                 blk.MaxArea=0.;
                 blk.MagDir=0.;
@@ -1041,15 +1094,15 @@ bool FPProc::OpenDocument(string pathname)
                 blk.IsExternal=false;
 
                 // scan in data
-                v=ParseDbl(s,&blk.x);
-                v=ParseDbl(v,&blk.y);
-                v=ParseInt(v,&blk.BlockType);
-                v=ParseDbl(v,&blk.MaxArea);
-                v=ParseInt(v,&blk.InCircuit);
-                v=ParseDbl(v,&blk.MagDir);
-                v=ParseInt(v,&blk.InGroup);
-                v=ParseInt(v,&blk.Turns);
-                v=ParseInt(v,&external_and_default_flags);
+                input.parseDouble(blk.x);
+                input.parseDouble(blk.y);
+                input.parseInt(blk.BlockType);
+                input.parseDouble(blk.MaxArea);
+                input.parseInt(blk.InCircuit);
+                input.parseDouble(blk.MagDir);
+                input.parseInt(blk.InGroup);
+                input.parseInt(blk.Turns);
+                input.parseInt(external_and_default_flags);
 
                 if ((external_and_default_flags & 1) == 0)
                 {
@@ -1069,7 +1122,8 @@ bool FPProc::OpenDocument(string pathname)
                     blk.IsDefault = true;
                 }
 
-                v=parseString(v,&blk.MagDirFctn);
+                input.parseString(blk.MagDirFctn);
+                input.skipLine();
 
                 if (blk.MaxArea<0) blk.MaxArea=0;
                 else blk.MaxArea=PI*blk.MaxArea*blk.MaxArea/4.;
@@ -1092,320 +1146,25 @@ bool FPProc::OpenDocument(string pathname)
     MProp.Hdata.clear();
     MProp.slope.clear();
 
-    if (flag == false)
+    if (!solution && flag == false)
     {
         // The flag was never set to true during the while loop.
         // This means the "[solution]" string was never
         // encountered
-        if(feof(fp))
-        {
-            // We read in the whole file but never found the start of
-            // a solution section
-            WarnMessage("No solution found in file.\n"); /* EOF */
-        }
-        else if(ferror(fp))
-        {
-            // There was some read error while trying to read the file
-            WarnMessage("An error occured while reading file.\n"); /* Error */
-        }
-        fclose(fp);
+        WarnMessage("No solution found in file.\n"); /* EOF */
         return false;
     }
 
-    // read in meshnodes;
-    fscanf(fp,"%i\n",&k);
-#ifdef DEBUG_FPPROC
-    printf("numnodes: %d\n", k);
-#endif // DEBUG_FPPROC
-    meshnode.resize(k);
-    for(i=0; i<k; i++)
+    if (solution)
     {
-        if ( fgets(s,1024,fp) != NULL )
-        {
-            if (Frequency!=0)
-            {
-                if (!bIncremental)
-                {
-                    sscnt = sscanf(s,"%lf\t%lf\t%lf\t%lf",
-                                   &mnode.x,
-                                   &mnode.y,
-                                   &mnode.A.re,
-                                   &mnode.A.im) ;
-
-                    if (sscnt != 4)
-                    {
-                        std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
-                                + std::to_string(sscnt) + ") for node " + std::to_string(i)
-                                + " (expected 4).\n";
-                        WarnMessage(msg.c_str()); /* Error */
-                        fclose(fp);
-                        return false;
-                    }
-                }
-                else
-                {
-                    int bc;
-
-                    sscanf(s,"%lf\t%lf\t%lf\t%lf\t%i\t%lf",
-                           &mnode.x,
-                           &mnode.y,
-                           &mnode.A.re,
-                           &mnode.A.im,
-                           &bc,
-                           &mnode.Aprev);
-
-                    if (sscnt != 6)
-                    {
-                        std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
-                                + std::to_string(sscnt) + ") for node " + std::to_string(i)
-                                + " (expected 6).\n";
-                        WarnMessage(msg.c_str()); /* Error */
-                        fclose(fp);
-                        return false;
-                    }
-                }
-            }
-            else
-            {
-                if (!bIncremental)
-                {
-                    sscnt = sscanf(s,"%lf\t%lf\t%lf",
-                                   &mnode.x,
-                                   &mnode.y,
-                                   &mnode.A.re);
-
-
-                    if (sscnt != 3)
-                    {
-                        std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
-                                + std::to_string(sscnt) + ") for node " + std::to_string(i)
-                                + " (expected 3).\n";
-                        WarnMessage(msg.c_str()); /* Error */
-    #ifdef DEBUG_FPPROC
-                        printf("s: %s\n", s);
-    #endif // DEBUG_FPPROC
-                        fclose(fp);
-                        return false;
-                    }
-                }
-                else
-                {
-                    int bc;
-
-                    sscnt = sscanf(s, "%lf\t%lf\t%lf\t%i\t%lf",
-                                   &mnode.x,
-                                   &mnode.y,
-                                   &mnode.A.re,
-                                   &bc,
-                                   &mnode.Aprev);
-
-                    if (sscnt != 5)
-                    {
-                        std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
-                                + std::to_string(sscnt) + ") for node " + std::to_string(i)
-                                + " (expected 5).\n";
-                        WarnMessage(msg.c_str()); /* Error */
-    #ifdef DEBUG_FPPROC
-                        printf("s: %s\n", s);
-    #endif // DEBUG_FPPROC
-                        fclose(fp);
-                        return false;
-                    }
-
-                }
-                mnode.A.im=0;
-            }
-            meshnode[i] = mnode;
-        }
-        else
-        {
-            // There was some read error while trying to read the file
-            WarnMessage("An error occured while reading mesh nodes section of file.\n"); /* Error */
-            fclose(fp);
+        if (!LoadSolutionFromData(*solution))
             return false;
-        }
-
     }
-
-    // read in elements;
-    fgets(s,1024,fp);
-    sscanf(s,"%i",&k);
-    //fscanf(fp,"%i\n",&k);
-    meshelem.resize(k);
-#ifdef DEBUG_FPPROC
-    printf("numelement: %d\n", k);
-#endif // DEBUG_FPPROC
-    for(i=0; i<k; i++)
+    else
     {
-        if ( fgets(s,1024,fp) != NULL )
-        {
-            if (!bIncremental)
-            {
-                sscnt = sscanf(s,"%i\t%i\t%i\t%i",&elm.p[0],&elm.p[1],&elm.p[2],&elm.lbl);
-#ifdef DEBUG_FPPROC
-                printf("s[%d]: %s", i,s);
-                //getchar();
-#endif // DEBUG_FPPROC
-                if (sscnt != 4)
-                {
-                    std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
-                            + std::to_string(sscnt) + ") for element " + std::to_string(i) + ".\n";
-                    WarnMessage(msg.c_str()); /* Error */
-                    fclose(fp);
-                    return false;
-                }
-            }
-            else
-            {
-                sscanf(s,"%i	%i	%i	%i	%lf",&elm.p[0],&elm.p[1],&elm.p[2],&elm.lbl,&elm.Jprev);
-
-#ifdef DEBUG_FPPROC
-                printf("s: %s\n", s);
-                //getchar();
-#endif // DEBUG_FPPROC
-                if (sscnt != 5)
-                {
-                    std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
-                            + std::to_string(sscnt) + ") for element " + std::to_string(i) + ".\n";
-                    WarnMessage(msg.c_str()); /* Error */
-                    fclose(fp);
-                    return false;
-                }
-            }
-
-            elm.blk=blocklist[elm.lbl].BlockType;
-            meshelem[i] = elm;
-#ifdef DEBUG_FPPROC
-            //printf("numelement: %d\n", k); //###note: this debug line make no sense here, is already before the loop...
-#endif // DEBUG_FPPROC
-        }
-        else
-        {
-            // There was some read error while trying to read the file
-            WarnMessage("An error occured while reading mesh elements section of file.\n"); /* Error */
-            fclose(fp);
+        if (!LoadSolutionFromFile(input, pathname))
             return false;
-        }
-    }
-    
-    // read in circuit data;
-    fscanf(fp,"%i\n",&k);
-    #ifdef DEBUG_FPPROC
-    printf("numcircuits: %d\n",k);
-    fflush(stdout);
-    #endif
-    for(i=0; i<k; i++)
-    {
-        fgets(s,1024,fp);
-        if (Frequency==0)
-        {
-            sscanf(s,"%i\t%lf",&j,&zr);
-            blocklist[i].Case=j;
-            if (j==0) blocklist[i].dVolts=zr;
-            else blocklist[i].J=zr;
-        }
-        else
-        {
-            sscanf(s,"%i\t%lf\t%lf",&j,&zr,&zi);
-            blocklist[i].Case=j;
-            if (j==0) blocklist[i].dVolts=zr + I*zi;
-            else blocklist[i].J=zr + I*zi;
-        }
     }
-
-	// fpproc doesn't actively use PBC data, but it needs to read it to get to the
-	// air gap element data beyond
-    #ifdef DEBUG_FPPROC
-    printf("PBC data skip\n");
-    fflush(stdout);
-    #endif
-	if (fgets(s,1024,fp)!=NULL)
-	{
-		sscanf(s,"%i",&k);
-		for(i=0;i<k;i++)
-			fgets(s,1024,fp);
-	}
-
-	// Read in Air Gap Element information
-	fgets(s,1024,fp);
-    sscanf(s,"%i",&k);
-    #ifdef DEBUG_FPPROC
-    printf("airgaps: %d\n",k);
-    fflush(stdout);
-    #endif
-	for(i=0;i<k;i++){
-		CAirGapElement age;
-
-		fgets(s,1024,fp);
-        #ifdef DEBUG_FPPROC
-        printf("airgap[%d]: %s",i,s);
-        fflush(stdout);
-        #endif
-		age.BdryName = std::string(s);
-		age.BdryName = std::regex_replace (age.BdryName, std::regex("\""), "");
-		age.BdryName = std::regex_replace (age.BdryName, std::regex("\n"), "");
-		fgets(s,1024,fp);
-		sscanf(s,"%i %lf %lf %lf %lf %lf %lf %lf %i %lf %lf",
-			&age.BdryFormat,&age.InnerAngle,&age.OuterAngle,
-			&age.ri,&age.ro,&age.totalArcLength,
-			&age.agc.re,&age.agc.im,&age.totalArcElements,
-			&age.InnerShift,&age.OuterShift);
-
-		age.ri*=LengthConv[LengthUnits];
-		age.ro*=LengthConv[LengthUnits];
-
-		// allocate space
-		if (age.totalArcElements>0)
-		{
-			j = age.totalArcElements+1;
-
-			age.quadNode.clear ();
-			age.quadNode.shrink_to_fit ();
-			age.quadNode.reserve (j);
-
-			//age.quadNode=(CQuadPoint *)calloc(j,sizeof(CQuadPoint));		// list of nodes on inner radius
-		}
-
-		for(j=0;j<=age.totalArcElements;j++)
-        {
-			CQuadPoint q;
-
-			fgets(s,1024,fp);
-			sscanf(s,"%i %lf %i %lf %i %lf %i %lf",
-				&q.n0, &q.w0,
-				&q.n1, &q.w1,
-				&q.n2, &q.w2,
-				&q.n3, &q.w3);
-
-            if ( (q.n0 < 0)
-                  || (q.n1 < 0)
-                  || (q.n2 < 0)
-                  || (q.n3 < 0) )
-            {
-                std::string msg = std::string("An error occured while reading input file\n")
-                            + pathname
-                            + std::string("\nquadNode has negative node number. ")
-                            + std::string("qp number: ") + std::to_string(j)
-                            + std::string(" n0: ") + std::to_string(q.n0)
-                            + std::string(" n1: ") + std::to_string(q.n1)
-                            + std::string(" n2: ") + std::to_string(q.n2)
-                            + std::string(" n3: ") + std::to_string(q.n3)
-                            + std::string("\n");
-                WarnMessage(msg.c_str()); /* Error */
-                //WarnMessage("quadNode has negative node number j: %i, n0: %i, n1: %i, n2: %i,n3: %i.\n", j, q.n0, q.n1, q.n2, q.n3); /* Error */
-                fclose(fp);
-                return false;
-            }
-			age.quadNode.push_back(q);
-		}
-
-		if (age.totalArcElements>0)
-        {
-            agelist.push_back (age);
-        }
-	}
-
-	fclose(fp);
     
     #ifdef DEBUG_FPPROC
     printf("Loading ANS file done!\n");
@@ -2179,6 +1938,301 @@ bool FPProc::OpenDocument(string pathname)
     return true;
 }
 
+bool FPProc::LoadSolutionFromFile(femm::Lexer &input, const string &pathname)
+{
+    int i,j,k;
+    double zr,zi;
+    femmpostproc::CPostProcMElement elm;
+    femmsolver::CMMeshNode mnode;
+
+    // number of values per node:
+    // x, y, A.re, (A.im if Frequency!=0), (bc and Aprev if incremental)
+    int numNodeValues = (Frequency!=0) ? 4 : 3;
+    if (bIncremental)
+        numNodeValues += 2;
+
+    // read in meshnodes;
+    k = 0;
+    input.parseInt(k);
+    input.skipLine();
+#ifdef DEBUG_FPPROC
+    printf("numnodes: %d\n", k);
+#endif // DEBUG_FPPROC
+    meshnode.resize(k);
+    for(i=0; i<k; i++)
+    {
+        if (input.atEnd())
+        {
+            // There was some read error while trying to read the file
+            WarnMessage("An error occured while reading mesh nodes section of file.\n"); /* Error */
+            return false;
+        }
+        int cnt = 0;
+        cnt += input.parseDouble(mnode.x);
+        cnt += input.parseDouble(mnode.y);
+        cnt += input.parseDouble(mnode.A.re);
+        if (Frequency!=0)
+            cnt += input.parseDouble(mnode.A.im);
+        else
+            mnode.A.im=0;
+        if (bIncremental)
+        {
+            int bc;
+            cnt += input.parseInt(bc);
+            cnt += input.parseDouble(mnode.Aprev);
+        }
+        input.skipLine();
+
+        if (cnt != numNodeValues)
+        {
+            std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
+                    + std::to_string(cnt) + ") for node " + std::to_string(i)
+                    + " (expected " + std::to_string(numNodeValues) + ").\n";
+            WarnMessage(msg.c_str()); /* Error */
+            return false;
+        }
+        meshnode[i] = mnode;
+    }
+
+    // read in elements;
+    k = 0;
+    input.parseInt(k);
+    input.skipLine();
+    meshelem.resize(k);
+#ifdef DEBUG_FPPROC
+    printf("numelement: %d\n", k);
+#endif // DEBUG_FPPROC
+    const int numElementValues = bIncremental ? 5 : 4;
+    for(i=0; i<k; i++)
+    {
+        if (input.atEnd())
+        {
+            // There was some read error while trying to read the file
+            WarnMessage("An error occured while reading mesh elements section of file.\n"); /* Error */
+            return false;
+        }
+        int cnt = 0;
+        cnt += input.parseInt(elm.p[0]);
+        cnt += input.parseInt(elm.p[1]);
+        cnt += input.parseInt(elm.p[2]);
+        cnt += input.parseInt(elm.lbl);
+        if (bIncremental)
+            cnt += input.parseDouble(elm.Jprev);
+        input.skipLine();
+
+        if (cnt != numElementValues || elm.lbl < 0 || elm.lbl >= (int)blocklist.size())
+        {
+            std::string msg = "An error occured while reading mesh elements section of file, wrong number of inputs ("
+                    + std::to_string(cnt) + ") for element " + std::to_string(i) + ".\n";
+            WarnMessage(msg.c_str()); /* Error */
+            return false;
+        }
+
+        elm.blk=blocklist[elm.lbl].BlockType;
+        meshelem[i] = elm;
+    }
+
+    // read in circuit data;
+    k = 0;
+    input.parseInt(k);
+    input.skipLine();
+    #ifdef DEBUG_FPPROC
+    printf("numcircuits: %d\n",k);
+    fflush(stdout);
+    #endif
+    for(i=0; i<k && i<(int)blocklist.size(); i++)
+    {
+        j = 0;
+        zr = zi = 0;
+        input.parseInt(j);
+        input.parseDouble(zr);
+        if (Frequency!=0)
+            input.parseDouble(zi);
+        input.skipLine();
+        blocklist[i].Case=j;
+        if (j==0) blocklist[i].dVolts=zr + I*zi;
+        else blocklist[i].J=zr + I*zi;
+    }
+
+	// fpproc doesn't actively use PBC data, but it needs to read it to get to the
+	// air gap element data beyond
+    #ifdef DEBUG_FPPROC
+    printf("PBC data skip\n");
+    fflush(stdout);
+    #endif
+    k = 0;
+    input.parseInt(k);
+    input.skipLine();
+    input.skipLines(k);
+
+	// Read in Air Gap Element information
+    k = 0;
+    input.parseInt(k);
+    input.skipLine();
+    #ifdef DEBUG_FPPROC
+    printf("airgaps: %d\n",k);
+    fflush(stdout);
+    #endif
+	for(i=0;i<k;i++){
+		CAirGapElement age;
+
+		// the name is on a line of its own, possibly quoted
+		femm::Lexer::Token name;
+		input.nextLine(name);
+		for (const char *c=name.begin; c<name.end; c++)
+		{
+			if (*c != '"')
+				age.BdryName += *c;
+		}
+        #ifdef DEBUG_FPPROC
+        printf("airgap[%d]: %s\n",i,age.BdryName.c_str());
+        fflush(stdout);
+        #endif
+		input.parseInt(age.BdryFormat);
+		input.parseDouble(age.InnerAngle);
+		input.parseDouble(age.OuterAngle);
+		input.parseDouble(age.ri);
+		input.parseDouble(age.ro);
+		input.parseDouble(age.totalArcLength);
+		input.parseDouble(age.agc.re);
+		input.parseDouble(age.agc.im);
+		input.parseInt(age.totalArcElements);
+		input.parseDouble(age.InnerShift);
+		input.parseDouble(age.OuterShift);
+		input.skipLine();
+
+		age.ri*=LengthConv[LengthUnits];
+		age.ro*=LengthConv[LengthUnits];
+
+		// allocate space
+		if (age.totalArcElements>0)
+		{
+			age.quadNode.clear ();
+			age.quadNode.shrink_to_fit ();
+			age.quadNode.reserve (age.totalArcElements+1);
+		}
+
+		for(j=0;j<=age.totalArcElements;j++)
+        {
+			CQuadPoint q;
+
+			input.parseInt(q.n0);
+			input.parseDouble(q.w0);
+			input.parseInt(q.n1);
+			input.parseDouble(q.w1);
+			input.parseInt(q.n2);
+			input.parseDouble(q.w2);
+			input.parseInt(q.n3);
+			input.parseDouble(q.w3);
+			input.skipLine();
+
+            if ( (q.n0 < 0)
+                  || (q.n1 < 0)
+                  || (q.n2 < 0)
+                  || (q.n3 < 0) )
+            {
+                std::string msg = std::string("An error occured while reading input file\n")
+                            + pathname
+                            + std::string("\nquadNode has negative node number. ")
+                            + std::string("qp number: ") + std::to_string(j)
+                            + std::string(" n0: ") + std::to_string(q.n0)
+                            + std::string(" n1: ") + std::to_string(q.n1)
+                            + std::string(" n2: ") + std::to_string(q.n2)
+                            + std::string(" n3: ") + std::to_string(q.n3)
+                            + std::string("\n");
+                WarnMessage(msg.c_str()); /* Error */
+                return false;
+            }
+			age.quadNode.push_back(q);
+		}
+
+		if (age.totalArcElements>0)
+        {
+            agelist.push_back (age);
+        }
+	}
+
+    return true;
+}
+
+bool FPProc::LoadSolutionFromData(const femm::SolutionData &solution)
+{
+    femmpostproc::CPostProcMElement elm;
+    femmsolver::CMMeshNode mnode;
+
+    // mesh nodes
+    meshnode.resize(solution.numNodes());
+    for(int i=0; i<solution.numNodes(); i++)
+    {
+        mnode.x = solution.nodeX[i];
+        mnode.y = solution.nodeY[i];
+        mnode.A = solution.nodeValue[i];
+        if (Frequency==0)
+            mnode.A.im = 0;
+        if (bIncremental && !solution.nodeValuePrev.empty())
+            mnode.Aprev = solution.nodeValuePrev[i];
+        meshnode[i] = mnode;
+    }
+
+    // elements
+    meshelem.resize(solution.numElements());
+    for(int i=0; i<solution.numElements(); i++)
+    {
+        for(int j=0; j<3; j++)
+            elm.p[j] = solution.elements[3*i+j];
+        elm.lbl = solution.elementLabel[i];
+        if (elm.lbl < 0 || elm.lbl >= (int)blocklist.size())
+        {
+            std::string msg = "Element " + std::to_string(i) + " has invalid block label " + std::to_string(elm.lbl) + ".\n";
+            WarnMessage(msg.c_str()); /* Error */
+            return false;
+        }
+        if (bIncremental && !solution.elementJprev.empty())
+            elm.Jprev = solution.elementJprev[i];
+        elm.blk = blocklist[elm.lbl].BlockType;
+        meshelem[i] = elm;
+    }
+
+    // circuit data
+    if (solution.labelCircuitCase.size() > blocklist.size())
+    {
+        WarnMessage("Solution contains circuit data for more block labels than the problem description.\n"); /* Error */
+        return false;
+    }
+    for(int i=0; i<(int)solution.labelCircuitCase.size(); i++)
+    {
+        blocklist[i].Case = solution.labelCircuitCase[i];
+        if (blocklist[i].Case==0) blocklist[i].dVolts = solution.labelCircuitValue[i];
+        else blocklist[i].J = solution.labelCircuitValue[i];
+    }
+
+    // air gap elements
+    for(const CAirGapElement &solverAge: solution.ages)
+    {
+        CAirGapElement age;
+
+        age.BdryName = std::regex_replace (solverAge.BdryName, std::regex("\""), "");
+        age.BdryName = std::regex_replace (age.BdryName, std::regex("\n"), "");
+        age.BdryFormat = solverAge.BdryFormat;
+        age.InnerAngle = solverAge.InnerAngle;
+        age.OuterAngle = solverAge.OuterAngle;
+        age.ri = solverAge.ri*LengthConv[LengthUnits];
+        age.ro = solverAge.ro*LengthConv[LengthUnits];
+        age.totalArcLength = solverAge.totalArcLength;
+        age.agc = solverAge.agc;
+        age.totalArcElements = solverAge.totalArcElements;
+        age.InnerShift = solverAge.InnerShift;
+        age.OuterShift = solverAge.OuterShift;
+        age.quadNode = solverAge.quadNode;
+
+        if (age.totalArcElements>0)
+        {
+            agelist.push_back (age);
+        }
+    }
+    return true;
+}
+
 //bool FPProc::LoadPBCFromSolution(FILE* fp)
 //{
 //    char s[1024];
@@ -2280,7 +2334,7 @@ int FPProc::numNodes() const
 
 int FPProc::InTriangle(double x, double y) const
 {
-    static int k;
+    int k = lastTriangle.load(std::memory_order_relaxed);
     int j,hi,lo,sz;
     double z;
 
@@ -2313,8 +2367,8 @@ int FPProc::InTriangle(double x, double y) const
         {
             if (InTriangleTest(x,y,hi))
             {
-                k = hi;
-                return k;
+                lastTriangle.store(hi, std::memory_order_relaxed);
+                return hi;
             }
         }
 
@@ -2325,8 +2379,8 @@ int FPProc::InTriangle(double x, double y) const
         {
             if (InTriangleTest(x,y,lo))
             {
-                k = lo;
-                return k;
+                lastTriangle.store(lo, std::memory_order_relaxed);
+                return lo;
             }
         }
 
@@ -3694,7 +3748,7 @@ CComplex FPProc::PlnInt(double a, CComplex *u, CComplex *v) const
 CComplex FPProc::AxiInt(double a, CComplex *u, CComplex *v,double *r) const
 {
     int i;
-    static CComplex M[3][3];
+    CComplex M[3][3];
     CComplex x, z[3];
 
     M[0][0]=6.*r[0]+2.*r[1]+2.*r[2];
@@ -5457,8 +5511,8 @@ void FPProc::GetH(CComplex b1, CComplex b2, CComplex &h1, CComplex &h2, int k)
 void FPProc::FindBoundaryEdges()
 {
     int i, j;
-    static int plus1mod3[3] = {1, 2, 0};
-    static int minus1mod3[3] = {2, 0, 1};
+    static const int plus1mod3[3] = {1, 2, 0};
+    static const int minus1mod3[3] = {2, 0, 1};
 
     // Init all elements' neigh to be unfinished.
     for(i = 0; i < (int)meshelem.size(); i ++)
@@ -37,6 +37,7 @@
 #include "femmcomplex.h"
 #include "femmenums.h"
 #include "fparse.h"
+#include "Lexer.h"
 #include "CArcSegment.h"
 #include "CBlockLabel.h"
 #include "CBoundaryProp.h"
@@ -49,7 +50,9 @@
 #include "CPointProp.h"
 #include "CSegment.h"
 #include "PostProcessor.h"
+#include "SolutionData.h"
 
+#include <atomic>
 #include <vector>
 
 //#ifndef PLANAR
@@ -149,6 +152,9 @@ public:
     // list of points in a user-defined contour;
     std::vector< CComplex > contour;
 
+    // start of the next InTriangle() search, as in femm::PostProcessor
+    mutable std::atomic<int> lastTriangle {0};
+
     // stuff that PTLOC needs
     std::vector< femmsolver::CMMeshNode >  *pmeshnode;
     std::vector< femmpostproc::CPostProcMElement >   *pmeshelem;
@@ -274,7 +280,28 @@ public:
     void ClearDocument();
     bool NewDocument();
 //     virtual void Serialize(CArchive& ar);
+    /**
+     * @brief Load a solution file.
+     * Both the text format and the binary format (see femm::SolutionData) are supported.
+     * If the file is a solution archive, its first step is loaded.
+     * @param lpszPathName
+     * @return \c true on success, \c false otherwise.
+     */
     bool OpenDocument(std::string lpszPathName) override;
+    /**
+     * @brief Load a solution that was handed over by the solver in memory.
+     * This is equivalent to loading the \c .ans file written by the solver, but avoids the file system.
+     * @param solution
+     * @return \c true on success, \c false otherwise.
+     */
+    bool OpenDocument(const femm::SolutionData &solution);
+    /**
+     * @brief Load one step of a solution archive (see femm::SolutionData::appendToArchive()).
+     * @param pathname the archive file
+     * @param step the step index, counting from 0
+     * @return \c true on success, \c false otherwise.
+     */
+    bool OpenArchiveStep(const std::string &pathname, int step);
     bool MakeMask();
     //bool LoadMeshNodesFromSolution(bool loadA, FILE* fp);
     //bool LoadMeshElementsFromSolution(FILE* fp);
@@ -290,6 +317,27 @@ private:
 
     char warnBuf [1028];
 
+    /**
+     * @brief Load the problem description and solution, either from a file, or from memory.
+     * @param pathname the \c .ans file (if \p solution is \c nullptr)
+     * @param solution the solution in memory, or \c nullptr
+     * @return \c true on success, \c false otherwise.
+     */
+    bool LoadDocument(const std::string &pathname, const femm::SolutionData *solution);
+    /**
+     * @brief Read the [Solution] section of a \c .ans file.
+     * @param input the lexer, positioned after the \c [Solution] line
+     * @param pathname the file name (for error messages)
+     * @return \c true on success, \c false otherwise.
+     */
+    bool LoadSolutionFromFile(femm::Lexer &input, const std::string &pathname);
+    /**
+     * @brief Take over the mesh, solution, circuit and air gap data from a solver.
+     * @param solution
+     * @return \c true on success, \c false if the solution does not match the problem description.
+     */
+    bool LoadSolutionFromData(const femm::SolutionData &solution);
+
 //#ifdef _DEBUG
     //virtual void AssertValid() const;
     //virtual void Dump(CDumpContext& dc) const;
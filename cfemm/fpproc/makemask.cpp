@@ -64,8 +64,8 @@ bool FPProc::MakeMask()
 	int NumEls=meshelem.size();
     bool bOnAxis=false;
 
-	static int plus1mod3[3] = {1, 2, 0};
-	static int minus1mod3[3] = {2, 0, 1};
+	static const int plus1mod3[3] = {1, 2, 0};
+	static const int minus1mod3[3] = {2, 0, 1};
 
 	//Display progress dialog
 //	if (bLinehook==false){
@@ -87,6 +87,9 @@ FSolver::FSolver()
     Frequency = 0.0;
     Relax = 0.0;
     ACSolver=0;
+    GMRESRestart=30;
+    warmStart = false;
+    reuseAssembly = false;
     NumCircPropsOrig = 0;
 
     //meshnode = NULL;
@@ -107,6 +110,9 @@ FSolver::~FSolver()
 void FSolver::CleanUp()
 {
     FEASolver_type::CleanUp();
+    // the restart length belongs to [ACSolver] = 2, so both are reset together
+    ACSolver = 0;
+    GMRESRestart = 30;
     //delete[] meshnode;
     //meshnode = NULL;
     //delete []Aprev;
@@ -351,22 +357,28 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
 {
     int i,j,k,q,n0,n1;
     char infile[256];
-    FILE *fp;
-    char s[1024];
 
     if (meshLoadedFromPrevSolution)
     {
         return NOERROR;
     }
 
-    //read meshnodes;
-    sprintf(infile,"%s.node",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL)
+    // use the mesh handed over by the mesher, or read it from the mesh files
+    femm::MeshData fileMesh;
+    const femm::MeshData *mesh = meshData.get();
+    if (!mesh)
     {
-        return BADNODEFILE;
+        std::stringstream err;
+        LoadMeshErr status = fileMesh.read(PathName, err);
+        if (!err.str().empty())
+            WarnMessage(err.str().c_str());
+        if (status != NOERROR)
+            return status;
+        mesh = &fileMesh;
     }
-    fgets(s,1024,fp);
-    sscanf(s,"%i",&k);
+
+    //read meshnodes;
+    k = mesh->numNodes();
     NumNodes = k;
 
     meshnode.clear();
@@ -375,10 +387,9 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
     CNode node;
     for(i=0; i<k; i++)
     {
-        fscanf(fp,"%i",&j);
-        fscanf(fp,"%lf",&node.x);
-        fscanf(fp,"%lf",&node.y);
-        fscanf(fp,"%i",&j);
+        node.x = mesh->nodeX[i];
+        node.y = mesh->nodeY[i];
+        j = mesh->nodeMarker[i];
         if(j>1) j=j-2;
         else j=-1;
         node.BoundaryMarker=j;
@@ -389,30 +400,10 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
 
         meshnode.push_back (node);
     }
-    fclose(fp);
 
     //read in periodic boundary conditions;
-    sprintf(infile,"%s.pbc",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL)
-    {
-        return BADPBCFILE;
-    }
-    fgets(s,1024,fp);
-    sscanf(s,"%i",&NumPBCs);
-
-    if (NumPBCs!=0)
-    {
-        pbclist.clear();
-        pbclist.shrink_to_fit();
-        pbclist.reserve(NumPBCs);
-    }
-    CCommonPoint pbc;
-    for(i=0; i<NumPBCs; i++)
-    {
-        fgets(s,1024,fp);
-        sscanf(s,"%i %i %i %i",&j,&pbc.x,&pbc.y,&pbc.t);
-        pbclist.push_back(pbc);
-    }
+    NumPBCs = (int)mesh->pbcs.size();
+    pbclist = mesh->pbcs;
 
 #ifdef DEBUG
     {
@@ -422,114 +413,11 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
 #endif // DEBUG
 
     // read in air gap element info
-    fgets(s,1024,fp);
-    sscanf(s,"%i", &NumAirGapElems);
-
-#ifdef DEBUG
-    {
-        char buf[1048]; SNPRINTF(buf, sizeof(buf), "Found %i ages, line was: \"%s\"\n", NumAirGapElems, s);
-        WarnMessage(buf);
-    }
-#endif // DEBUG
-
-    CAirGapElement age;
-
-    agelist.clear();
-    agelist.shrink_to_fit();
-    agelist.reserve(NumAirGapElems);
-
-    for(i=0;i<NumAirGapElems;i++)
-    {
-        fgets(s,80,fp);
-#ifdef DEBUG
-        {
-            char buf[1048]; SNPRINTF( buf, sizeof(buf), "Read line:\n%s\n", s);
-            WarnMessage(buf);
-        }
-#endif // DEBUG
-        age.BdryName = std::string (s);
-
-        fgets(s,1024,fp);
-
-        sscanf(s,"%i %lf %lf %lf %lf %lf %lf %lf %i %lf %lf",
-                &age.BdryFormat,
-                &age.InnerAngle,
-                &age.OuterAngle,
-                &age.ri,
-                &age.ro,
-                &age.totalArcLength,
-                &age.agc.re,
-                &age.agc.im,
-                &age.totalArcElements,
-                &age.InnerShift,
-                &age.OuterShift );
-
-#ifdef DEBUG
-        {
-            char buf[1048]; SNPRINTF( buf, sizeof(buf), "Read age:\n\tBdryFormat: %i \n\tInnerAngle: %lf \n\tOuterAngle %lf \n\ttotalArcElements: %i \n",
-                                      age.BdryFormat,
-                                      age.InnerAngle,
-                                      age.OuterAngle,
-                                      age.totalArcElements );
-            WarnMessage(buf);
-        }
-#endif // DEBUG
-        age.quadNode.clear();
-        age.quadNode.shrink_to_fit();
-        age.quadNode.reserve(age.totalArcElements+1);
-
-        for(k=0;k<=age.totalArcElements;k++)
-        {
-            fgets(s,1024,fp);
-
-            CQuadPoint qp;
-
-            sscanf(s,"%i %lf %i %lf %i %lf %i %lf",
-                &qp.n0, &qp.w0,
-                &qp.n1, &qp.w1,
-                &qp.n2, &qp.w2,
-                &qp.n3, &qp.w3);
-
-            if ( (qp.n0 < 0)
-                  || (qp.n1 < 0)
-                  || (qp.n2 < 0)
-                  || (qp.n3 < 0) )
-            {
-                std::string msg = std::string("An error occured while reading file, quadNode has negative node number. ")
-                            + std::string("\nFile: ") + std::string(infile)
-                            + std::string("\nq number: ") + std::to_string(k)
-                            + std::string(" n0: ") + std::to_string(qp.n0)
-                            + std::string(" n1: ") + std::to_string(qp.n1)
-                            + std::string(" n2: ") + std::to_string(qp.n2)
-                            + std::string(" n3: ") + std::to_string(qp.n3)
-                            + std::string("\n");
-                WarnMessage(msg.c_str()); /* Error */
-                //WarnMessage("quadNode has negative node number k: %i, n0: %i, n1: %i, n2: %i,n3: %i.\n", k, qp.n0, qp.n1, qp.n2, qp.n3); /* Error */
-                fclose(fp);
-                return BADPBCFILE;
-            }
-
-            age.quadNode.push_back(qp);
-        }
-        agelist.push_back (age);
-    }
-
-    fclose(fp);
+    NumAirGapElems = (int)mesh->ages.size();
+    agelist = mesh->ages;
 
     // read in elements;
-    sprintf(infile,"%s.ele",PathName.c_str());
-#ifdef DEBUG
-    {
-        char buf[1028]; SNPRINTF(buf, sizeof(buf), "Reading in elements from %s\n", infile);
-        WarnMessage(buf);
-    }
-#endif // DEBUG
-    if((fp=fopen(infile,"rt"))==NULL)
-    {
-        return BADELEMENTFILE;
-    }
-    fgets(s,1024,fp);
-    sscanf(s,"%i",&k);
+    k = mesh->numElements();
     NumEls = k;
 
     meshele.clear();
@@ -549,11 +437,10 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
 
     for(i=0; i<k; i++)
     {
-        fscanf(fp,"%i",&j);
-        fscanf(fp,"%i",&elm.p[0]);
-        fscanf(fp,"%i",&elm.p[1]);
-        fscanf(fp,"%i",&elm.p[2]);
-        fscanf(fp,"%i",&elm.lbl);
+        elm.p[0] = mesh->elements[3*i];
+        elm.p[1] = mesh->elements[3*i+1];
+        elm.p[2] = mesh->elements[3*i+2];
+        elm.lbl = mesh->elementLabel[i];
         elm.lbl--;
 
         if(elm.lbl<0)
@@ -568,7 +455,6 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
             char buf[1028]; SNPRINTF(buf, sizeof(buf), "The element number %i had label %i\n", i, elm.lbl);
             msg += std::string (buf);
             WarnMessage(msg.c_str());
-            fclose(fp);
             if (deleteFiles)
             {
                 sprintf(infile,"%s.ele",PathName.c_str());
@@ -590,7 +476,6 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
             char buf[1028];
             SNPRINTF(buf, sizeof(buf), "The element number %i had label %i which is greater than the number of available labels (%i)\n", i+1, elm.lbl+1, (int)labellist.size());
             WarnMessage(buf);
-            fclose(fp);
             if (deleteFiles)
             {
                 sprintf(infile,"%s.ele",PathName.c_str());
@@ -612,7 +497,6 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
 
         meshele.push_back(elm);
     }
-    fclose(fp);
 
     // initialize edge bc's and element permeabilities;
     for(i=0; i<NumEls; i++)
@@ -623,6 +507,8 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
             meshele[i].mu2  = -1.;
         }
 
+    meshEdges = mesh->edges;
+
     // read in edges to which boundary conditions are applied;
 
     // first, do a little bookkeeping so that element
@@ -656,20 +542,11 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
             nmbr[k]++;
         }
 
-    sprintf(infile,"%s.edge",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL)
-    {
-        return BADEDGEFILE;
-    }
-    fscanf(fp,"%i",&k);// read in number of lines
-
-    fscanf(fp,"%i",&j);// read in boundarymarker flag;
-    for(i=0; i<k; i++)
+    for(i=0; i<mesh->numEdges(); i++)
     {
-        fscanf(fp,"%i",&j);
-        fscanf(fp,"%i",&n0);
-        fscanf(fp,"%i",&n1);
-        fscanf(fp,"%i",&j);
+        n0 = mesh->edges[2*i];
+        n1 = mesh->edges[2*i+1];
+        j = mesh->edgeMarker[i];
 
         if(j<0)
         {
@@ -694,7 +571,6 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
         }
 
     }
-    fclose(fp);
 
     // free up the connectivity information
     free(nmbr);
@@ -1212,6 +1088,18 @@ double FSolver::ElmArea(int i)
 
 bool FSolver::runSolver(bool verbose)
 {
+    solution.reset();
+    if (!prepareMesh(verbose))
+        return false;
+    return solveMesh(verbose);
+}
+
+bool FSolver::prepareMesh(bool verbose)
+{
+    startSolution.clear();
+    harmonicStartSolution.clear();
+    harmonicAssembly = HarmonicAssembly();
+
     // load mesh
     LoadMeshErr err = LoadMesh();
     if (err != NOERROR)
@@ -1231,6 +1119,98 @@ bool FSolver::runSolver(bool verbose)
             return false;
         }
     }
+    return true;
+}
+
+bool FSolver::setAirGapAngles(const string &name, double innerAngle, double outerAngle)
+{
+    // the mesh coordinates have been converted to cm, the air gap center has not
+    const double scale = 100 * LengthConvMeters[LengthUnits];
+    for (int i=0; i<NumAirGapElems; i++)
+    {
+        CAirGapElement &age = agelist[i];
+        if (age.BdryName != "\"" + name + "\"\n")
+            continue;
+
+        std::vector<CComplex> nodePos;
+        nodePos.reserve(age.nodeNums.size());
+        for (int node: age.nodeNums)
+            nodePos.push_back(CComplex(meshnode[node].x, meshnode[node].y) / scale);
+        age.InnerAngle = innerAngle;
+        age.OuterAngle = outerAngle;
+        // the air gap element is part of the stored assembly
+        harmonicAssembly = HarmonicAssembly();
+        return age.mapRingNodes(nodePos);
+    }
+    return false;
+}
+
+bool FSolver::isHarmonicAssemblyReusable() const
+{
+    if (!previousSolutionFile.empty())
+        return false;
+
+    for(int i=0; i<NumEls; i++)
+    {
+        const CMSolverMaterialProp &prop = blockproplist[meshele[i].blk];
+        // nonlinear materials
+        if (prop.BHpoints != 0)
+            return false;
+        // frequency dependent permeability of laminations
+        if ((prop.LamType==0) && (prop.Lam_d!=0) && (prop.Cduct!=0))
+            return false;
+        // frequency dependent permeability of wound regions
+        if (prop.LamType>2)
+            return false;
+        // impedance boundaries
+        for(int j=0; j<3; j++)
+        {
+            if ((meshele[i].e[j] >= 0) && (lineproplist[meshele[i].e[j]].BdryFormat==1))
+                return false;
+        }
+    }
+    return true;
+}
+
+void FSolver::storeHarmonicAssembly(const CBigComplexLinProb &L, const CBigComplexLinProb &Lc)
+{
+    harmonicAssembly = HarmonicAssembly();
+    for(int i=0; i<L.n; i++)
+    {
+        for(const CComplexEntry *e=L.M[i]; e!=nullptr; e=e->next)
+        {
+            harmonicAssembly.stiffnessRow.push_back(i);
+            harmonicAssembly.stiffnessCol.push_back(e->c);
+            harmonicAssembly.stiffness.push_back(e->x);
+        }
+        for(const CComplexEntry *e=Lc.M[i]; e!=nullptr; e=e->next)
+        {
+            if (e->x==0)
+                continue;
+            harmonicAssembly.conductivityRow.push_back(i);
+            harmonicAssembly.conductivityCol.push_back(e->c);
+            harmonicAssembly.conductivity.push_back(e->x);
+        }
+    }
+    harmonicAssembly.rhs.assign(L.b, L.b+L.n);
+}
+
+void FSolver::restoreHarmonicAssembly(CBigComplexLinProb &L, double w) const
+{
+    const HarmonicAssembly &a = harmonicAssembly;
+    for(int k=0; k<(int)a.stiffness.size(); k++)
+        L.Put(a.stiffness[k], a.stiffnessRow[k], a.stiffnessCol[k]);
+    for(int k=0; k<(int)a.conductivity.size(); k++)
+        L.AddTo(w*a.conductivity[k], a.conductivityRow[k], a.conductivityCol[k]);
+    for(int i=0; i<L.n; i++)
+        L.b[i] = a.rhs[i];
+}
+
+bool FSolver::solveMesh(bool verbose)
+{
+    solution.reset();
+    // the relaxation factor of the Newton iteration adapts during a solve
+    Relax = 1.;
 
     if (verbose)
     {
@@ -1251,6 +1231,7 @@ bool FSolver::runSolver(bool verbose)
         }
         CBigLinProb L;
         L.Precision = Precision;
+        L.bFloatPC = FloatPreconditioner;
 
         // initialize the problem, allocating the space required to solve it.
         if (L.Create(NumNodes, BandWidth) == false)
@@ -1270,6 +1251,8 @@ bool FSolver::runSolver(bool verbose)
             }
             if (verbose)
                 PrintMessage("Static 2-D problem solved\n");
+            if (warmStart)
+                startSolution.assign(L.V, L.V+NumNodes);
         } else {
             if (StaticAxisymmetric(L) == false)
             {
@@ -1280,16 +1263,30 @@ bool FSolver::runSolver(bool verbose)
                 PrintMessage("Static axisymmetric problem solved\n");
         }
 
-        if (WriteStatic2D(L) == false)
+        if ((keepSolution || binarySolutionFile || !solutionArchive.empty()) && !StoreStatic2D(L))
         {
-            WarnMessage("couldn't write results to disk\n");
+            WarnMessage("couldn't store results\n");
             return false;
         }
-        if (verbose)
-            PrintMessage("results written to disk\n");
+        if (writeSolutionFile)
+        {
+            bool written = binarySolutionFile
+                    ? WriteBinarySolution(PathName + ".ans")
+                    : WriteStatic2D(L);
+            if (written == false)
+            {
+                WarnMessage("couldn't write results to disk\n");
+                return false;
+            }
+            if (verbose)
+                PrintMessage("results written to disk\n");
+        }
     } else {
         CBigComplexLinProb L;
         L.Precision = Precision;
+        L.bGMRES = (ACSolver==2);
+        L.bFloatPC = FloatPreconditioner;
+        L.Restart = GMRESRestart;
 
         // initialize the problem, allocating the space required to solve it.
         if (!L.Create(NumNodes+NumCircProps, BandWidth, NumNodes))
@@ -1326,17 +1323,98 @@ bool FSolver::runSolver(bool verbose)
             }
             if (verbose){ PrintMessage("Harmonic axisymmetric problem solved\n"); }
         }
+        if (warmStart)
+            harmonicStartSolution.assign(L.V, L.V+L.n);
 
-        if (!WriteHarmonic2D(L))
+        if ((keepSolution || binarySolutionFile || !solutionArchive.empty()) && !StoreHarmonic2D(L))
         {
-            WarnMessage("couldn't write results to disk\n");
+            WarnMessage("couldn't store results\n");
             return false;
         }
-        if (verbose){ PrintMessage("results written to disk.\n"); }
+        if (writeSolutionFile)
+        {
+            bool written = binarySolutionFile
+                    ? WriteBinarySolution(PathName + ".ans")
+                    : WriteHarmonic2D(L);
+            if (!written)
+            {
+                WarnMessage("couldn't write results to disk\n");
+                return false;
+            }
+            if (verbose){ PrintMessage("results written to disk.\n"); }
+        }
     }
+    if (!solutionArchive.empty() && !AppendToSolutionArchive())
+    {
+        WarnMessage("couldn't append results to the solution archive\n");
+        return false;
+    }
+    if (!keepSolution)
+        solution.reset();
     return true;
 }
 
+bool FSolver::StoreSolutionMesh()
+{
+    double unitconv[]= {2.54,0.1,1.,100.,0.00254,1.e-04};
+    if (!FEASolver_type::StoreSolutionMesh(meshnode.data(), unitconv[LengthUnits], PathName + ".fem", femm::FileType::MagneticsFile))
+        return false;
+
+    // include A and J from previous solution if this is an incremental permeability problem
+    if (!Aprev.empty())
+    {
+        solution->nodeValuePrev.assign(Aprev.begin(), Aprev.begin()+NumNodes);
+        solution->elementJprev.resize(NumEls);
+        for(int i=0; i<NumEls; i++)
+            solution->elementJprev[i] = meshele[i].Jprev;
+    }
+    return true;
+}
+
+void FSolver::WriteAirGapElement(femm::TextWriter &out, const femmsolver::CAirGapElement &age) const
+{
+    out.write(age.BdryName);
+
+    out.writeInt(age.BdryFormat);
+    const double values[] = {
+        age.InnerAngle, age.OuterAngle, age.ri, age.ro,
+        age.totalArcLength, age.agc.re, age.agc.im
+    };
+    for (double v: values)
+    {
+        out.write(' ');
+        out.writeDouble(v);
+    }
+    out.write(' ');
+    out.writeInt(age.totalArcElements);
+    out.write(' ');
+    out.writeDouble(age.InnerShift);
+    out.write(' ');
+    out.writeDouble(age.OuterShift);
+    out.write('\n');
+
+    for(int k=0; k<=age.totalArcElements; k++)
+    {
+        const femm::CQuadPoint &q = age.quadNode[k];
+        out.writeInt(q.n0);
+        out.write(' ');
+        out.writeDouble(q.w0);
+        out.write(' ');
+        out.writeInt(q.n1);
+        out.write(' ');
+        out.writeDouble(q.w1);
+        out.write(' ');
+        out.writeInt(q.n2);
+        out.write(' ');
+        out.writeDouble(q.w2);
+        out.write(' ');
+        out.writeInt(q.n3);
+        out.write(' ');
+        out.writeDouble(q.w3);
+        out.write('\n');
+    }
+}
+
 // SortNodes: sorts mesh nodes based on a new numbering
 void FSolver::SortNodes (std::vector<int> newnum)
 {
@@ -1352,7 +1430,19 @@ void FSolver::SortNodes (std::vector<int> newnum)
     }
 }
 
-bool FSolver::handleToken(const string &token, istream &input, ostream &err)
+// NodeCoordinates: copies the mesh node positions for the space filling curve orderings
+void FSolver::NodeCoordinates (std::vector<double> &x, std::vector<double> &y) const
+{
+    x.resize(NumNodes);
+    y.resize(NumNodes);
+    for(int i = 0; i < NumNodes; i++)
+    {
+        x[i] = meshnode[i].x;
+        y[i] = meshnode[i].y;
+    }
+}
+
+bool FSolver::handleToken(const string &token, femm::Lexer &input, ostream &err)
 {
     // Frequency of the problem
     if( token == "[frequency]")
@@ -1362,5 +1452,13 @@ bool FSolver::handleToken(const string &token, istream &input, ostream &err)
         return true;
     }
 
+    // Restart length of the GMRES AC solver
+    if( token == "[gmresrestart]")
+    {
+        expectChar(input, '=',err);
+        parseValue(input, GMRESRestart, err);
+        return true;
+    }
+
     return false;
 }
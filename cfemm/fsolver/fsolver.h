@@ -42,6 +42,10 @@
 #include "CMaterialProp.h"
 #include "CNode.h"
 #include "CPointProp.h"
+#include "SolutionData.h"
+#include "TextWriter.h"
+
+#include <memory>
 
 namespace femm {
 class LuaInstance;
@@ -66,6 +70,15 @@ public:
     // General problem attributes
     double Frequency;  ///< \brief Frequency for harmonic problems [Hz]
     double  Relax;
+    int GMRESRestart; ///< \brief Restart length of the GMRES AC solver \verbatim[gmresrestart]\endverbatim
+    /// \brief Start planar magnetostatic and harmonic solves from the solution of the previous solveMesh() call
+    bool warmStart;
+    /**
+     * \brief Keep the assembled system of linear harmonic problems between solveMesh() calls.
+     * A frequency sweep then only changes #Frequency, and every solve after the first one
+     * combines the stored stiffness and conductivity matrices instead of assembling the elements again.
+     */
+    bool reuseAssembly;
 
     // mesh information
     std::vector <femm::CNode> meshnode;
@@ -104,6 +117,20 @@ public:
     int WriteStatic2D(CBigLinProb &L);
     int Harmonic2D(CBigComplexLinProb &L,bool verbose=false);
     int WriteHarmonic2D(CBigComplexLinProb &L);
+    /**
+     * @brief Store the solution of a static problem in #solution.
+     * The stored data is the same that WriteStatic2D() writes to the \c .ans file.
+     * @param L
+     * @return \c true on success, \c false otherwise.
+     */
+    bool StoreStatic2D(CBigLinProb &L);
+    /**
+     * @brief Store the solution of a harmonic problem in #solution.
+     * The stored data is the same that WriteHarmonic2D() writes to the \c .ans file.
+     * @param L
+     * @return \c true on success, \c false otherwise.
+     */
+    bool StoreHarmonic2D(CBigComplexLinProb &L);
     int StaticAxisymmetric(CBigLinProb &L);
     int HarmonicAxisymmetric(CBigComplexLinProb &L,bool verbose=false);
     void GetFillFactor(int lbl);
@@ -111,10 +138,87 @@ public:
 
     virtual bool runSolver(bool verbose=false) override;
 
+    /**
+     * @brief Load the mesh and renumber its nodes.
+     * runSolver() calls this before solving.
+     * A rotor sweep calls it only once, and then setAirGapAngles() and solveMesh() for every rotor position.
+     * @param verbose
+     * @return \c true on success, \c false otherwise.
+     */
+    bool prepareMesh(bool verbose=false);
+    /**
+     * @brief Solve the problem on the mesh loaded by prepareMesh().
+     * @param verbose
+     * @return \c true on success, \c false otherwise.
+     */
+    bool solveMesh(bool verbose=false);
+    /**
+     * @brief Turn the rings of an air gap element.
+     * Only the connection of the ring nodes to the air gap element changes, the mesh stays the same.
+     * @param name the boundary name of the air gap element
+     * @param innerAngle the angle of the inner ring (rotor) in degrees
+     * @param outerAngle the angle of the outer ring (stator) in degrees
+     * @return \c false, if the mesh has no such air gap element, or if its ring nodes are unknown.
+     */
+    bool setAirGapAngles(const std::string &name, double innerAngle, double outerAngle);
+
 private:
 
+    /**
+     * @brief The system of a linear harmonic problem before boundary conditions are applied.
+     * For an angular frequency w, the system matrix is stiffness + w*conductivity,
+     * and the right hand side does not depend on the frequency.
+     * Both matrices are stored as upper triangles, entry by entry.
+     */
+    struct HarmonicAssembly
+    {
+        std::vector<int> stiffnessRow;
+        std::vector<int> stiffnessCol;
+        std::vector<CComplex> stiffness;
+        std::vector<int> conductivityRow;
+        std::vector<int> conductivityCol;
+        std::vector<CComplex> conductivity;
+        std::vector<CComplex> rhs;
+    };
+
+    /**
+     * @brief Check whether the system of a harmonic problem is linear in the frequency.
+     * This is not the case for nonlinear materials, laminations with eddy currents,
+     * proximity effects in wound regions, impedance boundaries, and incremental problems.
+     * @return \c true, if the assembly can be reused for other frequencies.
+     */
+    bool isHarmonicAssemblyReusable() const;
+    /**
+     * @brief Store the assembled system for later solves at other frequencies.
+     * @param L the system without boundary conditions and without conductivity terms
+     * @param Lc the conductivity terms, per unit angular frequency
+     */
+    void storeHarmonicAssembly(const CBigComplexLinProb &L, const CBigComplexLinProb &Lc);
+    /**
+     * @brief Fill an empty system with the stored assembly, combined for angular frequency w.
+     * Boundary conditions still need to be applied afterwards.
+     * @param L
+     * @param w
+     */
+    void restoreHarmonicAssembly(CBigComplexLinProb &L, double w) const;
+
     virtual void CleanUp() override;
 
+    /**
+     * @brief Create #solution and fill in everything that does not depend on the solution vector.
+     * In addition to FEASolver::StoreSolutionMesh(), this stores the previous solution of incremental problems.
+     * @return \c true on success, \c false if the problem file could not be read.
+     */
+    bool StoreSolutionMesh();
+
+    /**
+     * @brief Write an air gap element to the \c .ans file.
+     * Used by WriteStatic2D() and WriteHarmonic2D().
+     * @param out
+     * @param age
+     */
+    void WriteAirGapElement(femm::TextWriter &out, const femmsolver::CAirGapElement &age) const;
+
     /**
      * @brief getPrevAxiB
      * @param k
@@ -138,15 +242,22 @@ private:
      */
     void getPrev2DB(int k, double &B1p, double &B2p) const;
 
-    // override parent class virtual method
+    // override parent class virtual methods
     void SortNodes (std::vector<int> newnum) override;
+    void NodeCoordinates (std::vector<double> &x, std::vector<double> &y) const override;
 
-    bool handleToken(const std::string &token, std::istream &input, std::ostream &err) override;
+    bool handleToken(const std::string &token, femm::Lexer &input, std::ostream &err) override;
 
     femm::LuaInstance *theLua;
 
     /// Vector containing previous solution for incremental permeability analysis
     std::vector <double> Aprev;
+    /// Solution of the last call to solveMesh(), used as starting point if #warmStart is set
+    std::vector <double> startSolution;
+    /// Solution of the last harmonic solveMesh() call, used as starting point if #warmStart is set
+    std::vector <CComplex> harmonicStartSolution;
+    /// Assembly of the last linear harmonic problem, if #reuseAssembly is set
+    HarmonicAssembly harmonicAssembly;
 };
 
 /////////////////////////////////////////////////////////////////////////////
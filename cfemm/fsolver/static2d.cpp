@@ -72,9 +72,21 @@ int FSolver::Static2D(CBigLinProb &L)
 
 	if (!previousSolutionFile.empty()) bIncremental = PrevType;
 
+    // start from the previous solution, and linearize the nonlinear materials around it
+    const bool bWarmStart = warmStart
+            && (bIncremental == MS_LEGACY_FALSE)
+            && ((int)startSolution.size() == NumNodes);
+
     res=0;
     femmsolver::CMElement *El;
     V_old = (double *) calloc(NumNodes,sizeof(double));
+    if (bWarmStart)
+    {
+        for(i = 0; i < NumNodes; i++)
+        {
+            L.V[i] = startSolution[i];
+        }
+    }
 
     for(i = 0; i < NumBlockLabels; i++)
     {
@@ -680,7 +692,7 @@ int FSolver::Static2D(CBigLinProb &L)
                 }
 
             }
-            else
+            if ((Iter > 0) || bWarmStart)
             {
                 k = meshele[i].blk;
 
@@ -945,7 +957,7 @@ int FSolver::Static2D(CBigLinProb &L)
             V_old[j]=L.V[j];
         }
 
-        if (L.PCGSolve(Iter)==false)
+        if (L.PCGSolve(Iter || bWarmStart)==false)
         {
             return false;
         }
@@ -1005,7 +1017,7 @@ int FSolver::Static2D(CBigLinProb &L)
         // nonlinear iteration has to have a looser tolerance
         // than the linear solver--otherwise, things can't ever
         // converge.  Arbitrarily choose 100*tolerance.
-        if((res<100.*Precision) && (Iter>0))
+        if((res<100.*Precision) && ((Iter>0) || bWarmStart))
         {
             LinearFlag = true;
         }
@@ -1041,7 +1053,7 @@ int FSolver::WriteStatic2D(CBigLinProb &L)
 
     char c[1024];
     char msgbuff[1024];
-    FILE *fp,*fz;
+    FILE *fz;
     int i,k;
     double cf;
     double unitconv[]= {2.54,0.1,1.,100.,0.00254,1.e-04};
@@ -1057,70 +1069,65 @@ int FSolver::WriteStatic2D(CBigLinProb &L)
         return false;
     }
 
+    femm::TextWriter out;
     sprintf(c,"%s.ans",PathName.c_str());
-    fp = fopen(c,"wt");
-    if(fp==NULL)
+    if(!out.open(c))
     {
-        if (fz != NULL) fclose(fz);
+        fclose(fz);
         //MsgBox("Couldn't write to %s.ans\n",PathName.c_str());
         sprintf(msgbuff,"Couldn't write to %s.ans\n",PathName.c_str());
         WarnMessage(msgbuff);
         return false;
     }
 
-    while(fgets(c,1024,fz)!=NULL)
-    {
-        fputs(c,fp);
-    }
-
+    out.copy(fz);
     fclose(fz);
 
     // then print out node, line, and element information
-    fprintf(fp,"[Solution]\n");
+    out.write("[Solution]\n");
 
     cf = unitconv[LengthUnits];
 
-    fprintf(fp,"%i\n",NumNodes);
+    out.writeInt(NumNodes);
+    out.write('\n');
 
     for(i = 0; i<NumNodes; i++)
     {
-        fprintf( fp, "%.17g\t%.17g\t%.17g\t%i",
-                 meshnode[i].x/cf,
-                 meshnode[i].y/cf,
-                 L.b[i],
-                 meshnode[i].BoundaryMarker );
+        out.writeDouble(meshnode[i].x/cf);
+        out.write('\t');
+        out.writeDouble(meshnode[i].y/cf);
+        out.write('\t');
+        out.writeDouble(L.b[i]);
+        out.write('\t');
+        out.writeInt(meshnode[i].BoundaryMarker);
 
         // include A from previous solution if this is an incremental permeability problem
-		if (!Aprev.empty ())
+        // (note: there is no separator before A, just as in FEMM)
+        if (!Aprev.empty ())
         {
-            fprintf(fp, "%.17g\n", Aprev[i]);
-        }
-		else
-        {
-            fprintf(fp, "\n");
+            out.writeDouble(Aprev[i]);
         }
+        out.write('\n');
     }
 
-    fprintf(fp,"%i\n",NumEls);
+    out.writeInt(NumEls);
+    out.write('\n');
 
     for(i = 0; i<NumEls; i++)
     {
-        fprintf(fp,"%i\t%i\t%i\t%i\n",meshele[i].p[0],meshele[i].p[1],meshele[i].p[2],meshele[i].lbl);
+        out.writeInt(meshele[i].p[0]);
+        out.write('\t');
+        out.writeInt(meshele[i].p[1]);
+        out.write('\t');
+        out.writeInt(meshele[i].p[2]);
+        out.write('\t');
+        out.writeInt(meshele[i].lbl);
+        out.write('\n');
     }
 
-    /*
-    	// print out circuit info
-    	fprintf(fp,"%i\n",NumCircPropsOrig);
-    	for(i=0;i<NumCircPropsOrig;i++){
-    		if (circproplist[i].Case==0)
-    			fprintf(fp,"0	%.17g\n",circproplist[i].dV.Re());
-    		if (circproplist[i].Case==1)
-    			fprintf(fp,"1	%.17g\n",circproplist[i].J.Re());
-    	}
-    */
-
     // print out circuit info on a blocklabel by blocklabel basis;
-    fprintf(fp,"%i\n",NumBlockLabels);
+    out.writeInt(NumBlockLabels);
+    out.write('\n');
 
     for(k = 0; k<NumBlockLabels; k++)
     {
@@ -1131,66 +1138,91 @@ int FSolver::WriteStatic2D(CBigLinProb &L)
             // print out some "dummy" propeties that say that
             // there is a fixed additional current density,
             // but that that additional current density is zero.
-            fprintf(fp,"1\t0\n");
+            out.write("1\t0\n");
         }
         else
         {
             if (circproplist[i].Case==0)
             {
-                fprintf(fp,"0\t%.17g\n",circproplist[i].dV.Re());
+                out.write("0\t");
+                out.writeDouble(circproplist[i].dV.Re());
+                out.write('\n');
             }
 
             if (circproplist[i].Case==1)
             {
-                fprintf(fp,"1\t%.17g\n",circproplist[i].J.Re());
+                out.write("1\t");
+                out.writeDouble(circproplist[i].J.Re());
+                out.write('\n');
             }
         }
     }
 
-	// print out information on periodic boundary conditions for
-	// possible re-use in AC incremental permeability solutions
-	fprintf(fp,"%i\n",NumPBCs);
-	for(k=0;k<NumPBCs;k++)
+    // print out information on periodic boundary conditions for
+    // possible re-use in AC incremental permeability solutions
+    out.writeInt(NumPBCs);
+    out.write('\n');
+    for(k=0;k<NumPBCs;k++)
     {
-        fprintf(fp,"%i\t%i\t%i\n",pbclist[k].x,pbclist[k].y,pbclist[k].t);
+        out.writeInt(pbclist[k].x);
+        out.write('\t');
+        out.writeInt(pbclist[k].y);
+        out.write('\t');
+        out.writeInt(pbclist[k].t);
+        out.write('\n');
     }
 
-    // print out information on periodic boundary conditions for
-	// possible re-use in AC incremental permeability solutions
-	// and in post-processing of forces and torques
-	fprintf(fp,"%i\n",NumAirGapElems);
-	for(i=0;i<NumAirGapElems;i++)
+    // print out information on air gap elements for
+    // possible re-use in AC incremental permeability solutions
+    // and in post-processing of forces and torques
+    out.writeInt(NumAirGapElems);
+    out.write('\n');
+    for(i=0;i<NumAirGapElems;i++)
     {
-		fprintf(fp,"%s",agelist[i].BdryName.c_str ());
-
-		fprintf( fp,"%i %.17g %.17g %.17g %.17g %.17g %.17g %.17g %i %.17g %.17g\n",
-                 agelist[i].BdryFormat,
-                 agelist[i].InnerAngle,
-                 agelist[i].OuterAngle,
-                 agelist[i].ri,
-                 agelist[i].ro,
-                 agelist[i].totalArcLength,
-                 agelist[i].agc.re,
-                 agelist[i].agc.im,
-                 agelist[i].totalArcElements,
-                 agelist[i].InnerShift,
-                 agelist[i].OuterShift );
-
-		for(k=0;k<=agelist[i].totalArcElements;k++)
-		{
-			fprintf( fp,"%i %.17g %i %.17g %i %.17g %i %.17g\n",
-                     agelist[i].quadNode[k].n0,
-                     agelist[i].quadNode[k].w0,
-                     agelist[i].quadNode[k].n1,
-                     agelist[i].quadNode[k].w1,
-                     agelist[i].quadNode[k].n2,
-                     agelist[i].quadNode[k].w2,
-                     agelist[i].quadNode[k].n3,
-                     agelist[i].quadNode[k].w3 );
-		}
-	}
-
-    fclose(fp);
+        WriteAirGapElement(out, agelist[i]);
+    }
+
+    if (!out.close())
+    {
+        sprintf(msgbuff,"Couldn't write to %s.ans\n",PathName.c_str());
+        WarnMessage(msgbuff);
+        return false;
+    }
+    return true;
+}
+
+bool FSolver::StoreStatic2D(CBigLinProb &L)
+{
+    if (!StoreSolutionMesh())
+        return false;
+
+    solution->nodeValue.resize(NumNodes);
+    for(int i = 0; i<NumNodes; i++)
+    {
+        solution->nodeValue[i] = L.b[i];
+    }
+
+    // circuit info on a blocklabel by blocklabel basis;
+    // blocks that are not associated with any particular circuit
+    // have a fixed additional current density of zero.
+    solution->labelCircuitCase.assign(NumBlockLabels, 1);
+    solution->labelCircuitValue.assign(NumBlockLabels, 0);
+    for(int k = 0; k<NumBlockLabels; k++)
+    {
+        int i = labellist[k].InCircuit;
+        if (i<0)
+            continue;
+
+        if (circproplist[i].Case==0)
+        {
+            solution->labelCircuitCase[k] = 0;
+            solution->labelCircuitValue[k] = circproplist[i].dV.Re();
+        }
+        if (circproplist[i].Case==1)
+        {
+            solution->labelCircuitValue[k] = circproplist[i].J.Re();
+        }
+    }
     return true;
 }
 
@@ -799,18 +799,30 @@ void HPProc::lineIntegral(int inttype, double *z)
     return;
 }
 
-ParserResult HPProc::parseSolution(std::istream &input, std::ostream &err)
+ParserResult HPProc::parseSolution(femm::Lexer &input, std::ostream &err)
 {
     using femmsolver::CHMeshNode;
     using femmsolver::CHSElement;
 
     int k;
+    bool ok = true;
     // read in meshnodes;
     parseValue(input, k, err);
     meshnodes.reserve(k);
-    for(int i=0;i<k;i++)
+    for(int i=0;i<k && ok;i++)
+    {
+        CHMeshNode n;
+        ok &= input.parseDouble(n.x);
+        ok &= input.parseDouble(n.y);
+        ok &= input.parseDouble(n.T);
+        ok &= input.parseInt(n.Q);
+        input.skipLine();
+        meshnodes.push_back(MAKE_UNIQUE<CHMeshNode>(n));
+    }
+    if (!ok)
     {
-        meshnodes.push_back(MAKE_UNIQUE<CHMeshNode>(CHMeshNode::fromStream(input,err)));
+        err << "Malformed mesh node " << meshnodes.size()-1 << "\n";
+        return femm::F_FILE_MALFORMED;
     }
 
     // read in elements;
@@ -819,7 +831,17 @@ ParserResult HPProc::parseSolution(std::istream &input, std::ostream &err)
     auto &labellist = problem->labellist;
     for(int i=0;i<k;i++)
     {
-        CHSElement elm = CHSElement::fromStream(input,err);
+        CHSElement elm;
+        ok &= input.parseInt(elm.p[0]);
+        ok &= input.parseInt(elm.p[1]);
+        ok &= input.parseInt(elm.p[2]);
+        ok &= input.parseInt(elm.lbl);
+        input.skipLine();
+        if (!ok || elm.lbl < 0 || elm.lbl >= (int)labellist.size())
+        {
+            err << "Malformed mesh element " << i << "\n";
+            return femm::F_FILE_MALFORMED;
+        }
         elm.blk = labellist[elm.lbl]->BlockType;
         meshelems.push_back(MAKE_UNIQUE<CHSElement>(elm));
     }
@@ -827,12 +849,71 @@ ParserResult HPProc::parseSolution(std::istream &input, std::ostream &err)
     // read in circuit data;
     auto &circproplist = problem->circproplist;
     parseValue(input, k, err);
-    for(int i=0;i<k;i++)
+    for(int i=0;i<k && i<(int)circproplist.size();i++)
+    {
+        auto circuit = reinterpret_cast<CHConductor*>(circproplist[i].get());
+        // partially overwrite circuit data:
+        input.parseDouble(circuit->V);
+        input.parseDouble(circuit->q);
+        input.skipLine();
+    }
+    return femm::F_FILE_OK;
+}
+
+
+ParserResult HPProc::loadSolution(const femm::SolutionData &solution, std::ostream &err)
+{
+    using femmsolver::CHMeshNode;
+    using femmsolver::CHSElement;
+
+    // mesh nodes
+    meshnodes.reserve(solution.numNodes());
+    for(int i=0;i<solution.numNodes();i++)
+    {
+        CHMeshNode n;
+        n.x = solution.nodeX[i];
+        n.y = solution.nodeY[i];
+        n.T = solution.nodeValue[i].re;
+        n.Q = solution.nodeMarker[i];
+        meshnodes.push_back(MAKE_UNIQUE<CHMeshNode>(n));
+    }
+
+    // elements
+    meshelems.reserve(solution.numElements());
+    auto &labellist = problem->labellist;
+    for(int i=0;i<solution.numElements();i++)
+    {
+        CHSElement elm;
+        for(int j=0;j<3;j++)
+            elm.p[j] = solution.elements[3*i+j];
+        elm.lbl = solution.elementLabel[i];
+        if (elm.lbl < 0 || elm.lbl >= (int)labellist.size())
+        {
+            err << "Element " << i << " has invalid block label " << elm.lbl << "\n";
+            return femm::F_FILE_MALFORMED;
+        }
+        elm.blk = labellist[elm.lbl]->BlockType;
+        meshelems.push_back(MAKE_UNIQUE<CHSElement>(elm));
+    }
+
+    // circuit data
+    auto &circproplist = problem->circproplist;
+    if (solution.conductorValue.size() > circproplist.size())
+    {
+        err << "Solution contains more conductors than the problem description\n";
+        return femm::F_FILE_MALFORMED;
+    }
+    if (solution.conductorFlux.size() != solution.conductorValue.size())
+    {
+        err << "Solution contains inconsistent conductor data\n";
+        return femm::F_FILE_MALFORMED;
+    }
+    for(int i=0;i<(int)solution.conductorValue.size();i++)
     {
         auto circuit = reinterpret_cast<CHConductor*>(circproplist[i].get());
         // partially overwrite circuit data:
-        input >> circuit->V;
-        input >> circuit->q;
+        circuit->V = solution.conductorValue[i];
+        circuit->q = solution.conductorFlux[i];
     }
     return femm::F_FILE_OK;
 }
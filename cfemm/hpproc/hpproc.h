@@ -68,7 +68,8 @@ public:
     void lineIntegral(int inttype, double *z);
 
     bool OpenDocument(std::string solutionFile) override;
-    femm::ParserResult parseSolution( std::istream &input, std::ostream &err = std::cerr ) override;
+    femm::ParserResult parseSolution( femm::Lexer &input, std::ostream &err = std::cerr ) override;
+    femm::ParserResult loadSolution( const femm::SolutionData &solution, std::ostream &err = std::cerr ) override;
 
 protected:
     // General problem attributes
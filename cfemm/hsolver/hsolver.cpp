@@ -37,12 +37,16 @@
 #include "spars.h"
 #include "fparse.h"
 #include "hsolver.h"
+#include "TextWriter.h"
+#include "make_unique.h"
 
+#include <algorithm>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <cstring>
 #include <malloc.h>
+#include <sstream>
 
 // template instantiation:
 #include "../libfemm/feasolver.cpp"
@@ -77,7 +81,9 @@ using namespace femm;
 // HSolver construction/destruction
 
 HSolver::HSolver()
-    : meshnode(nullptr)
+    : reuseAssembly(false)
+    , maxStepChange(0)
+    , meshnode(nullptr)
     , Tprev(nullptr)
 {
 
@@ -188,28 +194,34 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 {
 	int i,j,k,q,n0,n1,n;
 	char infile[256];
-	FILE *fp;
-	char s[1024];
     double c[]={0.0254,0.001,0.01,1,2.54e-5,1.e-6};
 
 
-	//read meshnodes;
-	sprintf(infile,"%s.node",PathName.c_str());
-	if((fp=fopen(infile,"rt"))==NULL){
-		return BADELEMENTFILE;
+	// use the mesh handed over by the mesher, or read it from the mesh files
+	femm::MeshData fileMesh;
+	const femm::MeshData *mesh = meshData.get();
+	if (!mesh)
+	{
+		std::stringstream err;
+		LoadMeshErr status = fileMesh.read(PathName, err);
+		if (!err.str().empty())
+			WarnMessage(err.str().c_str());
+		if (status != NOERROR)
+			return status;
+		mesh = &fileMesh;
 	}
-	fgets(s,1024,fp);
-	sscanf(s,"%i",&k);
+
+	//read meshnodes;
+	k = mesh->numNodes();
 	NumNodes = k;
 
     meshnode = new CNode[k];
     CNode node;
 	for(i = 0; i < k; i++)
 	{
-		fscanf(fp,"%i",&j);
-		fscanf(fp,"%lf",&node.x);
-		fscanf(fp,"%lf",&node.y);
-		fscanf(fp,"%i",&n);
+		node.x = mesh->nodeX[i];
+		node.y = mesh->nodeY[i];
+		n = mesh->nodeMarker[i];
 
 		if (n > 1)
 		{
@@ -238,35 +250,14 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 
 		meshnode[i] = node;
 	}
-	fclose(fp);
 
 	//read in periodic boundary conditions;
-	sprintf(infile,"%s.pbc",PathName.c_str());
-	if((fp=fopen(infile,"rt"))==NULL){
-		return BADPBCFILE;
-	}
-	fgets(s,1024,fp);
-	sscanf(s,"%i",&k);
-	NumPBCs=k;
-
-    if (k!=0) pbclist.reserve(k);
-	CCommonPoint pbc;
-	for(i=0;i<k;i++){
-		fscanf(fp,"%i",&j);
-		fscanf(fp,"%i",&pbc.x);
-		fscanf(fp,"%i",&pbc.y);
-		fscanf(fp,"%i",&pbc.t);
-        pbclist.push_back(pbc);
-	}
-	fclose(fp);
+	NumPBCs = (int)mesh->pbcs.size();
+	pbclist = mesh->pbcs;
 
 	// read in elements;
-	sprintf(infile,"%s.ele",PathName.c_str());
-	if((fp=fopen(infile,"rt"))==NULL){
-		return BADELEMENTFILE;
-	}
-	fgets(s,1024,fp);
-	sscanf(s,"%i",&k); NumEls=k;
+	k = mesh->numElements();
+	NumEls=k;
 
     meshele.reserve(k);
     femmsolver::CElement elm;
@@ -276,11 +267,10 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 		if (labellist[i].IsDefault) defaultLabel=i;
 
 	for(i=0;i<k;i++){
-		fscanf(fp,"%i",&j);
-		fscanf(fp,"%i",&elm.p[0]);
-		fscanf(fp,"%i",&elm.p[1]);
-		fscanf(fp,"%i",&elm.p[2]);
-		fscanf(fp,"%i",&elm.lbl);
+		elm.p[0] = mesh->elements[3*i];
+		elm.p[1] = mesh->elements[3*i+1];
+		elm.p[2] = mesh->elements[3*i+2];
+		elm.lbl = mesh->elementLabel[i];
 		elm.lbl--;
 		if(elm.lbl<0) elm.lbl=defaultLabel;
 		if(elm.lbl<0){
@@ -289,7 +279,6 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
             msg += "button to highlight the problem regions.";
             WarnMessage(msg.c_str());
 
-			fclose(fp);
             if (deleteFiles)
             {
                 sprintf(infile,"%s.ele",PathName.c_str());
@@ -310,13 +299,14 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 
         meshele.push_back(elm);
 	}
-	fclose(fp);
 
 	// initialize edge bc's and element permeabilities;
 	for(i=0;i<NumEls;i++)
 		for(j=0;j<3;j++)
 			meshele[i].e[j] = -1;
 
+	meshEdges = mesh->edges;
+
 	// read in edges to which boundary conditions are applied;
 
 		// first, do a little bookkeeping so that element
@@ -349,20 +339,11 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 				nmbr[k]++;
 			}
 
-	sprintf(infile,"%s.edge",PathName.c_str());
-	if((fp=fopen(infile,"rt"))==NULL)
-	{
-		return BADEDGEFILE;
-	}
-	fscanf(fp,"%i",&k);	// read in number of lines
-
-	fscanf(fp,"%i",&j);	// read in boundarymarker flag;
-	for(i=0;i<k;i++)
+	for(i=0;i<mesh->numEdges();i++)
 	{
-		fscanf(fp,"%i",&j);
-		fscanf(fp,"%i",&n0);
-		fscanf(fp,"%i",&n1);
-		fscanf(fp,"%i",&n);
+		n0 = mesh->edges[2*i];
+		n1 = mesh->edges[2*i+1];
+		n = mesh->edgeMarker[i];
 
 		// BC number;
 		if (n<0)
@@ -407,7 +388,6 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 		}
 
 	}
-	fclose(fp);
 
 	// free up the connectivity information
 	free(nmbr);
@@ -461,19 +441,27 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 	double Me[3][3],be[3];		// element matrices;
 	double l[3],p[3],q[3];		// element shape parameters;
 	int n[3],ne[3];				// numbers of nodes for a particular element;
-	double a,K,r,z,kludge;
+	double a,K,Kc,r,z,kludge;
 	double bta,Tinf,Tlast,*Vo;
     int IsNonlinear=false;
     femmsolver::CElement *El;
 	CComplex kn;
 	int iter=0;
 
-	Depth*=units[LengthUnits];
-	extRo*=units[LengthUnits];
-	extRi*=units[LengthUnits];
-	extZo*=units[LengthUnits];
+	// lengths in meters; the problem attributes are left alone for later calls
+	double depth=Depth*units[LengthUnits];
+	const double Ro=extRo*units[LengthUnits];
+	const double Ri=extRi*units[LengthUnits];
+	const double Zo=extZo*units[LengthUnits];
 	kludge=1;
 
+	// the matrix of a linear transient problem is kept for the following time steps,
+	// which only change the heat capacity term of the right hand side
+	const bool bRestoreAssembly = reuseAssembly && (dT!=0) && (transientAssembly.dT==dT)
+			&& ((int)transientAssembly.rhs.size()==L.n);
+	const bool bStoreAssembly = reuseAssembly && (dT!=0) && !bRestoreAssembly
+			&& isTransientAssemblyReusable();
+
 	//TheView->SetDlgItemText(IDC_FRAME1,"Matrix Construction");
 
 	Vo=(double *) calloc(NumNodes,sizeof(double));
@@ -491,7 +479,26 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 	do{
 		// copy old solution
 		for(i=0;i<NumNodes;i++) Vo[i]=L.V[i];
+
+		if (bRestoreAssembly)
+		{
+			// L still holds the matrix of the previous time step,
+			// which is also a good starting point for the solver
+			restoreTransientAssembly(L);
+			if (L.PCGSolve(true)==false){
+				free(Vo);
+				return false;
+			}
+			break;
+		}
+
 		L.Wipe();
+		if (bStoreAssembly)
+		{
+			transientAssembly=TransientAssembly();
+			transientAssembly.capacity.assign(NumNodes,0.);
+			transientAssembly.row.assign(NumNodes,-1);
+		}
 
 		// do some book-keeping related to fixed boundary conditions;
 		// The P vector denotes which nodes have an assigned value
@@ -575,21 +582,21 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 				  blockproplist[El->blk].GetK(Vo[n[2]]))/3.;
 
 			if (ProblemType==AXISYMMETRIC){
-				Depth=2.*PI*r;
+				depth=2.*PI*r;
 
 				// "Warp" the permeability of this element is part of
 				// the conformally mapped external region
 				if(labellist[meshele[i].lbl].IsExternal)
 				{
-					z=(meshnode[n[0]].y+meshnode[n[1]].y+meshnode[n[2]].y)/3. - extZo;
-					kludge=(r*r+z*z)/(extRi*extRo);
+					z=(meshnode[n[0]].y+meshnode[n[1]].y+meshnode[n[2]].y)/3. - Zo;
+					kludge=(r*r+z*z)/(Ri*Ro);
 				}
 				else kludge=1;
 			}
 
 
 			// x-contribution;
-			K = -Depth*Re(kn)/(4.*a)/kludge;
+			K = -depth*Re(kn)/(4.*a)/kludge;
 			for(j=0;j<3;j++)
 				for(k=j;k<3;k++)
 				{
@@ -598,7 +605,7 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 				}
 
 			// y-contribution;
-			K = -Depth*Im(kn)/(4.*a)/kludge;
+			K = -depth*Im(kn)/(4.*a)/kludge;
 			for(j=0;j<3;j++)
 				for(k=j;k<3;k++)
 				{
@@ -623,22 +630,27 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 				be[2]+=K*(   Tprev[n[0]] +    Tprev[n[1]] + 2.*Tprev[n[2]]);
 			} */
 
+			Kc=0;
 			if (dT!=0)
 			{
-				K = -Depth*blockproplist[El->blk].Kt*a/(3.*dT);
+				K = -depth*blockproplist[El->blk].Kt*a/(3.*dT);
 
 				Me[0][0]+=K;
 				Me[1][1]+=K;
 				Me[2][2]+=K;
 
-				be[0]+=K*Tprev[n[0]];
-				be[1]+=K*Tprev[n[1]];
-				be[2]+=K*Tprev[n[2]];
+				// a stored assembly gets this term from restoreTransientAssembly()
+				if (bStoreAssembly) Kc=-K;
+				else{
+					be[0]+=K*Tprev[n[0]];
+					be[1]+=K*Tprev[n[1]];
+					be[2]+=K*Tprev[n[2]];
+				}
 			}
 
 			// contribution to be[] from volume charge density
 			for(j = 0;j<3;j++){
-				K = -Depth*(blockproplist[El->blk].qv)*a/3.;
+				K = -depth*(blockproplist[El->blk].qv)*a/3.;
 				be[j]+=K;
 			}
 
@@ -650,7 +662,7 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 					k=j+1; if(k==3) k=0;
 
 					if (ProblemType==AXISYMMETRIC)
-						Depth=PI*(meshnode[n[j]].x + meshnode[n[k]].x);
+						depth=PI*(meshnode[n[j]].x + meshnode[n[k]].x);
 
 					// contributions to Me, be from derivative boundary conditions;
 					// !!! need to put in contribution here for radiation....
@@ -698,13 +710,13 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 						}
 						else
 						{
-							K =-Depth*c0*l[j]/6.;
+							K =-depth*c0*l[j]/6.;
 							Me[j][j]+=K*2.;
 							Me[k][k]+=K*2.;
 							Me[j][k]+=K;
 							Me[k][j]+=K;
 
-							K = Depth*c1*l[j]/2.;
+							K = depth*c1*l[j]/2.;
 							be[j]+=K;
 							be[k]+=K;
 						}
@@ -745,6 +757,12 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 				if(meshnode[n[j]].InConductor>=0)
 					if(circproplist[meshnode[n[j]].InConductor].CircType==0)
 						ne[j]=meshnode[n[j]].InConductor+NumNodes;
+
+				if(bStoreAssembly && (L.Q[n[j]]==-2))
+				{
+					transientAssembly.capacity[n[j]]+=Kc;
+					transientAssembly.row[n[j]]=ne[j];
+				}
 			}
 			for (j=0;j<3;j++){
 				for (k=j;k<3;k++)
@@ -765,8 +783,8 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 		{
             if((meshnode[i].BoundaryMarker>=0) && (L.Q[i]==-2))
 			{
-				if (ProblemType==AXISYMMETRIC) Depth=2.*PI*meshnode[i].x;
-                L.b[i]+=(Depth*nodeproplist[meshnode[i].BoundaryMarker].qp);
+				if (ProblemType==AXISYMMETRIC) depth=2.*PI*meshnode[i].x;
+                L.b[i]+=(depth*nodeproplist[meshnode[i].BoundaryMarker].qp);
 				L.Q[i]=-1;
 			}
 
@@ -792,6 +810,7 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 				K=L.Get(0,0);
 				L.Put(K,k,k);
 				L.b[k]=K*circproplist[i].V;
+				if (bStoreAssembly) transientAssembly.fixedRows.push_back(k);
 			}
 
 			if(circproplist[i].CircType==0)
@@ -800,6 +819,7 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 				if(K!=0){
 					L.Put(-K,k,k);
 					L.b[k]=circproplist[i].q;
+					if (bStoreAssembly) transientAssembly.fixedRows.push_back(k);
 				}
 				else L.Put(L.Get(0,0),k,k);
 
@@ -807,6 +827,13 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 			}
 		}
 
+		if (bStoreAssembly)
+		{
+			transientAssembly.dT=dT;
+			transientAssembly.rhs.assign(L.b,L.b+L.n);
+			restoreTransientAssembly(L);
+		}
+
 		// solve the problem;
         if (L.PCGSolve(iter++)==false){
 			free(Vo);
@@ -853,6 +880,16 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 
 bool HSolver::runSolver(bool verbose)
 {
+    if (!prepareMesh(verbose))
+        return false;
+    return solveMesh(verbose);
+}
+
+bool HSolver::prepareMesh(bool verbose)
+{
+    linearSystem.reset();
+    transientAssembly = TransientAssembly();
+
     // load mesh
     LoadMeshErr err = LoadMesh();
     if (err != NOERROR)
@@ -875,7 +912,67 @@ bool HSolver::runSolver(bool verbose)
         WarnMessage("problem renumbering node points\n");
         return false;
     }
+    return true;
+}
+
+bool HSolver::solveMesh(bool verbose)
+{
+    bool ok = solveSystem(verbose) && storeSolution(*linearSystem, verbose);
+    if (!reuseAssembly)
+        linearSystem.reset();
+    return ok;
+}
+
+double HSolver::solveTimeStep(bool verbose)
+{
+    if (dT == 0)
+    {
+        WarnMessage("solveTimeStep(): the problem is not transient\n");
+        return 0;
+    }
+    // give up halving the time step at some point, and take the step anyway
+    constexpr int maxHalvings = 10;
+
+    const std::vector<double> start(Tprev, Tprev+NumNodes);
+    double step = dT;
+    for (int halvings=0; ; halvings++)
+    {
+        step = dT;
+        if (!solveSystem(verbose))
+        {
+            if (!reuseAssembly)
+                linearSystem.reset();
+            return 0;
+        }
+        if (maxStepChange <= 0)
+            break;
+
+        const CBigLinProb &L = *linearSystem;
+        double change = 0;
+        for (int i=0; i<NumNodes; i++)
+        {
+            if (L.Q[i] == -2)
+                change = std::max(change, fabs(L.V[i]-start[i]));
+        }
+        if (change <= maxStepChange || halvings == maxHalvings)
+        {
+            if (change < maxStepChange/4)
+                dT *= 2;
+            break;
+        }
+        // repeat the step from the same start
+        std::copy(start.begin(), start.end(), Tprev);
+        dT /= 2;
+    }
+
+    bool ok = storeSolution(*linearSystem, verbose);
+    if (!reuseAssembly)
+        linearSystem.reset();
+    return ok ? step : 0;
+}
 
+bool HSolver::solveSystem(bool verbose)
+{
     if (verbose)
     {
         PrintMessage("solving...");
@@ -886,17 +983,25 @@ bool HSolver::runSolver(bool verbose)
         std::cout << "Precision: " << Precision << "\n";
     }
 
-    CBigLinProb L;
-
-    L.Precision = Precision;
-    if (!L.Create(NumNodes+NumCircProps,BandWidth))
+    if (!linearSystem)
     {
-        WarnMessage("couldn't allocate enough space for matrices\n");
-        return false;
+        linearSystem = MAKE_UNIQUE<CBigLinProb>();
+        linearSystem->Precision = Precision;
+        linearSystem->bFloatPC = FloatPreconditioner;
+        if (!linearSystem->Create(NumNodes+NumCircProps,BandWidth))
+        {
+            linearSystem.reset();
+            WarnMessage("couldn't allocate enough space for matrices\n");
+            return false;
+        }
+        transientAssembly = TransientAssembly();
     }
+    CBigLinProb &L = *linearSystem;
 
     if (!AnalyzeProblem(L))
     {
+        // the matrix may be incomplete
+        transientAssembly = TransientAssembly();
         WarnMessage("Couldn't solve the problem\n");
         return false;
     }
@@ -904,17 +1009,97 @@ bool HSolver::runSolver(bool verbose)
     if (verbose)
         PrintMessage("Problem solved\n");
 
-    if (!WriteResults(L))
+    // the solution is the start of the next time step
+    if (dT != 0)
+        std::copy(L.V, L.V+NumNodes, Tprev);
+    return true;
+}
+
+bool HSolver::storeSolution(CBigLinProb &L, bool verbose)
+{
+    if ((keepSolution || binarySolutionFile || !solutionArchive.empty()) && !StoreResults(L))
     {
-       WarnMessage("couldn't write results to disk\n");
-       return 6;
+        WarnMessage("couldn't store results\n");
+        return false;
     }
-    if (verbose)
-        PrintMessage("results written to disk\n");
+    if (writeSolutionFile)
+    {
+        bool written = binarySolutionFile
+                ? WriteBinarySolution(PathName + ".anh")
+                : WriteResults(L);
+        if (!written)
+        {
+           WarnMessage("couldn't write results to disk\n");
+           return 6;
+        }
+        if (verbose)
+            PrintMessage("results written to disk\n");
+    }
+    if (!solutionArchive.empty() && !AppendToSolutionArchive())
+    {
+        WarnMessage("couldn't append results to the solution archive\n");
+        return false;
+    }
+    if (!keepSolution)
+        solution.reset();
+
+    return true;
+}
 
+bool HSolver::isTransientAssemblyReusable() const
+{
+    for(int i=0; i<NumEls; i++)
+    {
+        // temperature dependent conductivity
+        if (blockproplist[meshele[i].blk].npts>0)
+            return false;
+        // radiation boundaries
+        for(int j=0; j<3; j++)
+        {
+            if (meshele[i].e[j]>=0 && lineproplist[meshele[i].e[j]].BdryFormat==3)
+                return false;
+        }
+    }
     return true;
 }
 
+void HSolver::restoreTransientAssembly(CBigLinProb &L) const
+{
+    const TransientAssembly &a = transientAssembly;
+    std::vector<double> term(L.n, 0.);
+    for(int i=0; i<NumNodes; i++)
+    {
+        if (a.row[i]>=0)
+            term[a.row[i]] += a.capacity[i]*Tprev[i];
+    }
+
+    // combine the equations like CBigLinProb::Periodicity() and AntiPeriodicity() did
+    for(int k=0; k<NumPBCs; k++)
+    {
+        int i = pbclist[k].x;
+        int j = pbclist[k].y;
+        if (j<i)
+            swap(i,j);
+        if (pbclist[k].t==0)
+        {
+            double c = 0.5*(term[i]+term[j]);
+            term[i] = c;
+            term[j] = c;
+        }
+        if (pbclist[k].t==1)
+        {
+            double c = 0.5*(term[i]-term[j]);
+            term[i] = c;
+            term[j] = -c;
+        }
+    }
+    for(int k: a.fixedRows)
+        term[k] = 0;
+
+    for(int i=0; i<L.n; i++)
+        L.b[i] = a.rhs[i] + term[i];
+}
+
 //=========================================================================
 //=========================================================================
 
@@ -923,7 +1108,7 @@ int HSolver::WriteResults(CBigLinProb &L)
 	// write solution to disk;
 
 	char c[1024];
-	FILE *fp,*fz;
+	FILE *fz;
 	int i;
 	double cf;
 	// first, echo input .feh file to the .anh file;
@@ -936,47 +1121,90 @@ int HSolver::WriteResults(CBigLinProb &L)
         return false;
 	}
 
+    femm::TextWriter out;
     sprintf(c,"%s.anh",PathName.c_str());
-    fp=fopen(c,"wt");
-	if(fp==NULL)
+	if(!out.open(c))
     {
+		fclose(fz);
 		printf("Couldn't write to %s.anh",PathName.c_str());
         return false;
 	}
 
-	while(fgets(c,1024,fz)!=NULL)
-    {
-        fputs(c,fp);
-    }
+	out.copy(fz);
 	fclose(fz);
 
 	// then print out node, line, and element information
-	fprintf(fp,"[Solution]\n");
+	out.write("[Solution]\n");
     // get conversion factor for conversion from internal working units of
     // mm to the specified length units
 	cf = units[LengthUnits];
-	fprintf(fp,"%i\n",NumNodes);
+	out.writeInt(NumNodes);
+	out.write('\n');
 	for(i=0;i<NumNodes;i++)
     {
-		fprintf(fp,"%.17g	%.17g	%.17g	%i\n",meshnode[i].x/cf,meshnode[i].y/cf,L.V[i],L.Q[i]);
+		out.writeDouble(meshnode[i].x/cf);
+		out.write('\t');
+		out.writeDouble(meshnode[i].y/cf);
+		out.write('\t');
+		out.writeDouble(L.V[i]);
+		out.write('\t');
+		out.writeInt(L.Q[i]);
+		out.write('\n');
     }
 
-	fprintf(fp,"%i\n",NumEls);
+	out.writeInt(NumEls);
+	out.write('\n');
 
 	for(i=0;i<NumEls;i++)
     {
-		fprintf(fp,"%i	%i	%i	%i\n",
-			meshele[i].p[0],meshele[i].p[1],meshele[i].p[2],meshele[i].lbl);
+		out.writeInt(meshele[i].p[0]);
+		out.write('\t');
+		out.writeInt(meshele[i].p[1]);
+		out.write('\t');
+		out.writeInt(meshele[i].p[2]);
+		out.write('\t');
+		out.writeInt(meshele[i].lbl);
+		out.write('\n');
     }
 
 	// print out circuit info
-	fprintf(fp,"%i\n",NumCircProps);
+	out.writeInt(NumCircProps);
+	out.write('\n');
 	for(i=0;i<NumCircProps;i++)
     {
-		fprintf(fp,"%.17g	%.17g\n",L.V[NumNodes+i],circproplist[i].q);
+		out.writeDouble(L.V[NumNodes+i]);
+		out.write('\t');
+		out.writeDouble(circproplist[i].q);
+		out.write('\n');
+    }
+
+	if(!out.close())
+    {
+		printf("Couldn't write to %s.anh",PathName.c_str());
+        return false;
+	}
+    return true;
+}
+
+bool HSolver::StoreResults(CBigLinProb &L)
+{
+    if (!StoreSolutionMesh(meshnode, units[LengthUnits], PathName + ".feh", femm::FileType::HeatFlowFile))
+        return false;
+
+    solution->nodeValue.resize(NumNodes);
+    for(int i=0; i<NumNodes; i++)
+    {
+        solution->nodeValue[i] = L.V[i];
+        solution->nodeMarker[i] = L.Q[i];
     }
 
-	fclose(fp);
+    solution->conductorValue.resize(NumCircProps);
+    solution->conductorFlux.resize(NumCircProps);
+    for(int i=0; i<NumCircProps; i++)
+    {
+        solution->conductorValue[i] = L.V[NumNodes+i];
+        solution->conductorFlux[i] = circproplist[i].q;
+    }
     return true;
 }
 
@@ -1014,7 +1242,7 @@ double HSolver::ChargeOnConductor(int u, CBigLinProb &L)
 			a=da/2.;
 			if (ProblemType==AXISYMMETRIC)
 				a*=(2.*PI*(meshnode[n[0]].x+meshnode[n[1]].x+meshnode[n[2]].x)/3.);
-			else a*=Depth;
+			else a*=Depth*units[LengthUnits];
 			// get normal vector and element flux density;
 			for(k=0,kn=0,vx=0,vy=0,Dx=0,Dy=0;k<3;k++)
 			{
@@ -1050,7 +1278,19 @@ void HSolver::SortNodes (std::vector<int> newnum)
     }
 }
 
-bool HSolver::handleToken(const string &token, istream &input, ostream &err)
+// NodeCoordinates: copies the mesh node positions for the space filling curve orderings
+void HSolver::NodeCoordinates (std::vector<double> &x, std::vector<double> &y) const
+{
+    x.resize(NumNodes);
+    y.resize(NumNodes);
+    for(int i = 0; i < NumNodes; i++)
+    {
+        x[i] = meshnode[i].x;
+        y[i] = meshnode[i].y;
+    }
+}
+
+bool HSolver::handleToken(const string &token, femm::Lexer &input, ostream &err)
 {
     if( token == "[dt]" )
     {
@@ -44,7 +44,9 @@
 #include "CMaterialProp.h"
 #include "CPointProp.h"
 
+#include <memory>
 #include <string>
+#include <vector>
 
 class HSolver : public FEASolver<
         femm::CHPointProp
@@ -65,11 +67,23 @@ public:
 
     // General problem attributes
     double	dT; ///< \brief delta T used by hsolver \verbatim[dT]\endverbatim
+    /**
+     * \brief Keep the assembled system of linear transient problems between solveMesh() calls.
+     * As long as #dT does not change, every solve after the first one
+     * only updates the heat capacity term of the right hand side instead of assembling the elements again.
+     */
+    bool reuseAssembly;
+    /**
+     * \brief Largest temperature change per time step for solveTimeStep(), or 0 for a fixed time step.
+     * Nodes with a prescribed temperature, a point property or in a conductor are not checked.
+     */
+    double maxStepChange;
 
     // mesh information
     femm::CNode *meshnode;
 
     // Vector containing previous solution for time-transient analysis, only valid when dT!=0
+    // After a transient solveMesh() call, it holds that solution, so that the next call solves the next time step.
 	double *Tprev;
 
 
@@ -81,19 +95,74 @@ public:
     bool LoadProblemFile();
     double ChargeOnConductor(int OnConductor, CBigLinProb &L);
 	int WriteResults(CBigLinProb &L);
+    /**
+     * @brief Store the solution in #solution.
+     * The stored data is the same that WriteResults() writes to the solution file.
+     * @param L
+     * @return \c true on success, \c false otherwise.
+     */
+    bool StoreResults(CBigLinProb &L);
     int AnalyzeProblem(CBigLinProb &L);
     int (*WarnMessage)(const char*, ...);
 
     virtual bool runSolver(bool verbose=false) override;
+
+    /**
+     * @brief Load the mesh and the previous solution, and renumber the nodes.
+     * runSolver() calls this before solving.
+     * A transient run calls it only once, and then solveTimeStep() for every time step.
+     * @param verbose
+     * @return \c true on success, \c false otherwise.
+     */
+    bool prepareMesh(bool verbose=false);
+    /**
+     * @brief Solve the problem on the mesh loaded by prepareMesh().
+     * @param verbose
+     * @return \c true on success, \c false otherwise.
+     */
+    bool solveMesh(bool verbose=false);
+    /**
+     * @brief Solve the next time step of a transient problem.
+     * If #maxStepChange is set and a temperature changes by more than that,
+     * the step is repeated with half the time step.
+     * If all temperatures change by less than a quarter of it, #dT is doubled for the next step.
+     * @param verbose
+     * @return the length of the time step that was solved, or 0 if the solver failed
+     */
+    double solveTimeStep(bool verbose=false);
 private:
 
+    /// The assembled system of a linear transient problem, see #reuseAssembly.
+    struct TransientAssembly
+    {
+        double dT = 0;                  ///< time step the matrix was assembled for
+        std::vector<double> rhs;        ///< right hand side without the heat capacity term
+        std::vector<double> capacity;   ///< lumped heat capacity of each node, divided by dT
+        std::vector<int> row;           ///< equation that gets the heat capacity term of each node
+        std::vector<int> fixedRows;     ///< conductor equations whose right hand side does not depend on the nodes
+    };
+
     void MsgBox(const char* message);
     void CleanUp() override;
 
-    // override parent class virtual method
+    /// Check whether the system is linear, so that the matrix does not depend on the solution.
+    bool isTransientAssemblyReusable() const;
+    /// Assemble and solve the system of equations, and update #Tprev for transient problems.
+    bool solveSystem(bool verbose);
+    /// Set the right hand side from the stored assembly and #Tprev.
+    void restoreTransientAssembly(CBigLinProb &L) const;
+    /// Write the solution to #solution, the solution file, and the solution archive, as configured.
+    bool storeSolution(CBigLinProb &L, bool verbose);
+
+    /// System of equations of the last solveMesh() call, kept between calls if #reuseAssembly is set
+    std::unique_ptr<CBigLinProb> linearSystem;
+    TransientAssembly transientAssembly;
+
+    // override parent class virtual methods
     void SortNodes (std::vector<int> newnum) override;
+    void NodeCoordinates (std::vector<double> &x, std::vector<double> &y) const override;
 
-    virtual bool handleToken(const std::string &token, std::istream &input, std::ostream &err) override;
+    virtual bool handleToken(const std::string &token, femm::Lexer &input, std::ostream &err) override;
 
 };
 
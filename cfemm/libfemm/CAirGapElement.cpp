@@ -20,12 +20,26 @@
 */
 #include "CAirGapElement.h"
 
+#include "femmconstants.h"
 #include "stringTools.h"
 
+#include <algorithm>
+#include <cmath>
 #include <istream>
 #include <sstream>
 
+using femm::CQuadPoint;
 using femm::trim;
+
+namespace {
+
+/// \brief Angle of a complex number in degrees, in the range [0,360)
+double toDegrees(const CComplex &x)
+{
+    return ((Im(x)>=0) ? arg(x) : (arg(x) + 2.*PI))*(180./PI);
+}
+
+} // anonymous namespace
 
 
 femmsolver::CAirGapElement::~CAirGapElement()
@@ -52,6 +66,73 @@ std::unique_ptr<femmsolver::CAirGapElement> femmsolver::CAirGapElement::clone()
     return std::unique_ptr<femmsolver::CAirGapElement>(new femmsolver::CAirGapElement(*this));
 }
 
+bool femmsolver::CAirGapElement::mapRingNodes(const std::vector<CComplex> &nodePos)
+{
+    const int n = (int)nodeNums.size()/2; // nodes per ring
+    if (n==0 || nodePos.size()!=nodeNums.size() || totalArcLength<=0)
+        return false;
+
+    const double dtta = totalArcLength/n;
+    const int n0 = (int) round(360./dtta); // total elements in a 360deg annular ring;
+    const int n1 = (int) round(360./totalArcLength); // number of copied segments
+    if (n0 != n*n1)
+        return false;
+
+    std::vector<CQuadPoint> InnerRing(n0);
+    std::vector<CQuadPoint> OuterRing(n0);
+
+    // map each bdry point onto points on the ring;
+    for(int j=0,kk=0; j<n1; j++)  // do each slice
+    {
+        double dL = 1;
+        if ((BdryFormat==1) && (j % 2 != 0)) dL=-1; // antiperiodic
+
+        const CComplex a1=exp(I*(j*totalArcLength+InnerAngle)*DEGREE);
+        const CComplex a2=exp(I*(j*totalArcLength+OuterAngle)*DEGREE);
+        for(int i=0; i<n; i++, kk++)
+        {
+            // position of the shifted mesh node
+            InnerRing[kk].n0=nodeNums[i];
+            InnerRing[kk].w0=toDegrees(a1*(nodePos[i]-agc))/dtta;
+            InnerRing[kk].w1=dL;
+
+            OuterRing[kk].n0=nodeNums[i+n];
+            OuterRing[kk].w0=toDegrees(a2*(nodePos[i+n]-agc))/dtta;
+            OuterRing[kk].w1=dL;
+        }
+    }
+
+    // InnerRing and OuterRing contain a list of boundary nodes, but the aren't yet properly sorted.
+    // Sort out the rings based on the angle of the points in the ring
+    auto byAngle = [](const CQuadPoint &a, const CQuadPoint &b) { return a.w0 < b.w0; };
+    std::stable_sort(InnerRing.begin(), InnerRing.end(), byAngle);
+    std::stable_sort(OuterRing.begin(), OuterRing.end(), byAngle);
+
+    totalArcElements = n;
+    InnerShift = InnerRing[0].w0;
+    OuterShift = OuterRing[0].w0;
+
+    quadNode.clear();
+    quadNode.reserve(n+1);
+    for(int i=0; i<=n; i++)
+    {
+        int p0,p1;
+
+        p1=i; if(p1==n0) p1=0;
+        p0=p1-1; if(p0<0) p0=n0+p0;
+
+        // ring points that bracket points in the annulus mesh
+        // and their sign, for the purposes of periodicity/antiperiodicity
+        CQuadPoint qp;
+        qp.n0 = InnerRing[p0].n0; qp.w0 = InnerRing[p0].w1;
+        qp.n1 = InnerRing[p1].n0; qp.w1 = InnerRing[p1].w1;
+        qp.n2 = OuterRing[p0].n0; qp.w2 = OuterRing[p0].w1;
+        qp.n3 = OuterRing[p1].n0; qp.w3 = OuterRing[p1].w1;
+        quadNode.push_back(qp);
+    }
+    return true;
+}
+
 
 //femmsolver::CAirGapElement femmsolver::CMElement::fromStream(std::istream &input, std::ostream &)
 //{
@@ -55,6 +55,15 @@ public:
      */
     std::unique_ptr<femmsolver::CAirGapElement> clone() const;
 
+    /**
+     * @brief Connect the ring nodes to the annular air gap mesh for the current InnerAngle and OuterAngle.
+     * This sets totalArcElements, InnerShift, OuterShift and quadNode from nodeNums.
+     * The triangulation does not depend on the angles, so turning the rotor only requires calling this again.
+     * @param nodePos the position of each node in nodeNums, in the same units as agc
+     * @return \c false, if the ring nodes don't form an air gap element that spans a fraction of a full circle.
+     */
+    bool mapRingNodes(const std::vector<CComplex> &nodePos);
+
 //    /**
 //     * @brief fromStream constructs a CAirGapElement from an input stream (usually an input file stream)
 //     * @param input
@@ -75,7 +84,7 @@ public:
     double OuterShift;///< fraction of an element that outer mesh is shifted relative to annular mesh
     CComplex agc; ///< centre of the air gap element
     std::vector <femm::CQuadPoint> quadNode; ///< quad nodes that are part of the air gap element (was called 'qp' in FEMM)
-    std::vector <int> nodeNums; ///< node numbers that are part of the air gap element (was called 'node' in FEMM)
+    std::vector <int> nodeNums; ///< node numbers of the inner ring, followed by the node numbers of the outer ring (was called 'node' in FEMM)
 
     int nn; ///< number of harmonics in harmonic problem
     CComplex aco;
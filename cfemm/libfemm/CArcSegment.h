@@ -60,6 +60,10 @@ class CArcSegment : public CSegment
 public:
     CArcSegment();
 
+    /// Arc segments are allocated from the EntityPool of their class.
+    static void *operator new(std::size_t size) { return EntityPool<CArcSegment>::allocate(size); }
+    static void operator delete(void *p, std::size_t size) { EntityPool<CArcSegment>::deallocate(p, size); }
+
     double ArcLength; ///< arc angle [deg]
     bool NormalDirection; ///< mesher-specific property
     double mySideLength; ///< actual meshed length (used in FEMM for visualisation)
@@ -32,6 +32,7 @@
 #ifndef FEMM_CBLOCKLABEL_H
 #define FEMM_CBLOCKLABEL_H
 
+#include "EntityPool.h"
 #include "FemmProblem.h"
 #include "femmcomplex.h"
 #include <iostream>
@@ -155,6 +156,10 @@ class CMBlockLabel : public CBlockLabel
 public:
     CMBlockLabel();
 
+    /// Block labels are allocated from the EntityPool of their class.
+    static void *operator new(std::size_t size) { return EntityPool<CMBlockLabel>::allocate(size); }
+    static void operator delete(void *p, std::size_t size) { EntityPool<CMBlockLabel>::deallocate(p, size); }
+
     //---- fsolver attributes:
     // used for proximity effect regions only.
     CComplex ProximityMu;
@@ -191,6 +196,10 @@ class CHBlockLabel : public CBlockLabel
 public:
     CHBlockLabel();
 
+    /// Block labels are allocated from the EntityPool of their class.
+    static void *operator new(std::size_t size) { return EntityPool<CHBlockLabel>::allocate(size); }
+    static void operator delete(void *p, std::size_t size) { EntityPool<CHBlockLabel>::deallocate(p, size); }
+
     /**
      * @brief fromStream constructs a CHBlockLabel from an input stream (usually an input file stream)
      * @param input
@@ -213,6 +222,10 @@ class CSBlockLabel : public CBlockLabel
 public:
     CSBlockLabel();
 
+    /// Block labels are allocated from the EntityPool of their class.
+    static void *operator new(std::size_t size) { return EntityPool<CSBlockLabel>::allocate(size); }
+    static void operator delete(void *p, std::size_t size) { EntityPool<CSBlockLabel>::deallocate(p, size); }
+
     /**
      * @brief fromStream constructs a CSBlockLabel from an input stream (usually an input file stream)
      * @param input
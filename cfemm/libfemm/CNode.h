@@ -27,6 +27,7 @@
 #ifndef FEMM_CNODE_H
 #define FEMM_CNODE_H
 
+#include "EntityPool.h"
 #include "femmcomplex.h"
 #include <iostream>
 #include <memory>
@@ -69,6 +70,10 @@ public:
     CNode(double x, double y);
     virtual ~CNode();
 
+    /// Nodes are allocated from the EntityPool of their class.
+    static void *operator new(std::size_t size) { return EntityPool<CNode>::allocate(size); }
+    static void operator delete(void *p, std::size_t size) { EntityPool<CNode>::deallocate(p, size); }
+
     double x; ///< \brief x x-position of the point or r (axisymmetric)
     double y; ///< \brief x x-position of the point or r (axisymmetric)
     int InGroup;
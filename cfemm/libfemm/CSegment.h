@@ -27,6 +27,7 @@
 #ifndef FEMM_CSEGMENT_H
 #define FEMM_CSEGMENT_H
 
+#include "EntityPool.h"
 #include <memory>
 #include <string>
 
@@ -52,6 +53,10 @@ class CSegment
 public:
     CSegment();
 
+    /// Segments are allocated from the EntityPool of their class.
+    static void *operator new(std::size_t size) { return EntityPool<CSegment>::allocate(size); }
+    static void operator delete(void *p, std::size_t size) { EntityPool<CSegment>::deallocate(p, size); }
+
     // start and end points:
     int n0,n1;
     double MaxSideLength; ///< mesh size factor
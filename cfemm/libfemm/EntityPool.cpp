@@ -0,0 +1,85 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "EntityPool.h"
+
+#include <algorithm>
+#include <cstddef>
+
+using namespace femm;
+
+namespace {
+
+/// objects and their headers are aligned like memory from ::operator new
+constexpr std::size_t Alignment = alignof(std::max_align_t);
+/// the header in front of each object holds the owning pool
+constexpr std::size_t HeaderSize = (sizeof(SlabPool*) + Alignment - 1) / Alignment * Alignment;
+constexpr std::size_t SlabSize = 64*1024;
+
+} // namespace
+
+SlabPool::SlabPool(std::size_t size)
+    : slotSize(HeaderSize + (size + Alignment - 1) / Alignment * Alignment)
+{
+}
+
+SlabPool::~SlabPool()
+{
+    for (char *slab : slabs)
+        ::operator delete(slab);
+}
+
+void *SlabPool::allocate()
+{
+    if (freeList == nullptr)
+        freeList = returned.exchange(nullptr, std::memory_order_acquire);
+
+    char *slot;
+    if (freeList)
+    {
+        slot = reinterpret_cast<char*>(freeList) - HeaderSize;
+        freeList = freeList->next;
+    } else {
+        if (next == nullptr || next + slotSize > end)
+        {
+            std::size_t slabSize = std::max(SlabSize, slotSize);
+            slabs.reserve(slabs.size()+1);
+            next = static_cast<char*>(::operator new(slabSize));
+            end = next + slabSize;
+            slabs.push_back(next);
+        }
+        slot = next;
+        next += slotSize;
+        *reinterpret_cast<SlabPool**>(slot) = this;
+    }
+    references.fetch_add(1, std::memory_order_relaxed);
+    return slot + HeaderSize;
+}
+
+void SlabPool::deallocate(void *p)
+{
+    SlabPool *pool = *reinterpret_cast<SlabPool**>(static_cast<char*>(p) - HeaderSize);
+    FreeObject *obj = static_cast<FreeObject*>(p);
+    obj->next = pool->returned.load(std::memory_order_relaxed);
+    while (!pool->returned.compare_exchange_weak(obj->next, obj,
+                                                 std::memory_order_release, std::memory_order_relaxed))
+    {}
+    pool->unref();
+}
+
+void SlabPool::release()
+{
+    unref();
+}
+
+void SlabPool::unref()
+{
+    if (references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete this;
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
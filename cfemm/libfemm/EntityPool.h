@@ -0,0 +1,130 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FEMM_ENTITYPOOL_H
+#define FEMM_ENTITYPOOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace femm {
+
+/**
+ * @brief The SlabPool class hands out objects of one size from contiguous slabs.
+ *
+ * A SlabPool belongs to the thread that created it, and only that thread allocates from it.
+ * Every object is preceded by a pointer to its pool, so that any thread can free it:
+ * freed objects are pushed onto a lock free list, which the owning thread takes over
+ * as a whole when it runs out of memory.
+ * The pool is destroyed when its owning thread has released it and all of its objects have been freed.
+ */
+class SlabPool
+{
+public:
+    /**
+     * @brief Create a pool that is owned by the calling thread.
+     * @param size the size of the objects
+     */
+    explicit SlabPool(std::size_t size);
+    /**
+     * @brief Allocate an object. Must only be called by the owning thread.
+     * @return the memory, aligned like memory from ::operator new
+     */
+    void *allocate();
+    /**
+     * @brief Free an object that was returned by allocate(). May be called by any thread.
+     * @param p the object
+     */
+    static void deallocate(void *p);
+    /**
+     * @brief Called by the owning thread when it does not allocate any more.
+     */
+    void release();
+
+private:
+    ~SlabPool();
+    SlabPool(const SlabPool &) = delete;
+    SlabPool &operator=(const SlabPool &) = delete;
+
+    /// Drop one reference, and delete the pool if it was the last one.
+    void unref();
+
+    struct FreeObject
+    {
+        FreeObject *next;
+    };
+
+    std::size_t slotSize;     ///< size of an object plus its header
+    std::vector<char*> slabs;
+    char *next = nullptr;     ///< unused rest of the newest slab
+    char *end = nullptr;
+    FreeObject *freeList = nullptr;            ///< only used by the owning thread
+    std::atomic<FreeObject*> returned {nullptr}; ///< objects freed since the last refill of freeList
+    std::atomic<std::size_t> references {1};   ///< live objects, plus one for the owning thread
+};
+
+/**
+ * @brief The EntityPool class allocates the objects of one concrete geometry entity class.
+ *
+ * A FemmProblem keeps its nodes, segments, arc segments and block labels
+ * in lists of std::unique_ptr, i.e. every entity is a heap allocation of its own.
+ * These classes allocate their objects from the EntityPool of their own class
+ * (by a class specific operator new and operator delete),
+ * so that entities that are created one after the other are also next to each other in memory,
+ * and loops over the entity lists do not jump around the heap.
+ *
+ * Each thread allocates from a SlabPool of its own, so that no lock is needed.
+ * Objects of a different size (i.e. of a derived class that does not declare its own operator new)
+ * are passed on to the global operator new and operator delete.
+ */
+template <class T>
+class EntityPool
+{
+public:
+    /**
+     * @brief Allocate memory for an object.
+     * @param size the size of the object
+     * @return the memory, aligned like memory from ::operator new
+     */
+    static void *allocate(std::size_t size)
+    {
+        if (size != sizeof(T))
+            return ::operator new(size);
+        thread_local Owner owner;
+        return owner.pool->allocate();
+    }
+    /**
+     * @brief Free memory that was returned by allocate().
+     * @param p the memory, or \c nullptr
+     * @param size the size that was passed to allocate()
+     */
+    static void deallocate(void *p, std::size_t size)
+    {
+        if (p == nullptr)
+            return;
+        if (size != sizeof(T))
+            ::operator delete(p);
+        else
+            SlabPool::deallocate(p);
+    }
+
+private:
+    /// The pool of the current thread, released at thread exit.
+    struct Owner
+    {
+        Owner() : pool(new SlabPool(sizeof(T))) {}
+        ~Owner() { pool->release(); }
+        SlabPool *pool;
+    };
+};
+
+} // namespace femm
+
+#endif
+// vi:expandtab:tabstop=4 shiftwidth=4:
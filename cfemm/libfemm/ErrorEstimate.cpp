@@ -0,0 +1,149 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "ErrorEstimate.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <utility>
+
+using namespace femm;
+
+ErrorEstimate::ErrorEstimate(const MeshData &mesh, const SolutionData &solution, const std::vector<int> &nodeNumbering,
+                             const std::vector<CComplex> &coefficients)
+{
+    const int numElements = mesh.numElements();
+    elementError.assign(numElements, 0.);
+    elementArea.assign(numElements, 0.);
+
+    // the element of the solution that has the same nodes as each element of the mesh
+    std::vector<int> solutionElement;
+    if (!coefficients.empty())
+    {
+        std::map<std::array<int,3>, int> elementByNodes;
+        for (int i=0; i<solution.numElements(); i++)
+        {
+            std::array<int,3> nodes {{ solution.elements[3*i], solution.elements[3*i+1], solution.elements[3*i+2] }};
+            std::sort(nodes.begin(), nodes.end());
+            elementByNodes.emplace(nodes, i);
+        }
+        solutionElement.assign(numElements, -1);
+        for (int i=0; i<numElements; i++)
+        {
+            std::array<int,3> nodes;
+            for (int j=0; j<3; j++)
+            {
+                int n = mesh.elements[3*i+j];
+                nodes[j] = nodeNumbering.empty() ? n : nodeNumbering[n];
+            }
+            std::sort(nodes.begin(), nodes.end());
+            auto it = elementByNodes.find(nodes);
+            if (it != elementByNodes.end())
+                solutionElement[i] = it->second;
+        }
+    }
+
+    // flux (x and y component) in each element
+    std::vector<CComplex> flux(2*numElements);
+    for (int i=0; i<numElements; i++)
+    {
+        double x[3], y[3];
+        CComplex u[3];
+        for (int j=0; j<3; j++)
+        {
+            int n = mesh.elements[3*i+j];
+            x[j] = mesh.nodeX[n];
+            y[j] = mesh.nodeY[n];
+            u[j] = solution.nodeValue[nodeNumbering.empty() ? n : nodeNumbering[n]];
+        }
+        double det = (x[1]-x[0])*(y[2]-y[0]) - (x[2]-x[0])*(y[1]-y[0]);
+        elementArea[i] = std::fabs(det)/2;
+        if (det == 0)
+            continue;
+        CComplex *f = &flux[2*i];
+        for (int j=0; j<3; j++)
+        {
+            int k = (j+1)%3;
+            int l = (j+2)%3;
+            f[0] += u[j] * ((y[k]-y[l])/det);
+            f[1] += u[j] * ((x[l]-x[k])/det);
+        }
+        if (!coefficients.empty() && solutionElement[i] >= 0)
+        {
+            f[0] *= coefficients[2*solutionElement[i]];
+            f[1] *= coefficients[2*solutionElement[i]+1];
+        }
+        norm += elementArea[i] * (f[0].re*f[0].re + f[0].im*f[0].im + f[1].re*f[1].re + f[1].im*f[1].im);
+    }
+    norm = std::sqrt(norm);
+
+    // pair up the elements at each edge
+    std::map<std::pair<int,int>, int> firstElement;
+    for (int i=0; i<numElements; i++)
+    {
+        for (int j=0; j<3; j++)
+        {
+            int n0 = mesh.elements[3*i+j];
+            int n1 = mesh.elements[3*i+(j+1)%3];
+            auto side = std::make_pair(std::min(n0,n1), std::max(n0,n1));
+            auto it = firstElement.find(side);
+            if (it == firstElement.end())
+            {
+                firstElement.emplace(side, i);
+                continue;
+            }
+            int k = it->second;
+            firstElement.erase(it);
+
+            // jump of the normal flux times the edge length, (dy,-dx) being the normal scaled by the edge length
+            double dx = mesh.nodeX[n1] - mesh.nodeX[n0];
+            double dy = mesh.nodeY[n1] - mesh.nodeY[n0];
+            CComplex jump = (flux[2*i]-flux[2*k])*dy - (flux[2*i+1]-flux[2*k+1])*dx;
+            double edgeError = jump.re*jump.re + jump.im*jump.im;
+            error += edgeError;
+            elementError[i] += edgeError/2;
+            elementError[k] += edgeError/2;
+        }
+    }
+
+    for (double &e: elementError)
+        e = std::sqrt(e);
+    error = std::sqrt(error);
+}
+
+double ErrorEstimate::relativeError() const
+{
+    if (norm == 0)
+        return 0;
+    return error / norm;
+}
+
+std::vector<double> ErrorEstimate::refinementAreas(double fraction) const
+{
+    std::vector<int> order(elementError.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        return elementError[a] > elementError[b];
+    });
+
+    std::vector<double> maxArea(elementError.size(), -1.);
+    const double target = fraction * error * error;
+    double marked = 0;
+    for (int i: order)
+    {
+        if (marked >= target || elementError[i] == 0)
+            break;
+        marked += elementError[i] * elementError[i];
+        maxArea[i] = elementArea[i] / 4;
+    }
+    return maxArea;
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
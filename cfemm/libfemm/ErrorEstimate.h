@@ -0,0 +1,73 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FEMM_ERRORESTIMATE_H
+#define FEMM_ERRORESTIMATE_H
+
+#include "MeshData.h"
+#include "SolutionData.h"
+
+#include <vector>
+
+namespace femm {
+
+/**
+ * @brief The ErrorEstimate class estimates the discretization error of a solution for adaptive mesh refinement.
+ *
+ * The solution is piecewise linear, so its gradient is constant in every element and jumps across the element edges.
+ * The flux is the gradient times the material coefficient of the element,
+ * i.e. nu*grad(A) for magnetics, epsilon*grad(V) for electrostatics and k*grad(T) for heat flow problems.
+ * Its normal component is continuous in the exact solution, also at material boundaries.
+ * The error of an edge is the squared jump of the normal flux across it, weighted by the squared edge length.
+ * Each edge counts once towards the global error, and is split evenly between the indicators of its two elements.
+ * Edges on the mesh boundary are skipped.
+ *
+ * ## References
+ *  - D. W. Kelly, J. P. De S. R. Gago, O. C. Zienkiewicz, I. Babuska:
+ *    A posteriori error analysis and adaptive processes in the finite element method,
+ *    Int. J. Numer. Meth. Eng. 19(11), 1983.
+ *  - W. Dörfler: A convergent adaptive algorithm for Poisson's equation, SIAM J. Numer. Anal. 33(3), 1996.
+ */
+class ErrorEstimate
+{
+public:
+    /**
+     * @brief Estimate the error of a solution on a mesh.
+     * @param mesh the mesh, as created by the mesher
+     * @param solution the solution computed on \p mesh
+     * @param nodeNumbering the number in \p solution of each node of \p mesh (as assigned by the node renumbering of the solver),
+     * or an empty vector if the solver did not renumber the nodes
+     * @param coefficients two coefficients per element of \p solution (in the element order of the solution),
+     * by which the x and the y component of the gradient are multiplied to get the flux,
+     * or an empty vector if the flux is the gradient
+     */
+    ErrorEstimate(const MeshData &mesh, const SolutionData &solution, const std::vector<int> &nodeNumbering,
+                  const std::vector<CComplex> &coefficients = std::vector<CComplex>());
+
+    std::vector<double> elementError; ///< \brief error indicator of each element of the mesh
+    std::vector<double> elementArea; ///< \brief area of each element of the mesh
+    double error = 0; ///< \brief square root of the sum of the squared edge errors
+    double norm = 0; ///< \brief L2 norm of the flux
+
+    /**
+     * @brief Get the estimated error relative to the solution.
+     * @return error / norm, or 0 if the solution is zero everywhere
+     */
+    double relativeError() const;
+
+    /**
+     * @brief Mark the elements that are refined.
+     * The elements with the largest indicators are marked until they make up \p fraction of the squared estimated error.
+     * @param fraction a value between 0 and 1
+     * @return the maximum area of each element: a quarter of its area for marked elements, and -1 (no constraint) otherwise
+     */
+    std::vector<double> refinementAreas(double fraction) const;
+};
+
+} //namespace
+#endif
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -110,9 +110,29 @@ void femm::FemmProblem::writeProblemDescription(std::ostream &output) const
     {
         output.width(12);
         output << "[ACSolver]" << "  =  " << ACSolver <<"\n";
+        if (ACSolver==2)
+        {
+            output.width(12);
+            output << "[GMRESRestart]" << "  =  " << GMRESRestart <<"\n";
+        }
     }
 
 
+    if (FloatPreconditioner)
+    {
+        output << "[FloatPreconditioner]" << "  =  " << FloatPreconditioner << "\n";
+    }
+
+    if (NodeOrdering != 0)
+    {
+        output << "[NodeOrdering]" << "  =  " << NodeOrdering << "\n";
+    }
+
+    if (ElementOrdering != 0)
+    {
+        output << "[ElementOrdering]" << "  =  " << ElementOrdering << "\n";
+    }
+
     output.width(12);
     output << "[PrevSoln]" << "  = \"" << previousSolutionFile << "\"\n";
 
@@ -328,13 +348,29 @@ void femm::FemmProblem::updateNodeMap()
 }
 
 bool femm::FemmProblem::addArcSegment(femm::CArcSegment &asegm, double tol)
+{
+    if (!insertArcSegment(asegm, tol))
+        return false;
+    unselectAll();
+    return true;
+}
+
+bool femm::FemmProblem::insertArcSegment(femm::CArcSegment &asegm, double tol)
 {
     // don't add if line is degenerate
     if (asegm.n0==asegm.n1)
         return false;
 
+    // the arc can only cross or duplicate items that are close to it,
+    // so that only those have to be tested
+    double t = (tol==0) ? defaultTolerance() : tol;
+    std::vector<int> near;
+    geometryIndex.sync(*this);
+
     // don't add if the arc is already in the list;
-    for(int i=0; i<(int)arclist.size(); i++){
+    const CNode &start = *nodelist[asegm.n0];
+    geometryIndex.candidates(GeometryIndex::ArcSegments, start.x, start.y, start.x, start.y, near);
+    for(int i : near){
         if ((arclist[i]->n0==asegm.n0) && (arclist[i]->n1==asegm.n1) &&
                 (fabs(arclist[i]->ArcLength-asegm.ArcLength)<1.e-02)) return false;
         // arcs are ``the same'' if start and end points are the same, and if
@@ -348,14 +384,16 @@ bool femm::FemmProblem::addArcSegment(femm::CArcSegment &asegm, double tol)
     CComplex p[2];
     std::vector < CComplex > newnodes;
     // check to see if there are intersections
-    for(int i=0; i<(int)linelist.size(); i++)
+    geometryIndex.candidatesNear(GeometryIndex::Segments, *this, asegm, t, near);
+    for(int i : near)
     {
         int j = getLineArcIntersection(*linelist[i],asegm,p);
         if (j>0)
             for(int k=0; k<j; k++)
                 newnodes.push_back(p[k]);
     }
-    for (int i=0; i<(int)arclist.size(); i++)
+    geometryIndex.candidatesNear(GeometryIndex::ArcSegments, *this, asegm, t, near);
+    for (int i : near)
     {
         int j = getArcArcIntersection(asegm,*arclist[i],p);
         if (j>0)
@@ -364,26 +402,6 @@ bool femm::FemmProblem::addArcSegment(femm::CArcSegment &asegm, double tol)
     }
 
     // add nodes at intersections
-    double t;
-    if (tol==0)
-    {
-        if (nodelist.size()<2) t=1.e-08;
-        else{
-            CComplex p0,p1;
-            p0 = nodelist[0]->CC();
-            p1 = p0;
-            for (int i=1; i<(int)nodelist.size(); i++)
-            {
-                if(nodelist[i]->x<p0.re) p0.re = nodelist[i]->x;
-                if(nodelist[i]->x>p1.re) p1.re = nodelist[i]->x;
-                if(nodelist[i]->y<p0.im) p0.im = nodelist[i]->y;
-                if(nodelist[i]->y>p1.im) p1.im = nodelist[i]->y;
-            }
-            t = abs(p1-p0)*CLOSE_ENOUGH;
-        }
-    }
-    else t = tol;
-
     for (int i=0; i<(int)newnodes.size(); i++)
         addNode(newnodes[i].re,newnodes[i].im,t);
 
@@ -393,8 +411,6 @@ bool femm::FemmProblem::addArcSegment(femm::CArcSegment &asegm, double tol)
     // check to see if proposed arc passes through other points;
     // if so, delete arc and create arcs that link intermediate points;
     // does this by recursive use of AddArcSegment;
-
-    unselectAll();
     CComplex c;
     double R;
     getCircle(asegm,c,R);
@@ -404,7 +420,9 @@ bool femm::FemmProblem::addArcSegment(femm::CArcSegment &asegm, double tol)
         dmin = fabs(R*PI*asegm.ArcLength/180.)*1.e-05;
 
     int k = (int)arclist.size()-1;
-    for(int i=0; i<(int)nodelist.size(); i++)
+    geometryIndex.sync(*this);
+    geometryIndex.candidatesNear(GeometryIndex::Nodes, GeometryIndex::ArcSegments, k, dmin, near);
+    for(int i : near)
     {
         if( (i!=asegm.n0) && (i!=asegm.n1) )
         {
@@ -422,20 +440,21 @@ bool femm::FemmProblem::addArcSegment(femm::CArcSegment &asegm, double tol)
                 a0.Set(nodelist[asegm.n0]->x,nodelist[asegm.n0]->y);
                 a1.Set(nodelist[asegm.n1]->x,nodelist[asegm.n1]->y);
                 a2.Set(nodelist[i]->x,nodelist[i]->y);
-                arclist[k]->ToggleSelect();
-                deleteSelectedArcSegments();
+                // the proposed arc is the last one, drop it
+                undoArcJournal.truncate(arclist, k);
+                geometryIndex.truncate(GeometryIndex::ArcSegments, k);
 
                 CArcSegment newarc = asegm;
                 newarc.n1 = i;
                 newarc.ArcLength = arg((a2-c)/(a0-c))*180./PI;
-                addArcSegment(newarc,dmin);
+                insertArcSegment(newarc,dmin);
 
                 newarc = asegm;
                 newarc.n0 = i;
                 newarc.ArcLength = arg((a1-c)/(a2-c))*180./PI;
-                addArcSegment(newarc,dmin);
+                insertArcSegment(newarc,dmin);
 
-                i = nodelist.size();
+                break;
             }
         }
     }
@@ -470,18 +489,23 @@ bool femm::FemmProblem::addBlockLabel(std::unique_ptr<femm::CBlockLabel> &&label
 {
     double x = label->x;
     double y = label->y;
+    std::vector<int> near;
+    geometryIndex.sync(*this);
 
     // can't put a block label on top of an existing node...
-    for (int i=0; i<(int)nodelist.size(); i++)
+    geometryIndex.candidates(GeometryIndex::Nodes, x-d, y-d, x+d, y+d, near);
+    for (int i : near)
         if(nodelist[i]->GetDistance(x,y)<d) return false;
 
     // can't put a block label on a line, either...
-    for (int i=0; i<(int)linelist.size(); i++)
+    geometryIndex.candidates(GeometryIndex::Segments, x-d, y-d, x+d, y+d, near);
+    for (int i : near)
         if(shortestDistanceFromSegment(x,y,i)<d) return false;
 
     // test to see if ``too close'' to existing node...
     bool exists=false;
-    for (int i=0; i<(int)labellist.size(); i++)
+    geometryIndex.candidates(GeometryIndex::BlockLabels, x-d, y-d, x+d, y+d, near);
+    for (int i : near)
         if(labellist[i]->GetDistance(x,y)<d) {
             exists=true;
             break;
@@ -510,13 +534,17 @@ bool femm::FemmProblem::addNode(std::unique_ptr<femm::CNode> &&node, double d)
     double R;
     double x = node->x;
     double y = node->y;
+    std::vector<int> near;
+    geometryIndex.sync(*this);
 
     // test to see if ``too close'' to existing node...
-    for (int i=0; i<(int)nodelist.size(); i++)
+    geometryIndex.candidates(GeometryIndex::Nodes, x-d, y-d, x+d, y+d, near);
+    for (int i : near)
         if(nodelist[i]->GetDistance(x,y)<d) return false;
 
     // can't put a node on top of a block label; do same sort of test.
-    for (int i=0;i<(int)labellist.size();i++)
+    geometryIndex.candidates(GeometryIndex::BlockLabels, x-d, y-d, x+d, y+d, near);
+    for (int i : near)
         if(labellist[i]->GetDistance(x,y)<d) return false;
 
     // if all is OK, add point in to the node list...
@@ -524,13 +552,15 @@ bool femm::FemmProblem::addNode(std::unique_ptr<femm::CNode> &&node, double d)
 
     // test to see if node is on an existing line; if so,
     // break into two lines;
-
-    for(int i=0, k=(int)linelist.size(); i<k; i++)
+    // (the existing lines only shrink, so their index entries remain valid)
+    geometryIndex.candidates(GeometryIndex::Segments, x-d, y-d, x+d, y+d, near);
+    for(int i : near)
     {
         if (fabs(shortestDistanceFromSegment(x,y,i))<d)
         {
             std::unique_ptr<CSegment> segm;
             segm = linelist[i]->clone();
+            undoLineJournal.change(linelist, i);
             linelist[i]->n1=nodelist.size()-1;
             segm->n0=nodelist.size()-1;
             linelist.push_back(std::move(segm));
@@ -539,7 +569,8 @@ bool femm::FemmProblem::addNode(std::unique_ptr<femm::CNode> &&node, double d)
 
     // test to see if node is on an existing arc; if so,
     // break into two arcs;
-    for(int i=0, k=(int)arclist.size(); i<k; i++)
+    geometryIndex.candidates(GeometryIndex::ArcSegments, x-d, y-d, x+d, y+d, near);
+    for(int i : near)
     {
         if (shortestDistanceFromArc(CComplex(x,y),*arclist[i])<d)
         {
@@ -550,6 +581,7 @@ bool femm::FemmProblem::addNode(std::unique_ptr<femm::CNode> &&node, double d)
 
             std::unique_ptr<CArcSegment> asegm;
             asegm = MAKE_UNIQUE<CArcSegment>(*arclist[i]);
+            undoArcJournal.change(arclist, i);
             arclist[i]->n1 = nodelist.size()-1;
             arclist[i]->ArcLength = arg((a2-c)/(a0-c))*180./PI;
             asegm->n0 = nodelist.size()-1;
@@ -566,6 +598,14 @@ bool femm::FemmProblem::addSegment(int n0, int n1, double tol)
 }
 
 bool femm::FemmProblem::addSegment(int n0, int n1, const femm::CSegment *parsegm, double tol)
+{
+    if (!insertSegment(n0, n1, parsegm, tol))
+        return false;
+    unselectAll();
+    return true;
+}
+
+bool femm::FemmProblem::insertSegment(int n0, int n1, const femm::CSegment *parsegm, double tol)
 {
     double xi,yi,t;
     CComplex p[2];
@@ -575,8 +615,16 @@ bool femm::FemmProblem::addSegment(int n0, int n1, const femm::CSegment *parsegm
     // don't add if line is degenerate
     if (n0==n1) return false;
 
+    // the line can only cross or duplicate items that are close to it,
+    // so that only those have to be tested
+    t = (tol==0) ? defaultTolerance() : tol;
+    std::vector<int> near;
+    geometryIndex.sync(*this);
+
     // don't add if the line is already in the list;
-    for (int i=0; i<(int)linelist.size(); i++){
+    const CNode &start = *nodelist[n0];
+    geometryIndex.candidates(GeometryIndex::Segments, start.x, start.y, start.x, start.y, near);
+    for (int i : near){
         if ((linelist[i]->n0==n0) && (linelist[i]->n1==n1)) return false;
         if ((linelist[i]->n0==n1) && (linelist[i]->n1==n0)) return false;
     }
@@ -588,11 +636,13 @@ bool femm::FemmProblem::addSegment(int n0, int n1, const femm::CSegment *parsegm
     segm.n0=n0; segm.n1=n1;
 
     // check to see if there are intersections with segments
-    for (int i=0; i<(int)linelist.size(); i++)
+    geometryIndex.candidatesNear(GeometryIndex::Segments, *this, segm, t, near);
+    for (int i : near)
         if(getIntersection(n0,n1,i,&xi,&yi)) newnodes.push_back(CComplex(xi,yi));
 
     // check to see if there are intersections with arcs
-    for (int i=0; i<(int)arclist.size(); i++){
+    geometryIndex.candidatesNear(GeometryIndex::ArcSegments, *this, segm, t, near);
+    for (int i : near){
         int j = getLineArcIntersection(segm,*arclist[i],p);
         if (j>0)
             for(int k=0;k<j;k++)
@@ -600,26 +650,6 @@ bool femm::FemmProblem::addSegment(int n0, int n1, const femm::CSegment *parsegm
     }
 
     // add nodes at intersections
-    if (tol==0)
-    {
-        if (nodelist.size()<2)
-            t = 1.e-08;
-        else{
-            CComplex p0,p1;
-            p0 = nodelist[0]->CC();
-            p1 = p0;
-            for (int i=1; i<(int)nodelist.size(); i++)
-            {
-                if(nodelist[i]->x<p0.re) p0.re=nodelist[i]->x;
-                if(nodelist[i]->x>p1.re) p1.re=nodelist[i]->x;
-                if(nodelist[i]->y<p0.im) p0.im=nodelist[i]->y;
-                if(nodelist[i]->y>p1.im) p1.im=nodelist[i]->y;
-            }
-            t=abs(p1-p0)*CLOSE_ENOUGH;
-        }
-    }
-    else t=tol;
-
     for (int i=0; i<(int)newnodes.size(); i++)
         addNode(newnodes[i].re,newnodes[i].im,t);
 
@@ -630,12 +660,14 @@ bool femm::FemmProblem::addSegment(int n0, int n1, const femm::CSegment *parsegm
     // if so, delete line and create lines that link intermediate points;
     // does this by recursive use of AddSegment;
     double d,dmin;
-    unselectAll();
     if (tol==0)
         dmin = abs(nodelist[n1]->CC()-nodelist[n0]->CC())*1.e-05;
     else dmin = tol;
 
-    for (int i=0, k=linelist.size()-1; i<(int)nodelist.size(); i++)
+    int k = (int)linelist.size()-1;
+    geometryIndex.sync(*this);
+    geometryIndex.candidatesNear(GeometryIndex::Nodes, GeometryIndex::Segments, k, dmin, near);
+    for (int i : near)
     {
         if( (i!=n0) && (i!=n1) )
         {
@@ -643,18 +675,19 @@ bool femm::FemmProblem::addSegment(int n0, int n1, const femm::CSegment *parsegm
             if (abs(nodelist[i]->CC()-nodelist[n0]->CC())<dmin) d=2.*dmin;
             if (abs(nodelist[i]->CC()-nodelist[n1]->CC())<dmin) d=2.*dmin;
             if (d<dmin){
-                linelist[k]->ToggleSelect();
-                deleteSelectedSegments();
+                // the proposed line is the last one, drop it
+                undoLineJournal.truncate(linelist, k);
+                geometryIndex.truncate(GeometryIndex::Segments, k);
                 if(parsegm==NULL)
                 {
-                    addSegment(n0,i,dmin);
-                    addSegment(i,n1,dmin);
+                    insertSegment(n0,i,nullptr,dmin);
+                    insertSegment(i,n1,nullptr,dmin);
                 }
                 else{
-                    addSegment(n0,i,&segm,dmin);
-                    addSegment(i,n1,&segm,dmin);
+                    insertSegment(n0,i,&segm,dmin);
+                    insertSegment(i,n1,&segm,dmin);
                 }
-                i=nodelist.size();
+                break;
             }
         }
     }
@@ -664,13 +697,17 @@ bool femm::FemmProblem::addSegment(int n0, int n1, const femm::CSegment *parsegm
 
 void femm::FemmProblem::clearNotationTags()
 {
-    for (auto &line : linelist)
+    for (int i=0; i<(int)linelist.size(); i++)
     {
-        line->cnt = 0;
+        if (linelist[i]->cnt != 0)
+            undoLineJournal.change(linelist, i);
+        linelist[i]->cnt = 0;
     }
-    for (auto &arc : arclist)
+    for (int i=0; i<(int)arclist.size(); i++)
     {
-        arc->cnt = 0;
+        if (arclist[i]->cnt != 0)
+            undoArcJournal.change(arclist, i);
+        arclist[i]->cnt = 0;
     }
 }
 
@@ -680,80 +717,36 @@ void femm::FemmProblem::clearNotationTags()
 // identical in fmesher, FPProc and HPProc
 int femm::FemmProblem::closestArcSegment(double x, double y) const
 {
-    if(arclist.size()==0) return -1;
-
-    double d0=shortestDistanceFromArc(CComplex(x,y),*arclist[0]);
-    int idx=0;
-    for(int i=0; i<(int)arclist.size(); i++)
-    {
-        double d1=shortestDistanceFromArc(CComplex(x,y),*arclist[i]);
-        if(d1<d0)
-        {
-            d0=d1;
-            idx=i;
-        }
-    }
-
-    return idx;
+    geometryIndex.sync(*this);
+    return geometryIndex.nearest(GeometryIndex::ArcSegments, x, y, [&](int i) {
+        return shortestDistanceFromArc(CComplex(x,y),*arclist[i]);
+    });
 }
 
 int femm::FemmProblem::closestBlockLabel(double x, double y) const
 {
-    if(labellist.size()==0) return -1;
-
-    int idx=0;
-    double d0=labellist[0]->GetDistance(x,y);
-    for(int i=0; i<(int)labellist.size(); i++)
-    {
-        double d1=labellist[i]->GetDistance(x,y);
-        if(d1<d0)
-        {
-            d0=d1;
-            idx=i;
-        }
-    }
-
-    return idx;
+    geometryIndex.sync(*this);
+    return geometryIndex.nearest(GeometryIndex::BlockLabels, x, y, [&](int i) {
+        return labellist[i]->GetDistance(x,y);
+    });
 }
 
 // identical in fmesher, FPProc, and HPProc
 int femm::FemmProblem::closestNode(double x, double y) const
 {
-    if(nodelist.size()==0) return -1;
-
-    int idx=0;
-    double d0=nodelist[0]->GetDistance(x,y);
-    for(int i=0; i<(int)nodelist.size(); i++)
-    {
-        double d1=nodelist[i]->GetDistance(x,y);
-        if(d1<d0)
-        {
-            d0=d1;
-            idx=i;
-        }
-    }
-
-    return idx;
+    geometryIndex.sync(*this);
+    return geometryIndex.nearest(GeometryIndex::Nodes, x, y, [&](int i) {
+        return nodelist[i]->GetDistance(x,y);
+    });
 }
 
 // identical in fmesher, hpproc
 int femm::FemmProblem::closestSegment(double x, double y) const
 {
-    if(linelist.size()==0) return -1;
-
-    int idx=0;
-    double d0=shortestDistanceFromSegment(x,y,0);
-    for(int i=0; i<(int)linelist.size(); i++)
-    {
-        double d1=shortestDistanceFromSegment(x,y,i);
-        if(d1<d0)
-        {
-            d0=d1;
-            idx=i;
-        }
-    }
-
-    return idx;
+    geometryIndex.sync(*this);
+    return geometryIndex.nearest(GeometryIndex::Segments, x, y, [&](int i) {
+        return shortestDistanceFromSegment(x,y,i);
+    });
 }
 
 bool femm::FemmProblem::consistencyCheckOK() const
@@ -1046,7 +1039,7 @@ bool femm::FemmProblem::createRadius(int n, double r)
 
         // delete the node that is to be replace by a radius;
         n=closestNode(Re(p0),Im(p0));
-        nodelist[n]->IsSelected=true;
+        selectNode(n);
         deleteSelectedNodes();
 
         // compute the angle spanned by the new arc;
@@ -1115,7 +1108,7 @@ bool femm::FemmProblem::createRadius(int n, double r)
 
         // delete the node that is to be replace by a radius;
         n=closestNode(Re(p0),Im(p0));
-        nodelist[n]->IsSelected=true;
+        selectNode(n);
         deleteSelectedNodes();
 
         // add in the new radius;
@@ -1203,7 +1196,7 @@ bool femm::FemmProblem::createRadius(int n, double r)
 
         // delete the node that is to be replace by a radius;
         n=closestNode(Re(c0),Im(c0));
-        nodelist[n]->IsSelected=true;
+        selectNode(n);
         deleteSelectedNodes();
 
         // compute the angle spanned by the new arc;
@@ -1237,12 +1230,26 @@ void femm::FemmProblem::setDefaultEditMode(femm::EditMode mode)
     d_EditMode = mode;
 }
 
+double femm::FemmProblem::defaultTolerance() const
+{
+    double x[2], y[2];
+    geometryIndex.sync(*this);
+    if (nodelist.size()<2 || !geometryIndex.nodeBoundingBox(x,y))
+        return 1.e-08;
+    return abs(CComplex(x[1],y[1])-CComplex(x[0],y[0]))*CLOSE_ENOUGH;
+}
+
 bool femm::FemmProblem::deleteSelectedArcSegments()
 {
     size_t oldsize = arclist.size();
+    // the entries before the first deleted element keep their indices
+    size_t firstSelected = std::find_if(arclist.begin(),arclist.end(),
+                                        [](const std::unique_ptr<femm::CArcSegment>& arc){ return arc->IsSelected;} ) - arclist.begin();
 
     if (!arclist.empty())
     {
+        // the entries from the first deleted one on are removed or change their index
+        undoArcJournal.shift(arclist, (int)firstSelected);
         // remove selected elements
         arclist.erase(
                     std::remove_if(arclist.begin(),arclist.end(),
@@ -1251,6 +1258,10 @@ bool femm::FemmProblem::deleteSelectedArcSegments()
                     );
     }
     arclist.shrink_to_fit();
+    if (arclist.size() == firstSelected)
+        geometryIndex.truncate(GeometryIndex::ArcSegments, (int)firstSelected);
+    else
+        geometryIndex.invalidate(GeometryIndex::ArcSegments);
 
     return arclist.size() != oldsize;
 }
@@ -1258,9 +1269,14 @@ bool femm::FemmProblem::deleteSelectedArcSegments()
 bool femm::FemmProblem::deleteSelectedBlockLabels()
 {
     size_t oldsize = labellist.size();
+    // the entries before the first deleted element keep their indices
+    size_t firstSelected = std::find_if(labellist.begin(),labellist.end(),
+                                        [](const std::unique_ptr<femm::CBlockLabel>& label){ return label->IsSelected;} ) - labellist.begin();
 
     if (!labellist.empty())
     {
+        // the entries from the first deleted one on are removed or change their index
+        undoLabelJournal.shift(labellist, (int)firstSelected);
         // remove selected elements
         labellist.erase(
                     std::remove_if(labellist.begin(),labellist.end(),
@@ -1269,6 +1285,10 @@ bool femm::FemmProblem::deleteSelectedBlockLabels()
                     );
     }
     labellist.shrink_to_fit();
+    if (labellist.size() == firstSelected)
+        geometryIndex.truncate(GeometryIndex::BlockLabels, (int)firstSelected);
+    else
+        geometryIndex.invalidate(GeometryIndex::BlockLabels);
 
     return labellist.size() != oldsize;
 }
@@ -1288,21 +1308,30 @@ bool femm::FemmProblem::deleteSelectedNodes()
                 // first remove all lines that contain the point;
                 for (int j=0; j<(int)linelist.size(); j++)
                     if((linelist[j]->n0==i) || (linelist[j]->n1==i))
+                    {
+                        undoLineJournal.change(linelist, j);
                         linelist[j]->ToggleSelect();
+                    }
                 deleteSelectedSegments();
 
                 // remove all arcs that contain the point;
                 for (int j=0; j<(int)arclist.size(); j++)
                     if((arclist[j]->n0==i) || (arclist[j]->n1==i))
+                    {
+                        undoArcJournal.change(arclist, j);
                         arclist[j]->ToggleSelect();
+                    }
                 deleteSelectedArcSegments();
 
                 // remove node from the nodelist...
+                undoNodeJournal.shift(nodelist, i);
                 nodelist.erase(nodelist.begin()+i);
 
                 // update lines to point to the new node numbering
                 for (int j=0; j<(int)linelist.size(); j++)
                 {
+                    if (linelist[j]->n0>i || linelist[j]->n1>i)
+                        undoLineJournal.change(linelist, j);
                     if (linelist[j]->n0>i) linelist[j]->n0--;
                     if (linelist[j]->n1>i) linelist[j]->n1--;
                 }
@@ -1310,6 +1339,8 @@ bool femm::FemmProblem::deleteSelectedNodes()
                 // update arcs to point to the new node numbering
                 for (int j=0; j<(int)arclist.size(); j++)
                 {
+                    if (arclist[j]->n0>i || arclist[j]->n1>i)
+                        undoArcJournal.change(arclist, j);
                     if (arclist[j]->n0>i) arclist[j]->n0--;
                     if (arclist[j]->n1>i) arclist[j]->n1--;
                 }
@@ -1319,15 +1350,22 @@ bool femm::FemmProblem::deleteSelectedNodes()
     }
 
     nodelist.shrink_to_fit();
+    if (changed)
+        geometryIndex.invalidate();
     return changed;
 }
 
 bool femm::FemmProblem::deleteSelectedSegments()
 {
     size_t oldsize = linelist.size();
+    // the entries before the first deleted element keep their indices
+    size_t firstSelected = std::find_if(linelist.begin(),linelist.end(),
+                                        [](const std::unique_ptr<femm::CSegment>& segm){ return segm->IsSelected;} ) - linelist.begin();
 
     if (!linelist.empty())
     {
+        // the entries from the first deleted one on are removed or change their index
+        undoLineJournal.shift(linelist, (int)firstSelected);
         // remove selected elements
         linelist.erase(
                     std::remove_if(linelist.begin(),linelist.end(),
@@ -1336,6 +1374,10 @@ bool femm::FemmProblem::deleteSelectedSegments()
                     );
     }
     linelist.shrink_to_fit();
+    if (linelist.size() == firstSelected)
+        geometryIndex.truncate(GeometryIndex::Segments, (int)firstSelected);
+    else
+        geometryIndex.invalidate(GeometryIndex::Segments);
 
     return linelist.size() != oldsize;
 }
@@ -1352,6 +1394,11 @@ void femm::FemmProblem::enforcePSLG(double tol)
     newlinelist.swap(linelist);
     newarclist.swap(arclist);
     newlabellist.swap(labellist);
+    geometryIndex.invalidate();
+    undoNodeJournal.beginReplace();
+    undoLineJournal.beginReplace();
+    undoArcJournal.beginReplace();
+    undoLabelJournal.beginReplace();
 
     // find out what tolerance is so that there are not nodes right on
     // top of each other;
@@ -1394,7 +1441,7 @@ void femm::FemmProblem::enforcePSLG(double tol)
         CComplex p0 (newnodelist[line->n0]->x, newnodelist[line->n0]->y);
         CComplex p1 (newnodelist[line->n1]->x, newnodelist[line->n1]->y);
         // using the raw pointer is ok here, because AddSegment creates a copy anyways
-        addSegment(ClosestNode(p0.re,p0.im), ClosestNode(p1.re,p1.im), line.get(), d);
+        insertSegment(closestNode(p0.re,p0.im), closestNode(p1.re,p1.im), line.get(), d);
     }
 
     // put in all of the arcs;
@@ -1409,18 +1456,25 @@ void femm::FemmProblem::enforcePSLG(double tol)
 
         CComplex p0 (newnodelist[arc->n0]->x, newnodelist[arc->n0]->y);
         CComplex p1 (newnodelist[arc->n1]->x, newnodelist[arc->n1]->y);
-        arc->n0 = closestNode(p0.re,p0.im);
-        arc->n1 = closestNode(p1.re,p1.im);
-        // using the raw pointer is ok here, because AddArcSegment creates a copy anyways
-        addArcSegment(*arc.get(), d);
+        // the old arc is left untouched for the undo journal
+        CArcSegment asegm = *arc;
+        asegm.n0 = closestNode(p0.re,p0.im);
+        asegm.n1 = closestNode(p1.re,p1.im);
+        insertArcSegment(asegm, d);
     }
 
     // put in all of the block labels;
-    for (auto &label: newlabellist)
+    for (const auto &label: newlabellist)
     {
-        addBlockLabel(std::move(label), d);
+        addBlockLabel(label->clone(), d);
     }
 
+    // the old entries are the state at the undo point, unless they have been recorded already
+    undoNodeJournal.replace(newnodelist);
+    undoLineJournal.replace(newlinelist);
+    undoArcJournal.replace(newarclist);
+    undoLabelJournal.replace(newlabellist);
+
     unselectAll();
 }
 
@@ -1546,6 +1600,11 @@ void femm::FemmProblem::getCircle(const femm::CArcSegment &arc, CComplex &c, dou
     c = a0 + (d/2. + I * sqrt(R*R - d*d / 4.)) * t;
 }
 
+void femm::FemmProblem::invalidateGeometryIndex()
+{
+    geometryIndex.invalidate();
+}
+
 std::string femm::FemmProblem::getTitle() const
 {
     return pathName;
@@ -1926,8 +1985,8 @@ void femm::FemmProblem::rotateMove(CComplex c, double t, femm::EditMode selector
         {
             if (line->IsSelected)
             {
-                nodelist[line->n0]->IsSelected = true;
-                nodelist[line->n1]->IsSelected = true;
+                selectNode(line->n0);
+                selectNode(line->n1);
             }
         }
         processNodes = true;
@@ -1939,8 +1998,8 @@ void femm::FemmProblem::rotateMove(CComplex c, double t, femm::EditMode selector
         {
             if (arc->IsSelected)
             {
-                nodelist[arc->n0]->IsSelected = true;
-                nodelist[arc->n1]->IsSelected = true;
+                selectNode(arc->n0);
+                selectNode(arc->n1);
             }
         }
         processNodes = true;
@@ -1948,10 +2007,12 @@ void femm::FemmProblem::rotateMove(CComplex c, double t, femm::EditMode selector
 
     if(selector==EditMode::EditLabels || selector==EditMode::EditGroup)
     {
-        for (auto &label: labellist)
+        for (int i=0; i<(int)labellist.size(); i++)
         {
+            const auto &label = labellist[i];
             if (label->IsSelected)
             {
+                undoLabelJournal.change(labellist, i);
                 CComplex x (label->x, label->y);
                 x = (x-c)*z+c;
                 label->x = x.re;
@@ -1975,10 +2036,12 @@ void femm::FemmProblem::rotateMove(CComplex c, double t, femm::EditMode selector
 
     if(processNodes)
     {
-        for (auto &node : nodelist)
+        for (int i=0; i<(int)nodelist.size(); i++)
         {
+            const auto &node = nodelist[i];
             if (node->IsSelected)
             {
+                undoNodeJournal.change(nodelist, i);
                 CComplex x(node->x,node->y);
                 x = (x-c)*z+c;
                 node->x = x.re;
@@ -2000,8 +2063,8 @@ void femm::FemmProblem::scaleMove(double bx, double by, double sf, femm::EditMod
         {
             if (line->IsSelected)
             {
-                nodelist[line->n0]->IsSelected = true;
-                nodelist[line->n1]->IsSelected = true;
+                selectNode(line->n0);
+                selectNode(line->n1);
             }
         }
         processNodes = true;
@@ -2013,8 +2076,8 @@ void femm::FemmProblem::scaleMove(double bx, double by, double sf, femm::EditMod
         {
             if (arc->IsSelected)
             {
-                nodelist[arc->n0]->IsSelected = true;
-                nodelist[arc->n1]->IsSelected = true;
+                selectNode(arc->n0);
+                selectNode(arc->n1);
             }
         }
         processNodes = true;
@@ -2022,10 +2085,12 @@ void femm::FemmProblem::scaleMove(double bx, double by, double sf, femm::EditMod
 
     if (selector==EditMode::EditLabels || selector==EditMode::EditGroup)
     {
-        for (auto &label: labellist)
+        for (int i=0; i<(int)labellist.size(); i++)
         {
+            const auto &label = labellist[i];
             if (label->IsSelected)
             {
+                undoLabelJournal.change(labellist, i);
                 label->x = bx+sf*(label->x - bx);
                 label->y = by+sf*(label->y - by);
                 label->MaxArea *= (sf*sf);
@@ -2035,10 +2100,12 @@ void femm::FemmProblem::scaleMove(double bx, double by, double sf, femm::EditMod
 
     if (processNodes)
     {
-        for (auto &node : nodelist)
+        for (int i=0; i<(int)nodelist.size(); i++)
         {
+            const auto &node = nodelist[i];
             if (node->IsSelected)
             {
+                undoNodeJournal.change(nodelist, i);
                 node->x = bx+sf*(node->x - bx);
                 node->y = by+sf*(node->y - by);
             }
@@ -2218,8 +2285,8 @@ void femm::FemmProblem::translateMove(double dx, double dy, femm::EditMode selec
         {
             if (line->IsSelected)
             {
-                nodelist[line->n0]->IsSelected = true;
-                nodelist[line->n1]->IsSelected = true;
+                selectNode(line->n0);
+                selectNode(line->n1);
             }
         }
         // make sure to translate endpoints
@@ -2232,8 +2299,8 @@ void femm::FemmProblem::translateMove(double dx, double dy, femm::EditMode selec
         {
             if (arc->IsSelected)
             {
-                nodelist[arc->n0]->IsSelected = true;
-                nodelist[arc->n1]->IsSelected = true;
+                selectNode(arc->n0);
+                selectNode(arc->n1);
             }
         }
         // make sure to translate endpoints
@@ -2242,10 +2309,12 @@ void femm::FemmProblem::translateMove(double dx, double dy, femm::EditMode selec
 
     if (selector == EditMode::EditLabels || selector == EditMode::EditGroup)
     {
-        for (auto &lbl: labellist)
+        for (int i=0; i<(int)labellist.size(); i++)
         {
+            const auto &lbl = labellist[i];
             if (lbl->IsSelected)
             {
+                undoLabelJournal.change(labellist, i);
                 lbl->x += dx;
                 lbl->y += dy;
             }
@@ -2253,10 +2322,12 @@ void femm::FemmProblem::translateMove(double dx, double dy, femm::EditMode selec
     }
     if (processNodes)
     {
-        for (auto &node: nodelist)
+        for (int i=0; i<(int)nodelist.size(); i++)
         {
+            const auto &node = nodelist[i];
             if (node->IsSelected)
             {
+                undoNodeJournal.change(nodelist, i);
                 node->x += dx;
                 node->y += dy;
             }
@@ -2373,55 +2444,83 @@ double femm::FemmProblem::ShortestDistanceFromSegment(double p, double q, int se
 
 void femm::FemmProblem::unselectAll()
 {
-    for(auto &node: nodelist) node->IsSelected = false;
-    for(auto &line: linelist) line->IsSelected = false;
-    for(auto &label: labellist) label->IsSelected = false;
-    for(auto &arc: arclist) arc->IsSelected = false;
+    // only the selected entries change
+    for (int i=0; i<(int)nodelist.size(); i++)
+        if (nodelist[i]->IsSelected)
+        {
+            undoNodeJournal.change(nodelist, i);
+            nodelist[i]->IsSelected = false;
+        }
+    for (int i=0; i<(int)linelist.size(); i++)
+        if (linelist[i]->IsSelected)
+        {
+            undoLineJournal.change(linelist, i);
+            linelist[i]->IsSelected = false;
+        }
+    for (int i=0; i<(int)labellist.size(); i++)
+        if (labellist[i]->IsSelected)
+        {
+            undoLabelJournal.change(labellist, i);
+            labellist[i]->IsSelected = false;
+        }
+    for (int i=0; i<(int)arclist.size(); i++)
+        if (arclist[i]->IsSelected)
+        {
+            undoArcJournal.change(arclist, i);
+            arclist[i]->IsSelected = false;
+        }
 }
 
 void femm::FemmProblem::undo()
 {
-    for(int i=0; i<(int)undolinelist.size(); i++)
-        linelist[i].swap(undolinelist[i]);
-    for(int i=0; i<(int)undoarclist.size(); i++)
-        arclist[i].swap(undoarclist[i]);
-    for(int i=0; i<(int)undolabellist.size(); i++)
-        labellist[i].swap(undolabellist[i]);
-    for(int i=0; i<(int)undonodelist.size(); i++)
-        nodelist[i].swap(undonodelist[i]);
+    undoLineJournal.undo(linelist);
+    undoArcJournal.undo(arclist);
+    undoLabelJournal.undo(labellist);
+    undoNodeJournal.undo(nodelist);
+    geometryIndex.invalidate();
 }
 
 void femm::FemmProblem::undoLines()
 {
-    for(int i=0; i<(int)undolinelist.size(); i++)
-        linelist[i].swap(undolinelist[i]);
+    undoLineJournal.undo(linelist);
+    geometryIndex.invalidate(GeometryIndex::Segments);
 }
 
 void femm::FemmProblem::undoArcs()
 {
-	for(int i=0;i<(int)arclist.size();i++)
-	{
-		arclist[i]->mySideLength=arclist[i]->MaxSideLength;
-		arclist[i]->MaxSideLength=undoarclist[i]->MaxSideLength;
-	}
+    int n = std::min((int)arclist.size(), undoArcJournal.originalSize());
+    for(int i=0;i<n;i++)
+    {
+        arclist[i]->mySideLength=arclist[i]->MaxSideLength;
+        arclist[i]->MaxSideLength=undoArcJournal.original(arclist,i).MaxSideLength;
+    }
 }
 
 void femm::FemmProblem::updateUndo()
 {
-    undonodelist.clear();
-    undolinelist.clear();
-    undoarclist.clear();
-    undolabellist.clear();
+    undoNodeJournal.checkpoint(nodelist);
+    undoLineJournal.checkpoint(linelist);
+    undoArcJournal.checkpoint(arclist);
+    undoLabelJournal.checkpoint(labellist);
+}
+
+void femm::FemmProblem::recordSegmentChange(int idx)
+{
+    undoLineJournal.change(linelist, idx);
+}
+
+void femm::FemmProblem::recordArcSegmentChange(int idx)
+{
+    undoArcJournal.change(arclist, idx);
+}
 
-    // copy each entry
-    for(const auto& node: nodelist)
-        undonodelist.push_back(node->clone());
-    for(const auto& line: linelist)
-        undolinelist.push_back(line->clone());
-    for(const auto& arc: arclist)
-        undoarclist.push_back(MAKE_UNIQUE<CArcSegment>(*arc));
-    for(const auto& label: labellist)
-        undolabellist.push_back(label->clone());
+void femm::FemmProblem::selectNode(int idx)
+{
+    if (!nodelist[idx]->IsSelected)
+    {
+        undoNodeJournal.change(nodelist, idx);
+        nodelist[idx]->IsSelected = true;
+    }
 }
 
 femm::FemmProblem::FemmProblem(FileType ftype)
@@ -2438,11 +2537,15 @@ femm::FemmProblem::FemmProblem(FileType ftype)
     , extRi(0)
     , comment()
     , ACSolver(0)
+    , GMRESRestart(30)
     , dT(0)
     , previousSolutionFile()
     , PrevType(0)
     , DoForceMaxMeshArea(false)
     , DoSmartMesh(true)
+    , FloatPreconditioner(false)
+    , NodeOrdering(0)
+    , ElementOrdering(0)
     , nodelist()
     , linelist()
     , arclist()
@@ -2458,8 +2561,8 @@ femm::FemmProblem::FemmProblem(FileType ftype)
     , blockMap()
     , circuitMap()
     , d_EditMode( EditMode::Invalid )
-    , undonodelist()
-    , undolinelist()
-    , undoarclist()
-    , undolabellist()
+    , undoNodeJournal()
+    , undoLineJournal()
+    , undoArcJournal()
+    , undoLabelJournal()
 {}
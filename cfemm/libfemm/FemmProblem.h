@@ -31,6 +31,8 @@
 #include "CSegment.h"
 #include "femmenums.h"
 #include "fparse.h"
+#include "GeometryIndex.h"
+#include "UndoJournal.h"
 
 #include <map>
 #include <memory>
@@ -280,6 +282,12 @@ public:
     femm::EditMode defaultEditMode() const;
     void setDefaultEditMode( femm::EditMode mode);
 
+    /**
+     * @brief The tolerance that addNode(), addBlockLabel(), addSegment() and addArcSegment() use by default.
+     * @return CLOSE_ENOUGH times the diagonal of the bounding box of all nodes, or 1e-8 if there are less than 2 nodes.
+     */
+    double defaultTolerance() const;
+
     /**
      * @brief Delete all selected arc segments
      * @return \c true, if any segments were deleted, \c false otherwise.
@@ -342,6 +350,13 @@ public:
      */
     void getCircle(const femm::CArcSegment &arc,CComplex &c, double &R) const;
 
+    /**
+     * @brief Tell the geometry index that nodes, segments, arc segments or block labels were changed in place.
+     * The FemmProblem methods do this themselves; code that moves, removes or reorders entries of the lists directly must call it.
+     * Entries that are only appended to the lists do not need it.
+     */
+    void invalidateGeometryIndex();
+
     /**
      * @brief GetIntersection between a line and a segment.
      * Only intersections that are not at or close to an endpoint are considered.
@@ -479,6 +494,7 @@ public:
 
     /**
      * @brief Revert data to the undo point.
+     * A second call redoes the reverted changes.
      */
     void undo();
     /**
@@ -486,13 +502,28 @@ public:
      */
     void undoLines();
     /**
-     * @brief Revert only arclist to the undo point.
+     * @brief Revert only the MaxSideLength of the arc segments to the undo point.
+     * The current MaxSideLength is kept in mySideLength.
      */
     void undoArcs();
     /**
      * @brief Create an undo point.
+     * This does not copy the geometry: the changes that follow are recorded as they are made.
      */
     void updateUndo();
+    /**
+     * @brief Record a segment for undo() before it is modified directly.
+     * The methods of FemmProblem record their own changes; code that changes an entry
+     * of linelist in place has to call this first, so that the change can be reverted.
+     * @param idx index into linelist
+     */
+    void recordSegmentChange(int idx);
+    /**
+     * @brief Record an arc segment for undo() before it is modified directly.
+     * \sa recordSegmentChange()
+     * @param idx index into arclist
+     */
+    void recordArcSegmentChange(int idx);
 public: // data members
     double FileFormat; ///< \brief format version of the file
     double Frequency;  ///< \brief Frequency for harmonic problems [Hz]
@@ -508,13 +539,17 @@ public: // data members
     double extRi;  ///< \brief radius of interior [lfac], only valid for axisymmetric problems
     std::string comment; ///< \brief Problem description
 
-    int ACSolver; ///< \brief .succ. approcimation or .Newton is possible
+    int ACSolver; ///< \brief AC solver: 0 == successive approximation, 1 == Newton, 2 == successive approximation using GMRES
+    int GMRESRestart; ///< \brief Restart length of the GMRES AC solver. Property introduced by xfemm.
     double dT; ///< \brief delta T used by hsolver \verbatim[dT]\endverbatim
     std::string previousSolutionFile; ///y \brief   name of a previous solution file for hsolver and fsolver incremental permeability \verbatim[prevsoln]\endverbatim
     int	PrevType; ///< \brief Previous solution type. 0 == None, 1 == Incremental, 2 == Frozen
 
     bool    DoForceMaxMeshArea; ///< \brief Property introduced by xfemm.
     bool    DoSmartMesh; ///< \brief Property introduced by xfemm.
+    bool    FloatPreconditioner; ///< \brief Store the solver preconditioner in single precision. Property introduced by xfemm.
+    int     NodeOrdering; ///< \brief Node renumbering scheme: 0 == Cuthill-McKee as in FEMM, 1 == reverse Cuthill-McKee, 2 == Hilbert curve, 3 == Morton curve, 4 == approximate minimum degree, 5 == nested dissection. Property introduced by xfemm.
+    int     ElementOrdering; ///< \brief Element sorting scheme: 0 == sum of node numbers, 1 == Hilbert curve, 2 == Morton curve. Property introduced by xfemm.
 
     // lists of nodes, segments, and block labels
     std::vector< std::unique_ptr<CNode>> nodelist;
@@ -538,12 +573,27 @@ public: // data members
     std::map<std::string, int> nodeMap; ///< \brief a map from PointName to node index. \sa updateNodeMap
 
 private:
+    /**
+     * @brief Add an arc segment like addArcSegment() does, but leave the selection alone.
+     * addArcSegment() unselects everything, which is expensive when many arc segments are added.
+     */
+    bool insertArcSegment(femm::CArcSegment &asegm, double tol);
+    /**
+     * @brief Add a line like addSegment() does, but leave the selection alone.
+     * addSegment() unselects everything, which is expensive when many lines are added.
+     */
+    bool insertSegment(int n0, int n1, const femm::CSegment *parsegm, double tol);
+    /// Select a node, and record the change for undo().
+    void selectNode(int idx);
+
     femm::EditMode d_EditMode;
-    // lists of nodes, segments, and block labels for undo purposes...
-    std::vector< std::unique_ptr<femm::CNode> >       undonodelist;
-    std::vector< std::unique_ptr<femm::CSegment> >    undolinelist;
-    std::vector< std::unique_ptr<femm::CArcSegment> > undoarclist;
-    std::vector< std::unique_ptr<femm::CBlockLabel> > undolabellist;
+    /// spatial index over nodelist, linelist, arclist and labellist for the proximity queries
+    mutable GeometryIndex geometryIndex;
+    // changes of the nodes, segments, arc segments and block labels since the undo point
+    UndoJournal<femm::CNode>       undoNodeJournal;
+    UndoJournal<femm::CSegment>    undoLineJournal;
+    UndoJournal<femm::CArcSegment> undoArcJournal;
+    UndoJournal<femm::CBlockLabel> undoLabelJournal;
 };
 
 
@@ -18,14 +18,13 @@
 #include "FemmReader.h"
 
 #include "fparse.h"
+#include "Lexer.h"
 #include "stringTools.h"
 #include "make_unique.h"
 
 #include <cassert>
-#include <fstream>
 #include <ios>
 #include <iostream>
-#include <sstream>
 #include <string>
 
 using namespace std;
@@ -84,33 +83,53 @@ template< class PointPropT
 ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT>
 ::parse(const std::string &file)
 {
-    std::ifstream input;
+    // a binary solution file contains the problem description as text, and the solution as arrays
+    if (solutionReader && SolutionData::isBinaryFile(file))
+    {
+        SolutionData solution;
+        if (!solution.readBinary(file, err))
+            return F_FILE_MALFORMED;
+        if (solution.fileType != problem->filetype)
+        {
+            err << "File " << file << " contains a solution for a different problem type\n";
+            return F_FILE_UNKNOWN_TYPE;
+        }
+        problem->pathName = file;
+        Lexer input(solution.problemDescription);
+        return parseProblem(input, &solution);
+    }
 
-    input.open(file.c_str(), std::ifstream::in);
-    if (!input.is_open())
+    Lexer input;
+    if (!input.open(file))
     {
         err << "Couldn't read from file " << file<< "\n";
         return F_FILE_NOT_OPENED;
     }
     problem->pathName = file;
 
+    return parseProblem(input, nullptr);
+}
+
+template< class PointPropT
+          , class BoundaryPropT
+          , class BlockPropT
+          , class CircuitPropT
+          , class BlockLabelT
+          >
+ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT>
+::parseProblem(Lexer &input, const SolutionData *solution)
+{
     // parse the file
 
 #ifdef DEBUG_PARSER
-    std::cout << "FemmReader starting parsing file " << file << std::endl;
+    std::cout << "FemmReader starting parsing file " << problem->pathName << std::endl;
 #endif // DEBUG_PARSER
 
     bool success = true;
     bool readSolutionData = false;
-    while (input.good() && success)
+    Lexer::Token line;
+    while (success && input.nextTrimmedLine(line))
     {
-        if (input.eof())
-            break;
-
-        std::string line;
-        std::getline(input, line);
-
-        trim(line);
         if (line.empty())
         {
 #ifdef DEBUG_PARSER
@@ -121,15 +140,13 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
 
 #ifdef DEBUG_PARSER
         std::cout << "current line reads:" << std::endl
-                  << line << std::endl;
+                  << line.str() << std::endl;
 #endif // DEBUG_PARSER
 
-        std::istringstream lineStream(line);
-        string token;
+        Lexer lineStream(line.begin, line.end);
+        const Lexer::Token token = lineStream.nextToken();
 
-        nextToken(lineStream, &token);
-
-        if( token == "[format]")
+        if( token.is("[format]"))
         {
             success &= expectChar(lineStream, '=',err);
             success &= parseValue(lineStream, problem->FileFormat, err);
@@ -137,14 +154,14 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
         }
 
         // Precision
-        if( token == "[precision]")
+        if( token.is("[precision]"))
         {
             success &= expectChar(lineStream, '=', err);
             success &= parseValue(lineStream, problem->Precision, err);
             continue;
         }
 
-        if( token == "[minangle]")
+        if( token.is("[minangle]"))
         {
             success &= expectChar(lineStream, '=',err);
             success &= parseValue(lineStream, problem->MinAngle, err);
@@ -152,7 +169,7 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
         }
 
         // Depth for 2D planar problems;
-        if( token == "[depth]")
+        if( token.is("[depth]"))
         {
             success &= expectChar(lineStream, '=',err);
             success &= parseValue(lineStream, problem->Depth, err);
@@ -160,61 +177,61 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
         }
 
         // Units of length used by the problem
-        if( token == "[lengthunits]")
+        if( token.is("[lengthunits]"))
         {
             success &= expectChar(lineStream, '=', err);
-            nextToken(lineStream, &token);
-
-            if( token == "inches" ) problem->LengthUnits=LengthInches;
-            else if( token == "millimeters" ) problem->LengthUnits=LengthMillimeters;
-            else if( token == "centimeters" ) problem->LengthUnits=LengthCentimeters;
-            else if( token == "mils" ) problem->LengthUnits=LengthMils;
-            else if( token == "microns" ) problem->LengthUnits=LengthMicrometers;
-            else if( token == "meters" ) problem->LengthUnits=LengthMeters;
-            else err << "Unknown length unit: " << token << "\n";
+            const Lexer::Token value = lineStream.nextToken();
+
+            if( value.is("inches") ) problem->LengthUnits=LengthInches;
+            else if( value.is("millimeters") ) problem->LengthUnits=LengthMillimeters;
+            else if( value.is("centimeters") ) problem->LengthUnits=LengthCentimeters;
+            else if( value.is("mils") ) problem->LengthUnits=LengthMils;
+            else if( value.is("microns") ) problem->LengthUnits=LengthMicrometers;
+            else if( value.is("meters") ) problem->LengthUnits=LengthMeters;
+            else err << "Unknown length unit: " << value.str() << "\n";
             continue;
         }
 
         // Coordinates (cartesian or polar)
-        if( token == "[coordinates]" )
+        if( token.is("[coordinates]") )
         {
             success &= expectChar(lineStream, '=', err);
-            nextToken(lineStream, &token);
+            const Lexer::Token value = lineStream.nextToken();
 
-            if ( token == "cartesian" ) problem->Coords=CART;
-            else if ( token == "polar" ) problem->Coords=POLAR;
-            else err << "Unknown coordinate type: " << token << "\n";
+            if ( value.is("cartesian") ) problem->Coords=CART;
+            else if ( value.is("polar") ) problem->Coords=POLAR;
+            else err << "Unknown coordinate type: " << value.str() << "\n";
             continue;
         }
 
         // Problem Type (planar or axisymmetric)
-        if( token == "[problemtype]" )
+        if( token.is("[problemtype]") )
         {
             success &= expectChar(lineStream, '=', err);
-            nextToken(lineStream, &token);
+            const Lexer::Token value = lineStream.nextToken();
 
-            if( token == "planar" ) problem->problemType=PLANAR;
-            else if( token == "axisymmetric" ) problem->problemType=AXISYMMETRIC;
-            else err << "Unknown problem type:" << token << "\n";
+            if( value.is("planar") ) problem->problemType=PLANAR;
+            else if( value.is("axisymmetric") ) problem->problemType=AXISYMMETRIC;
+            else err << "Unknown problem type:" << value.str() << "\n";
             continue;
         }
 
         // properties for axisymmetric external region
-        if( token == "[extzo]" )
+        if( token.is("[extzo]") )
         {
             success &= expectChar(lineStream, '=', err);
             success &= parseValue(lineStream, problem->extZo, err);
             continue;
         }
 
-        if( token == "[extro]" )
+        if( token.is("[extro]") )
         {
             success &= expectChar(lineStream, '=', err);
             success &= parseValue(lineStream, problem->extRo, err);
             continue;
         }
 
-        if( token == "[extri]" )
+        if( token.is("[extri]") )
         {
             success &= expectChar(lineStream, '=', err);
             success &= parseValue(lineStream, problem->extRi, err);
@@ -222,7 +239,7 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
         }
 
 
-        if( token == "[comment]" )
+        if( token.is("[comment]") )
         {
             success &= expectChar(lineStream, '=', err);
             parseString(lineStream, &(problem->comment), err);
@@ -230,7 +247,7 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
         }
 
         // AC Solver Type
-        if( token == "[acsolver]")
+        if( token.is("[acsolver]"))
         {
             success &= expectChar(lineStream, '=', err);
             success &= parseValue(lineStream, problem->ACSolver, err);
@@ -238,14 +255,14 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
         }
 
 		// Previous solution type
-		if( token == "[prevtype]" )
+		if( token.is("[prevtype]") )
         {
 			success &= expectChar(lineStream, '=', err);
 			success &= parseValue(lineStream, problem->PrevType, err);
 			continue;
 		}
 
-        if( token == "[prevsoln]" )
+        if( token.is("[prevsoln]") )
         {
             success &= expectChar(lineStream, '=', err);
             parseString(lineStream,&(problem->previousSolutionFile), err);
@@ -254,7 +271,7 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
 
         // Option to force use of default max mesh, overriding
         // user choice
-        if( token == "[forcemaxmesh]")
+        if( token.is("[forcemaxmesh]"))
         {
             success &= expectChar(lineStream, '=', err);
             success &= parseValue(lineStream, problem->DoForceMaxMeshArea, err);
@@ -262,27 +279,53 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
         }
 
         // Option to use smart meshing
-        if( token == "[dosmartmesh]" )
+        if( token.is("[dosmartmesh]") )
         {
             success &= expectChar(lineStream, '=', err);
             success &= parseValue(lineStream, problem->DoSmartMesh, err);
             continue;
         }
 
+        // Option to store the preconditioner in single precision
+        if( token.is("[floatpreconditioner]") )
+        {
+            success &= expectChar(lineStream, '=', err);
+            success &= parseValue(lineStream, problem->FloatPreconditioner, err);
+            continue;
+        }
+
+        // Node renumbering scheme
+        if( token.is("[nodeordering]") )
+        {
+            success &= expectChar(lineStream, '=', err);
+            success &= parseValue(lineStream, problem->NodeOrdering, err);
+            continue;
+        }
+
+        // Element sorting scheme
+        if( token.is("[elementordering]") )
+        {
+            success &= expectChar(lineStream, '=', err);
+            success &= parseValue(lineStream, problem->ElementOrdering, err);
+            continue;
+        }
+
         // Point Properties
-        if( token == "[pointprops]" )
+        if( token.is("[pointprops]") )
         {
             int k;
             success &= expectChar(lineStream, '=', err);
             success &= parseValue(lineStream, k, err);
             if (k>0) problem->nodeproplist.reserve(k);
 
-            while (input && (int)problem->nodeproplist.size() < k)
+            LexerStream stream(input.position(), input.textEnd());
+            while (stream && (int)problem->nodeproplist.size() < k)
             {
                 std::unique_ptr<PointPropT> next;
-                next = MAKE_UNIQUE<PointPropT>(PointPropT::fromStream(input, err));
+                next = MAKE_UNIQUE<PointPropT>(PointPropT::fromStream(stream, err));
                 problem->nodeproplist.push_back(std::move(next));
             }
+            input.setPosition(stream.position());
             // message will be printed after parsing is done
             if ((int)problem->nodeproplist.size() != k)
             {
@@ -294,19 +337,21 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
 
 
         // Boundary Properties;
-        if( token == "[bdryprops]" )
+        if( token.is("[bdryprops]") )
         {
             success &= expectChar(lineStream, '=', err);
             int k;
             success &= parseValue(lineStream, k, err);
             if (k>0) problem->lineproplist.reserve(k);
 
-            while (input && (int)problem->lineproplist.size() < k)
+            LexerStream stream(input.position(), input.textEnd());
+            while (stream && (int)problem->lineproplist.size() < k)
             {
                 std::unique_ptr<BoundaryPropT> next;
-                next = MAKE_UNIQUE<BoundaryPropT>(BoundaryPropT::fromStream(input, err));
+                next = MAKE_UNIQUE<BoundaryPropT>(BoundaryPropT::fromStream(stream, err));
                 problem->lineproplist.push_back(std::move(next));
             }
+            input.setPosition(stream.position());
             // message will be printed after parsing is done
             if ((int)problem->lineproplist.size() != k)
             {
@@ -318,19 +363,21 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
 
 
         // Block Properties;
-        if( token == "[blockprops]" )
+        if( token.is("[blockprops]") )
         {
             success &= expectChar(lineStream, '=', err);
             int k;
             success &= parseValue(lineStream, k, err);
             if (k>0) problem->blockproplist.reserve(k);
 
-            while (input && (int)problem->blockproplist.size() < k)
+            LexerStream stream(input.position(), input.textEnd());
+            while (stream && (int)problem->blockproplist.size() < k)
             {
                 std::unique_ptr<BlockPropT> next;
-                next = MAKE_UNIQUE<BlockPropT>(BlockPropT::fromStream(input, err));
+                next = MAKE_UNIQUE<BlockPropT>(BlockPropT::fromStream(stream, err));
                 problem->blockproplist.push_back(std::move(next));
             }
+            input.setPosition(stream.position());
             // message will be printed after parsing is done
             if ((int)problem->blockproplist.size() != k)
             {
@@ -344,19 +391,21 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
         }
 
         // Circuit Properties
-        if( token == "[circuitprops]" || token == "[conductorprops]")
+        if( token.is("[circuitprops]") || token.is("[conductorprops]"))
         {
             success &= expectChar(lineStream, '=', err);
             int k;
             success &= parseValue(lineStream, k, err);
             if(k>0) problem->circproplist.reserve(k);
 
-            while (input && (int)problem->circproplist.size() < k)
+            LexerStream stream(input.position(), input.textEnd());
+            while (stream && (int)problem->circproplist.size() < k)
             {
                 std::unique_ptr<CircuitPropT> next;
-                next = MAKE_UNIQUE<CircuitPropT>(CircuitPropT::fromStream(input, err));
+                next = MAKE_UNIQUE<CircuitPropT>(CircuitPropT::fromStream(stream, err));
                 problem->circproplist.push_back(std::move(next));
             }
+            input.setPosition(stream.position());
             // message will be printed after parsing is done
             if ((int)problem->circproplist.size() != k)
             {
@@ -368,7 +417,7 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
 
 
         // read in regional attributes
-        if(token == "[numblocklabels]" )
+        if(token.is("[numblocklabels]") )
         {
             success &= expectChar(lineStream, '=', err);
             int k;
@@ -377,13 +426,15 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
 
             // labellist contains both BlockLabels and holes. Therefore we can't use labellist.size:
             int num=0;
-            while (input && num < k)
+            LexerStream stream(input.position(), input.textEnd());
+            while (stream && num < k)
             {
                 std::unique_ptr<BlockLabelT> next;
-                next = MAKE_UNIQUE<BlockLabelT>(BlockLabelT::fromStream(input, err));
+                next = MAKE_UNIQUE<BlockLabelT>(BlockLabelT::fromStream(stream, err));
                 problem->labellist.push_back(std::move(next));
                 num++;
             }
+            input.setPosition(stream.position());
             // message will be printed after parsing is done
             if (num != k)
             {
@@ -392,7 +443,7 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
             }
             continue;
         }
-        if(token == "[numholes]" )
+        if(token.is("[numholes]") )
         {
             success &= expectChar(lineStream, '=', err);
             int k;
@@ -401,29 +452,25 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
 
             // labellist contains both BlockLabels and holes. Therefore we can't use labellist.size:
             int num=0;
+            // holes are not relevant for the post processor -> skip them when reading the solution
+            if (solutionReader)
+                num = input.skipLines(k);
             // operate on a line-by-line level;
-            while (num < k && getline(input, line))
+            while (success && num < k && input.nextLine(line))
             {
-                // holes are not relevant for the post processor -> skip them when reading the solution
-                if (!solutionReader)
-                {
-                    size_t pos;
-                    std::unique_ptr<BlockLabelT> label;
-                    label = MAKE_UNIQUE<BlockLabelT>();
-
-                    trim(line);
-                    label->x = std::stod(line, &pos);
-                    line = line.substr(pos);
-                    label->y = std::stod(line, &pos);
-                    line = line.substr(pos);
-                    label->InGroup = std::stoi(line, &pos);
-
-                    problem->labellist.push_back(std::move(label));
-                }
+                std::unique_ptr<BlockLabelT> label;
+                label = MAKE_UNIQUE<BlockLabelT>();
+
+                Lexer data(line.begin, line.end);
+                success &= data.parseDouble(label->x);
+                success &= data.parseDouble(label->y);
+                success &= data.parseInt(label->InGroup);
+
+                problem->labellist.push_back(std::move(label));
                 num++;
             }
             // message will be printed after parsing is done
-            if (num != k)
+            if (num != k || !success)
             {
                 err << "Expected "<<k<<" holes, but got " << num << "\n";
                 break; // stop parsing
@@ -431,7 +478,7 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
             continue;
         }
 
-        if (token == "[numpoints]")
+        if (token.is("[numpoints]"))
         {
             success &= expectChar(lineStream, '=', err);
             int k;
@@ -439,42 +486,36 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
             if (k>0) problem->nodelist.reserve(k);
 
             // operate on a line-by-line level;
-            while ((int)problem->nodelist.size() < k && getline(input, line))
+            while (success && (int)problem->nodelist.size() < k && input.nextLine(line))
             {
-                size_t pos;
                 CNode node;
 
-                trim(line);
-                node.x = std::stod(line, &pos);
-                line = line.substr(pos);
-                node.y = std::stod(line, &pos);
-                line = line.substr(pos);
-                node.BoundaryMarker = std::stoi(line, &pos);
+                Lexer data(line.begin, line.end);
+                success &= data.parseDouble(node.x);
+                success &= data.parseDouble(node.y);
+                success &= data.parseInt(node.BoundaryMarker);
                 // correct for 1-based indexing:
                 node.BoundaryMarker--;
-                line = line.substr(pos);
-                node.InGroup = std::stoi(line, &pos);
-                line = line.substr(pos);
+                success &= data.parseInt(node.InGroup);
 
                 if (problem->filetype == femm::FileType::HeatFlowFile ||
                         problem->filetype == femm::FileType::ElectrostaticsFile )
                 {
-                    node.InConductor = std::stoi(line, &pos);
+                    success &= data.parseInt(node.InConductor);
                     // correct for 1-based indexing:
                     node.InConductor--;
-                    line = line.substr(pos);
                 }
                 problem->nodelist.push_back(node.clone());
             }
             // message will be printed after parsing is done
-            if ((int)problem->nodelist.size() != k)
+            if ((int)problem->nodelist.size() != k || !success)
             {
                 err << "Expected "<<k<<" points, but got " << problem->nodelist.size() << "\n";
                 break; // stop parsing
             }
             continue;
         }
-        if (token == "[numsegments]")
+        if (token.is("[numsegments]"))
         {
             success &= expectChar(lineStream, '=', err);
             int k;
@@ -482,45 +523,39 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
             if (k>0) problem->linelist.reserve(k);
 
             // operate on a line-by-line level;
-            while ((int)problem->linelist.size() < k && getline(input, line))
+            while (success && (int)problem->linelist.size() < k && input.nextLine(line))
             {
-                size_t pos;
                 CSegment segm;
+                int hidden = 0;
 
-                trim(line);
-                segm.n0 = std::stoi(line, &pos);
-                line = line.substr(pos);
-                segm.n1 = std::stoi(line, &pos);
-                line = line.substr(pos);
-                segm.MaxSideLength = std::stod(line, &pos);
-                line = line.substr(pos);
-                segm.BoundaryMarker = std::stoi(line, &pos);
+                Lexer data(line.begin, line.end);
+                success &= data.parseInt(segm.n0);
+                success &= data.parseInt(segm.n1);
+                success &= data.parseDouble(segm.MaxSideLength);
+                success &= data.parseInt(segm.BoundaryMarker);
                 // correct for 1-based indexing:
                 segm.BoundaryMarker--;
-                line = line.substr(pos);
-                segm.Hidden = (0 != std::stoi(line, &pos));
-                line = line.substr(pos);
-                segm.InGroup = std::stoi(line, &pos);
-                line = line.substr(pos);
+                success &= data.parseInt(hidden);
+                segm.Hidden = (0 != hidden);
+                success &= data.parseInt(segm.InGroup);
                 if (problem->filetype == femm::FileType::HeatFlowFile ||
                         problem->filetype == femm::FileType::ElectrostaticsFile )
                 {
-                    segm.InConductor = std::stoi(line, &pos);
+                    success &= data.parseInt(segm.InConductor);
                     // correct for 1-based indexing:
                     segm.InConductor--;
-                    line = line.substr(pos);
                 }
                 problem->linelist.push_back(segm.clone());
             }
             // message will be printed after parsing is done
-            if ((int)problem->linelist.size() != k)
+            if ((int)problem->linelist.size() != k || !success)
             {
                 err << "Expected "<<k<<" segments, but got " << problem->linelist.size() << "\n";
                 break; // stop parsing
             }
             continue;
         }
-        if (token == "[numarcsegments]")
+        if (token.is("[numarcsegments]"))
         {
             success &= expectChar(lineStream, '=', err);
             int k;
@@ -528,29 +563,23 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
             if (k>0) problem->arclist.reserve(k);
 
             // operate on a line-by-line level;
-            while ((int)problem->arclist.size() < k && getline(input, line))
+            while (success && (int)problem->arclist.size() < k && input.nextLine(line))
             {
-                size_t pos;
                 std::unique_ptr<CArcSegment> asegm;
                 asegm = MAKE_UNIQUE<CArcSegment>();
-
-                trim(line);
-                asegm->n0 = std::stoi(line, &pos);
-                line = line.substr(pos);
-                asegm->n1 = std::stoi(line, &pos);
-                line = line.substr(pos);
-                asegm->ArcLength = std::stod(line, &pos);
-                line = line.substr(pos);
-                asegm->MaxSideLength = std::stod(line, &pos);
-                line = line.substr(pos);
-                asegm->BoundaryMarker = std::stoi(line, &pos);
+                int hidden = 0;
+
+                Lexer data(line.begin, line.end);
+                success &= data.parseInt(asegm->n0);
+                success &= data.parseInt(asegm->n1);
+                success &= data.parseDouble(asegm->ArcLength);
+                success &= data.parseDouble(asegm->MaxSideLength);
+                success &= data.parseInt(asegm->BoundaryMarker);
                 // correct for 1-based indexing:
                 asegm->BoundaryMarker--;
-                line = line.substr(pos);
-                asegm->Hidden = (0 != std::stoi(line, &pos));
-                line = line.substr(pos);
-                asegm->InGroup = std::stoi(line, &pos);
-                line = line.substr(pos);
+                success &= data.parseInt(hidden);
+                asegm->Hidden = (0 != hidden);
+                success &= data.parseInt(asegm->InGroup);
 
                 // make mySideLength same as MaxSideLength in case it isn't specified
                 asegm->mySideLength=asegm->MaxSideLength;
@@ -558,27 +587,25 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
                 if (problem->filetype == femm::FileType::HeatFlowFile ||
                         problem->filetype == femm::FileType::ElectrostaticsFile )
                 {
-                    trim(line);
-                    if (!line.empty())
+                    if (!data.atEndOfLine())
                     {
-                        asegm->InConductor = std::stoi(line, &pos);
+                        success &= data.parseInt(asegm->InConductor);
                         // correct for 1-based indexing:
                         asegm->InConductor--;
                     }
                 }
                 else if (problem->filetype == femm::FileType::MagneticsFile)
                 {
-                    trim(line);
-                    if (!line.empty())
+                    if (!data.atEndOfLine())
                     {
-                        asegm->mySideLength = std::stod(line, &pos);
+                        success &= data.parseDouble(asegm->mySideLength);
                     }
                 }
 
                 problem->arclist.push_back(std::move(asegm));
             }
             // message will be printed after parsing is done
-            if ((int)problem->arclist.size() != k)
+            if ((int)problem->arclist.size() != k || !success)
             {
                 err << "Expected "<<k<<" arc segments, but got " << problem->arclist.size() << "\n";
                 break; // stop parsing
@@ -586,19 +613,21 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
             continue;
         }
 
-        if (token == "[solution]")
+        if (token.is("[solution]"))
         {
             readSolutionData = true;
             break;
         }
 
         // fall-through; token was not used
-        if (!handleToken(token, lineStream, err))
+        std::string tokenString = token.str();
+        to_lower(tokenString);
+        if (!handleToken(tokenString, lineStream, err))
         {
-            err << "Unknown token: " << token << "\n";
+            err << "Unknown token: " << tokenString << "\n";
             success = false;
             if (!ignoreUnhandled) {
-                err << "On line:\n" << line << "\n";
+                err << "On line:\n" << line.str() << "\n";
                 // stop parsing:
                 break;
             }
@@ -612,6 +641,9 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
     problem->updateLineMap();
     problem->updateNodeMap();
 
+    if (solution && success)
+        return solutionReader->loadSolution(*solution,err);
+
     if (readSolutionData && success)
     {
         if (solutionReader)
@@ -627,7 +659,7 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
     }
 
 #ifdef DEBUG_PARSER
-    std::cout << "FemmReader finished parsing file " << file << std::endl;
+    std::cout << "FemmReader finished parsing file " << problem->pathName << std::endl;
 #endif // DEBUG_PARSER
 
     return success ? F_FILE_OK : F_FILE_MALFORMED;
@@ -664,7 +696,7 @@ template< class PointPropT
           , class BlockLabelT
           >
 bool FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT>
-::handleToken(const string &, istream &, ostream &)
+::handleToken(const string &, Lexer &, ostream &)
 {
     return false;
 }
@@ -689,7 +721,7 @@ MagneticsReader::MagneticsReader(std::shared_ptr<FemmProblem> problem, SolutionR
 {
 }
 
-bool MagneticsReader::handleToken(const string &token, istream &input, ostream &err)
+bool MagneticsReader::handleToken(const string &token, Lexer &input, ostream &err)
 {
     // Frequency of the problem
     if( token == "[frequency]")
@@ -699,6 +731,14 @@ bool MagneticsReader::handleToken(const string &token, istream &input, ostream &
         return true;
     }
 
+    // Restart length of the GMRES AC solver
+    if( token == "[gmresrestart]")
+    {
+        expectChar(input, '=',err);
+        parseValue(input, problem->GMRESRestart, err);
+        return true;
+    }
+
     return false;
 }
 
@@ -721,7 +761,7 @@ HeatFlowReader::HeatFlowReader(std::shared_ptr<FemmProblem> problem, SolutionRea
 {
 }
 
-bool HeatFlowReader::handleToken(const string &token, istream &input, ostream &err)
+bool HeatFlowReader::handleToken(const string &token, Lexer &input, ostream &err)
 {
     if( token == "[dt]" )
     {
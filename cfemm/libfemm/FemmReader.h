@@ -19,6 +19,8 @@
 #define FEMMREADER_H
 
 #include "FemmProblem.h"
+#include "Lexer.h"
+#include "SolutionData.h"
 
 #include <iostream>
 #include <string>
@@ -33,7 +35,21 @@ enum ParserResult { F_FILE_OK, F_FILE_UNKNOWN_TYPE, F_FILE_NOT_OPENED, F_FILE_MA
  */
 class SolutionReader {
 public:
-    virtual ParserResult parseSolution( std::istream &input, std::ostream &err = std::cerr ) = 0;
+    /**
+     * @brief Parse the solution data of a solution file.
+     * @param input the lexer, positioned on the line after the \c [Solution] tag
+     * @param err output stream for error messages
+     * @return \c F_FILE_OK on success
+     */
+    virtual ParserResult parseSolution( Lexer &input, std::ostream &err = std::cerr ) = 0;
+    /**
+     * @brief Take the solution data from a binary solution file.
+     * This is called instead of parseSolution() when FemmReader reads a binary solution file.
+     * @param solution the solution data
+     * @param err output stream for error messages
+     * @return \c F_FILE_OK on success
+     */
+    virtual ParserResult loadSolution( const SolutionData &solution, std::ostream &err = std::cerr ) = 0;
 protected:
     virtual ~SolutionReader(){}
 };
@@ -91,6 +107,8 @@ public:
      *
      * If a SolutionReader was set, but no solution is encountered, \c F_FILE_MALFORMED is returned
      * If no SolutionReader was set, but a solution is encountered, a diagnostic is issued and parsing stops.
+     *
+     * If a SolutionReader was set, binary solution files (see SolutionData) are accepted as well.
      * @param file
      * @return
      */
@@ -110,18 +128,26 @@ protected:
      *
      * \internal
      * This function is only a dummy that rejects any token, and is overridden in derived classes.
-     * If a token is understood, this method should read its text from the input stream and then return \c true.
-     * If a token is not understood, the method must not change the position in the input stream, and must return \c false.
+     * If a token is understood, this method should read its text from the input lexer and then return \c true.
+     * If a token is not understood, the method must not change the position of the input lexer, and must return \c false.
      *
-     * \note The input stream contains the remaining contents of the line that \c token was found on.
+     * \note The input lexer contains the remaining contents of the line that \c token was found on.
      * Therefore, this method can never read beyond the current line.
      *
-     * @param token the current token that was already read from input
-     * @param input input stream for current line
+     * @param token the current (lowercase) token that was already read from input
+     * @param input lexer for current line
      * @param err output stream for error messages
      * @return \c false, if the token is not handled. \c true, if it is handled
      */
-    virtual bool handleToken(const std::string &token, std::istream &input, std::ostream &err);
+    virtual bool handleToken(const std::string &token, Lexer &input, std::ostream &err);
+
+    /**
+     * @brief Parse the problem description from the input text.
+     * @param input the lexer for the input text
+     * @param solution if not \c nullptr, the solution is taken from here instead of the input stream
+     * @return
+     */
+    ParserResult parseProblem(Lexer &input, const SolutionData *solution);
 
     std::shared_ptr<FemmProblem> problem;
     SolutionReader *solutionReader;
@@ -143,7 +169,7 @@ public:
     MagneticsReader(std::shared_ptr<FemmProblem> problem, std::ostream &errorpipe);
     MagneticsReader(std::shared_ptr<FemmProblem> problem, SolutionReader *r, std::ostream &errorpipe);
 protected:
-    bool handleToken(const std::string &token, std::istream &input, std::ostream &err) override;
+    bool handleToken(const std::string &token, Lexer &input, std::ostream &err) override;
 };
 
 class HeatFlowReader : public FemmReader<
@@ -158,7 +184,7 @@ public:
     HeatFlowReader(std::shared_ptr<FemmProblem> problem, std::ostream &errorpipe);
     HeatFlowReader(std::shared_ptr<FemmProblem> problem, SolutionReader *r, std::ostream &errorpipe);
 protected:
-    bool handleToken(const std::string &token, std::istream &input, std::ostream &err) override;
+    bool handleToken(const std::string &token, Lexer &input, std::ostream &err) override;
 };
 
 class ElectrostaticsReader : public FemmReader<
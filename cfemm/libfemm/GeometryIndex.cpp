@@ -0,0 +1,637 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "GeometryIndex.h"
+
+#include "FemmProblem.h"
+#include "femmconstants.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <limits>
+
+using namespace femm;
+
+namespace {
+
+/// items that touch more cells are stored as wide items
+constexpr std::size_t MaxCellsPerItem = 4096;
+/// largest cell index, so that differences of cell indices fit into an int
+constexpr double MaxCellIndex = 536870912.; // 2^29
+
+bool isFinite(double x)
+{
+    return std::isfinite(x);
+}
+
+/// Bounding box of the part of a circle between two angles (in radians, a0 <= a1 <= a0+2pi).
+void circleBox(CComplex c, double R, double a0, double a1, double (&box)[4])
+{
+    CComplex p0 = c + R*exp(I*a0);
+    CComplex p1 = c + R*exp(I*a1);
+    box[0] = std::min(p0.re, p1.re);
+    box[1] = std::max(p0.re, p1.re);
+    box[2] = std::min(p0.im, p1.im);
+    box[3] = std::max(p0.im, p1.im);
+    // extreme points at 0, 90, 180 and 270 degrees
+    for (int k=0; k<4; k++)
+    {
+        double t = std::fmod(k*PI/2 - a0, 2*PI);
+        if (t < 0)
+            t += 2*PI;
+        if (t <= a1-a0)
+        {
+            CComplex p = c + R*exp(I*(k*PI/2));
+            box[0] = std::min(box[0], p.re);
+            box[1] = std::max(box[1], p.re);
+            box[2] = std::min(box[2], p.im);
+            box[3] = std::max(box[3], p.im);
+        }
+    }
+}
+
+/// Start angle and span (in radians) of an arc segment, or \c false if the arc is degenerate
+bool arcAngles(const FemmProblem &problem, const CArcSegment &arc, CComplex &c, double &R, double &start, double &span)
+{
+    problem.getCircle(arc, c, R);
+    if (!isFinite(c.re) || !isFinite(c.im) || !isFinite(R))
+        return false;
+    const CNode &a0 = *problem.nodelist[arc.n0];
+    start = arg(CComplex(a0.x, a0.y) - c);
+    span = arc.ArcLength*PI/180.;
+    if (!(span > 0) || span > 2*PI)
+    {
+        // treat it as full circle
+        span = 2*PI;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+GeometryIndex::GeometryIndex()
+    : cellSize(0)
+    , pad(0)
+    , builtItems(0)
+    , haveNodes(false)
+    , nodeBox{0,0,0,0}
+{
+    for (LayerData &data : layers)
+        clearLayer(data);
+}
+
+void GeometryIndex::invalidate()
+{
+    for (LayerData &data : layers)
+        data.valid = false;
+}
+
+void GeometryIndex::invalidate(GeometryIndex::Layer layer)
+{
+    layers[layer].valid = false;
+}
+
+void GeometryIndex::truncate(GeometryIndex::Layer layer, int size)
+{
+    LayerData &data = layers[layer];
+    if (!data.valid || size >= data.count)
+        return;
+    if (layer == Nodes)
+    {
+        // the bounding box may shrink
+        data.valid = false;
+        return;
+    }
+    for (int idx=size; idx<data.count; idx++)
+    {
+        for (CellKey key : data.itemCells[idx])
+        {
+            auto cell = data.cells.find(key);
+            if (cell == data.cells.end())
+                continue;
+            std::vector<int> &items = cell->second;
+            items.erase(std::remove(items.begin(), items.end(), idx), items.end());
+            if (items.empty())
+                data.cells.erase(cell);
+        }
+    }
+    data.wide.erase(std::remove_if(data.wide.begin(), data.wide.end(),
+                                   [=](int idx) { return idx >= size; }),
+                    data.wide.end());
+    data.itemCells.resize(size);
+    data.mark.resize(size);
+    data.count = size;
+}
+
+void GeometryIndex::sync(const FemmProblem &problem)
+{
+    const int sizes[NumLayers] = {
+        (int)problem.nodelist.size(),
+        (int)problem.linelist.size(),
+        (int)problem.arclist.size(),
+        (int)problem.labellist.size()
+    };
+    const int total = sizes[0] + sizes[1] + sizes[2] + sizes[3];
+    if (total == 0)
+    {
+        cellSize = 0;
+        builtItems = 0;
+    }
+    if (total > 0 && (cellSize == 0 || total > 2*builtItems + 64))
+        rebuild(problem);
+
+    for (int layer=0; layer<NumLayers; layer++)
+    {
+        LayerData &data = layers[layer];
+        if (!data.valid || data.count > sizes[layer])
+        {
+            clearLayer(data);
+            data.valid = true;
+            if (layer == Nodes)
+                haveNodes = false;
+        }
+        for (int idx=data.count; idx<sizes[layer]; idx++)
+            addItem(problem, (Layer)layer, idx);
+        data.count = sizes[layer];
+    }
+}
+
+void GeometryIndex::candidates(GeometryIndex::Layer layer, double xmin, double ymin, double xmax, double ymax, std::vector<int> &result)
+{
+    result.clear();
+    LayerData &data = layers[layer];
+    int ix0, iy0, ix1, iy1;
+    if (cellSize == 0
+            || !cellOf(xmin-pad, ymin-pad, ix0, iy0)
+            || !cellOf(xmax+pad, ymax+pad, ix1, iy1))
+    {
+        for (int idx=0; idx<data.count; idx++)
+            result.push_back(idx);
+        return;
+    }
+    ix0 = std::max(ix0, data.ixmin);
+    iy0 = std::max(iy0, data.iymin);
+    ix1 = std::min(ix1, data.ixmax);
+    iy1 = std::min(iy1, data.iymax);
+
+    nextStamp(data);
+    const double numCells = (ix0 <= ix1 && iy0 <= iy1) ? (double)(ix1-ix0+1)*(iy1-iy0+1) : 0.;
+    if (numCells > (double)data.cells.size())
+    {
+        // looking at every cell is more expensive than looking at every item
+        for (int idx=0; idx<data.count; idx++)
+            result.push_back(idx);
+        return;
+    }
+    for (int ix=ix0; ix<=ix1 && numCells > 0; ix++)
+    {
+        for (int iy=iy0; iy<=iy1; iy++)
+        {
+            auto cell = data.cells.find(key(ix,iy));
+            if (cell == data.cells.end())
+                continue;
+            for (int idx : cell->second)
+            {
+                if (data.mark[idx] != data.stamp)
+                {
+                    data.mark[idx] = data.stamp;
+                    result.push_back(idx);
+                }
+            }
+        }
+    }
+    for (int idx : data.wide)
+        result.push_back(idx);
+    std::sort(result.begin(), result.end());
+}
+
+void GeometryIndex::candidatesNear(GeometryIndex::Layer layer, GeometryIndex::Layer itemLayer, int item, double d, std::vector<int> &result)
+{
+    result.clear();
+    LayerData &data = layers[layer];
+    const LayerData &itemData = layers[itemLayer];
+    if (cellSize == 0 || item >= itemData.count || itemData.itemCells[item].empty()
+            || !collectNear(data, itemData.itemCells[item], d, result))
+    {
+        // wide item, or looking at every cell is more expensive than looking at every item
+        result.clear();
+        for (int idx=0; idx<data.count; idx++)
+            result.push_back(idx);
+    }
+}
+
+void GeometryIndex::candidatesNear(GeometryIndex::Layer layer, const FemmProblem &problem, const CSegment &segm, double d, std::vector<int> &result)
+{
+    result.clear();
+    LayerData &data = layers[layer];
+    std::vector<CellKey> keys;
+    if (cellSize == 0 || !segmentCells(problem, segm, keys) || keys.size() > MaxCellsPerItem
+            || !collectNear(data, keys, d, result))
+    {
+        result.clear();
+        for (int idx=0; idx<data.count; idx++)
+            result.push_back(idx);
+    }
+}
+
+void GeometryIndex::candidatesNear(GeometryIndex::Layer layer, const FemmProblem &problem, const CArcSegment &arc, double d, std::vector<int> &result)
+{
+    result.clear();
+    LayerData &data = layers[layer];
+    std::vector<CellKey> keys;
+    if (cellSize == 0 || !arcCells(problem, arc, keys) || keys.size() > MaxCellsPerItem
+            || !collectNear(data, keys, d, result))
+    {
+        result.clear();
+        for (int idx=0; idx<data.count; idx++)
+            result.push_back(idx);
+    }
+}
+
+int GeometryIndex::nearest(GeometryIndex::Layer layer, double x, double y, const std::function<double(int)> &distance)
+{
+    LayerData &data = layers[layer];
+    if (data.count == 0)
+        return -1;
+
+    double best = std::numeric_limits<double>::infinity();
+    int bestIdx = -1;
+    auto consider = [&](int idx) {
+        double d = distance(idx);
+        if (d < best || (d == best && idx < bestIdx))
+        {
+            best = d;
+            bestIdx = idx;
+        }
+    };
+
+    int cx, cy;
+    const double occupied = data.cells.empty() ? 0.
+                          : (double)(data.ixmax-data.ixmin+1)*(data.iymax-data.iymin+1);
+    if (cellSize == 0 || !cellOf(x, y, cx, cy)
+            || occupied > 4.*(data.cells.size() + data.count))
+    {
+        // linear scan
+        for (int idx=0; idx<data.count; idx++)
+            consider(idx);
+        return (bestIdx < 0) ? 0 : bestIdx;
+    }
+
+    nextStamp(data);
+    for (int idx : data.wide)
+        consider(idx);
+    if (!data.cells.empty())
+    {
+        // search rings of cells around the cell of the point;
+        // the items of ring r are at least (r-1)*cellSize away
+        const int r0 = std::max({0, data.ixmin-cx, cx-data.ixmax, data.iymin-cy, cy-data.iymax});
+        const int rmax = std::max({std::abs(cx-data.ixmin), std::abs(cx-data.ixmax),
+                                   std::abs(cy-data.iymin), std::abs(cy-data.iymax)});
+        auto visit = [&](int ix, int iy) {
+            auto cell = data.cells.find(key(ix,iy));
+            if (cell == data.cells.end())
+                return;
+            for (int idx : cell->second)
+            {
+                if (data.mark[idx] != data.stamp)
+                {
+                    data.mark[idx] = data.stamp;
+                    consider(idx);
+                }
+            }
+        };
+        for (int r=r0; r<=rmax; r++)
+        {
+            if (bestIdx >= 0 && best < (r-1)*cellSize - pad)
+                break;
+            const int iylo = std::max(cy-r, data.iymin);
+            const int iyhi = std::min(cy+r, data.iymax);
+            for (int ix=std::max(cx-r, data.ixmin); ix<=std::min(cx+r, data.ixmax); ix++)
+            {
+                if (ix == cx-r || ix == cx+r)
+                {
+                    for (int iy=iylo; iy<=iyhi; iy++)
+                        visit(ix, iy);
+                } else {
+                    if (cy-r >= data.iymin && cy-r <= data.iymax)
+                        visit(ix, cy-r);
+                    if (cy+r >= data.iymin && cy+r <= data.iymax)
+                        visit(ix, cy+r);
+                }
+            }
+        }
+    }
+    // all distances are NaN
+    return (bestIdx < 0) ? 0 : bestIdx;
+}
+
+bool GeometryIndex::nodeBoundingBox(double (&x)[2], double (&y)[2]) const
+{
+    if (!haveNodes)
+        return false;
+    x[0] = nodeBox[0];
+    x[1] = nodeBox[1];
+    y[0] = nodeBox[2];
+    y[1] = nodeBox[3];
+    return true;
+}
+
+void GeometryIndex::rebuild(const FemmProblem &problem)
+{
+    double box[4] = {0,0,0,0};
+    bool haveBox = false;
+    auto extend = [&](double xmin, double xmax, double ymin, double ymax) {
+        if (!isFinite(xmin) || !isFinite(xmax) || !isFinite(ymin) || !isFinite(ymax))
+            return;
+        if (!haveBox)
+        {
+            box[0] = xmin; box[1] = xmax; box[2] = ymin; box[3] = ymax;
+            haveBox = true;
+            return;
+        }
+        box[0] = std::min(box[0], xmin);
+        box[1] = std::max(box[1], xmax);
+        box[2] = std::min(box[2], ymin);
+        box[3] = std::max(box[3], ymax);
+    };
+    for (const auto &node : problem.nodelist)
+        extend(node->x, node->x, node->y, node->y);
+    for (const auto &label : problem.labellist)
+        extend(label->x, label->x, label->y, label->y);
+    // arcs may bulge out of the bounding box of the nodes
+    for (const auto &arc : problem.arclist)
+    {
+        CComplex c;
+        double R, start, span;
+        if (arc->n0 < 0 || arc->n1 < 0 || arc->n0 >= (int)problem.nodelist.size() || arc->n1 >= (int)problem.nodelist.size()
+                || !arcAngles(problem, *arc, c, R, start, span))
+            continue;
+        double arcBox[4];
+        circleBox(c, R, start, start+span, arcBox);
+        extend(arcBox[0], arcBox[1], arcBox[2], arcBox[3]);
+    }
+
+    const int total = (int)(problem.nodelist.size() + problem.linelist.size()
+                            + problem.arclist.size() + problem.labellist.size());
+    const double n = std::max(total, 1);
+    const double w = box[1]-box[0];
+    const double h = box[3]-box[2];
+    const double l = std::max(w, h);
+    // about 4 items per cell, even if the geometry is flat
+    const double area = std::max(w*h, l*l/n);
+    const double largest = std::max({std::fabs(box[0]), std::fabs(box[1]), std::fabs(box[2]), std::fabs(box[3])});
+    cellSize = (l > 0) ? std::max(2*std::sqrt(area/n), largest*1e-9) : largest;
+    if (!(cellSize > 0) || !isFinite(cellSize))
+        cellSize = 1;
+    pad = 1e-3*cellSize;
+    builtItems = total;
+    invalidate();
+}
+
+void GeometryIndex::clearLayer(GeometryIndex::LayerData &data)
+{
+    data.count = 0;
+    data.cells.clear();
+    data.itemCells.clear();
+    data.wide.clear();
+    data.mark.clear();
+    data.stamp = 0;
+    data.ixmin = INT_MAX;
+    data.iymin = INT_MAX;
+    data.ixmax = INT_MIN;
+    data.iymax = INT_MIN;
+}
+
+void GeometryIndex::addItem(const FemmProblem &problem, GeometryIndex::Layer layer, int idx)
+{
+    LayerData &data = layers[layer];
+    if (layer == Nodes)
+    {
+        const CNode &node = *problem.nodelist[idx];
+        if (!haveNodes)
+        {
+            nodeBox[0] = nodeBox[1] = node.x;
+            nodeBox[2] = nodeBox[3] = node.y;
+            haveNodes = true;
+        } else {
+            if (node.x < nodeBox[0]) nodeBox[0] = node.x;
+            if (node.x > nodeBox[1]) nodeBox[1] = node.x;
+            if (node.y < nodeBox[2]) nodeBox[2] = node.y;
+            if (node.y > nodeBox[3]) nodeBox[3] = node.y;
+        }
+    }
+
+    std::vector<CellKey> keys;
+    if (!itemCells(problem, layer, idx, keys) || keys.size() > MaxCellsPerItem)
+    {
+        data.wide.push_back(idx);
+        keys.clear();
+    }
+    for (CellKey k : keys)
+    {
+        data.cells[k].push_back(idx);
+        int ix, iy;
+        cellOfKey(k, ix, iy);
+        data.ixmin = std::min(data.ixmin, ix);
+        data.ixmax = std::max(data.ixmax, ix);
+        data.iymin = std::min(data.iymin, iy);
+        data.iymax = std::max(data.iymax, iy);
+    }
+    data.itemCells.push_back(std::move(keys));
+    data.mark.push_back(0);
+    data.count = idx+1;
+}
+
+bool GeometryIndex::itemCells(const FemmProblem &problem, GeometryIndex::Layer layer, int idx, std::vector<CellKey> &keys) const
+{
+    switch (layer)
+    {
+    case Nodes:
+    case BlockLabels:
+    {
+        double x, y;
+        if (layer == Nodes)
+        {
+            x = problem.nodelist[idx]->x;
+            y = problem.nodelist[idx]->y;
+        } else {
+            x = problem.labellist[idx]->x;
+            y = problem.labellist[idx]->y;
+        }
+        int ix, iy;
+        if (!cellOf(x, y, ix, iy))
+            return false;
+        keys.push_back(key(ix,iy));
+        return true;
+    }
+    case Segments:
+        return segmentCells(problem, *problem.linelist[idx], keys);
+    case ArcSegments:
+        return arcCells(problem, *problem.arclist[idx], keys);
+    default:
+        return false;
+    }
+}
+
+bool GeometryIndex::segmentCells(const FemmProblem &problem, const CSegment &segm, std::vector<CellKey> &keys) const
+{
+    const int numNodes = (int)problem.nodelist.size();
+    if (segm.n0 < 0 || segm.n1 < 0 || segm.n0 >= numNodes || segm.n1 >= numNodes)
+        return false;
+    double x0 = problem.nodelist[segm.n0]->x;
+    double y0 = problem.nodelist[segm.n0]->y;
+    double x1 = problem.nodelist[segm.n1]->x;
+    double y1 = problem.nodelist[segm.n1]->y;
+    if (x0 > x1)
+    {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+    int ix0, ix1, iy;
+    if (!cellOf(x0-pad, y0, ix0, iy) || !cellOf(x1+pad, y1, ix1, iy))
+        return false;
+    if ((double)ix1-ix0 > MaxCellsPerItem)
+        return false;
+    // walk along the columns of the grid
+    for (int ix=ix0; ix<=ix1; ix++)
+    {
+        double ya = y0;
+        double yb = y1;
+        if (x1 > x0)
+        {
+            const double xa = std::max(x0, ix*cellSize - pad);
+            const double xb = std::min(x1, (ix+1)*cellSize + pad);
+            ya = y0 + (y1-y0)*(xa-x0)/(x1-x0);
+            yb = y0 + (y1-y0)*(xb-x0)/(x1-x0);
+        }
+        int ix_, iy0, iy1;
+        if (!cellOf(x0, std::min(ya,yb)-pad, ix_, iy0) || !cellOf(x0, std::max(ya,yb)+pad, ix_, iy1))
+            return false;
+        if (keys.size() + (iy1-iy0+1) > MaxCellsPerItem)
+            return false;
+        for (int iy=iy0; iy<=iy1; iy++)
+            keys.push_back(key(ix,iy));
+    }
+    return true;
+}
+
+bool GeometryIndex::arcCells(const FemmProblem &problem, const CArcSegment &arc, std::vector<CellKey> &keys) const
+{
+    const int numNodes = (int)problem.nodelist.size();
+    if (arc.n0 < 0 || arc.n1 < 0 || arc.n0 >= numNodes || arc.n1 >= numNodes)
+        return false;
+    CComplex c;
+    double R, start, span;
+    if (!arcAngles(problem, arc, c, R, start, span))
+        return false;
+    // split the arc into pieces that are about one cell long
+    const double pieces = std::ceil(R*span/cellSize) + 1;
+    if (!(pieces <= MaxCellsPerItem))
+        return false;
+    const int m = (int)pieces;
+    for (int k=0; k<m; k++)
+    {
+        double box[4];
+        circleBox(c, R, start + span*k/m, start + span*(k+1)/m, box);
+        if (!addRectangle(box[0], box[2], box[1], box[3], keys))
+            return false;
+    }
+    // the end points of the arc are exact, whereas the circle is computed
+    for (int n : {arc.n0, arc.n1})
+    {
+        const CNode &node = *problem.nodelist[n];
+        if (!addRectangle(node.x, node.y, node.x, node.y, keys))
+            return false;
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return true;
+}
+
+bool GeometryIndex::collectNear(GeometryIndex::LayerData &data, const std::vector<CellKey> &keys, double d, std::vector<int> &result)
+{
+    const double rings = std::ceil((d+pad)/cellSize);
+    if (!(rings < MaxCellIndex) || (double)keys.size()*(2*rings+1)*(2*rings+1) > (double)data.cells.size())
+        return false;
+    const int k = (int)rings;
+    nextStamp(data);
+    for (CellKey itemKey : keys)
+    {
+        int cx, cy;
+        cellOfKey(itemKey, cx, cy);
+        for (int ix=std::max(cx-k, data.ixmin); ix<=std::min(cx+k, data.ixmax); ix++)
+        {
+            for (int iy=std::max(cy-k, data.iymin); iy<=std::min(cy+k, data.iymax); iy++)
+            {
+                auto cell = data.cells.find(key(ix,iy));
+                if (cell == data.cells.end())
+                    continue;
+                for (int idx : cell->second)
+                {
+                    if (data.mark[idx] != data.stamp)
+                    {
+                        data.mark[idx] = data.stamp;
+                        result.push_back(idx);
+                    }
+                }
+            }
+        }
+    }
+    for (int idx : data.wide)
+        result.push_back(idx);
+    std::sort(result.begin(), result.end());
+    return true;
+}
+
+bool GeometryIndex::addRectangle(double xmin, double ymin, double xmax, double ymax, std::vector<CellKey> &keys) const
+{
+    int ix0, iy0, ix1, iy1;
+    if (!cellOf(xmin-pad, ymin-pad, ix0, iy0) || !cellOf(xmax+pad, ymax+pad, ix1, iy1))
+        return false;
+    if ((double)(ix1-ix0+1)*(iy1-iy0+1) > MaxCellsPerItem)
+        return false;
+    for (int ix=ix0; ix<=ix1; ix++)
+    {
+        for (int iy=iy0; iy<=iy1; iy++)
+            keys.push_back(key(ix,iy));
+    }
+    return true;
+}
+
+bool GeometryIndex::cellOf(double x, double y, int &ix, int &iy) const
+{
+    const double fx = std::floor(x/cellSize);
+    const double fy = std::floor(y/cellSize);
+    if (!(std::fabs(fx) < MaxCellIndex) || !(std::fabs(fy) < MaxCellIndex))
+        return false;
+    ix = (int)fx;
+    iy = (int)fy;
+    return true;
+}
+
+void GeometryIndex::nextStamp(GeometryIndex::LayerData &data)
+{
+    if (++data.stamp == 0)
+    {
+        std::fill(data.mark.begin(), data.mark.end(), 0);
+        data.stamp = 1;
+    }
+}
+
+GeometryIndex::CellKey GeometryIndex::key(int ix, int iy)
+{
+    return ((CellKey)(std::uint32_t)ix << 32) | (CellKey)(std::uint32_t)iy;
+}
+
+void GeometryIndex::cellOfKey(GeometryIndex::CellKey k, int &ix, int &iy)
+{
+    ix = (int)(std::int32_t)(std::uint32_t)(k >> 32);
+    iy = (int)(std::int32_t)(std::uint32_t)(k & 0xffffffffu);
+}
+
+// vi:expandtab:tabstop=4 shiftwidth=4:
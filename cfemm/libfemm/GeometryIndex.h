@@ -0,0 +1,186 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FEMM_GEOMETRYINDEX_H
+#define FEMM_GEOMETRYINDEX_H
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace femm {
+
+class CArcSegment;
+class CSegment;
+class FemmProblem;
+
+/**
+ * @brief The GeometryIndex class is a uniform grid over the nodes, segments, arc segments and block labels of a FemmProblem.
+ *
+ * Every item is stored in each grid cell that it touches, so that proximity queries
+ * only need to look at the items of a few cells instead of the whole list.
+ * The index only yields candidates: the caller still computes the exact distances,
+ * which keeps the results identical to a linear scan.
+ *
+ * The index is synchronized with the problem by sync():
+ * items that were appended to the lists since the last call are added incrementally,
+ * and the whole grid is rebuilt with a new cell size whenever the geometry has grown too much.
+ * Changes that are not appends (moving, deleting or reordering items) have to be announced
+ * by calling invalidate() or truncate().
+ * Items that shrink in place (e.g. a segment that is split in two) may keep their old entries,
+ * because these still cover the item.
+ *
+ * \internal
+ * A segment is stored in the cells along its path, an arc segment in the cells of the bounding boxes
+ * of short pieces of the arc.
+ * Items that would touch too many cells, or whose coordinates can not be mapped to grid cells
+ * (e.g. because they are not finite), are kept in a list of wide items that are candidates of every query.
+ * \endinternal
+ */
+class GeometryIndex
+{
+public:
+    /// \brief The kinds of items in the index
+    enum Layer {
+        Nodes = 0,
+        Segments,
+        ArcSegments,
+        BlockLabels,
+        NumLayers
+    };
+
+    GeometryIndex();
+
+    /**
+     * @brief Drop all entries. The next sync() adds all items again.
+     */
+    void invalidate();
+    /**
+     * @brief Drop the entries of one layer. The next sync() adds its items again.
+     * @param layer
+     */
+    void invalidate(Layer layer);
+    /**
+     * @brief Drop the entries of items that were removed from the end of a list.
+     * @param layer
+     * @param size the new size of the list
+     */
+    void truncate(Layer layer, int size);
+
+    /**
+     * @brief Add the items that are not in the index yet.
+     * @param problem
+     */
+    void sync(const FemmProblem &problem);
+
+    /**
+     * @brief Find the items of a layer that may touch a rectangle.
+     * @param layer
+     * @param xmin
+     * @param ymin
+     * @param xmax
+     * @param ymax
+     * @param result the item indices in ascending order
+     */
+    void candidates(Layer layer, double xmin, double ymin, double xmax, double ymax, std::vector<int> &result);
+
+    /**
+     * @brief Find the items of a layer that may be closer than a distance to an item of the index.
+     * @param layer
+     * @param itemLayer the layer of the item
+     * @param item the index of the item
+     * @param d the distance
+     * @param result the item indices in ascending order
+     */
+    void candidatesNear(Layer layer, Layer itemLayer, int item, double d, std::vector<int> &result);
+
+    /**
+     * @brief Find the items of a layer that may be closer than a distance to a segment that is not in the index (yet).
+     * @param layer
+     * @param problem the problem that holds the nodes of the segment
+     * @param segm the segment
+     * @param d the distance
+     * @param result the item indices in ascending order
+     */
+    void candidatesNear(Layer layer, const FemmProblem &problem, const CSegment &segm, double d, std::vector<int> &result);
+
+    /**
+     * @brief Find the items of a layer that may be closer than a distance to an arc segment that is not in the index (yet).
+     * @param layer
+     * @param problem the problem that holds the nodes of the arc segment
+     * @param arc the arc segment
+     * @param d the distance
+     * @param result the item indices in ascending order
+     */
+    void candidatesNear(Layer layer, const FemmProblem &problem, const CArcSegment &arc, double d, std::vector<int> &result);
+
+    /**
+     * @brief Find the item of a layer with the smallest distance to a point.
+     * Of several items with the same distance, the one with the lowest index is returned.
+     * @param layer
+     * @param x
+     * @param y
+     * @param distance the exact distance of an item to the point
+     * @return an item index, or -1 if the layer is empty
+     */
+    int nearest(Layer layer, double x, double y, const std::function<double(int)> &distance);
+
+    /**
+     * @brief Get the bounding box of all nodes.
+     * @param x the lower and upper x coordinate
+     * @param y the lower and upper y coordinate
+     * @return \c false, if there are no nodes.
+     */
+    bool nodeBoundingBox(double (&x)[2], double (&y)[2]) const;
+
+private:
+    using CellKey = std::uint64_t;
+
+    struct LayerData
+    {
+        bool valid = false;     ///< false, if the layer needs to be rebuilt by sync()
+        int count = 0;          ///< number of indexed items
+        std::unordered_map<CellKey, std::vector<int>> cells;
+        std::vector<std::vector<CellKey>> itemCells; ///< cells of each item; empty for wide items
+        std::vector<int> wide;  ///< items that are candidates of every query
+        int ixmin, ixmax, iymin, iymax; ///< range of occupied cells
+        std::vector<unsigned> mark; ///< visit marks for deduplication
+        unsigned stamp = 0;
+    };
+
+    /// Choose a new cell size for the current geometry, and drop all entries.
+    void rebuild(const FemmProblem &problem);
+    void clearLayer(LayerData &data);
+    void addItem(const FemmProblem &problem, Layer layer, int idx);
+    /// Cells that item \p idx touches; returns \c false if the item can not be mapped to the grid.
+    bool itemCells(const FemmProblem &problem, Layer layer, int idx, std::vector<CellKey> &keys) const;
+    bool segmentCells(const FemmProblem &problem, const CSegment &segm, std::vector<CellKey> &keys) const;
+    bool arcCells(const FemmProblem &problem, const CArcSegment &arc, std::vector<CellKey> &keys) const;
+    /// Collect the items of a layer within \p d of a set of cells; returns \c false if all items should be used instead.
+    bool collectNear(LayerData &data, const std::vector<CellKey> &keys, double d, std::vector<int> &result);
+    /// Add the cells of a rectangle; returns \c false if it does not fit into the grid.
+    bool addRectangle(double xmin, double ymin, double xmax, double ymax, std::vector<CellKey> &keys) const;
+    bool cellOf(double x, double y, int &ix, int &iy) const;
+    /// Start a new deduplication pass over a layer.
+    void nextStamp(LayerData &data);
+
+    static CellKey key(int ix, int iy);
+    static void cellOfKey(CellKey k, int &ix, int &iy);
+
+    LayerData layers[NumLayers];
+    double cellSize;  ///< edge length of the grid cells, or 0 if not chosen yet
+    double pad;       ///< margin against rounding errors
+    int builtItems;   ///< number of items when the cell size was chosen
+    bool haveNodes;
+    double nodeBox[4]; ///< bounding box of the nodes: xmin, xmax, ymin, ymax
+};
+
+} // namespace femm
+
+#endif
+// vi:expandtab:tabstop=4 shiftwidth=4:
@@ -0,0 +1,374 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "Lexer.h"
+
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+using namespace femm;
+
+namespace {
+
+inline bool isBlank(char c)
+{
+    return c==' ' || c=='\t' || c=='\r' || c==',';
+}
+
+inline bool isDigit(char c)
+{
+    return c>='0' && c<='9';
+}
+
+/// \brief Powers of ten that are exactly representable as double
+const double exactPow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/**
+ * @brief Parse a double using strtod.
+ * The number is copied to a buffer on the stack, because the text is not null-terminated.
+ */
+bool parseDoubleSlow(const char *&p, const char *end, double &value)
+{
+    char buf[64];
+    size_t len = 0;
+    while (p+len < end && len < sizeof(buf)-1 && !isBlank(p[len]) && p[len]!='\n')
+    {
+        buf[len] = p[len];
+        len++;
+    }
+    buf[len] = '\0';
+    char *numEnd;
+    const double d = std::strtod(buf, &numEnd);
+    if (numEnd == buf)
+        return false;
+    value = d;
+    p += numEnd-buf;
+    return true;
+}
+
+} // anonymous namespace
+
+bool Lexer::Token::is(const char *lowercase) const
+{
+    const char *c = begin;
+    for (; c<end && *lowercase; c++, lowercase++)
+    {
+        if (std::tolower(static_cast<unsigned char>(*c)) != *lowercase)
+            return false;
+    }
+    return c==end && *lowercase=='\0';
+}
+
+Lexer::Lexer()
+    : begin(nullptr)
+    , pos(nullptr)
+    , end(nullptr)
+{
+}
+
+Lexer::Lexer(const char *begin, const char *end)
+    : begin(begin)
+    , pos(begin)
+    , end(end)
+{
+}
+
+Lexer::Lexer(const std::string &text)
+    : Lexer(text.data(), text.data()+text.size())
+{
+}
+
+bool Lexer::open(const std::string &fileName)
+{
+    if (!file.open(fileName))
+        return false;
+    begin = pos = file.data();
+    end = begin + file.size();
+    return true;
+}
+
+bool Lexer::atEndOfLine()
+{
+    skipBlanks();
+    return pos==end || *pos=='\n';
+}
+
+const char *Lexer::lineEnd() const
+{
+    if (pos==end)
+        return end;
+    const char *nl = static_cast<const char*>(std::memchr(pos, '\n', end-pos));
+    return nl ? nl : end;
+}
+
+bool Lexer::nextLine(Token &line)
+{
+    if (pos==end)
+        return false;
+    const char *e = lineEnd();
+    line.begin = pos;
+    line.end = e;
+    if (line.end>line.begin && line.end[-1]=='\r')
+        line.end--;
+    pos = (e==end) ? end : e+1;
+    return true;
+}
+
+bool Lexer::nextTrimmedLine(Token &line)
+{
+    if (!nextLine(line))
+        return false;
+    while (line.begin<line.end && std::isspace(static_cast<unsigned char>(*line.begin)))
+        line.begin++;
+    while (line.end>line.begin && std::isspace(static_cast<unsigned char>(line.end[-1])))
+        line.end--;
+    return true;
+}
+
+void Lexer::skipLine()
+{
+    const char *e = lineEnd();
+    pos = (e==end) ? end : e+1;
+}
+
+int Lexer::skipLines(int n)
+{
+    int skipped = 0;
+    while (skipped < n && pos!=end)
+    {
+        skipLine();
+        skipped++;
+    }
+    return skipped;
+}
+
+void Lexer::skipBlanks()
+{
+    while (pos!=end && isBlank(*pos))
+        pos++;
+}
+
+Lexer::Token Lexer::nextToken()
+{
+    skipBlanks();
+    Token token { pos, pos };
+    if (pos!=end && *pos=='=')
+    {
+        token.end = ++pos;
+        return token;
+    }
+    while (pos!=end && !isBlank(*pos) && *pos!='\n' && *pos!='=')
+        pos++;
+    token.end = pos;
+    return token;
+}
+
+bool Lexer::expectChar(char c)
+{
+    skipBlanks();
+    if (pos!=end && *pos==c)
+    {
+        pos++;
+        return true;
+    }
+    return false;
+}
+
+bool Lexer::parseInt(int &value)
+{
+    skipBlanks();
+    return parseInt(pos, end, value);
+}
+
+bool Lexer::parseDouble(double &value)
+{
+    skipBlanks();
+    return parseDouble(pos, end, value);
+}
+
+bool Lexer::parseString(std::string &value)
+{
+    const char *start = pos;
+    if (!expectChar('"'))
+        return false;
+    const char *e = lineEnd();
+    // FEMM42 allows unescaped double-quotes ('"') inside a string;
+    // i.e. the last quote in the line terminates the string
+    const char *q = e;
+    while (q>pos && q[-1]!='"')
+        q--;
+    if (q==pos)
+    {
+        pos = start;
+        return false;
+    }
+    value.assign(pos, q-1);
+    pos = e;
+    return true;
+}
+
+bool Lexer::parseInt(const char *&p, const char *end, int &value)
+{
+    const char *c = p;
+    bool negative = false;
+    if (c!=end && (*c=='-' || *c=='+'))
+    {
+        negative = (*c=='-');
+        c++;
+    }
+    if (c==end || !isDigit(*c))
+        return false;
+    int64_t v = 0;
+    while (c!=end && isDigit(*c))
+    {
+        if (v <= INT32_MAX)
+            v = 10*v + (*c-'0');
+        c++;
+    }
+    value = static_cast<int>(negative ? -v : v);
+    p = c;
+    return true;
+}
+
+bool Lexer::parseDouble(const char *&p, const char *end, double &value)
+{
+    const char *c = p;
+    bool negative = false;
+    if (c!=end && (*c=='-' || *c=='+'))
+    {
+        negative = (*c=='-');
+        c++;
+    }
+
+    // significand: at most 19 digits fit into 64 bits
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool anyDigits = false;
+    while (c!=end && isDigit(*c))
+    {
+        anyDigits = true;
+        if (digits < 19)
+        {
+            mantissa = 10*mantissa + (*c-'0');
+            if (mantissa) digits++;
+        } else {
+            exponent++;
+        }
+        c++;
+    }
+    if (c!=end && *c=='.')
+    {
+        c++;
+        while (c!=end && isDigit(*c))
+        {
+            anyDigits = true;
+            if (digits < 19)
+            {
+                mantissa = 10*mantissa + (*c-'0');
+                if (mantissa) digits++;
+                exponent--;
+            }
+            c++;
+        }
+    }
+    if (!anyDigits)
+    {
+        // inf, nan, hex floats, or garbage
+        return parseDoubleSlow(p, end, value);
+    }
+    if (c!=end && (*c=='e' || *c=='E'))
+    {
+        // the exponent is only consumed if it contains digits
+        const char *e = c+1;
+        bool negativeExp = false;
+        if (e!=end && (*e=='-' || *e=='+'))
+        {
+            negativeExp = (*e=='-');
+            e++;
+        }
+        if (e!=end && isDigit(*e))
+        {
+            int expValue = 0;
+            while (e!=end && isDigit(*e))
+            {
+                if (expValue < 10000)
+                    expValue = 10*expValue + (*e-'0');
+                e++;
+            }
+            exponent += negativeExp ? -expValue : expValue;
+            c = e;
+        }
+    }
+
+    // fast path: both the significand and the power of ten are exact doubles,
+    // so that a single multiplication or division is correctly rounded
+    if (digits <= 15 && exponent >= -22 && exponent <= 22)
+    {
+        double d = static_cast<double>(mantissa);
+        if (exponent < 0)
+            d /= exactPow10[-exponent];
+        else
+            d *= exactPow10[exponent];
+        value = negative ? -d : d;
+        p = c;
+        return true;
+    }
+    return parseDoubleSlow(p, end, value);
+}
+
+LexerStream::Buffer::Buffer(const char *begin, const char *end)
+{
+    // the buffer is never written to
+    char *b = const_cast<char*>(begin);
+    setg(b, b, const_cast<char*>(end));
+}
+
+std::streambuf::pos_type LexerStream::Buffer::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    if (!(which & std::ios_base::in))
+        return pos_type(off_type(-1));
+    char *target;
+    switch (dir)
+    {
+    case std::ios_base::beg:
+        target = eback() + off;
+        break;
+    case std::ios_base::cur:
+        target = gptr() + off;
+        break;
+    default:
+        target = egptr() + off;
+        break;
+    }
+    if (target < eback() || target > egptr())
+        return pos_type(off_type(-1));
+    setg(eback(), target, egptr());
+    return pos_type(target - eback());
+}
+
+std::streambuf::pos_type LexerStream::Buffer::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+LexerStream::LexerStream(const char *begin, const char *end)
+    : std::istream(nullptr)
+    , buffer(begin, end)
+{
+    rdbuf(&buffer);
+}
+
+const char *LexerStream::position() const
+{
+    return buffer.position();
+}
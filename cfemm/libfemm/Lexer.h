@@ -0,0 +1,211 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FEMM_LEXER_H
+#define FEMM_LEXER_H
+
+#include "MappedFile.h"
+
+#include <istream>
+#include <streambuf>
+#include <string>
+
+namespace femm {
+
+/**
+ * @brief The Lexer class splits the text of a femm file into lines, tokens and numbers.
+ *
+ * The lexer works on a buffer that holds the whole text, either a memory mapped file
+ * (see open()) or a text that is owned by someone else.
+ * Tokens and lines are returned as views into that buffer,
+ * and numbers are parsed without allocating memory.
+ *
+ * Token-level functions (nextToken(), parseInt(), parseDouble(), ...) never move
+ * beyond the end of the current line; use nextLine() or skipLine() to go to the next line.
+ * Blanks (space, tab, carriage return) and commas separate tokens.
+ *
+ * For code that expects a std::istream, see LexerStream.
+ */
+class Lexer
+{
+public:
+    /**
+     * @brief A Token is a view into the text of the lexer.
+     * It is only valid as long as the Lexer is.
+     */
+    struct Token
+    {
+        const char *begin;
+        const char *end;
+
+        size_t size() const { return end - begin; }
+        bool empty() const { return begin == end; }
+        std::string str() const { return std::string(begin, end); }
+        /**
+         * @brief Compare the token (case insensitive) with a lowercase string.
+         * @param lowercase
+         * @return \c true, if the token matches the string
+         */
+        bool is(const char *lowercase) const;
+    };
+
+    /// \brief Construct an empty lexer
+    Lexer();
+    /**
+     * @brief Construct a lexer for the given text.
+     * The text is not copied and must stay valid while the lexer is used.
+     * @param begin
+     * @param end
+     */
+    Lexer(const char *begin, const char *end);
+    /**
+     * @brief Construct a lexer for the given text.
+     * The text is not copied and must stay valid while the lexer is used.
+     * @param text
+     */
+    explicit Lexer(const std::string &text);
+    Lexer(const Lexer &) = delete;
+    Lexer &operator=(const Lexer &) = delete;
+
+    /**
+     * @brief Map the given file and reset the lexer to its beginning.
+     * @param file
+     * @return \c true on success, \c false if the file can not be read.
+     */
+    bool open(const std::string &file);
+
+    bool atEnd() const { return pos == end; }
+    /// \brief Check whether the rest of the current line contains only blanks.
+    bool atEndOfLine();
+    const char *position() const { return pos; }
+    /// \brief Continue lexing at the given position (e.g. the position of a LexerStream)
+    void setPosition(const char *p) { pos = p; }
+    const char *textEnd() const { return end; }
+    /// \brief Return the end of the current line (i.e. the position of the next newline)
+    const char *lineEnd() const;
+
+    /**
+     * @brief Read the rest of the current line and move to the beginning of the next line.
+     * The newline (and a trailing carriage return) is not part of the line.
+     * @param line
+     * @return \c false, if there is no more text
+     */
+    bool nextLine(Token &line);
+    /**
+     * @brief Read the rest of the current line, stripped of surrounding blanks.
+     * @param line
+     * @return \c false, if there is no more text
+     */
+    bool nextTrimmedLine(Token &line);
+    /// \brief Move to the beginning of the next line
+    void skipLine();
+    /**
+     * @brief Skip n lines.
+     * @param n
+     * @return the number of lines that were actually skipped
+     */
+    int skipLines(int n);
+
+    /// \brief Skip blanks and commas on the current line
+    void skipBlanks();
+    /**
+     * @brief Read the next token on the current line.
+     * A token is a sequence of characters that are neither blanks, nor commas, nor '='.
+     * A single '=' is also a token.
+     * @return the token, or an empty token at the end of the line.
+     */
+    Token nextToken();
+    /**
+     * @brief Skip blanks and check whether the next character is \p c.
+     * If it is, the character is consumed.
+     * @param c
+     * @return \c true, if the character was found.
+     */
+    bool expectChar(char c);
+    /**
+     * @brief Read an integer value.
+     * On failure, the position is not changed.
+     * @param value
+     * @return \c true on success.
+     */
+    bool parseInt(int &value);
+    /**
+     * @brief Read a double value.
+     * On failure, the position is not changed.
+     * @param value
+     * @return \c true on success.
+     */
+    bool parseDouble(double &value);
+    /**
+     * @brief Read a string literal (delimited by '"').
+     * Just as with femm::parseString(), the last quote on the line terminates the string,
+     * and the rest of the line is consumed.
+     * @param value
+     * @return \c true, if a string literal was read
+     */
+    bool parseString(std::string &value);
+
+    /**
+     * @brief Parse a double value from the text [p,end).
+     * Numbers with at most 15 significant digits and a small exponent are converted
+     * exactly without calling the C library; all others are handed to \c strtod.
+     * @param p start of the text. On success, p is set to the first character after the number.
+     * @param end end of the text
+     * @param value the result
+     * @return \c true on success.
+     */
+    static bool parseDouble(const char *&p, const char *end, double &value);
+    /**
+     * @brief Parse an int value from the text [p,end).
+     * @param p start of the text. On success, p is set to the first character after the number.
+     * @param end end of the text
+     * @param value the result
+     * @return \c true on success.
+     */
+    static bool parseInt(const char *&p, const char *end, int &value);
+private:
+    MappedFile file;
+    const char *begin;
+    const char *pos;
+    const char *end;
+};
+
+/**
+ * @brief The LexerStream class is a std::istream that reads from a piece of text without copying it.
+ *
+ * Its main use is to call code that reads from a std::istream (like the fromStream() functions of the
+ * property classes) in the middle of lexing:
+ * \code
+ * LexerStream stream(lexer.position(), lexer.textEnd());
+ * CMPointProp prop = CMPointProp::fromStream(stream, err);
+ * lexer.setPosition(stream.position());
+ * \endcode
+ */
+class LexerStream : public std::istream
+{
+public:
+    LexerStream(const char *begin, const char *end);
+    /**
+     * @brief The current read position within the text.
+     * @return the position, or the end of the text, if the stream has reached its end.
+     */
+    const char *position() const;
+private:
+    class Buffer : public std::streambuf
+    {
+    public:
+        Buffer(const char *begin, const char *end);
+        const char *position() const { return gptr(); }
+    protected:
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+    };
+    Buffer buffer;
+};
+
+} //namespace
+#endif
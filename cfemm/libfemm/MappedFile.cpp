@@ -0,0 +1,65 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "MappedFile.h"
+
+#include <fstream>
+#include <iterator>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace femm;
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string &file)
+{
+    close();
+#ifndef _WIN32
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED)
+        {
+            mapped = p;
+            length = st.st_size;
+        }
+    }
+    ::close(fd);
+    if (mapped)
+        return true;
+#endif
+    // fall back to reading the file into memory
+    std::ifstream input(file, std::ios::in | std::ios::binary);
+    if (!input)
+        return false;
+    buffer.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifndef _WIN32
+    if (mapped)
+        munmap(mapped, length);
+#endif
+    mapped = nullptr;
+    length = 0;
+    buffer.clear();
+}
@@ -0,0 +1,49 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FEMM_MAPPEDFILE_H
+#define FEMM_MAPPEDFILE_H
+
+#include <string>
+#include <vector>
+
+namespace femm {
+
+/**
+ * @brief The MappedFile class provides read-only access to the contents of a file.
+ * If possible, the file is memory mapped; otherwise it is read into a buffer.
+ *
+ * \note The data is not null-terminated.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    /**
+     * @brief Open a file.
+     * Any previously opened file is closed.
+     * @param file
+     * @return \c true on success, \c false otherwise.
+     */
+    bool open(const std::string &file);
+    void close();
+
+    const char *data() const { return mapped ? static_cast<const char*>(mapped) : buffer.data(); }
+    size_t size() const { return mapped ? length : buffer.size(); }
+
+private:
+    void *mapped = nullptr;
+    size_t length = 0;
+    std::vector<char> buffer;
+};
+
+} //namespace
+#endif
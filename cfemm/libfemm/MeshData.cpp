@@ -0,0 +1,269 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "MeshData.h"
+
+#include <cstdio>
+
+using namespace femm;
+
+void MeshData::clear()
+{
+    nodeX.clear();
+    nodeY.clear();
+    nodeMarker.clear();
+    elements.clear();
+    elementLabel.clear();
+    edges.clear();
+    edgeMarker.clear();
+    pbcs.clear();
+    ages.clear();
+}
+
+LoadMeshErr MeshData::read(const std::string &pathName, std::ostream &err)
+{
+    int i,j,k;
+    std::string infile;
+    FILE *fp;
+    char s[1024];
+
+    clear();
+
+    //read meshnodes;
+    infile = pathName + ".node";
+    if((fp=fopen(infile.c_str(),"rt"))==NULL)
+    {
+        return BADNODEFILE;
+    }
+    fgets(s,1024,fp);
+    sscanf(s,"%i",&k);
+
+    nodeX.resize(k);
+    nodeY.resize(k);
+    nodeMarker.resize(k);
+    for(i=0; i<k; i++)
+    {
+        fscanf(fp,"%i",&j);
+        fscanf(fp,"%lf",&nodeX[i]);
+        fscanf(fp,"%lf",&nodeY[i]);
+        fscanf(fp,"%i",&nodeMarker[i]);
+    }
+    fclose(fp);
+
+    //read in periodic boundary conditions;
+    infile = pathName + ".pbc";
+    if((fp=fopen(infile.c_str(),"rt"))==NULL)
+    {
+        return BADPBCFILE;
+    }
+    fgets(s,1024,fp);
+    sscanf(s,"%i",&k);
+
+    pbcs.reserve(k);
+    CCommonPoint pbc;
+    for(i=0; i<k; i++)
+    {
+        fgets(s,1024,fp);
+        sscanf(s,"%i %i %i %i",&j,&pbc.x,&pbc.y,&pbc.t);
+        pbcs.push_back(pbc);
+    }
+
+    // read in air gap element info;
+    // only written for problems with periodic boundaries
+    k = 0;
+    if (fgets(s,1024,fp)!=NULL)
+        sscanf(s,"%i",&k);
+
+    ages.reserve(k);
+    for(i=0; i<k; i++)
+    {
+        femmsolver::CAirGapElement age;
+
+        fgets(s,80,fp);
+        age.BdryName = std::string (s);
+
+        fgets(s,1024,fp);
+        sscanf(s,"%i %lf %lf %lf %lf %lf %lf %lf %i %lf %lf",
+                &age.BdryFormat,
+                &age.InnerAngle,
+                &age.OuterAngle,
+                &age.ri,
+                &age.ro,
+                &age.totalArcLength,
+                &age.agc.re,
+                &age.agc.im,
+                &age.totalArcElements,
+                &age.InnerShift,
+                &age.OuterShift );
+
+        age.quadNode.reserve(age.totalArcElements+1);
+        for(j=0; j<=age.totalArcElements; j++)
+        {
+            CQuadPoint qp;
+
+            fgets(s,1024,fp);
+            sscanf(s,"%i %lf %i %lf %i %lf %i %lf",
+                &qp.n0, &qp.w0,
+                &qp.n1, &qp.w1,
+                &qp.n2, &qp.w2,
+                &qp.n3, &qp.w3);
+
+            if ( (qp.n0 < 0)
+                  || (qp.n1 < 0)
+                  || (qp.n2 < 0)
+                  || (qp.n3 < 0) )
+            {
+                err << "An error occured while reading file, quadNode has negative node number. "
+                    << "\nFile: " << infile
+                    << "\nq number: " << j
+                    << " n0: " << qp.n0
+                    << " n1: " << qp.n1
+                    << " n2: " << qp.n2
+                    << " n3: " << qp.n3
+                    << "\n";
+                fclose(fp);
+                return BADPBCFILE;
+            }
+
+            age.quadNode.push_back(qp);
+        }
+        ages.push_back(age);
+    }
+    fclose(fp);
+
+    // read in elements;
+    infile = pathName + ".ele";
+    if((fp=fopen(infile.c_str(),"rt"))==NULL)
+    {
+        return BADELEMENTFILE;
+    }
+    fgets(s,1024,fp);
+    sscanf(s,"%i",&k);
+
+    elements.resize(3*k);
+    elementLabel.resize(k);
+    for(i=0; i<k; i++)
+    {
+        fscanf(fp,"%i",&j);
+        fscanf(fp,"%i",&elements[3*i]);
+        fscanf(fp,"%i",&elements[3*i+1]);
+        fscanf(fp,"%i",&elements[3*i+2]);
+        fscanf(fp,"%i",&elementLabel[i]);
+    }
+    fclose(fp);
+
+    // read in edges;
+    infile = pathName + ".edge";
+    if((fp=fopen(infile.c_str(),"rt"))==NULL)
+    {
+        return BADEDGEFILE;
+    }
+    fscanf(fp,"%i",&k);// read in number of lines
+    fscanf(fp,"%i",&j);// read in boundarymarker flag;
+
+    edges.resize(2*k);
+    edgeMarker.resize(k);
+    for(i=0; i<k; i++)
+    {
+        fscanf(fp,"%i",&j);
+        fscanf(fp,"%i",&edges[2*i]);
+        fscanf(fp,"%i",&edges[2*i+1]);
+        fscanf(fp,"%i",&edgeMarker[i]);
+    }
+    fclose(fp);
+
+    return NOERROR;
+}
+
+bool MeshData::write(const std::string &pathName, std::ostream &err) const
+{
+    FILE *fp;
+    std::string outfile;
+
+    // <# of vertices> <dimension (must be 2)> <# of attributes> <# of boundary markers (0 or 1)>
+    // <vertex #> <x> <y> [attributes] [boundary marker]
+    outfile = pathName + ".node";
+    if ((fp=fopen(outfile.c_str(),"wt"))==NULL)
+    {
+        err << "Couldn't write to " << outfile << "\n";
+        return false;
+    }
+    fprintf(fp, "%i\t%i\t%i\t%i\n", numNodes(), 2, 0, 1);
+    for (int i=0; i<numNodes(); i++)
+        fprintf(fp, "%i\t%.17g\t%.17g\t%i\n", i, nodeX[i], nodeY[i], nodeMarker[i]);
+    fclose(fp);
+
+    if (!writePbc(pathName))
+    {
+        err << "Couldn't write to " << pathName << ".pbc\n";
+        return false;
+    }
+
+    // <# of triangles> <nodes per triangle> <# of attributes>
+    // <triangle #> <node> <node> <node> [attributes]
+    outfile = pathName + ".ele";
+    if ((fp=fopen(outfile.c_str(),"wt"))==NULL)
+    {
+        err << "Couldn't write to " << outfile << "\n";
+        return false;
+    }
+    fprintf(fp, "%i\t%i\t%i\n", numElements(), 3, 1);
+    for (int i=0; i<numElements(); i++)
+        fprintf(fp, "%i\t%i\t%i\t%i\t%i\t\n", i, elements[3*i], elements[3*i+1], elements[3*i+2], elementLabel[i]);
+    fclose(fp);
+
+    // <# of edges> <# of boundary markers (0 or 1)>
+    // <edge #> <endpoint> <endpoint> [boundary marker]
+    outfile = pathName + ".edge";
+    if ((fp=fopen(outfile.c_str(),"wt"))==NULL)
+    {
+        err << "Couldn't write to " << outfile << "\n";
+        return false;
+    }
+    fprintf(fp, "%i\t%i\n", numEdges(), 1);
+    for (int i=0; i<numEdges(); i++)
+        fprintf(fp, "%i\t%i\t%i\t%i\n", i, edges[2*i], edges[2*i+1], edgeMarker[i]);
+    fclose(fp);
+
+    return true;
+}
+
+bool MeshData::writePbc(const std::string &pathName) const
+{
+    FILE *fp;
+    std::string outfile = pathName + ".pbc";
+    if ((fp=fopen(outfile.c_str(),"wt"))==NULL)
+        return false;
+
+    fprintf(fp,"%i\n", (int) pbcs.size());
+    for(int k=0;k<(int)pbcs.size();k++)
+    {
+        fprintf(fp,"%i    %i    %i    %i\n",k,pbcs[k].x,pbcs[k].y,pbcs[k].t);
+    }
+
+    fprintf(fp,"%i\n",(int) ages.size());
+    for(const femmsolver::CAirGapElement &age: ages)
+    {
+        // BdryName already contains the quotes and the line break
+        fprintf(fp,"%s",age.BdryName.c_str());
+        fprintf(fp,"%i %.17g %.17g %.17g %.17g %.17g %.17g %.17g %i %.17g %.17g\n",
+                age.BdryFormat,age.InnerAngle,age.OuterAngle,
+                age.ri,age.ro,age.totalArcLength,
+                age.agc.re,age.agc.im,age.totalArcElements,
+                age.InnerShift,age.OuterShift);
+        for(const CQuadPoint &qp: age.quadNode)
+        {
+            fprintf(fp,"%i %g %i %g %i %g %i %g\n",
+                    qp.n0, qp.w0,
+                    qp.n1, qp.w1,
+                    qp.n2, qp.w2,
+                    qp.n3, qp.w3);
+        }
+    }
+    fclose(fp);
+    return true;
+}
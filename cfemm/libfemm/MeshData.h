@@ -0,0 +1,97 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FEMM_MESHDATA_H
+#define FEMM_MESHDATA_H
+
+#include "CAirGapElement.h"
+#include "CCommonPoint.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+enum LoadMeshErr
+{
+    NOERROR,
+    BADFEMFILE,
+    BADNODEFILE,
+    BADPBCFILE,
+    BADELEMENTFILE,
+    BADEDGEFILE,
+    MISSINGMATPROPS,
+    ELMLABELTOOBIG
+};
+
+namespace femm {
+
+/**
+ * @brief The MeshData class holds a triangulation as it is handed from the mesher to a solver.
+ * Its contents correspond to the \c .node, \c .ele, \c .edge and \c .pbc files written by fmesher,
+ * so that the mesh can be passed on in memory instead of going through the file system.
+ *
+ * Coordinates are stored in problem length units, and all markers are stored
+ * exactly as they would appear in the files. It is up to the solver to interpret them.
+ */
+class MeshData
+{
+public:
+    // .node file
+    std::vector<double> nodeX; ///< \brief x coordinate of each node
+    std::vector<double> nodeY; ///< \brief y coordinate of each node
+    std::vector<int> nodeMarker; ///< \brief boundary marker of each node
+
+    // .ele file
+    std::vector<int> elements; ///< \brief three node numbers per element
+    std::vector<int> elementLabel; ///< \brief region attribute of each element (block label number + 1, or 0)
+
+    // .edge file
+    std::vector<int> edges; ///< \brief two node numbers per edge
+    std::vector<int> edgeMarker; ///< \brief boundary marker of each edge
+
+    // .pbc file
+    std::vector<femm::CCommonPoint> pbcs; ///< \brief pairs of (anti)periodic nodes
+    /**
+     * \brief air gap elements
+     * \note As in the .pbc file, the BdryName of each element is the quoted name followed by a newline.
+     */
+    std::vector<femmsolver::CAirGapElement> ages;
+
+    int numNodes() const { return (int)nodeX.size(); }
+    int numElements() const { return (int)elementLabel.size(); }
+    int numEdges() const { return (int)edgeMarker.size(); }
+
+    /**
+     * @brief Remove all data.
+     */
+    void clear();
+
+    /**
+     * @brief Read the mesh from the files \c PathName.node, \c PathName.pbc, \c PathName.ele and \c PathName.edge.
+     * @param pathName the file name without extension
+     * @param err output stream for error messages
+     * @return \c NOERROR on success, otherwise the error for the file that could not be read
+     */
+    LoadMeshErr read(const std::string &pathName, std::ostream &err = std::cerr);
+    /**
+     * @brief Write the mesh to the files \c PathName.node, \c PathName.pbc, \c PathName.ele and \c PathName.edge.
+     * The files have the same format as the ones written by fmesher after calling triangle.
+     * @param pathName the file name without extension
+     * @param err output stream for error messages
+     * @return \c true on success
+     */
+    bool write(const std::string &pathName, std::ostream &err = std::cerr) const;
+    /**
+     * @brief Write only the periodic boundary conditions and air gap elements to \c PathName.pbc.
+     * @param pathName the file name without extension
+     * @return \c true on success
+     */
+    bool writePbc(const std::string &pathName) const;
+};
+
+} //namespace
+#endif
@@ -299,7 +299,7 @@ void PostProcessor::addContourPointFromNode(double mx, double my)
 // identical in EPProc, FPProc and HPProc
 int femm::PostProcessor::InTriangle(double x, double y) const
 {
-    static int k=0;
+    int k = lastTriangle.load(std::memory_order_relaxed);
     int j,hi,lo,sz;
     double z;
 
@@ -332,8 +332,8 @@ int femm::PostProcessor::InTriangle(double x, double y) const
         {
             if (InTriangleTest(x,y,hi))
             {
-                k = hi;
-                return k;
+                lastTriangle.store(hi, std::memory_order_relaxed);
+                return hi;
             }
         }
 
@@ -344,8 +344,8 @@ int femm::PostProcessor::InTriangle(double x, double y) const
         {
             if (InTriangleTest(x,y,lo))
             {
-                k = lo;
-                return k;
+                lastTriangle.store(lo, std::memory_order_relaxed);
+                return lo;
             }
         }
 
@@ -900,7 +900,7 @@ void PostProcessor::getNodalD(CComplex *d, int N) const
     int i,j,k,n,m,p,eos,nos,qn;
     int lf,rt;
     double xi,yi,ii,xx,xy,yy,iv,xv,yv,dx,dy,dv,Ex,Ey,det;
-    static int q[21];
+    int q[21];
     bool flag;
 
     const auto *elem = reinterpret_cast<const femmsolver::CHSElement*>(meshelems[N].get());
@@ -31,6 +31,7 @@
 #include "fparse.h"
 #include "FemmProblem.h"
 
+#include <atomic>
 #include <vector>
 
 namespace femm {
@@ -245,6 +246,10 @@ protected:
     // list of points in a user-defined contour;
     std::vector< CComplex > contour;
 
+    // element found by the last InTriangle() call, where the next search starts;
+    // atomic, so that concurrent point queries on the same solution do not race
+    mutable std::atomic<int> lastTriangle {0};
+
     // member functions
     /**
      * @brief AECF
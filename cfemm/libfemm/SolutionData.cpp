@@ -0,0 +1,891 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "SolutionData.h"
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+using namespace femm;
+using femm::CQuadPoint;
+using femmsolver::CAirGapElement;
+
+namespace {
+
+const char binaryMagic[8] = {'X','F','E','M','M','S','O','L'};
+const uint32_t binaryVersion = 1;
+const char archiveMagic[8] = {'X','F','E','M','M','A','R','C'};
+const uint32_t archiveVersion = 1;
+const uint32_t byteOrderMark = 0x01020304;
+
+enum SectionId : uint32_t {
+    ProblemDescription = 1,
+    NodeX,
+    NodeY,
+    NodeValue,
+    NodeMarker,
+    NodeValuePrev,
+    Elements,
+    ElementLabel,
+    ElementJprev,
+    LabelCircuitCase,
+    LabelCircuitValue,
+    ConductorValue,
+    ConductorFlux,
+    PeriodicNodes,
+    AirGapElements,
+    AirGapQuadNodes,
+    AirGapNames
+};
+
+struct FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t fileType;
+    uint32_t numSections;
+};
+
+/// \brief Header of a solution archive; it is followed by the blocks
+struct ArchiveHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t fileType;
+    uint32_t reserved;
+};
+
+/// \brief Header of a block in a solution archive
+struct BlockHeader
+{
+    uint32_t kind;
+    uint32_t numSections;
+    uint64_t size; ///< size of the block in bytes, including this header
+};
+
+enum BlockKind : uint32_t {
+    MeshBlock = 1,
+    StepBlock = 2
+};
+
+struct SectionEntry
+{
+    uint32_t id;
+    uint32_t itemSize;
+    uint64_t offset;
+    uint64_t count;
+};
+
+/// \brief Fixed size part of an air gap element; the quad nodes and the name are stored in separate sections.
+struct AirGapRecord
+{
+    int32_t BdryFormat;
+    int32_t totalArcElements;
+    int32_t numQuadNodes;
+    int32_t numNameChars;
+    double totalArcLength;
+    double ri,ro;
+    double InnerAngle,OuterAngle;
+    double InnerShift,OuterShift;
+    double agc[2];
+};
+
+/// \brief Quad node as stored in the file (independent of the layout of CQuadPoint)
+struct QuadNodeRecord
+{
+    int32_t n[4];
+    double w[4];
+};
+
+static_assert(sizeof(FileHeader) == 24, "unexpected padding in FileHeader");
+static_assert(sizeof(SectionEntry) == 24, "unexpected padding in SectionEntry");
+static_assert(sizeof(ArchiveHeader) == 24, "unexpected padding in ArchiveHeader");
+static_assert(sizeof(BlockHeader) == 16, "unexpected padding in BlockHeader");
+static_assert(sizeof(CComplex) == 2*sizeof(double), "CComplex can not be stored as array of doubles");
+static_assert(std::is_trivially_copyable<CComplex>::value, "CComplex can not be stored as array of doubles");
+static_assert(sizeof(int) == sizeof(int32_t), "int arrays can not be stored as int32 arrays");
+
+uint64_t alignedOffset(uint64_t offset)
+{
+    return (offset + 7) & ~uint64_t(7);
+}
+
+/**
+ * @brief The Section struct describes an array that is written to the file.
+ */
+struct Section
+{
+    uint32_t id;
+    uint32_t itemSize;
+    const void *data;
+    uint64_t count;
+};
+
+template <typename T>
+Section section(uint32_t id, const std::vector<T> &v)
+{
+    return Section { id, (uint32_t)sizeof(T), v.data(), (uint64_t)v.size() };
+}
+
+/**
+ * @brief Fill a vector from a section of the mapped file.
+ * The sections are aligned to 8 bytes, so the items are copied straight from the mapping
+ * without zero-filling the vector first; a misplaced section is copied bytewise.
+ */
+template <typename T>
+void readSection(const char *data, const SectionEntry &s, std::vector<T> &v)
+{
+    const char *first = data + s.offset;
+    if (reinterpret_cast<uintptr_t>(first) % alignof(T) == 0)
+    {
+        const T *items = reinterpret_cast<const T*>(first);
+        v.assign(items, items + s.count);
+    } else {
+        v.resize(s.count);
+        if (s.count > 0)
+            std::memcpy(v.data(), first, s.count*sizeof(T));
+    }
+}
+
+/**
+ * @brief The MappedArray struct refers to a section of the mapped file
+ * that is only needed while the solution is read.
+ */
+template <typename T>
+struct MappedArray
+{
+    const char *data = nullptr;
+    uint64_t count = 0;
+
+    void assign(const char *origin, const SectionEntry &s)
+    {
+        data = origin + s.offset;
+        count = s.count;
+    }
+    uint64_t size() const { return count; }
+    T operator[](uint64_t i) const
+    {
+        T item;
+        std::memcpy(&item, data + i*sizeof(T), sizeof(T));
+        return item;
+    }
+};
+
+/// \brief Expected item size for each known section, or 0 for unknown sections
+uint32_t expectedItemSize(uint32_t id)
+{
+    switch (id)
+    {
+    case ProblemDescription:
+    case AirGapNames:
+        return sizeof(char);
+    case NodeX:
+    case NodeY:
+    case NodeValuePrev:
+    case ElementJprev:
+    case ConductorValue:
+    case ConductorFlux:
+        return sizeof(double);
+    case NodeValue:
+    case LabelCircuitValue:
+        return sizeof(CComplex);
+    case NodeMarker:
+    case Elements:
+    case ElementLabel:
+    case LabelCircuitCase:
+    case PeriodicNodes:
+        return sizeof(int32_t);
+    case AirGapElements:
+        return sizeof(AirGapRecord);
+    case AirGapQuadNodes:
+        return sizeof(QuadNodeRecord);
+    default:
+        return 0;
+    }
+}
+
+/// \brief Sections that are stored only once in a solution archive, because all steps share the mesh
+bool isMeshSection(uint32_t id)
+{
+    switch (id)
+    {
+    case NodeX:
+    case NodeY:
+    case NodeMarker:
+    case Elements:
+    case ElementLabel:
+    case PeriodicNodes:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief The FlatSolution class holds the sections of a SolutionData.
+ * Data that is not stored as plain array in SolutionData is flattened,
+ * so that all sections can be written as they are.
+ */
+class FlatSolution
+{
+public:
+    explicit FlatSolution(const SolutionData &sol);
+    FlatSolution(const FlatSolution &) = delete;
+    FlatSolution &operator=(const FlatSolution &) = delete;
+
+    std::vector<Section> sections;
+private:
+    std::vector<int> periodicNodes;
+    std::vector<AirGapRecord> ageRecords;
+    std::vector<QuadNodeRecord> quadNodes;
+    std::vector<char> ageNames;
+};
+
+FlatSolution::FlatSolution(const SolutionData &sol)
+{
+    periodicNodes.reserve(3*sol.pbcs.size());
+    for (const auto &pbc: sol.pbcs)
+    {
+        periodicNodes.push_back(pbc.x);
+        periodicNodes.push_back(pbc.y);
+        periodicNodes.push_back(pbc.t);
+    }
+    for (const CAirGapElement &age: sol.ages)
+    {
+        AirGapRecord r;
+        r.BdryFormat = age.BdryFormat;
+        r.totalArcElements = age.totalArcElements;
+        r.numQuadNodes = (int32_t)age.quadNode.size();
+        r.numNameChars = (int32_t)age.BdryName.size();
+        r.totalArcLength = age.totalArcLength;
+        r.ri = age.ri;
+        r.ro = age.ro;
+        r.InnerAngle = age.InnerAngle;
+        r.OuterAngle = age.OuterAngle;
+        r.InnerShift = age.InnerShift;
+        r.OuterShift = age.OuterShift;
+        r.agc[0] = age.agc.re;
+        r.agc[1] = age.agc.im;
+        ageRecords.push_back(r);
+        for (const CQuadPoint &q: age.quadNode)
+        {
+            quadNodes.push_back(QuadNodeRecord { {q.n0,q.n1,q.n2,q.n3}, {q.w0,q.w1,q.w2,q.w3} });
+        }
+        ageNames.insert(ageNames.end(), age.BdryName.begin(), age.BdryName.end());
+    }
+
+    sections = {
+        Section { ProblemDescription, 1, sol.problemDescription.data(), (uint64_t)sol.problemDescription.size() },
+        section(NodeX, sol.nodeX),
+        section(NodeY, sol.nodeY),
+        section(NodeValue, sol.nodeValue),
+        section(NodeMarker, sol.nodeMarker),
+        section(NodeValuePrev, sol.nodeValuePrev),
+        section(Elements, sol.elements),
+        section(ElementLabel, sol.elementLabel),
+        section(ElementJprev, sol.elementJprev),
+        section(LabelCircuitCase, sol.labelCircuitCase),
+        section(LabelCircuitValue, sol.labelCircuitValue),
+        section(ConductorValue, sol.conductorValue),
+        section(ConductorFlux, sol.conductorFlux),
+        section(PeriodicNodes, periodicNodes),
+        section(AirGapElements, ageRecords),
+        section(AirGapQuadNodes, quadNodes),
+        section(AirGapNames, ageNames)
+    };
+}
+
+/**
+ * @brief Compute the section table for a list of sections.
+ * @param sections
+ * @param start position of the section table; the offsets in the table are relative to the same origin
+ * @param table the section table
+ * @return the (aligned) end of the last section
+ */
+uint64_t layoutSections(const std::vector<Section> &sections, uint64_t start, std::vector<SectionEntry> &table)
+{
+    uint64_t offset = alignedOffset(start + sections.size()*sizeof(SectionEntry));
+    for (const Section &s: sections)
+    {
+        table.push_back(SectionEntry { s.id, s.itemSize, offset, s.count });
+        offset = alignedOffset(offset + s.count*s.itemSize);
+    }
+    return offset;
+}
+
+/**
+ * @brief Write the section table and the sections, padded to 8 bytes.
+ * @param output
+ * @param sections
+ * @param table the section table, as computed by layoutSections()
+ * @param pos the position of the section table, relative to the origin of the offsets
+ */
+void writeSections(std::ostream &output, const std::vector<Section> &sections, const std::vector<SectionEntry> &table, uint64_t pos)
+{
+    output.write(reinterpret_cast<const char*>(table.data()), table.size()*sizeof(SectionEntry));
+    const char padding[8] = {0};
+    pos += table.size()*sizeof(SectionEntry);
+    for (size_t i=0; i<sections.size(); i++)
+    {
+        output.write(padding, table[i].offset - pos);
+        output.write(static_cast<const char*>(sections[i].data), sections[i].count*sections[i].itemSize);
+        pos = table[i].offset + sections[i].count*sections[i].itemSize;
+    }
+    output.write(padding, alignedOffset(pos) - pos);
+}
+
+/**
+ * @brief Write a block of a solution archive.
+ * @param output
+ * @param kind the BlockKind
+ * @param sections
+ */
+void writeBlock(std::ostream &output, uint32_t kind, const std::vector<Section> &sections)
+{
+    std::vector<SectionEntry> table;
+    const uint64_t size = layoutSections(sections, sizeof(BlockHeader), table);
+    const BlockHeader header { kind, (uint32_t)sections.size(), size };
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeSections(output, sections, table, sizeof(BlockHeader));
+}
+
+/**
+ * @brief The SectionReader class reads the sections of a binary solution file,
+ * or of the blocks of a solution archive, into a SolutionData.
+ *
+ * If a section occurs more than once, the last one wins.
+ * After reading all sections, call finish() to unflatten the air gap elements and periodic nodes.
+ * The flattened sections are read from the file contents, which must stay valid until then.
+ */
+class SectionReader
+{
+public:
+    SectionReader(SolutionData &sol, const std::string &file, std::ostream &err)
+        : sol(sol), file(file), err(err)
+    {}
+
+    /**
+     * @brief Read sections.
+     * @param origin the origin of the section offsets
+     * @param size number of bytes available after \p origin
+     * @param tableOffset offset of the section table
+     * @param numSections number of sections in the table
+     * @return \c true on success
+     */
+    bool read(const char *origin, uint64_t size, uint64_t tableOffset, uint32_t numSections);
+    /**
+     * @brief Check the consistency of the data and build the air gap elements and periodic nodes.
+     * Node numbers must refer to existing nodes; block labels can only be checked by the post processor.
+     * @return \c true on success
+     */
+    bool finish();
+private:
+    SolutionData &sol;
+    const std::string &file;
+    std::ostream &err;
+
+    MappedArray<AirGapRecord> ageRecords;
+    MappedArray<QuadNodeRecord> quadNodes;
+    MappedArray<char> ageNames;
+    MappedArray<int32_t> periodicNodes;
+};
+
+bool SectionReader::read(const char *origin, uint64_t size, uint64_t tableOffset, uint32_t numSections)
+{
+    if (tableOffset + (uint64_t)numSections*sizeof(SectionEntry) > size)
+    {
+        err << file << " is truncated\n";
+        return false;
+    }
+    for (uint32_t i=0; i<numSections; i++)
+    {
+        SectionEntry s;
+        std::memcpy(&s, origin + tableOffset + i*sizeof(SectionEntry), sizeof(s));
+        const uint32_t itemSize = expectedItemSize(s.id);
+        if (itemSize == 0)
+            continue; // unknown section
+        if (s.itemSize != itemSize)
+        {
+            err << file << ": section " << s.id << " has unexpected item size " << s.itemSize << "\n";
+            return false;
+        }
+        if (s.offset > size || s.count > (size - s.offset) / itemSize)
+        {
+            err << file << " is truncated\n";
+            return false;
+        }
+        switch (s.id)
+        {
+        case ProblemDescription:
+            sol.problemDescription.assign(origin + s.offset, s.count);
+            break;
+        case NodeX: readSection(origin, s, sol.nodeX); break;
+        case NodeY: readSection(origin, s, sol.nodeY); break;
+        case NodeValue: readSection(origin, s, sol.nodeValue); break;
+        case NodeMarker: readSection(origin, s, sol.nodeMarker); break;
+        case NodeValuePrev: readSection(origin, s, sol.nodeValuePrev); break;
+        case Elements: readSection(origin, s, sol.elements); break;
+        case ElementLabel: readSection(origin, s, sol.elementLabel); break;
+        case ElementJprev: readSection(origin, s, sol.elementJprev); break;
+        case LabelCircuitCase: readSection(origin, s, sol.labelCircuitCase); break;
+        case LabelCircuitValue: readSection(origin, s, sol.labelCircuitValue); break;
+        case ConductorValue: readSection(origin, s, sol.conductorValue); break;
+        case ConductorFlux: readSection(origin, s, sol.conductorFlux); break;
+        case PeriodicNodes: periodicNodes.assign(origin, s); break;
+        case AirGapElements: ageRecords.assign(origin, s); break;
+        case AirGapQuadNodes: quadNodes.assign(origin, s); break;
+        case AirGapNames: ageNames.assign(origin, s); break;
+        }
+    }
+    return true;
+}
+
+bool SectionReader::finish()
+{
+    if (sol.nodeX.size() != sol.nodeY.size()
+            || sol.nodeValue.size() != sol.nodeX.size()
+            || sol.nodeMarker.size() != sol.nodeX.size()
+            || sol.elements.size() != 3*sol.elementLabel.size()
+            || (!sol.nodeValuePrev.empty() && sol.nodeValuePrev.size() != sol.nodeX.size())
+            || (!sol.elementJprev.empty() && sol.elementJprev.size() != sol.elementLabel.size())
+            || periodicNodes.size() % 3 != 0)
+    {
+        err << file << " contains inconsistent mesh data\n";
+        return false;
+    }
+    if (sol.labelCircuitCase.size() != sol.labelCircuitValue.size())
+    {
+        err << file << " contains inconsistent circuit data\n";
+        return false;
+    }
+    if (sol.conductorFlux.size() != sol.conductorValue.size())
+    {
+        err << file << " contains inconsistent conductor data\n";
+        return false;
+    }
+
+    // the post processors index their node lists with these numbers;
+    // the block labels are checked against the problem description by the post processors
+    const size_t numNodes = sol.nodeX.size();
+    auto isNode = [numNodes](int32_t n) { return n >= 0 && (size_t)n < numNodes; };
+    for (size_t i=0; i<sol.elements.size(); i++)
+    {
+        if (!isNode(sol.elements[i]))
+        {
+            err << file << ": element " << i/3 << " has invalid node " << sol.elements[i] << "\n";
+            return false;
+        }
+    }
+    for (size_t i=0; i<sol.elementLabel.size(); i++)
+    {
+        if (sol.elementLabel[i] < 0)
+        {
+            err << file << ": element " << i << " has invalid block label " << sol.elementLabel[i] << "\n";
+            return false;
+        }
+    }
+
+    sol.pbcs.resize(periodicNodes.size()/3);
+    for (size_t i=0; i<sol.pbcs.size(); i++)
+    {
+        sol.pbcs[i].x = periodicNodes[3*i];
+        sol.pbcs[i].y = periodicNodes[3*i+1];
+        sol.pbcs[i].t = periodicNodes[3*i+2];
+        if (!isNode(sol.pbcs[i].x) || !isNode(sol.pbcs[i].y))
+        {
+            err << file << " contains inconsistent periodic node data\n";
+            return false;
+        }
+    }
+
+    size_t quadIdx = 0;
+    size_t nameIdx = 0;
+    sol.ages.resize(ageRecords.size());
+    for (size_t i=0; i<ageRecords.size(); i++)
+    {
+        const AirGapRecord r = ageRecords[i];
+        // the post processors expect one quad node more than there are arc elements
+        if (r.numQuadNodes < 0 || r.numNameChars < 0
+                || r.totalArcElements < 0 || (r.totalArcElements > 0 && r.totalArcElements >= r.numQuadNodes)
+                || quadIdx + r.numQuadNodes > quadNodes.size()
+                || nameIdx + r.numNameChars > ageNames.size())
+        {
+            err << file << " contains inconsistent air gap element data\n";
+            return false;
+        }
+        CAirGapElement &age = sol.ages[i];
+        age.BdryName.assign(ageNames.data + nameIdx, r.numNameChars);
+        nameIdx += r.numNameChars;
+        age.BdryFormat = r.BdryFormat;
+        age.totalArcElements = r.totalArcElements;
+        age.totalArcLength = r.totalArcLength;
+        age.ri = r.ri;
+        age.ro = r.ro;
+        age.InnerAngle = r.InnerAngle;
+        age.OuterAngle = r.OuterAngle;
+        age.InnerShift = r.InnerShift;
+        age.OuterShift = r.OuterShift;
+        age.agc = CComplex(r.agc[0], r.agc[1]);
+        age.quadNode.resize(r.numQuadNodes);
+        for (CQuadPoint &q: age.quadNode)
+        {
+            const QuadNodeRecord qr = quadNodes[quadIdx++];
+            if (!isNode(qr.n[0]) || !isNode(qr.n[1]) || !isNode(qr.n[2]) || !isNode(qr.n[3]))
+            {
+                err << file << " contains inconsistent air gap element data\n";
+                return false;
+            }
+            q.n0 = qr.n[0]; q.n1 = qr.n[1]; q.n2 = qr.n[2]; q.n3 = qr.n[3];
+            q.w0 = qr.w[0]; q.w1 = qr.w[1]; q.w2 = qr.w[2]; q.w3 = qr.w[3];
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Check the header of a solution archive and find its blocks.
+ * @param data the archive contents
+ * @param size the archive size
+ * @param blocks the offsets of the blocks; the first block is the mesh block, all others are steps
+ * @param file the file name (for error messages)
+ * @param err
+ * @return \c true, if the archive is valid
+ */
+bool scanArchive(const char *data, uint64_t size, std::vector<uint64_t> &blocks, const std::string &file, std::ostream &err)
+{
+    ArchiveHeader header;
+    if (size < sizeof(ArchiveHeader))
+    {
+        err << file << " is not a solution archive\n";
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, archiveMagic, sizeof(archiveMagic)) != 0)
+    {
+        err << file << " is not a solution archive\n";
+        return false;
+    }
+    if (header.byteOrder != byteOrderMark)
+    {
+        err << file << " was written on a machine with different byte order\n";
+        return false;
+    }
+    if (header.version > archiveVersion)
+    {
+        err << file << " uses archive format version " << header.version
+            << ", but only versions up to " << archiveVersion << " are supported\n";
+        return false;
+    }
+
+    blocks.clear();
+    uint64_t offset = sizeof(ArchiveHeader);
+    while (offset < size)
+    {
+        BlockHeader block;
+        if (size - offset < sizeof(BlockHeader))
+        {
+            err << file << " is truncated\n";
+            return false;
+        }
+        std::memcpy(&block, data + offset, sizeof(block));
+        const uint32_t expectedKind = blocks.empty() ? MeshBlock : StepBlock;
+        if (block.kind != expectedKind || block.size < sizeof(BlockHeader))
+        {
+            err << file << " contains an invalid block at offset " << offset << "\n";
+            return false;
+        }
+        if (block.size > size - offset)
+        {
+            err << file << " is truncated\n";
+            return false;
+        }
+        blocks.push_back(offset);
+        offset += block.size;
+    }
+    if (blocks.empty())
+    {
+        err << file << " contains no mesh\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Read a block of a solution archive.
+ * @param data the archive contents
+ * @param offset the offset of the block
+ * @param reader
+ * @return \c true on success
+ */
+bool readBlock(const char *data, uint64_t offset, SectionReader &reader)
+{
+    BlockHeader block;
+    std::memcpy(&block, data + offset, sizeof(block));
+    return reader.read(data + offset, block.size, sizeof(BlockHeader), block.numSections);
+}
+
+} // anonymous namespace
+
+void SolutionData::clear()
+{
+    problemDescription.clear();
+    nodeX.clear();
+    nodeY.clear();
+    nodeValue.clear();
+    nodeMarker.clear();
+    nodeValuePrev.clear();
+    elements.clear();
+    elementLabel.clear();
+    elementJprev.clear();
+    labelCircuitCase.clear();
+    labelCircuitValue.clear();
+    conductorValue.clear();
+    conductorFlux.clear();
+    pbcs.clear();
+    ages.clear();
+}
+
+bool SolutionData::writeBinary(const std::string &file, std::ostream &err) const
+{
+    FlatSolution flat(*this);
+
+    FileHeader header;
+    std::memcpy(header.magic, binaryMagic, sizeof(binaryMagic));
+    header.version = binaryVersion;
+    header.byteOrder = byteOrderMark;
+    header.fileType = (uint32_t)fileType;
+    header.numSections = (uint32_t)flat.sections.size();
+
+    std::vector<SectionEntry> table;
+    layoutSections(flat.sections, sizeof(FileHeader), table);
+
+    std::ofstream output(file, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!output)
+    {
+        err << "Couldn't write to " << file << "\n";
+        return false;
+    }
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeSections(output, flat.sections, table, sizeof(FileHeader));
+    if (!output)
+    {
+        err << "Error while writing " << file << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool SolutionData::readBinary(const std::string &file, std::ostream &err)
+{
+    clear();
+
+    MappedFile input;
+    if (!input.open(file))
+    {
+        err << "Couldn't read from " << file << "\n";
+        return false;
+    }
+    const char *data = input.data();
+    const uint64_t size = input.size();
+
+    FileHeader header;
+    if (size < sizeof(FileHeader))
+    {
+        err << file << " is not a binary solution file\n";
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, binaryMagic, sizeof(binaryMagic)) != 0)
+    {
+        err << file << " is not a binary solution file\n";
+        return false;
+    }
+    if (header.byteOrder != byteOrderMark)
+    {
+        err << file << " was written on a machine with different byte order\n";
+        return false;
+    }
+    if (header.version > binaryVersion)
+    {
+        err << file << " uses binary format version " << header.version
+            << ", but only versions up to " << binaryVersion << " are supported\n";
+        return false;
+    }
+    fileType = (femm::FileType)header.fileType;
+
+    SectionReader reader(*this, file, err);
+    return reader.read(data, size, sizeof(FileHeader), header.numSections)
+            && reader.finish();
+}
+
+bool SolutionData::appendToArchive(const std::string &file, std::ostream &err) const
+{
+    FlatSolution flat(*this);
+    std::vector<Section> meshSections;
+    std::vector<Section> stepSections;
+    const Section *description = nullptr;
+    for (const Section &s: flat.sections)
+    {
+        if (s.id == ProblemDescription)
+            description = &s;
+        else if (isMeshSection(s.id))
+            meshSections.push_back(s);
+        else
+            stepSections.push_back(s);
+    }
+
+    bool create = true;
+    {
+        MappedFile input;
+        if (input.open(file) && input.size() > 0)
+        {
+            create = false;
+            const char *data = input.data();
+            std::vector<uint64_t> blocks;
+            if (!scanArchive(data, input.size(), blocks, file, err))
+                return false;
+            ArchiveHeader header;
+            std::memcpy(&header, data, sizeof(header));
+            if (header.fileType != (uint32_t)fileType)
+            {
+                err << file << " contains solutions of a different problem type\n";
+                return false;
+            }
+
+            // all steps must share the mesh
+            BlockHeader block;
+            std::memcpy(&block, data + blocks[0], sizeof(block));
+            const char *origin = data + blocks[0];
+            size_t meshSectionsFound = 0;
+            bool sameDescription = false;
+            for (uint32_t i=0; i<block.numSections; i++)
+            {
+                SectionEntry entry;
+                std::memcpy(&entry, origin + sizeof(BlockHeader) + i*sizeof(SectionEntry), sizeof(entry));
+                if (entry.id == ProblemDescription)
+                {
+                    sameDescription = (entry.count == description->count
+                                       && std::memcmp(origin + entry.offset, description->data, entry.count) == 0);
+                    continue;
+                }
+                for (const Section &s: meshSections)
+                {
+                    if (s.id != entry.id)
+                        continue;
+                    if (entry.itemSize != s.itemSize || entry.count != s.count
+                            || std::memcmp(origin + entry.offset, s.data, s.count*s.itemSize) != 0)
+                    {
+                        err << file << " contains solutions for a different mesh\n";
+                        return false;
+                    }
+                    meshSectionsFound++;
+                }
+            }
+            if (meshSectionsFound != meshSections.size())
+            {
+                err << file << " contains solutions for a different mesh\n";
+                return false;
+            }
+            // the problem description is only repeated if it changed:
+            if (!sameDescription)
+                stepSections.push_back(*description);
+        }
+    }
+
+    std::ofstream output(file, std::ios::out | std::ios::binary | (create ? std::ios::trunc : std::ios::app));
+    if (!output)
+    {
+        err << "Couldn't write to " << file << "\n";
+        return false;
+    }
+    if (create)
+    {
+        ArchiveHeader header;
+        std::memcpy(header.magic, archiveMagic, sizeof(archiveMagic));
+        header.version = archiveVersion;
+        header.byteOrder = byteOrderMark;
+        header.fileType = (uint32_t)fileType;
+        header.reserved = 0;
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        meshSections.push_back(*description);
+        writeBlock(output, MeshBlock, meshSections);
+    }
+    writeBlock(output, StepBlock, stepSections);
+    if (!output)
+    {
+        err << "Error while writing " << file << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool SolutionData::readArchiveStep(const std::string &file, int step, std::ostream &err)
+{
+    clear();
+
+    MappedFile input;
+    if (!input.open(file))
+    {
+        err << "Couldn't read from " << file << "\n";
+        return false;
+    }
+    const char *data = input.data();
+    std::vector<uint64_t> blocks;
+    if (!scanArchive(data, input.size(), blocks, file, err))
+        return false;
+    if (step < 0 || step >= (int)blocks.size()-1)
+    {
+        err << file << " has no step " << step << " (number of steps: " << blocks.size()-1 << ")\n";
+        return false;
+    }
+    ArchiveHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    fileType = (femm::FileType)header.fileType;
+
+    SectionReader reader(*this, file, err);
+    return readBlock(data, blocks[0], reader)
+            && readBlock(data, blocks[step+1], reader)
+            && reader.finish();
+}
+
+int SolutionData::archiveStepCount(const std::string &file, std::ostream &err)
+{
+    MappedFile input;
+    if (!input.open(file))
+    {
+        err << "Couldn't read from " << file << "\n";
+        return -1;
+    }
+    std::vector<uint64_t> blocks;
+    if (!scanArchive(input.data(), input.size(), blocks, file, err))
+        return -1;
+    return (int)blocks.size()-1;
+}
+
+bool SolutionData::isArchiveFile(const std::string &file)
+{
+    std::ifstream input(file, std::ios::in | std::ios::binary);
+    char magic[sizeof(archiveMagic)];
+    if (!input.read(magic, sizeof(magic)))
+        return false;
+    return std::memcmp(magic, archiveMagic, sizeof(archiveMagic)) == 0;
+}
+
+bool SolutionData::isBinaryFile(const std::string &file)
+{
+    std::ifstream input(file, std::ios::in | std::ios::binary);
+    char magic[sizeof(binaryMagic)];
+    if (!input.read(magic, sizeof(magic)))
+        return false;
+    return std::memcmp(magic, binaryMagic, sizeof(binaryMagic)) == 0;
+}
@@ -0,0 +1,169 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FEMM_SOLUTIONDATA_H
+#define FEMM_SOLUTIONDATA_H
+
+#include "CAirGapElement.h"
+#include "CCommonPoint.h"
+#include "femmcomplex.h"
+#include "femmenums.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace femm {
+
+/**
+ * @brief The SolutionData class holds a solution as it is handed from a solver to a post processor.
+ * Its contents correspond to a solution file (e.g. \c .ans), so that the solution can be
+ * passed on in memory instead of going through the file system.
+ *
+ * Coordinates are stored in problem length units, exactly as they would be written to the file.
+ *
+ * The data can also be stored in a binary solution file (see writeBinary()),
+ * which is much faster to read than the text format.
+ *
+ * Binary file format (version 1)
+ * ------------------------------
+ * All values are stored in native byte order; the header contains a byte order mark
+ * so that files from a machine with a different byte order are rejected.
+ *
+ *  * The header: 8 bytes magic ("XFEMMSOL"), then uint32 values for the format version,
+ *    the byte order mark (0x01020304), the femm::FileType, and the number of sections.
+ *  * The section table: one entry per section, consisting of uint32 section id,
+ *    uint32 item size, uint64 file offset, and uint64 item count.
+ *  * The sections: each section is a plain array that starts at an offset aligned to 8 bytes,
+ *    so that the file can be memory mapped and the arrays used in place.
+ *
+ * Readers ignore sections they don't know, which allows adding data without breaking old readers.
+ *
+ * Solution archive format (version 1)
+ * -----------------------------------
+ * A solution archive holds the solutions of several steps (e.g. of a sweep) that share one mesh
+ * (see appendToArchive()). It uses the same sections as the binary file format, grouped into blocks:
+ *
+ *  * The header: 8 bytes magic ("XFEMMARC"), then uint32 values for the format version,
+ *    the byte order mark (0x01020304), the femm::FileType, and a reserved value.
+ *  * The mesh block, containing the problem description, nodes, elements and periodic nodes.
+ *  * One block per step, containing the node values, circuit, conductor and air gap element data.
+ *    If the problem description of a step differs from the one in the mesh block,
+ *    the step block contains its own problem description.
+ *
+ * Each block starts with a uint32 block kind (1 for the mesh block, 2 for a step), the uint32 number of sections,
+ * and the uint64 size of the block in bytes. The section table follows, with offsets relative to the start of the block.
+ * Steps are appended without touching the rest of the file.
+ */
+class SolutionData
+{
+public:
+    /// \brief The kind of problem the solution belongs to
+    femm::FileType fileType = femm::FileType::MagneticsFile;
+
+    /// \brief The problem description, i.e. the contents of the problem file that is echoed at the start of the solution file
+    std::string problemDescription;
+
+    // nodes
+    std::vector<double> nodeX; ///< \brief x coordinate of each node
+    std::vector<double> nodeY; ///< \brief y coordinate of each node
+    std::vector<CComplex> nodeValue; ///< \brief solution at each node (A for magnetics problems)
+    std::vector<int> nodeMarker; ///< \brief boundary marker of each node
+    std::vector<double> nodeValuePrev; ///< \brief A of the previous solution; only set for incremental permeability problems
+
+    // elements
+    std::vector<int> elements; ///< \brief three node numbers per element
+    std::vector<int> elementLabel; ///< \brief block label number of each element
+    std::vector<double> elementJprev; ///< \brief J of the previous solution; only set for incremental permeability problems
+
+    // circuit data, one entry per block label
+    std::vector<int> labelCircuitCase; ///< \brief 0 for a voltage gradient, 1 for a current density
+    std::vector<CComplex> labelCircuitValue; ///< \brief the voltage gradient or current density
+
+    // conductor data (heat flow and electrostatics), one entry per conductor property
+    std::vector<double> conductorValue; ///< \brief temperature (heat flow) or voltage (electrostatics) of each conductor
+    std::vector<double> conductorFlux; ///< \brief total heat flux (heat flow) or charge (electrostatics) of each conductor
+
+    std::vector<femm::CCommonPoint> pbcs; ///< \brief pairs of (anti)periodic nodes
+    /**
+     * \brief air gap elements
+     * \note As in the solution file, the BdryName of each element is the quoted name followed by a newline.
+     */
+    std::vector<femmsolver::CAirGapElement> ages;
+
+    int numNodes() const { return (int)nodeX.size(); }
+    int numElements() const { return (int)elementLabel.size(); }
+
+    /**
+     * @brief Remove all data.
+     */
+    void clear();
+
+    /**
+     * @brief Write the solution to a binary solution file.
+     * @param file the file name (including extension)
+     * @param err output stream for error messages
+     * @return \c true on success, \c false otherwise.
+     */
+    bool writeBinary(const std::string &file, std::ostream &err = std::cerr) const;
+
+    /**
+     * @brief Read the solution from a binary solution file.
+     * The file is memory mapped if the platform supports it,
+     * and the arrays are filled straight from the mapping.
+     * @param file the file name (including extension)
+     * @param err output stream for error messages
+     * @return \c true on success, \c false otherwise.
+     */
+    bool readBinary(const std::string &file, std::ostream &err = std::cerr);
+
+    /**
+     * @brief Check whether a file is a binary solution file.
+     * Only the magic bytes at the start of the file are checked.
+     * @param file the file name (including extension)
+     * @return \c true, if the file starts with the binary solution file magic.
+     */
+    static bool isBinaryFile(const std::string &file);
+
+    /**
+     * @brief Append the solution as a new step to a solution archive.
+     * If the file does not exist (or is empty), a new archive is created.
+     * Otherwise, the archive must contain solutions for the same mesh.
+     * @param file the file name (including extension)
+     * @param err output stream for error messages
+     * @return \c true on success, \c false otherwise.
+     */
+    bool appendToArchive(const std::string &file, std::ostream &err = std::cerr) const;
+
+    /**
+     * @brief Read one step of a solution archive.
+     * @param file the file name (including extension)
+     * @param step the step index, counting from 0
+     * @param err output stream for error messages
+     * @return \c true on success, \c false otherwise.
+     */
+    bool readArchiveStep(const std::string &file, int step, std::ostream &err = std::cerr);
+
+    /**
+     * @brief Get the number of steps in a solution archive.
+     * @param file the file name (including extension)
+     * @param err output stream for error messages
+     * @return the number of steps, or -1 if the file is not a valid solution archive.
+     */
+    static int archiveStepCount(const std::string &file, std::ostream &err = std::cerr);
+
+    /**
+     * @brief Check whether a file is a solution archive.
+     * Only the magic bytes at the start of the file are checked.
+     * @param file the file name (including extension)
+     * @return \c true, if the file starts with the solution archive magic.
+     */
+    static bool isArchiveFile(const std::string &file);
+};
+
+} //namespace
+#endif
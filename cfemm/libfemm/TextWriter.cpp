@@ -0,0 +1,523 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "TextWriter.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstring>
+
+using namespace femm;
+
+namespace {
+
+constexpr size_t bufferSize = 1 << 16;
+
+/*
+ * Shortest round-trip double formatting using the Grisu2 algorithm:
+ * Florian Loitsch, "Printing Floating-Point Numbers Quickly and Accurately with Integers",
+ * PLDI 2010.
+ * Grisu2 always produces a representation that reads back to the same double;
+ * in rare cases, it is one digit longer than the shortest possible representation.
+ */
+
+/// \brief A floating point number f * 2^e with 64 bit significand
+struct DiyFp
+{
+    uint64_t f;
+    int e;
+};
+
+/// \brief Compute x - y; both must have the same exponent and x.f >= y.f
+DiyFp sub(const DiyFp &x, const DiyFp &y)
+{
+    assert(x.e == y.e && x.f >= y.f);
+    return DiyFp { x.f - y.f, x.e };
+}
+
+/// \brief Compute x * y, rounded to 64 bits
+DiyFp mul(const DiyFp &x, const DiyFp &y)
+{
+    const uint64_t u_lo = x.f & 0xFFFFFFFFu;
+    const uint64_t u_hi = x.f >> 32u;
+    const uint64_t v_lo = y.f & 0xFFFFFFFFu;
+    const uint64_t v_hi = y.f >> 32u;
+
+    const uint64_t p0 = u_lo * v_lo;
+    const uint64_t p1 = u_lo * v_hi;
+    const uint64_t p2 = u_hi * v_lo;
+    const uint64_t p3 = u_hi * v_hi;
+
+    uint64_t q = (p0 >> 32u) + (p1 & 0xFFFFFFFFu) + (p2 & 0xFFFFFFFFu);
+    q += uint64_t(1) << 31u; // round
+    const uint64_t h = p3 + (p1 >> 32u) + (p2 >> 32u) + (q >> 32u);
+    return DiyFp { h, x.e + y.e + 64 };
+}
+
+DiyFp normalize(DiyFp x)
+{
+    while ((x.f >> 63u) == 0)
+    {
+        x.f <<= 1u;
+        x.e--;
+    }
+    return x;
+}
+
+DiyFp normalizeTo(const DiyFp &x, int e)
+{
+    const int delta = x.e - e;
+    assert(delta >= 0 && ((x.f << delta) >> delta) == x.f);
+    return DiyFp { x.f << delta, e };
+}
+
+/**
+ * @brief Compute the (normalized) value v and the boundaries m- and m+ of the
+ * interval of real numbers that round to v.
+ * @param value a finite positive double
+ */
+void computeBoundaries(double value, DiyFp &v, DiyFp &mMinus, DiyFp &mPlus)
+{
+    constexpr int precision = 53;
+    constexpr int bias = 1023 + (precision-1);
+    constexpr int minExp = 1 - bias;
+    constexpr uint64_t hiddenBit = uint64_t(1) << (precision-1);
+
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint64_t E = bits >> (precision-1);
+    const uint64_t F = bits & (hiddenBit-1);
+
+    const bool isDenormal = (E == 0);
+    const DiyFp x = isDenormal
+            ? DiyFp { F, minExp }
+            : DiyFp { F + hiddenBit, static_cast<int>(E) - bias };
+
+    // the lower boundary is closer if the significand is a power of two
+    const bool lowerBoundaryIsCloser = (F == 0 && E > 1);
+    const DiyFp plus = DiyFp { 2*x.f + 1, x.e - 1 };
+    const DiyFp minus = lowerBoundaryIsCloser
+            ? DiyFp { 4*x.f - 1, x.e - 2 }
+            : DiyFp { 2*x.f - 1, x.e - 1 };
+
+    mPlus = normalize(plus);
+    mMinus = normalizeTo(minus, mPlus.e);
+    v = normalize(x);
+}
+
+// The cached powers c = 10^k = f * 2^e are chosen so that the products
+// in grisu2() have a binary exponent in the range [alpha, gamma].
+constexpr int alpha = -60;
+constexpr int gamma = -32;
+
+struct CachedPower
+{
+    uint64_t f;
+    int e;
+    int k;
+};
+
+/// \brief Get a cached power of ten 10^k so that alpha <= e + c.e + 64 <= gamma
+CachedPower getCachedPower(int e)
+{
+    constexpr int minDecExp = -300;
+    constexpr int decStep = 8;
+    static const CachedPower cachedPowers[] = {
+        { 0xAB70FE17C79AC6CA, -1060, -300 },
+        { 0xFF77B1FCBEBCDC4F, -1034, -292 },
+        { 0xBE5691EF416BD60C, -1007, -284 },
+        { 0x8DD01FAD907FFC3C,  -980, -276 },
+        { 0xD3515C2831559A83,  -954, -268 },
+        { 0x9D71AC8FADA6C9B5,  -927, -260 },
+        { 0xEA9C227723EE8BCB,  -901, -252 },
+        { 0xAECC49914078536D,  -874, -244 },
+        { 0x823C12795DB6CE57,  -847, -236 },
+        { 0xC21094364DFB5637,  -821, -228 },
+        { 0x9096EA6F3848984F,  -794, -220 },
+        { 0xD77485CB25823AC7,  -768, -212 },
+        { 0xA086CFCD97BF97F4,  -741, -204 },
+        { 0xEF340A98172AACE5,  -715, -196 },
+        { 0xB23867FB2A35B28E,  -688, -188 },
+        { 0x84C8D4DFD2C63F3B,  -661, -180 },
+        { 0xC5DD44271AD3CDBA,  -635, -172 },
+        { 0x936B9FCEBB25C996,  -608, -164 },
+        { 0xDBAC6C247D62A584,  -582, -156 },
+        { 0xA3AB66580D5FDAF6,  -555, -148 },
+        { 0xF3E2F893DEC3F126,  -529, -140 },
+        { 0xB5B5ADA8AAFF80B8,  -502, -132 },
+        { 0x87625F056C7C4A8B,  -475, -124 },
+        { 0xC9BCFF6034C13053,  -449, -116 },
+        { 0x964E858C91BA2655,  -422, -108 },
+        { 0xDFF9772470297EBD,  -396, -100 },
+        { 0xA6DFBD9FB8E5B88F,  -369,  -92 },
+        { 0xF8A95FCF88747D94,  -343,  -84 },
+        { 0xB94470938FA89BCF,  -316,  -76 },
+        { 0x8A08F0F8BF0F156B,  -289,  -68 },
+        { 0xCDB02555653131B6,  -263,  -60 },
+        { 0x993FE2C6D07B7FAC,  -236,  -52 },
+        { 0xE45C10C42A2B3B06,  -210,  -44 },
+        { 0xAA242499697392D3,  -183,  -36 },
+        { 0xFD87B5F28300CA0E,  -157,  -28 },
+        { 0xBCE5086492111AEB,  -130,  -20 },
+        { 0x8CBCCC096F5088CC,  -103,  -12 },
+        { 0xD1B71758E219652C,   -77,   -4 },
+        { 0x9C40000000000000,   -50,    4 },
+        { 0xE8D4A51000000000,   -24,   12 },
+        { 0xAD78EBC5AC620000,     3,   20 },
+        { 0x813F3978F8940984,    30,   28 },
+        { 0xC097CE7BC90715B3,    56,   36 },
+        { 0x8F7E32CE7BEA5C70,    83,   44 },
+        { 0xD5D238A4ABE98068,   109,   52 },
+        { 0x9F4F2726179A2245,   136,   60 },
+        { 0xED63A231D4C4FB27,   162,   68 },
+        { 0xB0DE65388CC8ADA8,   189,   76 },
+        { 0x83C7088E1AAB65DB,   216,   84 },
+        { 0xC45D1DF942711D9A,   242,   92 },
+        { 0x924D692CA61BE758,   269,  100 },
+        { 0xDA01EE641A708DEA,   295,  108 },
+        { 0xA26DA3999AEF774A,   322,  116 },
+        { 0xF209787BB47D6B85,   348,  124 },
+        { 0xB454E4A179DD1877,   375,  132 },
+        { 0x865B86925B9BC5C2,   402,  140 },
+        { 0xC83553C5C8965D3D,   428,  148 },
+        { 0x952AB45CFA97A0B3,   455,  156 },
+        { 0xDE469FBD99A05FE3,   481,  164 },
+        { 0xA59BC234DB398C25,   508,  172 },
+        { 0xF6C69A72A3989F5C,   534,  180 },
+        { 0xB7DCBF5354E9BECE,   561,  188 },
+        { 0x88FCF317F22241E2,   588,  196 },
+        { 0xCC20CE9BD35C78A5,   614,  204 },
+        { 0x98165AF37B2153DF,   641,  212 },
+        { 0xE2A0B5DC971F303A,   667,  220 },
+        { 0xA8D9D1535CE3B396,   694,  228 },
+        { 0xFB9B7CD9A4A7443C,   720,  236 },
+        { 0xBB764C4CA7A44410,   747,  244 },
+        { 0x8BAB8EEFB6409C1A,   774,  252 },
+        { 0xD01FEF10A657842C,   800,  260 },
+        { 0x9B10A4E5E9913129,   827,  268 },
+        { 0xE7109BFBA19C0C9D,   853,  276 },
+        { 0xAC2820D9623BF429,   880,  284 },
+        { 0x80444B5E7AA7CF85,   907,  292 },
+        { 0xBF21E44003ACDD2D,   933,  300 },
+        { 0x8E679C2F5E44FF8F,   960,  308 },
+        { 0xD433179D9C8CB841,   986,  316 },
+        { 0x9E19DB92B4E31BA9,  1013,  324 }
+    };
+
+    // k = ceil((alpha - e - 1) * log10(2))
+    const int f = alpha - e - 1;
+    const int k = (f * 78913) / (1 << 18) + static_cast<int>(f > 0);
+    const int index = (-minDecExp + k + (decStep-1)) / decStep;
+    assert(index >= 0 && index < (int)(sizeof(cachedPowers)/sizeof(cachedPowers[0])));
+
+    const CachedPower cached = cachedPowers[index];
+    assert(alpha <= cached.e + e + 64);
+    assert(gamma >= cached.e + e + 64);
+    return cached;
+}
+
+/// \brief Return the number of decimal digits of n, and set pow10 to 10^(digits-1)
+int findLargestPow10(uint32_t n, uint32_t &pow10)
+{
+    int digits = 10;
+    pow10 = 1000000000;
+    while (digits > 1 && n < pow10)
+    {
+        pow10 /= 10;
+        digits--;
+    }
+    return digits;
+}
+
+void grisu2Round(char *buf, int len, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t tenK)
+{
+    // move the last digit closer to w as long as it stays in the safe interval
+    while (rest < dist
+           && delta - rest >= tenK
+           && (rest + tenK < dist || dist - rest > rest + tenK - dist))
+    {
+        buf[len-1]--;
+        rest += tenK;
+    }
+}
+
+/**
+ * @brief Generate the digits of a number v within the interval [M-, M+].
+ * The result is buf * 10^decimalExponent.
+ */
+void grisu2DigitGen(char *buf, int &len, int &decimalExponent, DiyFp mMinus, DiyFp w, DiyFp mPlus)
+{
+    uint64_t delta = sub(mPlus, mMinus).f;
+    uint64_t dist = sub(mPlus, w).f;
+
+    // split M+ = f * 2^e into integral part p1 and fractional part p2
+    const DiyFp one { uint64_t(1) << -mPlus.e, mPlus.e };
+    uint32_t p1 = static_cast<uint32_t>(mPlus.f >> -one.e);
+    uint64_t p2 = mPlus.f & (one.f - 1);
+
+    // integral part
+    uint32_t pow10;
+    int n = findLargestPow10(p1, pow10);
+    while (n > 0)
+    {
+        const uint32_t d = p1 / pow10;
+        const uint32_t r = p1 % pow10;
+        buf[len++] = static_cast<char>('0' + d);
+        p1 = r;
+        n--;
+        const uint64_t rest = (uint64_t(p1) << -one.e) + p2;
+        if (rest <= delta)
+        {
+            decimalExponent += n;
+            grisu2Round(buf, len, dist, delta, rest, uint64_t(pow10) << -one.e);
+            return;
+        }
+        pow10 /= 10;
+    }
+
+    // fractional part
+    int m = 0;
+    for (;;)
+    {
+        p2 *= 10;
+        const uint64_t d = p2 >> -one.e;
+        const uint64_t r = p2 & (one.f - 1);
+        buf[len++] = static_cast<char>('0' + d);
+        p2 = r;
+        m++;
+        delta *= 10;
+        dist *= 10;
+        if (p2 <= delta)
+            break;
+    }
+    decimalExponent -= m;
+    grisu2Round(buf, len, dist, delta, p2, one.f);
+}
+
+/**
+ * @brief Compute the digits of a finite positive double.
+ * The result is buf[0..len) * 10^decimalExponent.
+ */
+void grisu2(double value, char *buf, int &len, int &decimalExponent)
+{
+    DiyFp v, mMinus, mPlus;
+    computeBoundaries(value, v, mMinus, mPlus);
+
+    const CachedPower cached = getCachedPower(mPlus.e);
+    const DiyFp c { cached.f, cached.e };
+
+    const DiyFp w = mul(v, c);
+    const DiyFp wMinus = mul(mMinus, c);
+    const DiyFp wPlus = mul(mPlus, c);
+
+    // shrink the interval by one unit to account for the rounding errors
+    const DiyFp lower { wMinus.f + 1, wMinus.e };
+    const DiyFp upper { wPlus.f - 1, wPlus.e };
+
+    len = 0;
+    decimalExponent = -cached.k;
+    grisu2DigitGen(buf, len, decimalExponent, lower, w, upper);
+}
+
+int formatInt(int value, char *out)
+{
+    char tmp[12];
+    int len = 0;
+    unsigned int u = static_cast<unsigned int>(value);
+    if (value < 0)
+        u = 0u - u;
+    do {
+        tmp[len++] = static_cast<char>('0' + u % 10);
+        u /= 10;
+    } while (u != 0);
+    int pos = 0;
+    if (value < 0)
+        out[pos++] = '-';
+    while (len > 0)
+        out[pos++] = tmp[--len];
+    return pos;
+}
+
+} // anonymous namespace
+
+TextWriter::TextWriter()
+    : fp(nullptr)
+    , buffer(bufferSize)
+    , used(0)
+    , failed(false)
+{
+}
+
+TextWriter::~TextWriter()
+{
+    close();
+}
+
+bool TextWriter::open(const std::string &file)
+{
+    close();
+    fp = fopen(file.c_str(), "wt");
+    used = 0;
+    failed = false;
+    return fp != nullptr;
+}
+
+bool TextWriter::close()
+{
+    if (!fp)
+        return false;
+    flush();
+    if (fclose(fp) != 0)
+        failed = true;
+    fp = nullptr;
+    return !failed;
+}
+
+void TextWriter::copy(FILE *source)
+{
+    size_t n;
+    do {
+        reserve(bufferSize/2);
+        n = fread(buffer.data() + used, 1, buffer.size() - used, source);
+        used += n;
+    } while (n > 0);
+}
+
+void TextWriter::write(const char *s)
+{
+    const size_t len = strlen(s);
+    reserve(len);
+    std::memcpy(buffer.data() + used, s, len);
+    used += len;
+}
+
+void TextWriter::write(const std::string &s)
+{
+    reserve(s.size());
+    std::memcpy(buffer.data() + used, s.data(), s.size());
+    used += s.size();
+}
+
+void TextWriter::writeInt(int i)
+{
+    reserve(12);
+    used += formatInt(i, buffer.data() + used);
+}
+
+void TextWriter::writeDouble(double d)
+{
+    reserve(32);
+    used += formatDouble(d, buffer.data() + used);
+}
+
+void TextWriter::printf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    va_list args2;
+    va_copy(args2, args);
+    const int len = vsnprintf(buffer.data() + used, buffer.size() - used, format, args);
+    va_end(args);
+    if (len >= 0 && used + len >= buffer.size())
+    {
+        // output did not fit: flush and retry
+        reserve(len + 1);
+        vsnprintf(buffer.data() + used, buffer.size() - used, format, args2);
+    }
+    va_end(args2);
+    if (len > 0)
+        used += len;
+}
+
+void TextWriter::flush(size_t n)
+{
+    if (fp && used > 0)
+    {
+        if (fwrite(buffer.data(), 1, used, fp) != used)
+            failed = true;
+    }
+    used = 0;
+    if (n > buffer.size())
+        buffer.resize(n);
+}
+
+int TextWriter::formatDouble(double d, char *out)
+{
+    if (!std::isfinite(d))
+        return snprintf(out, 32, "%.17g", d);
+
+    int pos = 0;
+    if (std::signbit(d))
+    {
+        out[pos++] = '-';
+        d = -d;
+    }
+    if (d == 0)
+    {
+        out[pos++] = '0';
+        return pos;
+    }
+
+    char digits[20];
+    int len;
+    int k;
+    grisu2(d, digits, len, k);
+    // value = digits * 10^k; decimal exponent in scientific notation:
+    const int x = len + k - 1;
+
+    if (x < -4 || x >= 17)
+    {
+        // exponential notation, like printf("%.17g"): d.ddde+XX
+        out[pos++] = digits[0];
+        if (len > 1)
+        {
+            out[pos++] = '.';
+            std::memcpy(out + pos, digits + 1, len - 1);
+            pos += len - 1;
+        }
+        out[pos++] = 'e';
+        int e = x;
+        if (e < 0)
+        {
+            out[pos++] = '-';
+            e = -e;
+        } else {
+            out[pos++] = '+';
+        }
+        if (e >= 100)
+        {
+            out[pos++] = static_cast<char>('0' + e / 100);
+            e %= 100;
+        }
+        out[pos++] = static_cast<char>('0' + e / 10);
+        out[pos++] = static_cast<char>('0' + e % 10);
+    } else if (k >= 0) {
+        // integer: digits followed by k zeros
+        std::memcpy(out + pos, digits, len);
+        pos += len;
+        for (int i=0; i<k; i++)
+            out[pos++] = '0';
+    } else if (x >= 0) {
+        // ddd.ddd
+        std::memcpy(out + pos, digits, x + 1);
+        pos += x + 1;
+        out[pos++] = '.';
+        std::memcpy(out + pos, digits + x + 1, len - x - 1);
+        pos += len - x - 1;
+    } else {
+        // 0.000ddd
+        out[pos++] = '0';
+        out[pos++] = '.';
+        for (int i=0; i < -x-1; i++)
+            out[pos++] = '0';
+        std::memcpy(out + pos, digits, len);
+        pos += len;
+    }
+    return pos;
+}
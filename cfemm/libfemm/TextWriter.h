@@ -0,0 +1,99 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FEMM_TEXTWRITER_H
+#define FEMM_TEXTWRITER_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace femm {
+
+/**
+ * @brief The TextWriter class is a buffered writer for large text files, like solution files.
+ *
+ * Output is collected in a buffer and written to the file in large blocks.
+ * Numbers are formatted without going through the printf machinery:
+ *  * integers are written like \c printf("%i")
+ *  * doubles are written in the shortest form that reads back to the same value,
+ *    using the same notation as \c printf("%.17g") (i.e. exponential notation
+ *    for exponents below -4 or above 16).
+ *
+ * Since every double reads back to exactly the same value, files written with
+ * TextWriter can be read by FEMM and xfemm just like files written with \c "%.17g".
+ */
+class TextWriter
+{
+public:
+    TextWriter();
+    ~TextWriter();
+    TextWriter(const TextWriter &) = delete;
+    TextWriter &operator=(const TextWriter &) = delete;
+
+    /**
+     * @brief Open a file for writing.
+     * The file is opened in text mode, just like with \c fopen(file,"wt").
+     * @param file
+     * @return \c true on success, \c false otherwise.
+     */
+    bool open(const std::string &file);
+    /**
+     * @brief Flush the buffer and close the file.
+     * @return \c true, if all data was written successfully.
+     */
+    bool close();
+    bool isOpen() const { return fp != nullptr; }
+
+    /**
+     * @brief Append the remaining contents of another file.
+     * @param source a file opened for reading
+     */
+    void copy(FILE *source);
+
+    void write(char c)
+    {
+        reserve(1);
+        buffer[used++] = c;
+    }
+    void write(const char *s);
+    void write(const std::string &s);
+    /// \brief Write an integer, like \c printf("%i")
+    void writeInt(int i);
+    /// \brief Write a double in the shortest representation that reads back to the same value
+    void writeDouble(double d);
+    /// \brief printf-style output, for everything that is not time critical
+    void printf(const char *format, ...)
+#ifdef __GNUC__
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+    /**
+     * @brief Format a double like writeDouble() does.
+     * @param d the value
+     * @param out output buffer of at least 32 characters. The result is not null-terminated.
+     * @return the number of characters written
+     */
+    static int formatDouble(double d, char *out);
+private:
+    /// \brief Make sure that at least n bytes are available in the buffer.
+    void reserve(size_t n)
+    {
+        if (used + n > buffer.size())
+            flush(n);
+    }
+    void flush(size_t n = 0);
+
+    FILE *fp;
+    std::vector<char> buffer;
+    size_t used;
+    bool failed;
+};
+
+} //namespace
+#endif
@@ -0,0 +1,190 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FEMM_UNDOJOURNAL_H
+#define FEMM_UNDOJOURNAL_H
+
+#include "CArcSegment.h"
+#include "make_unique.h"
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace femm {
+
+/**
+ * @brief The UndoJournal class records how an entity list of a FemmProblem differs from its state at the undo point.
+ *
+ * Instead of copying the whole list for every undo point, the journal keeps the size of the list
+ * at the undo point, and the original version of every entry that has been changed, removed
+ * or moved to another index since then.
+ * An entry is recorded only the first time it is touched, so that the cost of an undo point
+ * grows with the number of touched entries instead of the size of the list.
+ * Entries that are appended after the undo point need no record.
+ *
+ * Changes to entries that existed at the undo point have to be announced before they are made:
+ * change() before an entry is modified in place, shift() before entries are erased from the middle
+ * of the list, and beginReplace() before the list is rebuilt from copies of its entries.
+ * Entries are removed from the end of the list by truncate().
+ */
+template <class T>
+class UndoJournal
+{
+public:
+    using List = std::vector<std::unique_ptr<T>>;
+
+    /**
+     * @brief Start a new undo point at the current state of the list, and drop all records.
+     * @param list
+     */
+    void checkpoint(const List &list)
+    {
+        saved.clear();
+        size = (int)list.size();
+        active = true;
+    }
+
+    /**
+     * @brief Record an entry before it is modified in place.
+     * @param list
+     * @param idx
+     */
+    void change(const List &list, int idx)
+    {
+        if (!replacing && idx < size && saved.find(idx) == saved.end())
+            saved.emplace(idx, copy(*list[idx]));
+    }
+
+    /**
+     * @brief Record the entries from an index on, before some of them are erased and the others change their index.
+     * @param list
+     * @param first
+     */
+    void shift(const List &list, int first)
+    {
+        int end = std::min(size, (int)list.size());
+        for (int i=first; i<end; i++)
+            change(list, i);
+    }
+
+    /**
+     * @brief Remove the entries from an index on.
+     * Entries that existed at the undo point are moved into the journal instead of being copied.
+     * @param list
+     * @param newSize
+     */
+    void truncate(List &list, int newSize)
+    {
+        int end = std::min(size, (int)list.size());
+        for (int i=newSize; i<end && !replacing; i++)
+        {
+            if (saved.find(i) == saved.end())
+                saved.emplace(i, std::move(list[i]));
+        }
+        list.resize(newSize);
+    }
+
+    /**
+     * @brief Stop recording, because the list is about to be rebuilt from copies of its old entries.
+     * The changes made while the list is rebuilt only affect new entries, which need no record.
+     */
+    void beginReplace()
+    {
+        replacing = true;
+    }
+
+    /**
+     * @brief Take over the old entries of a list that has been rebuilt, and continue recording.
+     * @param old the entries of the list before it was rebuilt; entries that are taken over are left empty.
+     */
+    void replace(List &old)
+    {
+        replacing = false;
+        int end = std::min(size, (int)old.size());
+        for (int i=0; i<end; i++)
+        {
+            if (saved.find(i) == saved.end())
+                saved.emplace(i, std::move(old[i]));
+        }
+    }
+
+    /**
+     * @brief Revert the list to the undo point.
+     * Afterwards, the journal records the reverted changes, so that a second call redoes them.
+     * Without an undo point, nothing happens.
+     * @param list
+     */
+    void undo(List &list)
+    {
+        if (!active)
+            return;
+        int current = (int)list.size();
+        std::unordered_map<int, std::unique_ptr<T>> redo;
+        if (size > current)
+            list.resize(size);
+        for (auto &entry: saved)
+        {
+            int i = entry.first;
+            if (i < current)
+                redo.emplace(i, std::move(list[i]));
+            list[i] = std::move(entry.second);
+        }
+        // entries that were appended after the undo point
+        for (int i=size; i<current; i++)
+            redo.emplace(i, std::move(list[i]));
+        list.resize(size);
+
+        saved.swap(redo);
+        size = current;
+    }
+
+    /**
+     * @brief Get the size of the list at the undo point.
+     * @return the size, or 0 if there is no undo point.
+     */
+    int originalSize() const
+    {
+        return active ? size : 0;
+    }
+
+    /**
+     * @brief Get an entry as it was at the undo point.
+     * @param list
+     * @param idx an index below originalSize() and below the size of the list
+     * @return the recorded entry, or the entry of the list if it has not been touched.
+     */
+    const T &original(const List &list, int idx) const
+    {
+        auto it = saved.find(idx);
+        return (it != saved.end()) ? *it->second : *list[idx];
+    }
+
+private:
+    static std::unique_ptr<T> copy(const T &entry)
+    {
+        return entry.clone();
+    }
+
+    bool active = false;
+    bool replacing = false; ///< true between beginReplace() and replace()
+    int size = 0; ///< size of the list at the undo point
+    std::unordered_map<int, std::unique_ptr<T>> saved; ///< original entries by index
+};
+
+/// CArcSegment::clone() is inherited from CSegment and would slice the arc segment.
+template <>
+inline std::unique_ptr<CArcSegment> UndoJournal<CArcSegment>::copy(const CArcSegment &entry)
+{
+    return MAKE_UNIQUE<CArcSegment>(entry);
+}
+
+} // namespace femm
+
+#endif
+// vi:expandtab:tabstop=4 shiftwidth=4:
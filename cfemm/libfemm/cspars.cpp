@@ -26,6 +26,7 @@
 #include "cspars.h"
 
 #define MAXITER 1000000
+#define MAXGMRESITER 10000
 #define KLUDGE
 #define nrm(X) sqrt(Re(ConjDot(X,X)))
 
@@ -42,6 +43,9 @@ CBigComplexLinProb::CBigComplexLinProb()
     n=0;
     // Best guess for relaxation parameter
     Lambda = 1.5;
+    Restart = 30;
+    bGMRES = false;
+    bFloatPC = false;
 }
 
 CBigComplexLinProb::~CBigComplexLinProb()
@@ -436,10 +440,78 @@ CComplex CBigComplexLinProb::ConjDot(CComplex *x, CComplex *y)
     return z;
 }
 
+// Copy M into single precision compressed row storage for MultPC.
+// Only the stored values are rounded; the SSOR sweeps themselves
+// are done in double precision.
+void CBigComplexLinProb::BuildFloatPC()
+{
+    int i,k;
+    CComplexEntry *e;
+
+    PCRow.resize(n+1);
+    for(i=0,k=0; i<n; i++)
+    {
+        PCRow[i]=k;
+        for(e=M[i]; e!=NULL; e=e->next) k++;
+    }
+    PCRow[n]=k;
+
+    PCRe.resize(k);
+    PCIm.resize(k);
+    PCCol.resize(k);
+    for(i=0,k=0; i<n; i++)
+        for(e=M[i]; e!=NULL; e=e->next)
+        {
+            PCRe[k]=(float) e->x.re;
+            PCIm[k]=(float) e->x.im;
+            PCCol[k]=e->c;
+            k++;
+        }
+}
+
+void CBigComplexLinProb::MultFloatPC(CComplex *X, CComplex *Y)
+{
+    int i,j;
+    CComplex c;
+
+    c= Lambda*(2.-Lambda);
+    for(i=0; i<n; i++) Y[i]=X[i]*c;
+
+    // invert Lower Triangle;
+    for(i=0; i<n; i++)
+    {
+        j=PCRow[i];
+        Y[i]/= CComplex(PCRe[j],PCIm[j]);
+        for(j++; j<PCRow[i+1]; j++)
+            Y[PCCol[j]] -= CComplex(PCRe[j],PCIm[j]) * Y[i] * Lambda;
+    }
+
+    for(i=0; i<n; i++)
+    {
+        j=PCRow[i];
+        Y[i]*=CComplex(PCRe[j],PCIm[j]);
+    }
+
+    // invert Upper Triangle
+    for(i=n-1; i>=0; i--)
+    {
+        for(j=PCRow[i]+1; j<PCRow[i+1]; j++)
+            Y[i] -= CComplex(PCRe[j],PCIm[j]) * Y[PCCol[j]] * Lambda;
+        j=PCRow[i];
+        Y[i]/= CComplex(PCRe[j],PCIm[j]);
+    }
+}
+
 void CBigComplexLinProb::MultPC(CComplex *X, CComplex *Y)
 {
     int i;
 
+    if (bFloatPC && (int)PCRow.size()==n+1)
+    {
+        MultFloatPC(X,Y);
+        return;
+    }
+
     // Jacobi preconditioner:
 //	for(i=0;i<n;i++) Y[i]=X[i]/M[i]->x; return;
 
@@ -1055,16 +1127,396 @@ int CBigComplexLinProb::KludgeSolve(int flag)
     return 1;
 }
 
+// Assemble the full N-R operator Y = (M+Mh+Ma)*X + Ms*conj(X) as a
+// real-valued matrix acting on [Re(X);Im(X)].  With A=M+Mh+Ma and S=Ms:
+//
+//     | Re(A)+Re(S)   Im(S)-Im(A) |
+//     | Im(A)+Im(S)   Re(A)-Re(S) |
+//
+// The linked lists only hold the upper triangle, so the lower triangle
+// is reconstructed from the symmetry of each matrix.
+void CBigComplexLinProb::BuildRealBlockMatrix()
+{
+    int i,j,k,p,m;
+    CComplexEntry *e;
+    CComplexEntry **Mat[4]= {M,Mh,Ma,Ms};
+
+    // count entries in each row of the full complex matrices;
+    std::vector<int> cnt(n+1,0);
+    for(k=0; k<4; k++)
+        for(i=0; i<n; i++)
+            for(e=Mat[k][i]; e!=NULL; e=e->next)
+            {
+                cnt[i+1]++;
+                if (e->c!=i) cnt[e->c+1]++;
+            }
+    for(i=0; i<n; i++) cnt[i+1]+=cnt[i];
+
+    // scatter entries into their rows;
+    std::vector<int> col(cnt[n]);
+    std::vector<CComplex> a(cnt[n]),s(cnt[n]);
+    std::vector<int> fill(cnt.begin(),cnt.end()-1);
+    for(k=0; k<4; k++)
+        for(i=0; i<n; i++)
+            for(e=Mat[k][i]; e!=NULL; e=e->next)
+            {
+                CComplex xt=e->x;
+                if (k==1) xt=conj(e->x);	// hermitian matrix
+                if (k==2) xt=-conj(e->x);	// antihermitian matrix
+
+                j=fill[i]++;
+                col[j]=e->c;
+                if (k==3) s[j]=e->x;
+                else a[j]=e->x;
+
+                if (e->c==i) continue;
+                j=fill[e->c]++;
+                col[j]=i;
+                if (k==3) s[j]=xt;
+                else a[j]=xt;
+            }
+
+    // merge duplicate columns in place;
+    std::vector<int> crow(n+1);
+    std::vector<int> pos(n,-1);
+    for(i=0,m=0; i<n; i++)
+    {
+        crow[i]=m;
+        for(j=cnt[i]; j<cnt[i+1]; j++)
+        {
+            p=col[j];
+            if (pos[p]<crow[i])
+            {
+                pos[p]=m;
+                col[m]=p;
+                a[m]=a[j];
+                s[m]=s[j];
+                m++;
+            }
+            else
+            {
+                a[pos[p]]+=a[j];
+                s[pos[p]]+=s[j];
+            }
+        }
+    }
+    crow[n]=m;
+
+    // write out the real and imaginary block rows;
+    BlockRow.resize(2*n+1);
+    BlockCol.resize(4*m);
+    BlockVal.resize(4*m);
+    for(i=0,k=0; i<n; i++)
+    {
+        BlockRow[i]=k;
+        for(j=crow[i]; j<crow[i+1]; j++)
+        {
+            BlockCol[k]=col[j];
+            BlockVal[k++]=a[j].re+s[j].re;
+            BlockCol[k]=col[j]+n;
+            BlockVal[k++]=s[j].im-a[j].im;
+        }
+    }
+    for(i=0; i<n; i++)
+    {
+        BlockRow[n+i]=k;
+        for(j=crow[i]; j<crow[i+1]; j++)
+        {
+            BlockCol[k]=col[j];
+            BlockVal[k++]=a[j].im+s[j].im;
+            BlockCol[k]=col[j]+n;
+            BlockVal[k++]=a[j].re-s[j].re;
+        }
+    }
+    BlockRow[2*n]=k;
+}
+
+void CBigComplexLinProb::MultBlockA(const double *X, double *Y)
+{
+    int i,j;
+
+    for(i=0; i<2*n; i++)
+    {
+        Y[i]=0;
+        for(j=BlockRow[i]; j<BlockRow[i+1]; j++)
+            Y[i]+=BlockVal[j]*X[BlockCol[j]];
+    }
+}
+
+// The SSOR preconditioner built from M (which includes the complex-symmetric
+// approximation of the N-R matrix) applied to a real block vector.
+void CBigComplexLinProb::MultBlockPC(const double *X, double *Y, CComplex *Xc, CComplex *Yc)
+{
+    int i;
+
+    for(i=0; i<n; i++) Xc[i]=CComplex(X[i],X[n+i]);
+    MultPC(Xc,Yc);
+    for(i=0; i<n; i++)
+    {
+        Y[i]=Yc[i].re;
+        Y[n+i]=Yc[i].im;
+    }
+}
+
+// Right-preconditioned restarted GMRES on the real-valued block form
+// of the N-R system.  Unlike KludgeSolve, this treats the
+// Mh, Ma and Ms contributions exactly within a single Krylov iteration.
+int CBigComplexLinProb::BlockGMRESSolve(int flag)
+{
+    int i,j,k,it;
+    int N=2*n;
+    int m=Restart;
+    double normb,beta,er,t;
+
+    if (m<1) m=1;
+    if (m>N) m=N;
+
+    BuildRealBlockMatrix();
+
+    std::vector<double> x(N),r(N),w(N),z(N),rhs(N);
+    std::vector<double> Q((m+1)*N);		// Krylov basis
+    std::vector<double> H((m+1)*m);		// Hessenberg matrix, column-major
+    std::vector<double> cs(m),sn(m),g(m+1),y(m);
+    std::vector<CComplex> Xc(n),Yc(n);
+
+    for(i=0; i<n; i++)
+    {
+        rhs[i]=b[i].re;
+        rhs[n+i]=b[i].im;
+        if (flag)
+        {
+            x[i]=V[i].re;
+            x[n+i]=V[i].im;
+        }
+    }
+
+    for(i=0,normb=0; i<N; i++) normb+=rhs[i]*rhs[i];
+    normb=sqrt(normb);
+    if (normb==0)
+    {
+        for(i=0; i<n; i++) V[i]=0;
+        return 1;
+    }
+
+    er=1;
+    for(it=0; it<MAXGMRESITER;)
+    {
+        // form (true) residual;
+        MultBlockA(x.data(),w.data());
+        for(i=0,beta=0; i<N; i++)
+        {
+            r[i]=rhs[i]-w[i];
+            beta+=r[i]*r[i];
+        }
+        beta=sqrt(beta);
+        er=beta/normb;
+        if (er<Precision) break;
+
+        for(i=0; i<N; i++) Q[i]=r[i]/beta;
+        for(i=0; i<=m; i++) g[i]=0;
+        g[0]=beta;
+
+        // Arnoldi process with modified Gram-Schmidt;
+        for(j=0; (j<m) && (it<MAXGMRESITER); it++)
+        {
+            double *qj=&Q[j*N];
+            double *hj=&H[j*(m+1)];
+
+            MultBlockPC(qj,z.data(),Xc.data(),Yc.data());
+            MultBlockA(z.data(),w.data());
+
+            for(k=0; k<=j; k++)
+            {
+                double *qk=&Q[k*N];
+                for(i=0,t=0; i<N; i++) t+=w[i]*qk[i];
+                hj[k]=t;
+                for(i=0; i<N; i++) w[i]-=t*qk[i];
+            }
+            for(i=0,t=0; i<N; i++) t+=w[i]*w[i];
+            hj[j+1]=sqrt(t);
+            if (hj[j+1]!=0)
+                for(i=0; i<N; i++) Q[(j+1)*N+i]=w[i]/hj[j+1];
+
+            // apply previous Givens rotations to the new column;
+            for(k=0; k<j; k++)
+            {
+                t       = cs[k]*hj[k]+sn[k]*hj[k+1];
+                hj[k+1] =-sn[k]*hj[k]+cs[k]*hj[k+1];
+                hj[k]   = t;
+            }
+
+            // compute the rotation that eliminates the subdiagonal;
+            t=sqrt(hj[j]*hj[j]+hj[j+1]*hj[j+1]);
+            if (t==0) break;
+            cs[j]=hj[j]/t;
+            sn[j]=hj[j+1]/t;
+            hj[j]=t;
+            hj[j+1]=0;
+            g[j+1]=-sn[j]*g[j];
+            g[j]  = cs[j]*g[j];
+            j++;
+
+            er=fabs(g[j])/normb;
+            if (er<Precision) break;
+        }
+
+        // stagnation; let the caller choose another approach
+        if (j==0) break;
+
+        // solve the upper triangular least-squares system;
+        for(k=j-1; k>=0; k--)
+        {
+            y[k]=g[k];
+            for(i=k+1; i<j; i++) y[k]-=H[i*(m+1)+k]*y[i];
+            y[k]/=H[k*(m+1)+k];
+        }
+
+        // update the solution with the preconditioned correction;
+        for(i=0; i<N; i++) w[i]=0;
+        for(k=0; k<j; k++)
+            for(i=0; i<N; i++) w[i]+=y[k]*Q[k*N+i];
+        MultBlockPC(w.data(),z.data(),Xc.data(),Yc.data());
+        for(i=0; i<N; i++) x[i]+=z[i];
+    }
+
+    for(i=0; i<n; i++) V[i]=CComplex(x[i],x[n+i]);
+
+    if (er<Precision) return 1;
+    return 0;
+}
+
+// Right-preconditioned restarted GMRES(m) for the complex-symmetric problem.
+// Slower per iteration than PBCGSolve, but the residual decreases
+// monotonically, so it does not stall on poorly conditioned AC problems.
+int CBigComplexLinProb::PGMRESSolve(int flag)
+{
+    int i,j,k,it;
+    int m=Restart;
+    double normb,beta,er;
+    CComplex t,h1,h2;
+
+    if (m<1) m=1;
+    if (m>n) m=n;
+
+    std::vector<CComplex> Q((m+1)*n);		// Krylov basis
+    std::vector<CComplex> H((m+1)*m);		// Hessenberg matrix, column-major
+    std::vector<CComplex> cs(m),sn(m),g(m+1),y(m);
+
+    // if flag is false, initialize V with zeros;
+    if (flag==0) for(i=0; i<n; i++) V[i]=0;
+
+    normb=nrm(b);
+    if (normb==0)
+    {
+        for(i=0; i<n; i++) V[i]=0;
+        return 1;
+    }
+
+    er=1;
+    for(it=0; it<MAXGMRESITER;)
+    {
+        // form (true) residual;
+        MultA(V,R);
+        for(i=0; i<n; i++) R[i]=b[i]-R[i];
+        beta=nrm(R);
+        er=beta/normb;
+        if (er<Precision) break;
+
+        for(i=0; i<n; i++) Q[i]=R[i]/beta;
+        for(i=0; i<=m; i++) g[i]=0;
+        g[0]=beta;
+
+        // Arnoldi process with modified Gram-Schmidt;
+        for(j=0; (j<m) && (it<MAXGMRESITER); it++)
+        {
+            CComplex *qj=&Q[j*n];
+            CComplex *hj=&H[j*(m+1)];
+
+            MultPC(qj,Z);
+            MultA(Z,U);
+
+            for(k=0; k<=j; k++)
+            {
+                hj[k]=ConjDot(&Q[k*n],U);
+                for(i=0; i<n; i++) U[i]-=hj[k]*Q[k*n+i];
+            }
+            hj[j+1]=nrm(U);
+            if (hj[j+1]!=0)
+                for(i=0; i<n; i++) Q[(j+1)*n+i]=U[i]/hj[j+1];
+
+            // apply previous Givens rotations to the new column;
+            for(k=0; k<j; k++)
+            {
+                t       = conj(cs[k])*hj[k]+conj(sn[k])*hj[k+1];
+                hj[k+1] =-sn[k]*hj[k]+cs[k]*hj[k+1];
+                hj[k]   = t;
+            }
+
+            // compute the rotation that eliminates the subdiagonal;
+            h1=hj[j];
+            h2=hj[j+1];
+            t=sqrt(Re(h1*conj(h1))+Re(h2*conj(h2)));
+            if (t==0) break;
+            cs[j]=h1/t;
+            sn[j]=h2/t;
+            hj[j]=t;
+            hj[j+1]=0;
+            g[j+1]=-sn[j]*g[j];
+            g[j]  = conj(cs[j])*g[j];
+            j++;
+
+            er=abs(g[j])/normb;
+            if (er<Precision) break;
+        }
+
+        // stagnation
+        if (j==0) break;
+
+        // solve the upper triangular least-squares system;
+        for(k=j-1; k>=0; k--)
+        {
+            y[k]=g[k];
+            for(i=k+1; i<j; i++) y[k]-=H[i*(m+1)+k]*y[i];
+            y[k]/=H[k*(m+1)+k];
+        }
+
+        // update the solution with the preconditioned correction;
+        for(i=0; i<n; i++) U[i]=0;
+        for(k=0; k<j; k++)
+            for(i=0; i<n; i++) U[i]+=y[k]*Q[k*n+i];
+        MultPC(U,Z);
+        for(i=0; i<n; i++) V[i]+=Z[i];
+    }
+
+    if (er<Precision) return 1;
+    fprintf(stderr,"GMRES solver did not converge (residual %g)\n",er);
+    return 0;
+}
+
 // Entry point into linear solvers.
 // Calls PCGSQStart to do a small number of iterations,
 // moving the starting point for PBCG away from the
 // pathological starting points that can sometimes crop up.
 int CBigComplexLinProb::PBCGSolveMod(int flag,bool verbose)
 {
+    // M does not change during the solve;
+    // take the single precision copy for the preconditioner now
+    if (bFloatPC) BuildFloatPC();
+
     // if this is a N-R iteration, call the appropriate solver
     if (bNewton)
+    {
         //	return BiCGSTAB(flag);
-        return KludgeSolve(flag);
+        if (BlockGMRESSolve(flag)) return 1;
+
+        // GMRES did not converge;
+        // continue from its last iterate with the ad-hoc solver
+        return KludgeSolve(true);
+    }
+
+    // restarted GMRES, if requested by the problem definition
+    if (bGMRES)
+        return PGMRESSolve(flag);
 
     // Get starting point with a few iterations of CGNE;
     if(flag==false)
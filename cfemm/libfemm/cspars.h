@@ -22,6 +22,8 @@
 #ifndef CSPARS_H
 #define CSPARS_H
 
+#include <vector>
+
 class CComplexEntry
 {
 public:
@@ -56,9 +58,12 @@ public:
     int n;						// dimensions of the matrix;
     int bdw;					// optional bandwidth parameter;
     int bNewton;				// Flag which denotes whether or not there are entries in Mh or Ms;
+    int bGMRES;					// Flag which selects GMRES(m) instead of BiCG for complex-symmetric problems;
     int NumNodes;
     double Precision;
     double Lambda;			// relaxation factor;
+    int Restart;				// number of Krylov vectors kept by GMRES(m) between restarts;
+    bool bFloatPC;				// keep a single precision copy of M for the preconditioner;
 
     // member functions
 
@@ -87,11 +92,32 @@ public:
     int PBCGSolve(int flag);
     int BiCGSTAB(int flag);
     int KludgeSolve(int flag);
+    int BlockGMRESSolve(int flag);
+    int PGMRESSolve(int flag);
 
 //		CFknDlg *TheView;
 
 private:
 
+    // The N-R operator M+Mh+Ma+Ms*conj() assembled as an equivalent
+    // real-valued 2n x 2n block matrix in compressed row storage.
+    std::vector<int> BlockRow;
+    std::vector<int> BlockCol;
+    std::vector<double> BlockVal;
+
+    // single precision copy of M in compressed row storage;
+    // the diagonal is stored first in each row.
+    std::vector<float> PCRe;
+    std::vector<float> PCIm;
+    std::vector<int> PCCol;
+    std::vector<int> PCRow;
+
+    void BuildFloatPC();
+    void MultFloatPC(CComplex *X, CComplex *Y);
+    void BuildRealBlockMatrix();
+    void MultBlockA(const double *X, double *Y);
+    void MultBlockPC(const double *X, double *Y, CComplex *Xc, CComplex *Yc);
+
 };
 
 #endif
@@ -19,9 +19,11 @@
    Contact: richard.crozier@yahoo.co.uk
 */
 
-// does Cuthill-McKee algorithm as described in Hoole;
+// renumbers the mesh nodes using one of the orderings in nodeordering.h;
+// originally did Cuthill-McKee algorithm as described in Hoole;
 
 #include<stdio.h>
+#include<algorithm>
 #include<math.h>
 #include "malloc.h"
 #include "femmcomplex.h"
@@ -29,6 +31,7 @@
 #include "femmenums.h"
 //#include "spars.h"
 #include "feasolver.h"
+#include "nodeordering.h"
 
 template< class PointPropT
           , class BoundaryPropT
@@ -40,11 +43,39 @@ template< class PointPropT
 int FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshElementT>
 ::SortElements()
 {
-    // Comb Sort -- see http://en.wikipedia.org/wiki/Comb_sort
-    int *Score;
     int i,j,k,gap;
 
-    Score=(int*)calloc(NumEls,sizeof(int));
+    if ((ElementOrdering==femm::ElementHilbertCurve) || (ElementOrdering==femm::ElementMortonCurve))
+    {
+        // order by the position of the element centroids along the curve,
+        // so that neighbouring elements are close in memory
+        std::vector<int> rank;
+        std::vector<double> x, y, cx(NumEls), cy(NumEls);
+        NodeCoordinates(x, y);
+        for(k=0; k<NumEls; k++)
+        {
+            cx[k]=(x[meshele[k].p[0]]+x[meshele[k].p[1]]+x[meshele[k].p[2]])/3.;
+            cy[k]=(y[meshele[k].p[0]]+y[meshele[k].p[1]]+y[meshele[k].p[2]])/3.;
+        }
+        rank = femm::curveNumbering(cx, cy,
+                                    (ElementOrdering==femm::ElementHilbertCurve) ? femm::SpaceFillingCurve::Hilbert
+                                                                                 : femm::SpaceFillingCurve::Morton);
+
+        // apply the permutation in place
+        for(i=0; i<NumEls; i++)
+        {
+            while(rank[i]!=i)
+            {
+                j=rank[i];
+                std::swap(rank[i],rank[j]);
+                std::swap(meshele[i],meshele[j]);
+            }
+        }
+        return true;
+    }
+
+    // Comb Sort -- see http://en.wikipedia.org/wiki/Comb_sort
+    std::vector<int> Score(NumEls);
 
     for(k=0; k<NumEls; k++)
     {
@@ -79,8 +110,6 @@ int FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshE
     }
     while((gap>1)&&(i>0));
 
-
-    free(Score);
     return true;
 }
 
@@ -94,221 +123,30 @@ template< class PointPropT
 int FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshElementT>
 ::Cuthill(bool deletefiles)
 {
-
-    FILE *fp;
-    int i, n0, n1, n, newwide;
-    long int j, n_lines;
-    std::vector<std::vector<int>> ocon;
-    std::vector<int> newnum, numcon, nxtnum;
+    int i, j;
     char infile[256];
 
-    // read in connectivity from nodefile
-    sprintf(infile,"%s.edge",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL)
-    {
-        //MsgBox("Couldn't open %s",infile);
-        printf("Couldn't open %s",infile);
-        return false;
-    }
-    // read in number of lines
-    if (fscanf(fp,"%li",&n_lines) != 1)
-    {
-        printf("Couldn't read the number of lines");
-        return false;
-    }
-    // read in boundarymarker flag;
-    if (fscanf(fp,"%li",&j) != 1)
-    {
-        printf("Couldn't read in the boundarymarker flag");
-        return false;
-    }
-
-    // allocate storage for numbering
-    nxtnum.resize(NumNodes);
-    newnum.resize(NumNodes);
-    numcon.resize(NumNodes);
-    ocon.resize(NumNodes);
-
-    // initialize node array;
-    for(i=0; i<NumNodes; i++)
-    {
-        newnum[i] = -1;
-    }
-
-    // allocate space for connections;
-    //ocon[0].resize(2*n_lines);
-
-    // with first pass, figure out how many connections
-    // there are for each node;
-    for(i=0; i<n_lines; i++)
-    {
-        if (fscanf(fp,"%li",&j) != 1)
-        {
-            return false;
-        }
-        if (fscanf(fp,"%i",&n0) != 1)
-        {
-            return false;
-        }
-        if (fscanf(fp,"%i",&n1) != 1)
-        {
-            return false;
-        }
-        if (fscanf(fp,"%li",&j) != 1)
-        {
-            return false;
-        }
-
-        numcon[n0]++;
-        numcon[n1]++;
-    }
-
-    // mete out connection storage space;
-    for(i=0, n=0; i<NumNodes; i++)
-    {
-        //n += numcon[i-1];
-        //ocon[i] = ocon[0] + n;
-        ocon[i].resize(numcon[i]);
-    }
-
-    // on second pass through file, store connections;
-    rewind(fp);
-    // read in number of lines
-    if (fscanf(fp,"%li",&n_lines) != 1)
-    {
-        return false;
-    }
-    // read in boundarymarker flag;
-    if (fscanf(fp,"%li",&j) != 1)
-    {
-        return false;
-    }
-
-    for(i=0; i<n_lines; i++)
-    {
-        if (fscanf(fp,"%li",&j) != 1) 
-        { 
-            return false; 
-        }
-        if (fscanf(fp,"%i",&n0) != 1) 
-        { 
-            return false; 
-        }
-        if (fscanf(fp,"%i",&n1) != 1) 
-        { 
-            return false; 
-        }
-        if (fscanf(fp,"%li",&j) != 1) 
-        { 
-            return false; 
-        }
-
-        ocon[n0][nxtnum[n0]]=n1;
-        nxtnum[n0]++;
-        ocon[n1][nxtnum[n1]]=n0;
-        nxtnum[n1]++;
-    }
-    fclose(fp);
+    // the edges have already been read by LoadMesh
     if (deletefiles)
     {
+        sprintf(infile,"%s.edge",PathName.c_str());
         remove(infile);
     }
 
-
-    // sort connections in order of increasing connectivity;
-    // I'm lazy, so I'm doing a bubble sort;
-    for(n0=0; n0<NumNodes; n0++)
-    {
-        for(i=1; i<numcon[n0]; i++)
-            for(j=1; j<numcon[n0]; j++)
-                if(numcon[ocon[n0][j]]<numcon[ocon[n0][j-1]])
-                {
-                    n1=ocon[n0][j];
-                    ocon[n0][j]=ocon[n0][j-1];
-                    ocon[n0][j-1]=n1;
-                }
-    }
-
-
-    // search for a node to start with;
-    j = numcon[0];
-    n0 = 0;
-    for(i=1; i<NumNodes; i++)
+    femm::NodeGraph graph(NumNodes, meshEdges);
+    std::vector<int>().swap(meshEdges);
+    std::vector<int> newnum;
+    if ((NodeOrdering==femm::NodeHilbertCurve) || (NodeOrdering==femm::NodeMortonCurve))
     {
-        if(numcon[i]<j)
-        {
-            j=numcon[i];
-            n0=i;
-        }
-        if(j==2) i=n_lines;	// break out if j==2,
-        // because this is the best we can do
-    }
-
-    // do renumbering algorithm;
-    for(i=0; i<NumNodes; i++) nxtnum[i]=-1;
-    newnum[n0]=0;
-    n=1;
-    nxtnum[0]=n0;
-
-    do
-    {
-        // renumber in order of increasing number of connections;
-
-        for(i=0; i<numcon[n0]; i++)
-        {
-            if (newnum[ocon[n0][i]]<0)
-            {
-                newnum[ocon[n0][i]]=n;
-                nxtnum[n]=ocon[n0][i];
-                n++;
-            }
-        }
-
-        // need to catch case in which problem is multiply
-        // connected and still renumber right.
-        if(nxtnum[newnum[n0]+1]<0)
-        {
-            //	WarnMessage("Multiply Connected!");
-            //	exit(0);
-
-            // first, get a node that hasn't been visited yet;
-            for(i=0; i<NumNodes; i++)
-                if(newnum[i]<0)
-                {
-                    j=numcon[i];
-                    n0=i;
-                    break;
-                }
-
-
-            // now, get a new starting node;
-            for(i=0; i<NumNodes; i++)
-            {
-                if((newnum[i]<0) && (numcon[i]<j))
-                {
-                    j=numcon[i];
-                    n0=i;
-                }
-                if(j==2) break;	// break out if j==2,
-                // because this is the
-                // best we can do
-            }
-
-            // now, set things to restart;
-            newnum[n0]=n;
-            nxtnum[n]=n0;
-            n++;
-        }
-        else n0=nxtnum[newnum[n0]+1];
-
-
+        std::vector<double> x, y;
+        NodeCoordinates(x, y);
+        newnum = femm::curveNumbering(x, y,
+                                      (NodeOrdering==femm::NodeHilbertCurve) ? femm::SpaceFillingCurve::Hilbert
+                                                                             : femm::SpaceFillingCurve::Morton);
+    } else {
+        newnum = graph.ordering((femm::NodeOrdering)NodeOrdering);
     }
-    while(n<NumNodes);
-
-    // remap connectivities;
-    for(i=0; i<NumNodes; i++)
-        for(j=0; j<numcon[i]; j++)
-            ocon[i][j]=newnum[ocon[i][j]];
+    nodeNumbering = newnum;
 
     // remap (anti)periodic boundary points
     for(i=0; i<NumPBCs; i++)
@@ -327,6 +165,8 @@ int FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshE
 			agelist[i].quadNode[k].n2=newnum[agelist[i].quadNode[k].n2];
 			agelist[i].quadNode[k].n3=newnum[agelist[i].quadNode[k].n3];
 		}
+		for(int &node: agelist[i].nodeNums)
+			node=newnum[node];
 	}
 
     // find new bandwidth;
@@ -338,24 +178,9 @@ int FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshE
     // but if we apply the PCBs the last thing before the
     // solver is called, we can take advantage of banding
     // speed optimizations without messing things up.
-    for(n0=0,newwide=0; n0<NumNodes; n0++)
-    {
-        for(i=0; i<numcon[n0]; i++)
-            if(abs(newnum[n0]-ocon[n0][i])>newwide)
-            {
-                newwide=abs(newnum[n0]-ocon[n0][i]);
-            }
-    }
-
-    BandWidth=newwide+1;
+    BandWidth=graph.bandWidth(newnum)+1;
     // }
 
-    // free up the variables that we needed during the routine....
-    //free(numcon);
-    //free(nxtnum);
-    //free(ocon[0]);
-    //free(ocon);
-
     // new mapping remains in newnum;
     // apply this mapping to elements first.
     for(i=0; i<NumEls; i++)
@@ -80,6 +80,9 @@ FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshEleme
     , ACSolver(0)
     , DoForceMaxMeshArea(false)
     , DoSmartMesh(true)
+    , FloatPreconditioner(false)
+    , NodeOrdering(0)
+    , ElementOrdering(0)
     , bMultiplyDefinedLabels(false)
     , BandWidth(0)
     , meshele()
@@ -147,6 +150,9 @@ void FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
     ACSolver = 0;
     DoForceMaxMeshArea = false;
     DoSmartMesh = true;
+    FloatPreconditioner = false;
+    NodeOrdering = 0;
+    ElementOrdering = 0;
     bMultiplyDefinedLabels = false;
     BandWidth = 0;
     meshele.clear();
@@ -181,14 +187,13 @@ template< class PointPropT
 bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshElementT>
 ::LoadProblemFile(std::string &file)
 {
-    std::ifstream input;
+    Lexer input;
     std::stringstream err;
     err >> noskipws; // don't discard whitespace from message stream
 
     WarnMessage ("FEASolver::LoadProblemFile\n");
 
-    input.open(file.c_str(), std::ifstream::in);
-    if (!input.is_open())
+    if (!input.open(file))
     {
         err << "Couldn't read from specified .fem file: "
             << file.c_str()
@@ -205,17 +210,11 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
     std::cout << "feasolver starting parsing file " << file << std::endl;
 #endif // DEBUG_PARSER
 
-    string line;
-    string token;
+    Lexer::Token line { nullptr, nullptr };
+    Lexer::Token token { nullptr, nullptr };
     bool success = true;
-    while (input.good() && success)
+    while (success && input.nextTrimmedLine(line))
     {
-        if (input.eof())
-            break;
-
-        std::getline(input, line);
-
-        trim(line);
         if (line.empty())
         {
 #ifdef DEBUG_PARSER
@@ -226,17 +225,17 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
 
 #ifdef DEBUG_PARSER
         std::cout << "current line reads:" << std::endl
-                  << line << std::endl;
+                  << line.str() << std::endl;
 #endif // DEBUG_PARSER
 
-        std::istringstream lineStream(line);
-        nextToken(lineStream, &token);
+        Lexer lineStream(line.begin, line.end);
+        token = lineStream.nextToken();
 
 #ifdef DEBUG_PARSER
-        std::cout << "feasolver token is: " << token << std::endl;
+        std::cout << "feasolver token is: " << token.str() << std::endl;
 #endif // DEBUG_PARSER
 
-        if( token == "[format]")
+        if( token.is("[format]"))
         {
             success &= expectChar(lineStream, '=',err);
             success &= parseValue(lineStream, FileFormat, err);
@@ -244,14 +243,14 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
         }
 
         // Precision
-        if( token == "[precision]")
+        if( token.is("[precision]"))
         {
             success &= expectChar(lineStream, '=', err);
             success &= parseValue(lineStream, Precision, err);
             continue;
         }
 
-        if( token == "[minangle]")
+        if( token.is("[minangle]"))
         {
             success &= expectChar(lineStream, '=',err);
             success &= parseValue(lineStream, MinAngle, err);
@@ -259,7 +258,7 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
         }
 
         // Depth for 2D planar problems;
-        if( token == "[depth]")
+        if( token.is("[depth]"))
         {
             success &= expectChar(lineStream, '=',err);
             success &= parseValue(lineStream, Depth, err);
@@ -267,58 +266,58 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
         }
 
         // Units of length used by the problem
-        if( token == "[lengthunits]")
+        if( token.is("[lengthunits]"))
         {
             success &= expectChar(lineStream, '=', err);
-            nextToken(lineStream, &token);
-
-            if( token == "inches" ) LengthUnits=LengthInches;
-            else if( token == "millimeters" ) LengthUnits=LengthMillimeters;
-            else if( token == "centimeters" ) LengthUnits=LengthCentimeters;
-            else if( token == "mils" ) LengthUnits=LengthMils;
-            else if( token == "microns" ) LengthUnits=LengthMicrometers;
-            else if( token == "meters" ) LengthUnits=LengthMeters;
+            const Lexer::Token value = lineStream.nextToken();
+
+            if( value.is("inches") ) LengthUnits=LengthInches;
+            else if( value.is("millimeters") ) LengthUnits=LengthMillimeters;
+            else if( value.is("centimeters") ) LengthUnits=LengthCentimeters;
+            else if( value.is("mils") ) LengthUnits=LengthMils;
+            else if( value.is("microns") ) LengthUnits=LengthMicrometers;
+            else if( value.is("meters") ) LengthUnits=LengthMeters;
             continue;
         }
 
         // Coordinates (cartesian or polar)
-        if( token == "[coordinates]" )
+        if( token.is("[coordinates]") )
         {
             success &= expectChar(lineStream, '=', err);
-            nextToken(lineStream, &token);
+            const Lexer::Token value = lineStream.nextToken();
 
-            if ( token == "cartesian" ) Coords=CART;
-            if ( token == "polar" ) Coords=POLAR;
+            if ( value.is("cartesian") ) Coords=CART;
+            if ( value.is("polar") ) Coords=POLAR;
             continue;
         }
 
         // Problem Type (planar or axisymmetric)
-        if( token == "[problemtype]" )
+        if( token.is("[problemtype]") )
         {
             success &= expectChar(lineStream, '=', err);
-            nextToken(lineStream, &token);
+            const Lexer::Token value = lineStream.nextToken();
 
-            if( token == "planar" ) ProblemType=PLANAR;
-            if( token == "axisymmetric" ) ProblemType=AXISYMMETRIC;
+            if( value.is("planar") ) ProblemType=PLANAR;
+            if( value.is("axisymmetric") ) ProblemType=AXISYMMETRIC;
             continue;
         }
 
         // properties for axisymmetric external region
-        if( token == "[extzo]" )
+        if( token.is("[extzo]") )
         {
             success &= expectChar(lineStream, '=', err);
             success &= parseValue(lineStream, extZo, err);
             continue;
         }
 
-        if( token == "[extro]" )
+        if( token.is("[extro]") )
         {
             success &= expectChar(lineStream, '=', err);
             success &= parseValue(lineStream, extRo, err);
             continue;
         }
 
-        if( token == "[extri]" )
+        if( token.is("[extri]") )
         {
             success &= expectChar(lineStream, '=', err);
             success &= parseValue(lineStream, extRi, err);
@@ -326,7 +325,7 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
         }
 
 
-        if( token == "[comment]" )
+        if( token.is("[comment]") )
         {
             success &= expectChar(lineStream, '=', err);
             parseString(lineStream, &comment, err);
@@ -334,7 +333,7 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
         }
 
         // AC Solver Type
-        if( token == "[acsolver]")
+        if( token.is("[acsolver]"))
         {
             success &= expectChar(lineStream, '=', err);
             success &= parseValue(lineStream, ACSolver, err);
@@ -342,14 +341,14 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
         }
 
 		// Previous solution type
-		if( token == "[prevtype]" )
+		if( token.is("[prevtype]") )
         {
 			success &= expectChar(lineStream, '=', err);
 			success &= parseValue(lineStream, PrevType, err);
 			continue;
 		}
 
-        if( token == "[prevsoln]" )
+        if( token.is("[prevsoln]") )
         {
             success &= expectChar(lineStream, '=', err);
             success &= parseString(lineStream, &previousSolutionFile, err);
@@ -358,7 +357,7 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
 
         // Option to force use of default max mesh, overriding
         // user choice
-        if( token == "[forcemaxmesh]")
+        if( token.is("[forcemaxmesh]"))
         {
             success &= expectChar(lineStream, '=', err);
             success &= parseValue(lineStream, DoForceMaxMeshArea, err);
@@ -367,7 +366,7 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
 
         // Option to use smart meshing
         //std::cout << "checking for dosmartmesh" << std::endl;
-        if( token == "[dosmartmesh]" )
+        if( token.is("[dosmartmesh]") )
         {
             //std::cout << "found dosmartmesh" << std::endl;
             success &= expectChar(lineStream, '=', err);
@@ -375,19 +374,45 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
             continue;
         }
 
+        // Option to store the preconditioner in single precision
+        if( token.is("[floatpreconditioner]") )
+        {
+            success &= expectChar(lineStream, '=', err);
+            success &= parseValue(lineStream, FloatPreconditioner, err);
+            continue;
+        }
+
+        // Node renumbering scheme
+        if( token.is("[nodeordering]") )
+        {
+            success &= expectChar(lineStream, '=', err);
+            success &= parseValue(lineStream, NodeOrdering, err);
+            continue;
+        }
+
+        // Element sorting scheme
+        if( token.is("[elementordering]") )
+        {
+            success &= expectChar(lineStream, '=', err);
+            success &= parseValue(lineStream, ElementOrdering, err);
+            continue;
+        }
+
         // Point Properties
-        if( token == "[pointprops]" )
+        if( token.is("[pointprops]") )
         {
             int k;
             success &= expectChar(lineStream, '=', err);
             success &= parseValue(lineStream, k, err);
             if (k>0) nodeproplist.reserve(k);
-            while (input.good() && NumPointProps < k)
+            LexerStream stream(input.position(), input.textEnd());
+            while (stream && NumPointProps < k)
             {
-                PointPropT next = PointPropT::fromStream(input, err);
+                PointPropT next = PointPropT::fromStream(stream, err);
                 nodeproplist.push_back(next);
                 NumPointProps++;
             }
+            input.setPosition(stream.position());
             // message will be printed after parsing is done
             if (NumPointProps != k)
             {
@@ -399,19 +424,21 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
 
 
         // Boundary Properties;
-        if( token == "[bdryprops]" )
+        if( token.is("[bdryprops]") )
         {
             success &= expectChar(lineStream, '=', err);
             int k;
             success &= parseValue(lineStream, k, err);
             if (k>0) lineproplist.reserve(k);
 
-            while (input.good() && NumLineProps < k)
+            LexerStream stream(input.position(), input.textEnd());
+            while (stream && NumLineProps < k)
             {
-                BoundaryPropT next = BoundaryPropT::fromStream(input, err);
+                BoundaryPropT next = BoundaryPropT::fromStream(stream, err);
                 lineproplist.push_back(next);
                 NumLineProps++;
             }
+            input.setPosition(stream.position());
             // message will be printed after parsing is done
             if (NumLineProps != k)
             {
@@ -423,19 +450,21 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
 
 
         // Block Properties;
-        if( token == "[blockprops]" )
+        if( token.is("[blockprops]") )
         {
             success &= expectChar(lineStream, '=', err);
             int k;
             success &= parseValue(lineStream, k, err);
             if (k>0) blockproplist.reserve(k);
 
-            while (input.good() && NumBlockProps < k)
+            LexerStream stream(input.position(), input.textEnd());
+            while (stream && NumBlockProps < k)
             {
-                BlockPropT next = BlockPropT::fromStream(input, err);
+                BlockPropT next = BlockPropT::fromStream(stream, err);
                 blockproplist.push_back(next);
                 NumBlockProps++;
             }
+            input.setPosition(stream.position());
             // message will be printed after parsing is done
             if (NumBlockProps != k)
             {
@@ -446,19 +475,21 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
         }
 
         // Circuit Properties
-        if( token == "[circuitprops]" || token == "[conductorprops]")
+        if( token.is("[circuitprops]") || token.is("[conductorprops]"))
         {
             success &= expectChar(lineStream, '=', err);
             int k;
             success &= parseValue(lineStream, k, err);
             if(k>0) circproplist.reserve(k);
 
-            while (input.good() && NumCircProps < k)
+            LexerStream stream(input.position(), input.textEnd());
+            while (stream && NumCircProps < k)
             {
-                CircuitPropT next = CircuitPropT::fromStream(input, err);
+                CircuitPropT next = CircuitPropT::fromStream(stream, err);
                 circproplist.push_back(next);
                 NumCircProps++;
             }
+            input.setPosition(stream.position());
             // message will be printed after parsing is done
             if (NumCircProps != k)
             {
@@ -469,7 +500,7 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
         }
 
         // read in regional attributes
-        if(token == "[numblocklabels]" )
+        if(token.is("[numblocklabels]") )
         {
             success &= expectChar(lineStream, '=', err);
             success &= parseValue(lineStream, NumBlockLabels, err);
@@ -482,13 +513,15 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
             }
 #endif // DEBUG_PARSER
 
+            LexerStream stream(input.position(), input.textEnd());
             for(int i=0; i<NumBlockLabels; i++)
             {
 
-                BlockLabelT blk = BlockLabelT::fromStream(input, err);
+                BlockLabelT blk = BlockLabelT::fromStream(stream, err);
 
                 labellist.push_back(blk);
             }
+            input.setPosition(stream.position());
 
             // message will be printed after parsing is done
 //            if (NumBlockLabels != i)
@@ -511,10 +544,10 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
             continue;
         }
 
-        if(token == "[numpoints]"
-                || token == "[numsegments]"
-                || token == "[numarcsegments]"
-                || token == "[numholes]"
+        if(token.is("[numpoints]")
+                || token.is("[numsegments]")
+                || token.is("[numarcsegments]")
+                || token.is("[numholes]")
                 )
         {
             success &= expectChar(lineStream, '=', err);
@@ -523,16 +556,17 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
             // -> just skip the lines here:
             int i;
             success &= parseValue(lineStream, i, err);
-            while (0 < i--)
-                std::getline(input,line);
+            input.skipLines(i);
             continue;
         }
 
         // fall-through; token was not used
-        if (!handleToken(token, lineStream, err))
+        std::string tokenString = token.str();
+        to_lower(tokenString);
+        if (!handleToken(tokenString, lineStream, err))
         {
-            err << "Unknown token: " << token << "\n"
-                << "Context line:\n" << line << "\n";
+            err << "Unknown token: " << tokenString << "\n"
+                << "Context line:\n" << line.str() << "\n";
             success = false;
 #ifdef STOP_ON_UNKNOWN_TOKEN
             // stop parsing:
@@ -543,8 +577,8 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
     if (!success)
     {
         string msg = "Parse error while reading input file " + file + "!\n";
-        msg += "Last token was: " + token + "\n";
-        msg += "Last input line was: " + line + "\n";
+        msg += "Last token was: " + token.str() + "\n";
+        msg += "Last input line was: " + line.str() + "\n";
         msg += err.str();
         WarnMessage(msg.c_str());
         return false;
@@ -570,7 +604,7 @@ template< class PointPropT
           , class MeshElementT
           >
 bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshElementT>
-::handleToken(const string &, istream &, ostream &)
+::handleToken(const string &, Lexer &, ostream &)
 {
     // token not handled
     return false;
@@ -610,3 +644,89 @@ std::string FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabe
     return std::string();
 }
 
+template< class PointPropT
+          , class BoundaryPropT
+          , class BlockPropT
+          , class CircuitPropT
+          , class BlockLabelT
+          , class MeshElementT
+          >
+bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshElementT>
+::StoreSolutionMesh(const femm::CNode *nodes, double cf, const std::string &problemFile, femm::FileType fileType)
+{
+    solution = std::make_shared<femm::SolutionData>();
+    solution->fileType = fileType;
+
+    // the problem description is echoed from the problem file, just like in the solution file
+    std::ifstream input(problemFile);
+    if (!input)
+    {
+        std::string msg = "Couldn't open " + problemFile + "\n";
+        WarnMessage(msg.c_str());
+        return false;
+    }
+    std::stringstream description;
+    description << input.rdbuf();
+    solution->problemDescription = description.str();
+
+    solution->nodeX.resize(NumNodes);
+    solution->nodeY.resize(NumNodes);
+    solution->nodeMarker.resize(NumNodes);
+    for(int i=0; i<NumNodes; i++)
+    {
+        solution->nodeX[i] = nodes[i].x/cf;
+        solution->nodeY[i] = nodes[i].y/cf;
+        solution->nodeMarker[i] = nodes[i].BoundaryMarker;
+    }
+
+    solution->elements.resize(3*NumEls);
+    solution->elementLabel.resize(NumEls);
+    for(int i=0; i<NumEls; i++)
+    {
+        for(int j=0; j<3; j++)
+            solution->elements[3*i+j] = meshele[i].p[j];
+        solution->elementLabel[i] = meshele[i].lbl;
+    }
+
+    solution->pbcs.assign(pbclist.begin(), pbclist.begin()+NumPBCs);
+    solution->ages.assign(agelist.begin(), agelist.begin()+NumAirGapElems);
+    return true;
+}
+
+template< class PointPropT
+          , class BoundaryPropT
+          , class BlockPropT
+          , class CircuitPropT
+          , class BlockLabelT
+          , class MeshElementT
+          >
+bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshElementT>
+::WriteBinarySolution(const std::string &file)
+{
+    std::stringstream err;
+    if (!solution || !solution->writeBinary(file, err))
+    {
+        WarnMessage(err.str().c_str());
+        return false;
+    }
+    return true;
+}
+
+template< class PointPropT
+          , class BoundaryPropT
+          , class BlockPropT
+          , class CircuitPropT
+          , class BlockLabelT
+          , class MeshElementT
+          >
+bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshElementT>
+::AppendToSolutionArchive()
+{
+    std::stringstream err;
+    if (!solution || !solution->appendToArchive(solutionArchive, err))
+    {
+        WarnMessage(err.str().c_str());
+        return false;
+    }
+    return true;
+}
@@ -34,12 +34,16 @@
 
 #include "femmenums.h"
 #include "fparse.h"
+#include "Lexer.h"
 #include "spars.h"
 #include "CAirGapElement.h"
 #include "CBoundaryProp.h"
 #include "CCommonPoint.h"
 #include "CNode.h"
+#include "MeshData.h"
+#include "SolutionData.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -54,18 +58,6 @@
 #endif
 #endif
 
-enum LoadMeshErr
-{
-    NOERROR,
-    BADFEMFILE,
-    BADNODEFILE,
-    BADPBCFILE,
-    BADELEMENTFILE,
-    BADEDGEFILE,
-    MISSINGMATPROPS,
-    ELMLABELTOOBIG
-};
-
 template< class PointPropT
           , class BoundaryPropT
           , class BlockPropT
@@ -106,6 +98,9 @@ public:
     int		ACSolver;
     bool    DoForceMaxMeshArea;
     bool    DoSmartMesh;
+    bool    FloatPreconditioner; ///< \brief store the SSOR preconditioner in single precision \verbatim[floatpreconditioner]\endverbatim
+    int     NodeOrdering; ///< \brief node renumbering scheme, see femm::NodeOrdering \verbatim[nodeordering]\endverbatim
+    int     ElementOrdering; ///< \brief element sorting scheme, see femm::ElementOrdering \verbatim[elementordering]\endverbatim
     bool    bMultiplyDefinedLabels;
 
 
@@ -129,6 +124,23 @@ public:
 
     // string to hold the location of the files
     std::string PathName;
+    /// \brief Mesh handed over by the mesher. If unset, LoadMesh() reads the mesh files instead.
+    std::shared_ptr<const femm::MeshData> meshData;
+    /// \brief The edges of the mesh in the order of the mesher, two node numbers per edge. Set by LoadMesh(), used by Cuthill().
+    std::vector<int> meshEdges;
+
+    /// \brief If set, runSolver() keeps the solution in #solution, so that it can be handed to a post processor.
+    bool keepSolution = false;
+    /// \brief If unset, runSolver() does not write the solution file.
+    bool writeSolutionFile = true;
+    /// \brief If set, runSolver() writes the solution file in the binary format (see femm::SolutionData).
+    bool binarySolutionFile = false;
+    /// \brief If set, runSolver() appends the solution as a new step to this solution archive (see femm::SolutionData::appendToArchive()).
+    std::string solutionArchive;
+    /// \brief The solution computed by the last call to runSolver(), if #keepSolution is set.
+    std::shared_ptr<femm::SolutionData> solution;
+    /// \brief The number in #solution of each node of the mesh, as assigned by Cuthill(). Empty if the nodes were not renumbered.
+    std::vector<int> nodeNumbering;
 
     int PrevType; ///< \brief flag indicating type of previous solution, 0 for None, 1 for Incremental or 2 for Frozen \verbatim[prevtype]\endverbatim
     std::string previousSolutionFile; ///< \brief name of a previous solution file for hsolver and fsolver incremental permeability \verbatim[prevsoln]\endverbatim
@@ -189,22 +201,46 @@ protected:
      * @brief handleToken is called by LoadProblemFile() when a token is encountered that it can not handle.
      *
      * Classes subclassing FeaSolver can override this method to handle problem-specific problem file entries.
-     * If a token is understood, this method should read its text from the input stream and then return \c true.
-     * If a token is not understood, the method must not change the position in the input stream, and must return \c false.
+     * If a token is understood, this method should read its text from the input lexer and then return \c true.
+     * If a token is not understood, the method must not change the position of the input lexer, and must return \c false.
      *
-     * \note The input stream contains the remaining contents of the line that \c token was found on.
+     * \note The input lexer contains the remaining contents of the line that \c token was found on.
      * Therefore, this method can never read beyond the current line.
      *
-     * @param token the token in question
-     * @param input input stream for the current line
+     * @param token the token in question (lowercase)
+     * @param input lexer for the current line
      * @param err output stream for error messages
      * @return \c false, if the token is not handled. \c true, if it is handled
      */
-    virtual bool handleToken(const std::string &token, std::istream &input, std::ostream &err);
+    virtual bool handleToken(const std::string &token, femm::Lexer &input, std::ostream &err);
+
+    /**
+     * @brief Create #solution and fill in everything that does not depend on the solution vector.
+     * The node markers are set to the boundary markers of the nodes.
+     * @param nodes the mesh nodes (#NumNodes entries)
+     * @param cf the length of one problem length unit in the solver's internal length unit
+     * @param problemFile the problem file, which is echoed into the problem description
+     * @param fileType the problem type
+     * @return \c true on success, \c false if the problem file could not be read.
+     */
+    bool StoreSolutionMesh(const femm::CNode *nodes, double cf, const std::string &problemFile, femm::FileType fileType);
+    /**
+     * @brief Write #solution to a binary solution file.
+     * @param file the file name (including extension)
+     * @return \c true on success, \c false otherwise.
+     */
+    bool WriteBinarySolution(const std::string &file);
+    /**
+     * @brief Append #solution as a new step to #solutionArchive.
+     * @return \c true on success, \c false otherwise.
+     */
+    bool AppendToSolutionArchive();
 
 private:
 
     virtual void SortNodes (std::vector<int> newnum) = 0;
+    /// \brief Get the coordinates of all mesh nodes, as needed by the space filling curve orderings
+    virtual void NodeCoordinates (std::vector<double> &x, std::vector<double> &y) const = 0;
 
 };
 
@@ -0,0 +1,28 @@
+/* Copyright 2016-2017 Johannes Zarl-Zierl <johannes.zarl-zierl@jku.at>
+ * Contributions by Johannes Zarl-Zierl were funded by Linz Center of
+ * Mechatronics GmbH (LCM)
+ *
+ * The source code in this file is heavily derived from
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FEMMVERSION_H
+#define FEMMVERSION_H
+
+#define FEMM_FLAVOR "xfemm"
+#define FEMM_VERSION_MAJOR 0
+#define FEMM_VERSION_MINOR 0
+#define FEMM_VERSION_PATCH 0
+#define FEMM_VERSION_STRING "0.0.0-dev"
+
+#define FEMM_VERSION_INT ( ( FEMM_VERSION_MAJOR * 100 + FEMM_VERSION_MINOR ) * 100 + FEMM_VERSION_PATCH )
+
+#endif
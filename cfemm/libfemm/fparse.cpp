@@ -1,5 +1,6 @@
 #include "fparse.h"
 
+#include "Lexer.h"
 #include "stringTools.h"
 
 #include <algorithm>
@@ -41,7 +42,7 @@ char *ParseDbl(char *t, double *f)
     if (t==NULL) return NULL;
 
     int i,j,k,u,ws;
-    static char w[]="\t, \n";
+    static const char w[]="\t, \n";
     char *v;
 
     k=strlen(t);
@@ -78,7 +79,7 @@ char *ParseInt(char *t, int *f)
     if (t==NULL) return NULL;
 
     int i,j,k,u,ws;
-    static char w[]="\t, \n";
+    static const char w[]="\t, \n";
     char *v;
 
     k=strlen(t);
@@ -302,4 +303,99 @@ bool parseValue(istream &input, bool &val, ostream &err)
     return true;
 }
 
+
+namespace {
+/// \brief Consume the rest of the line and warn about trailing characters
+void finishValue(Lexer &input, std::ostream &err)
+{
+    Lexer::Token rest;
+    if (input.atEndOfLine())
+        input.skipLine();
+    else if (input.nextTrimmedLine(rest))
+        err << "Warning: trailing characters: '" << rest.str() << "'\n";
+}
+
+/// \brief Consume the rest of the line and complain that it is not a valid value
+void invalidValue(Lexer &input, const char *type, std::ostream &err)
+{
+    Lexer::Token rest { input.position(), input.position() };
+    input.nextTrimmedLine(rest);
+    err << "Could not convert '" << rest.str() << "' to " << type << "\n";
+}
+} // anonymous namespace
+
+bool expectChar(Lexer &input, char c,  std::ostream &err)
+{
+    if (input.expectChar(c))
+        return true;
+    err << "Expected char code " << (int)c
+        << "(" << c << "), but got "
+        << (input.atEnd() ? -1 : (int)*input.position());
+    return false;
+}
+
+bool parseString(Lexer &input, std::string *s, std::ostream &err)
+{
+    if (s)
+        s->clear();
+    if (!expectChar(input, '"', err))
+    {
+        err << "Error: Invalid begin of string literal!\n";
+        return false;
+    }
+
+    Lexer::Token line { input.position(), input.position() };
+    input.nextLine(line);
+    // FEMM42 allows unescaped double-quotes ('"') inside a string;
+    // i.e. the last quote in the line terminates the string
+    const char *pos = line.end;
+    while (pos > line.begin && pos[-1] != '"')
+        pos--;
+    if (pos == line.begin)
+    {
+        err << "Error: unterminated string literal!\n"
+            << "Offending string: " << line.str() << "\n";
+        return false;
+    }
+    if (s)
+        s->assign(line.begin, pos-1);
+    return true;
+}
+
+bool parseValue(Lexer &input, double &val, std::ostream &err)
+{
+    if (!input.parseDouble(val))
+    {
+        invalidValue(input, "double", err);
+        return false;
+    }
+    finishValue(input, err);
+    return true;
+}
+
+bool parseValue(Lexer &input, int &val, std::ostream &err)
+{
+    if (!input.parseInt(val))
+    {
+        invalidValue(input, "int", err);
+        return false;
+    }
+    finishValue(input, err);
+    return true;
+}
+
+bool parseValue(Lexer &input, bool &val, std::ostream &err)
+{
+    int i=0;
+    if (! parseValue(input, i, err))
+        return false;
+
+    if ( i != 0 && i != 1)
+    {
+        err << "Warning: bool out of range: " << i << "\n";
+    }
+    val = i;
+    return true;
+}
+
 }
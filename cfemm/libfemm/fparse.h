@@ -9,6 +9,7 @@
 //#define DEBUG_PARSER
 namespace femm
 {
+class Lexer;
 
 
 // declare some functions used to parse files
@@ -77,6 +78,51 @@ bool parseValue(std::istream &input, int &val, std::ostream &err = std::cerr);
  */
 bool parseValue(std::istream &input, bool &val, std::ostream &err = std::cerr);
 
+/**
+ * @brief expectChar reads the character \p c from the current line of the lexer.
+ * @param input
+ * @param c
+ * @param err output stream for error messages
+ * @return \c true, if the character was found, \c false otherwise
+ */
+bool expectChar(Lexer &input, const char c, std::ostream &err = std::cerr);
+/**
+ * @brief parseString reads a string literal (using the delimiter '"') from the current line of the lexer.
+ * Behaves like parseString(std::istream&,std::string*,std::ostream&).
+ * @param input
+ * @param s the result string. May be null, will be cleared.
+ * @param err
+ * @return \c true, if a string literal was read, \c false otherwise.
+ */
+bool parseString(Lexer &input, std::string *s, std::ostream &err);
+/**
+ * @brief parseValue reads a double value from the current line of the lexer.
+ * All characters until the end of line are consumed.
+ * @param input
+ * @param val
+ * @param err
+ * @return \c true, if the conversion worked, \c false otherwise
+ */
+bool parseValue(Lexer &input, double &val, std::ostream &err = std::cerr);
+/**
+ * @brief parseValue reads an int value from the current line of the lexer.
+ * All characters until the end of line are consumed.
+ * @param input
+ * @param val
+ * @param err
+ * @return \c true, if the conversion worked, \c false otherwise
+ */
+bool parseValue(Lexer &input, int &val, std::ostream &err = std::cerr);
+/**
+ * @brief parseValue reads a bool value from the current line of the lexer.
+ * All characters until the end of line are consumed.
+ * @param input
+ * @param val
+ * @param err
+ * @return \c true, if the conversion worked, \c false otherwise
+ */
+bool parseValue(Lexer &input, bool &val, std::ostream &err = std::cerr);
+
 // declare a default warning message function
 int PrintWarningMsg(const char* message, ...);
 
@@ -19,7 +19,8 @@
 
 
 // const TObject luaO_nilobject = {LUA_TNIL, {NULL}};
-TObject luaO_nilobject;
+// initialized here instead of in lua_open(), so that states can be opened in parallel threads
+TObject luaO_nilobject = {LUA_TNIL, Value()};
 
 //luaO_nilobject.ttype = 1;
 //luaO_nilobject.Value = {NULL};
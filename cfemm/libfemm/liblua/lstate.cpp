@@ -47,9 +47,6 @@ static int errormessage (lua_State *L)
 */
 static void f_luaopen (lua_State *L, void *ud)
 {
-    luaO_nilobject.ttype = LUA_TNIL;
-//  luaO_nilobject.value = NULL;
-
     int stacksize = *(int *)ud;
     if (stacksize == 0)
         stacksize = DEFAULT_STACK_SIZE;
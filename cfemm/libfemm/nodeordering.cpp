@@ -0,0 +1,557 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#include "nodeordering.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <set>
+#include <utility>
+
+using namespace femm;
+
+namespace {
+// resolution of the space filling curves (bits per coordinate)
+constexpr int CurveBits = 16;
+// subgraphs smaller than this are not dissected any further
+constexpr int DissectionLeafSize = 64;
+
+uint64_t hilbertKey(uint32_t x, uint32_t y)
+{
+    const uint32_t n = 1u << CurveBits;
+    uint64_t d = 0;
+    for (uint32_t s=n/2; s>0; s/=2)
+    {
+        uint32_t rx = (x & s) ? 1 : 0;
+        uint32_t ry = (y & s) ? 1 : 0;
+        d += (uint64_t)s * s * ((3*rx) ^ ry);
+        // rotate the quadrant
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = n-1-x;
+                y = n-1-y;
+            }
+            std::swap(x,y);
+        }
+    }
+    return d;
+}
+
+uint64_t mortonKey(uint32_t x, uint32_t y)
+{
+    uint64_t d = 0;
+    for (int b=0; b<CurveBits; b++)
+    {
+        d |= (uint64_t)((x >> b) & 1) << (2*b);
+        d |= (uint64_t)((y >> b) & 1) << (2*b+1);
+    }
+    return d;
+}
+} // namespace
+
+std::vector<int> femm::curveNumbering(const std::vector<double> &x, const std::vector<double> &y, SpaceFillingCurve curve)
+{
+    int n = (int)x.size();
+    std::vector<int> newnum(n);
+    if (n==0)
+        return newnum;
+
+    double xmin = *std::min_element(x.begin(),x.end());
+    double ymin = *std::min_element(y.begin(),y.end());
+    double wide = std::max(*std::max_element(x.begin(),x.end())-xmin,
+                           *std::max_element(y.begin(),y.end())-ymin);
+    double scale = (wide>0) ? ((1u << CurveBits)-1)/wide : 0;
+
+    std::vector<std::pair<uint64_t,int>> key(n);
+    for (int i=0; i<n; i++)
+    {
+        uint32_t ix = (uint32_t)((x[i]-xmin)*scale);
+        uint32_t iy = (uint32_t)((y[i]-ymin)*scale);
+        key[i].first = (curve==SpaceFillingCurve::Hilbert) ? hilbertKey(ix,iy) : mortonKey(ix,iy);
+        key[i].second = i;
+    }
+    std::sort(key.begin(),key.end());
+
+    for (int k=0; k<n; k++)
+        newnum[key[k].second] = k;
+    return newnum;
+}
+
+NodeGraph::NodeGraph(int numNodes, const std::vector<int> &edges)
+    : xadj(numNodes+1,0)
+    , adjncy(edges.size())
+    , visited(numNodes,0)
+    , visitTag(0)
+{
+    int numEdges = (int)edges.size()/2;
+
+    // first pass: count the edges of each node
+    for (int i=0; i<numEdges; i++)
+    {
+        xadj[edges[2*i]+1]++;
+        xadj[edges[2*i+1]+1]++;
+    }
+    for (int i=0; i<numNodes; i++)
+        xadj[i+1] += xadj[i];
+
+    // second pass: store the connections in the order of the edges
+    std::vector<int> fill(xadj.begin(),xadj.end()-1);
+    for (int i=0; i<numEdges; i++)
+    {
+        int n0 = edges[2*i];
+        int n1 = edges[2*i+1];
+        adjncy[fill[n0]++] = n1;
+        adjncy[fill[n1]++] = n0;
+    }
+}
+
+std::vector<int> NodeGraph::ordering(NodeOrdering method) const
+{
+    switch (method)
+    {
+    case ReverseCuthillMcKee:
+        return reverseCuthillMcKee();
+    case ApproximateMinimumDegree:
+        return approximateMinimumDegree();
+    case NestedDissection:
+        return nestedDissection();
+    case CuthillMcKee:
+    default:
+        return cuthillMcKee();
+    }
+}
+
+int NodeGraph::bandWidth(const std::vector<int> &newnum) const
+{
+    int wide = 0;
+    for (int i=0; i<numNodes(); i++)
+        for (int k=xadj[i]; k<xadj[i+1]; k++)
+            wide = std::max(wide, std::abs(newnum[i]-newnum[adjncy[k]]));
+    return wide;
+}
+
+long long NodeGraph::factorSize(const std::vector<int> &newnum) const
+{
+    // Row k of the factor has a nonzero for every node on the paths
+    // from its original entries up to k in the elimination tree (Liu),
+    // and the tree is built while the rows are visited.
+    int n = numNodes();
+    std::vector<int> perm(n), parent(n,-1), mark(n,-1);
+    for (int i=0; i<n; i++)
+        perm[newnum[i]] = i;
+
+    long long size = 0;
+    for (int k=0; k<n; k++)
+    {
+        mark[k] = k;
+        int n0 = perm[k];
+        for (int q=xadj[n0]; q<xadj[n0+1]; q++)
+        {
+            int j = newnum[adjncy[q]];
+            if (j > k)
+                continue;
+            while (mark[j] != k)
+            {
+                mark[j] = k;
+                size++;
+                if (parent[j] < 0)
+                    parent[j] = k;
+                j = parent[j];
+            }
+        }
+    }
+    return size;
+}
+
+int NodeGraph::levelStructure(int root, const std::vector<int> &mask, int tag,
+                              std::vector<int> &order, std::vector<int> &levelStart) const
+{
+    visitTag++;
+    order.clear();
+    levelStart.clear();
+
+    order.push_back(root);
+    visited[root] = visitTag;
+    levelStart.push_back(0);
+
+    size_t begin = 0;
+    while (begin < order.size())
+    {
+        size_t end = order.size();
+        for (size_t k=begin; k<end; k++)
+        {
+            int n0 = order[k];
+            for (int q=xadj[n0]; q<xadj[n0+1]; q++)
+            {
+                int n1 = adjncy[q];
+                if (mask[n1]==tag && visited[n1]!=visitTag)
+                {
+                    visited[n1] = visitTag;
+                    order.push_back(n1);
+                }
+            }
+        }
+        if (order.size() > end)
+            levelStart.push_back((int)end);
+        begin = end;
+    }
+    levelStart.push_back((int)order.size());
+
+    return (int)levelStart.size()-1;
+}
+
+int NodeGraph::pseudoPeripheralNode(int start, const std::vector<int> &mask, int tag) const
+{
+    std::vector<int> order, levelStart;
+    int root = start;
+    int numLevels = levelStructure(root, mask, tag, order, levelStart);
+
+    while (true)
+    {
+        // pick the node of minimum degree in the last level
+        int candidate = order[levelStart[numLevels-1]];
+        for (int k=levelStart[numLevels-1]+1; k<levelStart[numLevels]; k++)
+            if (degree(order[k]) < degree(candidate))
+                candidate = order[k];
+
+        int candidateLevels = levelStructure(candidate, mask, tag, order, levelStart);
+        if (candidateLevels <= numLevels)
+            break;
+        root = candidate;
+        numLevels = candidateLevels;
+    }
+    return root;
+}
+
+std::vector<int> NodeGraph::cuthillMcKee() const
+{
+    // This is the renumbering of FEMM 4.2, which starts at the first node of
+    // minimum degree and does not reverse the result. Ties are resolved in the
+    // order of the edges, so that the node numbers are the same as in FEMM.
+    int n = numNodes();
+    std::vector<int> newnum(n,-1);
+    std::vector<int> nxtnum(n,-1);
+    if (n==0)
+        return newnum;
+
+    // sort connections in order of increasing connectivity
+    std::vector<int> ocon(adjncy);
+    for (int n0=0; n0<n; n0++)
+        std::stable_sort(ocon.begin()+xadj[n0], ocon.begin()+xadj[n0+1], [this](int a, int b) {
+            return degree(a) < degree(b);
+        });
+
+    // search for a node to start with;
+    // stop at degree 2, because this is the best we can do
+    int n0 = 0;
+    int j = degree(0);
+    for (int i=1; i<n; i++)
+    {
+        if (degree(i)<j)
+        {
+            j = degree(i);
+            n0 = i;
+        }
+        if (j==2)
+            break;
+    }
+
+    newnum[n0] = 0;
+    nxtnum[0] = n0;
+    int next = 1;
+    while (next<n)
+    {
+        // renumber in order of increasing number of connections
+        for (int q=xadj[n0]; q<xadj[n0+1]; q++)
+        {
+            int n1 = ocon[q];
+            if (newnum[n1]<0)
+            {
+                newnum[n1] = next;
+                nxtnum[next] = n1;
+                next++;
+            }
+        }
+        if (next>=n)
+            break;
+
+        if (nxtnum[newnum[n0]+1]<0)
+        {
+            // the mesh consists of several unconnected regions:
+            // restart at the first unvisited node of minimum degree
+            int i = 0;
+            while (newnum[i]>=0)
+                i++;
+            n0 = i;
+            j = degree(i);
+            for (i=0; i<n; i++)
+            {
+                if (newnum[i]<0 && degree(i)<j)
+                {
+                    j = degree(i);
+                    n0 = i;
+                }
+                if (j==2)
+                    break;
+            }
+            newnum[n0] = next;
+            nxtnum[next] = n0;
+            next++;
+        } else {
+            n0 = nxtnum[newnum[n0]+1];
+        }
+    }
+    return newnum;
+}
+
+std::vector<int> NodeGraph::reverseCuthillMcKee() const
+{
+    int n = numNodes();
+    std::vector<int> mask(n,0);
+    std::vector<int> perm;
+    std::vector<int> nbrs;
+    perm.reserve(n);
+
+    // a mesh can consist of several unconnected regions,
+    // so each component gets its own starting node
+    for (int s=0; s<n; s++)
+    {
+        if (mask[s]!=0)
+            continue;
+
+        int root = pseudoPeripheralNode(s, mask, 0);
+        size_t head = perm.size();
+        perm.push_back(root);
+        mask[root] = 1;
+        for (; head<perm.size(); head++)
+        {
+            int n0 = perm[head];
+            // number unvisited neighbours in order of increasing connectivity
+            nbrs.clear();
+            for (int q=xadj[n0]; q<xadj[n0+1]; q++)
+                if (mask[adjncy[q]]==0)
+                    nbrs.push_back(adjncy[q]);
+            std::sort(nbrs.begin(), nbrs.end(), [this](int a, int b) {
+                return std::make_pair(degree(a),a) < std::make_pair(degree(b),b);
+            });
+            for (int n1: nbrs)
+            {
+                mask[n1] = 1;
+                perm.push_back(n1);
+            }
+        }
+    }
+
+    std::vector<int> newnum(n);
+    for (int k=0; k<n; k++)
+        newnum[perm[k]] = n-1-k;
+    return newnum;
+}
+
+std::vector<int> NodeGraph::approximateMinimumDegree() const
+{
+    // Quotient graph elimination: every eliminated node p becomes an
+    // element with variable list L[p]. A variable i keeps its remaining
+    // node neighbours in A[i] and its adjacent elements in E[i].
+    // Degrees are the approximate external degrees of Amestoy, Davis & Duff;
+    // supervariable detection is not done.
+    int n = numNodes();
+    std::vector<std::vector<int>> A(n), E(n), L(n);
+    std::vector<char> eliminated(n,0), alive(n,0);
+    std::vector<int> deg(n), inLp(n,0), w(n,0), wTag(n,0);
+    std::set<std::pair<int,int>> queue;
+    std::vector<int> perm, Lp;
+    perm.reserve(n);
+
+    for (int i=0; i<n; i++)
+    {
+        A[i].assign(adjncy.begin()+xadj[i], adjncy.begin()+xadj[i+1]);
+        deg[i] = degree(i);
+        queue.insert(std::make_pair(deg[i],i));
+    }
+
+    for (int k=0; k<n; k++)
+    {
+        int p = queue.begin()->second;
+        queue.erase(queue.begin());
+        eliminated[p] = 1;
+        perm.push_back(p);
+
+        // the new element consists of all neighbours of p
+        // and of the variables of the elements adjacent to p
+        int tag = k+1;
+        Lp.clear();
+        inLp[p] = tag;
+        for (int j: A[p])
+            if (!eliminated[j] && inLp[j]!=tag)
+            {
+                inLp[j] = tag;
+                Lp.push_back(j);
+            }
+        for (int e: E[p])
+        {
+            if (!alive[e])
+                continue;
+            for (int j: L[e])
+                if (!eliminated[j] && inLp[j]!=tag)
+                {
+                    inLp[j] = tag;
+                    Lp.push_back(j);
+                }
+            // e is absorbed by p
+            alive[e] = 0;
+            std::vector<int>().swap(L[e]);
+        }
+        std::vector<int>().swap(A[p]);
+        std::vector<int>().swap(E[p]);
+
+        // node neighbours that are part of Lp are now reachable through p
+        for (int i: Lp)
+        {
+            auto &Ai = A[i];
+            Ai.erase(std::remove_if(Ai.begin(), Ai.end(), [&](int j) {
+                return eliminated[j] || inLp[j]==tag;
+            }), Ai.end());
+        }
+
+        // w[e] = |L[e] \ Lp| for all elements adjacent to Lp
+        for (int i: Lp)
+            for (int e: E[i])
+            {
+                if (!alive[e])
+                    continue;
+                if (wTag[e]!=tag)
+                {
+                    wTag[e] = tag;
+                    w[e] = (int)L[e].size();
+                }
+                w[e]--;
+            }
+
+        // new approximate degrees
+        int lpSize = (int)Lp.size();
+        for (int i: Lp)
+        {
+            auto &Ei = E[i];
+            // aggressive absorption: elements completely inside Lp are redundant
+            for (int e: Ei)
+                if (alive[e] && w[e]==0)
+                {
+                    alive[e] = 0;
+                    std::vector<int>().swap(L[e]);
+                }
+            Ei.erase(std::remove_if(Ei.begin(), Ei.end(), [&](int e) {
+                return !alive[e];
+            }), Ei.end());
+
+            int d = (int)A[i].size() + lpSize-1;
+            for (int e: Ei)
+                d += w[e];
+            d = std::min(d, deg[i]+lpSize-1);
+            d = std::min(d, n-k-2);
+            Ei.push_back(p);
+
+            queue.erase(std::make_pair(deg[i],i));
+            deg[i] = std::max(d,0);
+            queue.insert(std::make_pair(deg[i],i));
+        }
+
+        alive[p] = 1;
+        L[p] = Lp;
+    }
+
+    std::vector<int> newnum(n);
+    for (int k=0; k<n; k++)
+        newnum[perm[k]] = k;
+    return newnum;
+}
+
+void NodeGraph::dissect(std::vector<int> &nodes, std::vector<int> &part, int tag,
+                        int &nextTag, std::vector<int> &perm) const
+{
+    std::vector<int> order, levelStart;
+    std::vector<int> remaining;
+    remaining.swap(nodes);
+
+    while (!remaining.empty())
+    {
+        int root = pseudoPeripheralNode(remaining[0], part, tag);
+        int numLevels = levelStructure(root, part, tag, order, levelStart);
+        int size = (int)order.size();
+
+        if (size < (int)remaining.size())
+        {
+            // split off this connected component and carry on with the rest
+            std::vector<int> component(order);
+            int ctag = nextTag++;
+            for (int j: component)
+                part[j] = ctag;
+            dissect(component, part, ctag, nextTag, perm);
+
+            std::vector<int> rest;
+            for (int j: remaining)
+                if (part[j]==tag)
+                    rest.push_back(j);
+            remaining.swap(rest);
+            continue;
+        }
+
+        if (size <= DissectionLeafSize || numLevels < 3)
+        {
+            perm.insert(perm.end(), order.begin(), order.end());
+            for (int j: order)
+                part[j] = -1;
+            return;
+        }
+
+        // use the level closest to the median as separator
+        int m = 1;
+        while (m < numLevels-2 && levelStart[m+1] <= size/2)
+            m++;
+
+        std::vector<int> first(order.begin(), order.begin()+levelStart[m]);
+        std::vector<int> separator(order.begin()+levelStart[m], order.begin()+levelStart[m+1]);
+        std::vector<int> second(order.begin()+levelStart[m+1], order.end());
+
+        for (int j: separator)
+            part[j] = -1;
+        int tagFirst = nextTag++;
+        for (int j: first)
+            part[j] = tagFirst;
+        int tagSecond = nextTag++;
+        for (int j: second)
+            part[j] = tagSecond;
+
+        dissect(first, part, tagFirst, nextTag, perm);
+        dissect(second, part, tagSecond, nextTag, perm);
+        // separators are numbered last
+        perm.insert(perm.end(), separator.begin(), separator.end());
+        return;
+    }
+}
+
+std::vector<int> NodeGraph::nestedDissection() const
+{
+    int n = numNodes();
+    std::vector<int> part(n,0);
+    std::vector<int> nodes(n);
+    std::vector<int> perm;
+    perm.reserve(n);
+    for (int i=0; i<n; i++)
+        nodes[i] = i;
+
+    int nextTag = 1;
+    dissect(nodes, part, 0, nextTag, perm);
+
+    std::vector<int> newnum(n);
+    for (int k=0; k<n; k++)
+        newnum[perm[k]] = k;
+    return newnum;
+}
@@ -0,0 +1,157 @@
+/*
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+#ifndef FEMM_NODEORDERING_H
+#define FEMM_NODEORDERING_H
+
+#include <vector>
+
+/**
+ * \file nodeordering.h
+ * \brief Bandwidth- and fill-reducing orderings for the mesh node graph,
+ * and locality preserving orderings along space filling curves.
+ *
+ * All orderings work on a node adjacency graph in compressed sparse row (CSR)
+ * form that is built from the mesh edges in memory,
+ * so that the .edge file does not have to be read again.
+ *
+ * ## References
+ *  - S. R. H. Hoole: Computer-Aided Analysis and Design of Electromagnetic Devices, 1989.
+ *  - A. George, J. W. Liu: An Implementation of a Pseudoperipheral Node Finder,
+ *    ACM TOMS 5(3), 1979.
+ *  - P. R. Amestoy, T. A. Davis, I. S. Duff: An Approximate Minimum Degree
+ *    Ordering Algorithm, SIAM J. Matrix Anal. Appl. 17(4), 1996.
+ *  - A. George: Nested Dissection of a Regular Finite Element Mesh,
+ *    SIAM J. Numer. Anal. 10(2), 1973.
+ */
+
+namespace femm {
+
+/**
+ * @brief The NodeOrdering enum selects the renumbering scheme used by the solvers.
+ * The numeric values are used in the problem file \verbatim[nodeordering]\endverbatim
+ */
+enum NodeOrdering {
+    /// \brief Cuthill-McKee as in FEMM, starting at a node of minimum degree (default)
+    CuthillMcKee = 0,
+    /// \brief Reverse Cuthill-McKee, starting at a pseudo-peripheral node
+    ReverseCuthillMcKee = 1,
+    /// \brief Position along a Hilbert curve through the node coordinates
+    NodeHilbertCurve = 2,
+    /// \brief Position along a Morton (Z-order) curve through the node coordinates
+    NodeMortonCurve = 3,
+    /// \brief Approximate minimum degree, reduces the fill of a factorization
+    ApproximateMinimumDegree = 4,
+    /// \brief Nested dissection using level set separators, reduces the fill of a factorization
+    NestedDissection = 5
+};
+
+/**
+ * @brief The ElementOrdering enum selects how the solvers sort the mesh elements after renumbering the nodes.
+ * The numeric values are used in the problem file \verbatim[elementordering]\endverbatim
+ */
+enum ElementOrdering {
+    /// \brief Sort by the sum of the (renumbered) node numbers
+    ElementNodeSum = 0,
+    /// \brief Position of the centroid along a Hilbert curve
+    ElementHilbertCurve = 1,
+    /// \brief Position of the centroid along a Morton (Z-order) curve
+    ElementMortonCurve = 2
+};
+
+/**
+ * @brief Space filling curves that can be used to order points.
+ */
+enum class SpaceFillingCurve {
+    Hilbert,
+    Morton
+};
+
+/**
+ * @brief Number a set of points by their position along a space filling curve.
+ * The bounding box of the points is mapped onto a 65536x65536 grid,
+ * points that fall into the same grid cell keep their relative order.
+ * @param x x coordinates of the points
+ * @param y y coordinates of the points
+ * @param curve the curve to use
+ * @return a vector \c newnum, such that \c newnum[i] is the position of point \c i along the curve
+ */
+std::vector<int> curveNumbering(const std::vector<double> &x, const std::vector<double> &y, SpaceFillingCurve curve);
+
+/**
+ * @brief Node adjacency graph in compressed sparse row form.
+ * The neighbours of node \c i are \c adjncy[xadj[i]] ... \c adjncy[xadj[i+1]-1],
+ * in the order in which the edges were given.
+ * Self loops are not stored.
+ */
+class NodeGraph
+{
+public:
+    /**
+     * @brief Build the graph from a list of edges.
+     * @param numNodes number of nodes in the mesh
+     * @param edges node numbers of the edges, two consecutive entries per edge; each edge must be given once
+     */
+    NodeGraph(int numNodes, const std::vector<int> &edges);
+
+    int numNodes() const { return (int)xadj.size()-1; }
+    int degree(int node) const { return xadj[node+1]-xadj[node]; }
+
+    /**
+     * @brief Compute a node ordering.
+     * @param method the ordering scheme to use (any but the space filling curves)
+     * @return a vector \c newnum, such that \c newnum[oldNumber] is the new node number
+     */
+    std::vector<int> ordering(NodeOrdering method) const;
+
+    /**
+     * @brief Compute the bandwidth of the graph for a given renumbering.
+     * @param newnum a permutation as returned by ordering()
+     * @return the largest difference between connected node numbers
+     */
+    int bandWidth(const std::vector<int> &newnum) const;
+
+    /**
+     * @brief Compute the size of the Cholesky factor of a matrix with the sparsity of the graph.
+     * @param newnum a permutation as returned by ordering()
+     * @return the number of nonzero entries below the diagonal of the factor, i.e. the original entries plus the fill
+     */
+    long long factorSize(const std::vector<int> &newnum) const;
+
+    std::vector<int> xadj;
+    std::vector<int> adjncy;
+
+private:
+    std::vector<int> cuthillMcKee() const;
+    std::vector<int> reverseCuthillMcKee() const;
+    std::vector<int> approximateMinimumDegree() const;
+    std::vector<int> nestedDissection() const;
+
+    /**
+     * @brief Find a pseudo-peripheral node in the component of \p start (George-Liu).
+     * Only nodes with \c mask[node]==tag are considered part of the graph.
+     */
+    int pseudoPeripheralNode(int start, const std::vector<int> &mask, int tag) const;
+    /**
+     * @brief Breadth first level structure rooted at \p root.
+     * @return the number of levels; \p order contains the visited nodes, \p levelStart the first index of every level.
+     */
+    int levelStructure(int root, const std::vector<int> &mask, int tag,
+                       std::vector<int> &order, std::vector<int> &levelStart) const;
+    /**
+     * @brief Append the nodes with \c part[node]==tag to \p perm, numbering the separators of their subgraph last.
+     */
+    void dissect(std::vector<int> &nodes, std::vector<int> &part, int tag,
+                 int &nextTag, std::vector<int> &perm) const;
+
+    // visit markers for levelStructure, so that a search does not need to clear a full array
+    mutable std::vector<int> visited;
+    mutable int visitTag;
+};
+
+} //namespace
+#endif
@@ -44,6 +44,7 @@ CBigLinProb::CBigLinProb()
     n=0;
     // Best guess for relaxation parameter
     Lambda = 1.5;
+    bFloatPC = false;
 }
 
 CBigLinProb::~CBigLinProb()
@@ -196,6 +197,12 @@ double CBigLinProb::Dot(double *X, double *Y)
 
 void CBigLinProb::MultPC(const double *X, double *Y)
 {
+    if (bFloatPC && (int)PCRow.size()==n+1)
+    {
+        MultFloatPC(X,Y);
+        return;
+    }
+
     // Jacobi preconditioner:
     //	int i;
     // for(i=0;i<n;i++) Y[i]=X[i]/M[i]->x;
@@ -235,6 +242,62 @@ void CBigLinProb::MultPC(const double *X, double *Y)
     }
 }
 
+// Copy M into single precision compressed row storage.
+// The SSOR sweeps are memory bound, so halving the size of the
+// matrix values speeds up MultPC.  The arithmetic is still done in
+// double precision, so the preconditioner remains a fixed symmetric
+// operator and CG converges to the same tolerance.
+void CBigLinProb::BuildFloatPC()
+{
+    int i,k;
+    CEntry *e;
+
+    PCRow.resize(n+1);
+    for(i=0,k=0; i<n; i++)
+    {
+        PCRow[i]=k;
+        for(e=M[i]; e!=NULL; e=e->next) k++;
+    }
+    PCRow[n]=k;
+
+    PCVal.resize(k);
+    PCCol.resize(k);
+    for(i=0,k=0; i<n; i++)
+        for(e=M[i]; e!=NULL; e=e->next)
+        {
+            PCVal[k]=(float) e->x;
+            PCCol[k]=e->c;
+            k++;
+        }
+}
+
+void CBigLinProb::MultFloatPC(const double *X, double *Y)
+{
+    int i,j;
+    double c;
+
+    c= Lambda*(2.-Lambda);
+    for(i=0; i<n; i++) Y[i]=X[i]*c;
+
+    // invert Lower Triangle;
+    for(i=0; i<n; i++)
+    {
+        Y[i]/= PCVal[PCRow[i]];
+        for(j=PCRow[i]+1; j<PCRow[i+1]; j++)
+            Y[PCCol[j]] -= PCVal[j] * Y[i] * Lambda;
+    }
+
+    for(i=0; i<n; i++) Y[i]*=PCVal[PCRow[i]];
+
+    // invert Upper Triangle
+    for(i=n-1; i>=0; i--)
+    {
+        for(j=PCRow[i]+1; j<PCRow[i+1]; j++)
+            Y[i] -= PCVal[j] * Y[PCCol[j]] * Lambda;
+        Y[i]/= PCVal[PCRow[i]];
+    }
+}
+
 bool CBigLinProb::PCGSolve(int flag)
 {
     int i;
@@ -248,6 +311,8 @@ bool CBigLinProb::PCGSolve(int flag)
             return 0;
         }
 
+    if (bFloatPC) BuildFloatPC();
+
     // initialize progress bar;
 //	TheView->SetDlgItemText(IDC_FRAME1,"Conjugate Gradient Solver");
 //	TheView->m_prog1.SetPos(0);
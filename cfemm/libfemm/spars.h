@@ -22,6 +22,8 @@
 #ifndef SPARS_H
 #define SPARS_H
 
+#include <vector>
+
 class CEntry
 {
 public:
@@ -52,6 +54,7 @@ public:
     int bdw;				// Optional matrix bandwidth parameter;
     double Precision;		// error tolerance for solution
     double Lambda;			// relaxation factor;
+    bool bFloatPC;			// keep a single precision copy of M for the preconditioner;
 
     int *Q; ///< Used by esolver and hsolver.
 
@@ -80,6 +83,14 @@ public:
 
 private:
 
+    // single precision copy of M in compressed row storage;
+    // the diagonal is stored first in each row.
+    std::vector<float> PCVal;
+    std::vector<int> PCCol;
+    std::vector<int> PCRow;
+
+    void BuildFloatPC();
+    void MultFloatPC(const double *X, double *Y);
 };
 
 #endif
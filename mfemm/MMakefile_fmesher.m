@@ -92,6 +92,8 @@ function [rules,vars] = MMakefile_fmesher (varargin)
 
     fmesher_sources = { ...
         'fmesher.cpp', ...
+        'MeshCache.cpp', ...
+        'MeshMorph.cpp', ...
         'nosebl.cpp', ...
         'writepoly.cpp', ...
     };
@@ -40,9 +40,11 @@ function FemmProblem = newproblem_mfemm(probtype, varargin)
 %                   quantities.
 %
 %   'ACSolver'    - Determines the type of solver used. Can be a scalar
-%                   value of 0 or 1. If zero, a Successive Approximation
-%                   method is used, if 1 a Newton method is used. Defalts
-%                   to the Successive Approximation method.
+%                   value of 0, 1 or 2. If zero, a Successive Approximation
+%                   method is used, if 1 a Newton method is used, and if 2
+%                   a Successive Approximation method with a restarted
+%                   GMRES linear solver is used. Defalts to the Successive
+%                   Approximation method.
 %
 %   'Coords'      - String determining whether cartesian of polar
 %                   coordinates are used. 'cart' specifies cartesian
@@ -59,6 +61,25 @@ function FemmProblem = newproblem_mfemm(probtype, varargin)
 %                   extra mesh points at corners to force a smoother mesh
 %                   gradient in these areas. Default is true.
 %
+%   'FloatPreconditioner' - Boolean value determining whether the solver
+%                   stores its preconditioner in single precision. This
+%                   halves the memory traffic of the preconditioner, the
+%                   precision of the solution does not change. Default is
+%                   false.
+%
+%   'NodeOrdering' - Scalar value selecting how the solver numbers the mesh
+%                   nodes: 0 for Cuthill-McKee, the same numbering as FEMM,
+%                   1 for reverse Cuthill-McKee, 2 for the position along a
+%                   Hilbert curve, 3 for the position along a Morton curve,
+%                   4 for approximate minimum degree, and 5 for nested
+%                   dissection. Default is 0.
+%
+%   'ElementOrdering' - Scalar value selecting how the solver sorts the
+%                   mesh elements: 0 by the sum of the node numbers, the
+%                   same order as FEMM, 1 for the position of the centroid
+%                   along a Hilbert curve, and 2 for the position of the
+%                   centroid along a Morton curve. Default is 0.
+%
 % Output
 %
 % FemmProblem - A structure containing the field 'Probinfo' with the same
@@ -97,6 +118,9 @@ function FemmProblem = newproblem_mfemm(probtype, varargin)
     Inputs.PrevSolutionType = 0;
     Inputs.dT = 0;
     Inputs.SmartMesh = true;
+    Inputs.FloatPreconditioner = false;
+    Inputs.NodeOrdering = 0;
+    Inputs.ElementOrdering = 0;
 
     Inputs = mfemmdeps.parse_pv_pairs(Inputs, varargin);
     
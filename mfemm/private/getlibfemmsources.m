@@ -16,20 +16,28 @@ function libfemm_sources = getlibfemmsources ()
         'CNode.cpp', ...
         'CPointProp.cpp', ...
         'CSegment.cpp', ...
+        'EntityPool.cpp', ...
         'cspars.cpp', ...
         'cuthill.cpp', ...
         'feasolver.cpp', ...
         'FemmProblem.cpp', ...
         'FemmReader.cpp', ...
         'FemmStateBase.cpp', ...
+        'GeometryIndex.cpp', ...
         'femmversion.cpp', ...
         'fparse.cpp', ...
         'fullmatrix.cpp', ...
         'IntPoint.cpp', ...
+        'Lexer.cpp', ...
         'LuaInstance.cpp', ...
+        'MappedFile.cpp', ...
+        'MeshData.cpp', ...
+        'nodeordering.cpp', ...
         'PostProcessor.cpp', ...
+        'SolutionData.cpp', ...
         'spars.cpp', ...
         'stringTools.cpp', ... 
+        'TextWriter.cpp', ... 
         };
 
 end
\ No newline at end of file
@@ -63,6 +63,18 @@ function writefemmfile(filename, FemmProblem, varargin)
 %         an upper default limit for a given area. If false the User's mesh
 %         size is always used. Defaults to false of not supplied.
 %
+%       FloatPreconditioner - true or false, if evaluating to true, the
+%         solver stores its preconditioner in single precision. Defaults to
+%         false if not supplied.
+%
+%       NodeOrdering - a scalar value selecting how the solver numbers the
+%         mesh nodes, see newproblem_mfemm. Defaults to 0 (Cuthill-McKee)
+%         if not supplied.
+%
+%       ElementOrdering - a scalar value selecting how the solver sorts the
+%         mesh elements, see newproblem_mfemm. Defaults to 0 (sum of the
+%         node numbers) if not supplied.
+%
 %   PointProps is a structure array, each member of which contains
 %   information on point properties which can be applied to nodes in the
 %   simulation. The structures must have the following fields:
@@ -299,6 +311,21 @@ function writefemmfile(filename, FemmProblem, varargin)
     else
         fprintf(fp,'[dosmartmesh] =  0\n');
     end
+
+    if isfield (FemmProblem.ProbInfo, 'FloatPreconditioner') ...
+            && FemmProblem.ProbInfo.FloatPreconditioner == true
+        fprintf(fp,'[FloatPreconditioner] =  1\n');
+    end
+
+    if isfield (FemmProblem.ProbInfo, 'NodeOrdering') ...
+            && FemmProblem.ProbInfo.NodeOrdering ~= 0
+        fprintf(fp,'[NodeOrdering] =  %i\n', FemmProblem.ProbInfo.NodeOrdering);
+    end
+
+    if isfield (FemmProblem.ProbInfo, 'ElementOrdering') ...
+            && FemmProblem.ProbInfo.ElementOrdering ~= 0
+        fprintf(fp,'[ElementOrdering] =  %i\n', FemmProblem.ProbInfo.ElementOrdering);
+    end
     
     fprintf(fp, '[Comment]     =  "%s"\n', s);
 